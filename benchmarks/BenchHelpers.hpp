@@ -0,0 +1,94 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <utility>
+
+/**
+ * Minimal helpers shared by the benchmark executables. We don't depend on any
+ * benchmark framework, each benchmark is a plain executable which prints one
+ * line per measurement.
+ */
+namespace blueth::bench {
+
+struct BenchResult {
+	std::string name;
+	std::size_t iterations{};
+	double total_ns{};
+	std::size_t bytes_per_iteration{};
+	double nsPerOp() const noexcept { return total_ns / iterations; }
+	double megabytesPerSecond() const noexcept {
+		if (!bytes_per_iteration || !total_ns) return 0;
+		return (static_cast<double>(bytes_per_iteration) * iterations) /
+		       (total_ns / 1e9) / (1024 * 1024);
+	}
+};
+
+/**
+ * Prevent the compiler from optimizing away a computed value
+ */
+template <typename T> inline void do_not_optimize(const T &value) {
+	asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline void print_result(const BenchResult &result) {
+	std::printf("%-48s %12zu iters %12.1f ns/op", result.name.c_str(),
+		    result.iterations, result.nsPerOp());
+	if (result.bytes_per_iteration)
+		std::printf(" %10.1f MB/s", result.megabytesPerSecond());
+	std::printf("\n");
+}
+
+/**
+ * Run 'bench_fn' 'iterations' times and print the result
+ *
+ * @param name Name of the benchmark
+ * @param iterations Number of times to invoke bench_fn
+ * @param bytes_per_iteration Bytes processed by a single invocation, used for
+ * reporting the throughput(0 to skip)
+ * @param bench_fn Callable to be measured
+ */
+template <typename BenchFn>
+inline BenchResult run_benchmark(std::string name, std::size_t iterations,
+				 std::size_t bytes_per_iteration,
+				 BenchFn &&bench_fn) {
+	auto start = std::chrono::steady_clock::now();
+	for (std::size_t i{}; i < iterations; i++) bench_fn();
+	auto end = std::chrono::steady_clock::now();
+	BenchResult result{
+	    std::move(name), iterations,
+	    static_cast<double>(
+		std::chrono::duration_cast<std::chrono::nanoseconds>(end -
+								     start)
+		    .count()),
+	    bytes_per_iteration};
+	print_result(result);
+	return result;
+}
+
+} // namespace blueth::bench
+
+#ifdef BLUETH_BENCH_COUNT_ALLOCATIONS
+/**
+ * Define BLUETH_BENCH_COUNT_ALLOCATIONS before including this header to count
+ * the operator new calls of the benchmark, for the allocations per operation.
+ * The replacement operator new is defined here, so only a single translation
+ * unit of an executable may define it. Memory which the IOBuffer allocators
+ * take with malloc is not counted.
+ */
+namespace blueth::bench {
+// Benchmarks are single threaded, a plain counter keeps the hook cheap
+inline std::size_t allocation_count{};
+} // namespace blueth::bench
+
+void *operator new(std::size_t size) {
+	blueth::bench::allocation_count++;
+	if (void *memory = std::malloc(size ? size : 1)) return memory;
+	throw std::bad_alloc{};
+}
+void operator delete(void *memory) noexcept { std::free(memory); }
+void operator delete(void *memory, std::size_t) noexcept { std::free(memory); }
+#endif
@@ -0,0 +1,61 @@
+#include "BenchHelpers.hpp"
+#include "http/HTTPCompression.hpp"
+#include "io/IOBuffer.hpp"
+#include <cstdio>
+#include <memory>
+#include <string>
+
+using namespace blueth;
+
+static constexpr std::size_t iterations = 2'000;
+
+// A JSON API response of about 24KB
+static std::string json_body() {
+	std::string body = "[";
+	for (int record{}; record < 400; record++)
+		body += R"({"id":)" + std::to_string(record) +
+			R"(,"name":"user)" + std::to_string(record * 7919 % 1000) +
+			R"(","active":true,"roles":["reader","writer"]},)";
+	body.back() = ']';
+	return body;
+}
+
+int main() {
+	const std::string body = json_body();
+	std::unique_ptr<io::IOBuffer<char>> output_buffer =
+	    io::IOBuffer<char>::create(body.size());
+	for (int level : {1, 6, 9}) {
+		http::HTTPCompressor compressor{http::HTTPContentCoding::Gzip, level};
+		bench::run_benchmark("gzip_level_" + std::to_string(level),
+				     iterations, body.size(), [&]() {
+					     output_buffer->clear();
+					     compressor.reset();
+					     compressor.compress(body.data(),
+								 body.size(),
+								 *output_buffer);
+					     compressor.finish(*output_buffer);
+				     });
+		std::printf("%-48s %12zu -> %zu bytes\n", "", body.size(),
+			    output_buffer->getDataSize());
+	}
+
+	// Every request after the first ones is a hit
+	http::HTTPCompressor compressor{http::HTTPContentCoding::Gzip, 6};
+	http::HTTPCompressedVariantCache variant_cache;
+	bench::run_benchmark("variant_cache_hit", iterations * 100, body.size(),
+			     [&]() {
+				     http::HTTPCompressedVariantCache::Key key =
+					 http::HTTPCompressedVariantCache::makeKey(
+					     body, http::HTTPContentCoding::Gzip);
+				     std::shared_ptr<const std::string> compressed =
+					 variant_cache.find(key);
+				     if (!compressed)
+					     compressed = variant_cache.getOrCompress(
+						 body, compressor);
+				     bench::do_not_optimize(compressed->size());
+			     });
+	bench::run_benchmark("content_hash", iterations * 100, body.size(), [&]() {
+		bench::do_not_optimize(http::content_hash(body.data(), body.size()));
+	});
+	return 0;
+}
@@ -0,0 +1,78 @@
+#define BLUETH_BENCH_COUNT_ALLOCATIONS
+#include "BenchHelpers.hpp"
+#include "http/HTTPMessagePool.hpp"
+#include "http/HTTPParserStateMachine.hpp"
+#include "io/IOBuffer.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+using namespace blueth;
+
+static constexpr std::size_t iterations = 1'000'000;
+
+template <typename BenchFn>
+static void bench_allocations(const std::string &name, std::size_t bytes,
+			      BenchFn &&bench_fn) {
+	std::size_t allocations_before = bench::allocation_count;
+	bench::BenchResult result =
+	    bench::run_benchmark(name, iterations, bytes, bench_fn);
+	std::size_t allocations = bench::allocation_count - allocations_before;
+	std::printf("%-48s %12.2f allocations/op\n", result.name.c_str(),
+		    static_cast<double>(allocations) / iterations);
+}
+
+int main() {
+	// A browser request on a keep-alive connection
+	const std::string raw_request =
+	    "GET /static/js/app.3f9c1a2b.bundle.min.js?v=12 HTTP/1.1\r\n"
+	    "Host: www.example.com\r\n"
+	    "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:91.0) Gecko/20100101 "
+	    "Firefox/91.0\r\n"
+	    "Accept: */*\r\n"
+	    "Accept-Language: en-US,en;q=0.5\r\n"
+	    "Accept-Encoding: gzip, deflate, br\r\n"
+	    "Connection: keep-alive\r\n"
+	    "Referer: https://www.example.com/index.html\r\n"
+	    "Cookie: _ga=GA1.2.1234567890.1690000000; "
+	    "session=eyJ1c2VyIjoiYWxpY2UifQ\r\n"
+	    "Sec-Fetch-Dest: script\r\n"
+	    "Sec-Fetch-Mode: no-cors\r\n"
+	    "Sec-Fetch-Site: same-origin\r\n\r\n";
+	std::unique_ptr<io::IOBuffer<char>> read_buffer =
+	    io::IOBuffer<char>::create(4096);
+	auto parse_into = [&](std::unique_ptr<http::HTTPRequestMessage> message) {
+		read_buffer->clear();
+		read_buffer->appendRawBytes(raw_request.data(), raw_request.size());
+		http::ParserState parser_state = http::ParserState::RequestLineBegin;
+		std::size_t consumed_bytes{};
+		message = http::ParseHTTP1_1RequestMessage(
+		    read_buffer, parser_state, std::move(message), consumed_bytes,
+		    http::HTTPParserLimits{});
+		bench::do_not_optimize(parser_state);
+		return message;
+	};
+
+	bench_allocations("parse_into_new_message", raw_request.size(), [&]() {
+		bench::do_not_optimize(
+		    parse_into(http::HTTPRequestMessage::create()));
+	});
+	std::unique_ptr<http::HTTPRequestMessage> connection_message =
+	    http::HTTPRequestMessage::create();
+	bench_allocations("parse_into_reset_message", raw_request.size(), [&]() {
+		connection_message->reset();
+		connection_message = parse_into(std::move(connection_message));
+		bench::do_not_optimize(connection_message.get());
+	});
+	// A connection per request, the message comes back to the pool when
+	// the connection is closed
+	http::HTTPMessagePool<http::HTTPRequestMessage> message_pool;
+	bench_allocations("parse_into_pooled_message", raw_request.size(), [&]() {
+		std::unique_ptr<http::HTTPRequestMessage> message =
+		    parse_into(message_pool.acquire());
+		bench::do_not_optimize(message.get());
+		message_pool.release(std::move(message));
+	});
+	return 0;
+}
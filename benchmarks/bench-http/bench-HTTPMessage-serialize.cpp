@@ -0,0 +1,57 @@
+#define BLUETH_BENCH_COUNT_ALLOCATIONS
+#include "BenchHelpers.hpp"
+#include "http/HTTPMessage.hpp"
+#include "io/IOBuffer.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <sys/uio.h>
+
+using namespace blueth;
+
+static constexpr std::size_t iterations = 1'000'000;
+
+template <typename BenchFn>
+static void bench_allocations(const std::string &name, BenchFn &&bench_fn) {
+	std::size_t allocations_before = bench::allocation_count;
+	bench::BenchResult result =
+	    bench::run_benchmark(name, iterations, 0, bench_fn);
+	std::size_t allocations = bench::allocation_count - allocations_before;
+	std::printf("%-48s %12.2f allocations/op\n", result.name.c_str(),
+		    static_cast<double>(allocations) / iterations);
+}
+
+int main() {
+	// A typical small API response
+	std::unique_ptr<http::HTTPResponseMessage> response =
+	    http::HTTPResponseMessage::create();
+	response->setResponseCode(http::HTTPResponseCodes::Ok);
+	response->addHeader("Content-Type", "application/json");
+	response->addHeader("Content-Length", "61");
+	response->addHeader("Date", "Tue, 20 Jul 2021 10:00:00 GMT");
+	response->addHeader("Server", "blueth");
+	response->addHeader("Cache-Control", "no-store");
+	response->addHeader("X-Request-ID", "f058ebd6-02f7-4d3f-942e-904344e8cde5");
+	response->pushBackRawBody(
+	    R"({"id":42,"name":"blueth","tags":["http","parser"],"ok":true})");
+
+	bench_allocations("buildRawMessage", [&]() {
+		bench::do_not_optimize(response->buildRawMessage());
+	});
+	// The write buffer of a connection, reused across the responses
+	std::unique_ptr<io::IOBuffer<char>> write_buffer =
+	    io::IOBuffer<char>::create(4096);
+	bench_allocations("serializeTo_IOBuffer", [&]() {
+		write_buffer->clear();
+		response->serializeTo(*write_buffer);
+		bench::do_not_optimize(write_buffer->getDataSize());
+	});
+	bench_allocations("fillIovec", [&]() {
+		write_buffer->clear();
+		::iovec iov[2];
+		bench::do_not_optimize(response->fillIovec(*write_buffer, iov));
+		bench::do_not_optimize(iov);
+	});
+	return 0;
+}
@@ -0,0 +1,252 @@
+#define BLUETH_BENCH_COUNT_ALLOCATIONS
+#include "BenchHelpers.hpp"
+#include "http/HTTPParserStateMachine.hpp"
+#include "http/HTTPParserStateMachineResponse.hpp"
+#include "io/IOBuffer.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace blueth;
+
+static constexpr std::size_t corpus_bytes_per_case = 64 * 1024 * 1024;
+static constexpr std::size_t max_fragment_size = 512;
+
+struct CorpusEntry {
+	std::string name;
+	std::string raw_bytes;
+	// Number of messages in raw_bytes(> 1 for a pipelined batch)
+	std::size_t message_count;
+};
+
+static std::string make_browser_request() {
+	return "GET /static/js/app.3f9c1a.js HTTP/1.1\r\n"
+	       "Host: www.example.com\r\n"
+	       "User-Agent: Mozilla/5.0 (Windows NT 10.0; Win64; x64) "
+	       "AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0.0.0 "
+	       "Safari/537.36\r\n"
+	       "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,"
+	       "image/avif,image/webp,*/*;q=0.8\r\n"
+	       "Accept-Language: en-US,en;q=0.9\r\n"
+	       "Accept-Encoding: gzip, deflate, br\r\n"
+	       "Referer: https://www.example.com/products/listing?page=2\r\n"
+	       "Cookie: _ga=GA1.2.1234567890.1690000000; "
+	       "_gid=GA1.2.987654321.1690000000; session=eyJhbGciOiJIUzI1NiJ9."
+	       "eyJ1c2VyIjoiYWxpY2UiLCJyb2xlIjoiYWRtaW4ifQ.c2lnbmF0dXJl; "
+	       "theme=dark; consent=yes; cart=8f3e2a1b9c; ab_test=variant_b; "
+	       "tz=Europe%2FBerlin; last_seen=1690000123\r\n"
+	       "Connection: keep-alive\r\n"
+	       "Sec-Fetch-Dest: script\r\n"
+	       "Sec-Fetch-Mode: no-cors\r\n"
+	       "Sec-Fetch-Site: same-origin\r\n\r\n";
+}
+
+static std::vector<CorpusEntry> make_request_corpus() {
+	std::vector<CorpusEntry> returner;
+	returner.push_back({"short_get",
+			    "GET / HTTP/1.1\r\n"
+			    "Host: example.com\r\n"
+			    "Accept: */*\r\n\r\n",
+			    1});
+	returner.push_back({"cookie_heavy_browser", make_browser_request(), 1});
+	std::string large_body(64 * 1024, 'p');
+	returner.push_back({"large_post_64k",
+			    "POST /api/v2/upload HTTP/1.1\r\n"
+			    "Host: api.example.com\r\n"
+			    "Content-Type: application/octet-stream\r\n"
+			    "Content-Length: " +
+				std::to_string(large_body.size()) +
+				"\r\n\r\n" + large_body,
+			    1});
+	std::string chunked_body;
+	for (int chunk{}; chunk < 16; chunk++)
+		chunked_body += "400\r\n" + std::string(1024, 'c') + "\r\n";
+	returner.push_back({"chunked_post_16k",
+			    "POST /api/v2/stream HTTP/1.1\r\n"
+			    "Host: api.example.com\r\n"
+			    "Transfer-Encoding: chunked\r\n\r\n" +
+				chunked_body + "0\r\n\r\n",
+			    1});
+	std::string pipelined_batch;
+	for (int request{}; request < 16; request++)
+		pipelined_batch += "GET /api/v2/items/" + std::to_string(request) +
+				   " HTTP/1.1\r\n"
+				   "Host: api.example.com\r\n"
+				   "Accept: application/json\r\n\r\n";
+	returner.push_back({"pipelined_16_gets", pipelined_batch, 16});
+	return returner;
+}
+
+static std::vector<CorpusEntry> make_response_corpus() {
+	std::vector<CorpusEntry> returner;
+	returner.push_back({"small_200",
+			    "HTTP/1.1 200 OK\r\n"
+			    "Content-Type: application/json\r\n"
+			    "Content-Length: 26\r\n\r\n"
+			    "{\"id\":4242,\"status\":\"ok\"}\n",
+			    1});
+	returner.push_back({"not_modified_304",
+			    "HTTP/1.1 304 Not Modified\r\n"
+			    "Date: Sat, 24 Apr 2021 04:00:59 GMT\r\n"
+			    "Server: blueth\r\n"
+			    "ETag: \"5f3c-1a2b3c4d\"\r\n"
+			    "Cache-Control: max-age=3600\r\n"
+			    "Set-Cookie: session=abc123; Path=/; HttpOnly\r\n\r\n",
+			    1});
+	returner.push_back({"redirect_301",
+			    "HTTP/1.1 301 Moved Permanently\r\n"
+			    "Location: https://www.example.com/new/path\r\n"
+			    "Date: Sat, 24 Apr 2021 04:00:59 GMT\r\n"
+			    "Server: blueth\r\n"
+			    "Content-Length: 0\r\n\r\n",
+			    1});
+	std::string large_body(256 * 1024, 'b');
+	returner.push_back({"large_256k",
+			    "HTTP/1.1 200 OK\r\n"
+			    "Content-Type: application/octet-stream\r\n"
+			    "Content-Length: " +
+				std::to_string(large_body.size()) +
+				"\r\n\r\n" + large_body,
+			    1});
+	std::string chunked_body;
+	for (int chunk{}; chunk < 16; chunk++)
+		chunked_body += "400\r\n" + std::string(1024, 'r') + "\r\n";
+	returner.push_back({"chunked_16k",
+			    "HTTP/1.1 200 OK\r\n"
+			    "Content-Type: text/html\r\n"
+			    "Transfer-Encoding: chunked\r\n\r\n" +
+				chunked_body + "0\r\n\r\n",
+			    1});
+	return returner;
+}
+
+/**
+ * Random fragment boundaries of a message, the same for every iteration so
+ * the fragmentation doesn't add noise to the measurement
+ */
+static std::vector<std::size_t> make_fragments(std::size_t message_size,
+					       std::mt19937 &random_engine) {
+	std::uniform_int_distribution<std::size_t> fragment_size(
+	    1, max_fragment_size);
+	std::vector<std::size_t> returner;
+	for (std::size_t offset{}; offset < message_size;) {
+		std::size_t size =
+		    std::min(fragment_size(random_engine), message_size - offset);
+		returner.push_back(size);
+		offset += size;
+	}
+	return returner;
+}
+
+static void print_summary(const bench::BenchResult &result,
+			  std::size_t messages_per_iteration,
+			  std::size_t allocations_per_iteration) {
+	std::printf("    %.1f ns/message, %.2f allocations/message\n",
+		    result.total_ns / (result.iterations *
+				       static_cast<double>(messages_per_iteration)),
+		    static_cast<double>(allocations_per_iteration) /
+			messages_per_iteration);
+}
+
+static void bench_request(const CorpusEntry &entry, const char *feed_mode,
+			  const std::vector<std::size_t> &fragments) {
+	std::unique_ptr<io::IOBuffer<char>> io_buffer =
+	    io::IOBuffer<char>::create(entry.raw_bytes.size() + 1024);
+	std::size_t iterations =
+	    std::max<std::size_t>(corpus_bytes_per_case / entry.raw_bytes.size(),
+				  1);
+	auto parse_once = [&]() {
+		io_buffer->clear();
+		http::ParserState current_state =
+		    http::ParserState::RequestLineBegin;
+		std::unique_ptr<http::HTTPRequestMessage> http_message =
+		    http::HTTPRequestMessage::create();
+		std::size_t parsed_count{};
+		auto on_request =
+		    [&](std::unique_ptr<http::HTTPRequestMessage> request) {
+			    bench::do_not_optimize(request.get());
+			    parsed_count++;
+		    };
+		const char *fragment_start = entry.raw_bytes.data();
+		for (std::size_t fragment_size : fragments) {
+			io_buffer->appendRawBytes(fragment_start, fragment_size);
+			fragment_start += fragment_size;
+			http::ParseHTTP1_1PipelinedRequests(
+			    io_buffer, current_state, http_message, on_request);
+		}
+		if (parsed_count != entry.message_count) {
+			std::fprintf(stderr, "%s: parsed %zu of %zu requests\n",
+				     entry.name.c_str(), parsed_count,
+				     entry.message_count);
+			std::abort();
+		}
+	};
+	std::size_t allocations_before = bench::allocation_count;
+	parse_once();
+	std::size_t allocations_per_iteration =
+	    bench::allocation_count - allocations_before;
+	std::string name = "parse_request/" + entry.name + "/" + feed_mode;
+	bench::BenchResult result = bench::run_benchmark(
+	    name, iterations, entry.raw_bytes.size(), parse_once);
+	print_summary(result, entry.message_count, allocations_per_iteration);
+}
+
+static void bench_response(const CorpusEntry &entry, const char *feed_mode,
+			   const std::vector<std::size_t> &fragments) {
+	std::unique_ptr<io::IOBuffer<char>> io_buffer =
+	    io::IOBuffer<char>::create(entry.raw_bytes.size() + 1024);
+	std::size_t iterations =
+	    std::max<std::size_t>(corpus_bytes_per_case / entry.raw_bytes.size(),
+				  1);
+	auto parse_once = [&]() {
+		io_buffer->clear();
+		http::ResponseParserState current_state =
+		    http::ResponseParserState::ResponseProtocolH;
+		std::unique_ptr<http::HTTPResponseMessage> http_message =
+		    http::HTTPResponseMessage::create();
+		const char *fragment_start = entry.raw_bytes.data();
+		for (std::size_t fragment_size : fragments) {
+			io_buffer->appendRawBytes(fragment_start, fragment_size);
+			fragment_start += fragment_size;
+			std::size_t consumed_bytes{};
+			http_message = http::ParseHTTP1_1ResponseMessage(
+			    io_buffer, current_state, std::move(http_message),
+			    consumed_bytes);
+			io_buffer->modifyStartOffset(consumed_bytes);
+		}
+		if (current_state != http::ResponseParserState::ParsingDone) {
+			std::fprintf(stderr, "%s: response parser state %d\n",
+				     entry.name.c_str(),
+				     static_cast<int>(current_state));
+			std::abort();
+		}
+		bench::do_not_optimize(http_message.get());
+	};
+	std::size_t allocations_before = bench::allocation_count;
+	parse_once();
+	std::size_t allocations_per_iteration =
+	    bench::allocation_count - allocations_before;
+	std::string name = "parse_response/" + entry.name + "/" + feed_mode;
+	bench::BenchResult result = bench::run_benchmark(
+	    name, iterations, entry.raw_bytes.size(), parse_once);
+	print_summary(result, entry.message_count, allocations_per_iteration);
+}
+
+int main() {
+	std::mt19937 random_engine{42};
+	for (const CorpusEntry &entry : make_request_corpus()) {
+		bench_request(entry, "whole", {entry.raw_bytes.size()});
+		bench_request(
+		    entry, "fragmented",
+		    make_fragments(entry.raw_bytes.size(), random_engine));
+	}
+	for (const CorpusEntry &entry : make_response_corpus()) {
+		bench_response(entry, "whole", {entry.raw_bytes.size()});
+		bench_response(
+		    entry, "fragmented",
+		    make_fragments(entry.raw_bytes.size(), random_engine));
+	}
+	return 0;
+}
@@ -0,0 +1,35 @@
+#include "BenchHelpers.hpp"
+#include "http/HTTPCommonResponseMessageTemplate.hpp"
+#include "io/IOBuffer.hpp"
+#include <memory>
+#include <string>
+
+using namespace blueth;
+
+static constexpr std::size_t iterations = 1'000'000;
+
+int main() {
+	const std::string not_found_body = "<html><body>404 Not Found</body></html>";
+	std::unique_ptr<io::IOBuffer<char>> write_buffer =
+	    io::IOBuffer<char>::create(4096);
+	bench::run_benchmark("HTTPResponseTemplates_message", iterations, 0, [&]() {
+		write_buffer->clear();
+		std::unique_ptr<http::HTTPResponseMessage> message =
+		    http::HTTPResponseTemplates(http::TemplateType::NotFound,
+						not_found_body);
+		message->serializeTo(*write_buffer);
+		bench::do_not_optimize(write_buffer->getDataSize());
+	});
+	http::HTTPDateClock date_clock;
+	http::HTTPResponseTemplate not_found = http::make_response_template(
+	    http::TemplateType::NotFound, not_found_body);
+	bench::run_benchmark("HTTPResponseTemplate_blob", iterations, 0, [&]() {
+		write_buffer->clear();
+		not_found.appendTo(*write_buffer, date_clock);
+		bench::do_not_optimize(write_buffer->getDataSize());
+	});
+	bench::run_benchmark("HTTPDateClock_tick", iterations, 0, [&]() {
+		bench::do_not_optimize(date_clock.tick());
+	});
+	return 0;
+}
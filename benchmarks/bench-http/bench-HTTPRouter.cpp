@@ -0,0 +1,110 @@
+#include "BenchHelpers.hpp"
+#include "http/HTTPRouter.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace blueth;
+
+static constexpr std::size_t iterations = 200'000;
+
+// Routes of one service of the gateway, {} is the service name
+static const std::vector<std::string_view> service_routes{
+    "/api/v1/{}/items",
+    "/api/v1/{}/items/:id",
+    "/api/v1/{}/items/:id/history",
+    "/api/v1/{}/items/:id/tags/:tag",
+    "/api/v1/{}/search",
+    "/api/v2/{}/items/:id",
+    "/api/v2/{}/stats/daily",
+    "/internal/{}/health",
+    "/internal/{}/metrics",
+    "/assets/{}/*path"};
+
+static std::string expand(std::string_view route, std::string_view replacement,
+			  std::string_view placeholder = "{}") {
+	std::string expanded{route};
+	std::size_t position = expanded.find(placeholder);
+	if (position != std::string::npos)
+		expanded.replace(position, placeholder.size(), replacement);
+	return expanded;
+}
+
+// A request path of the route, the captures filled in
+static std::string sample_path(std::string_view route) {
+	std::string path;
+	for (std::size_t index{}; index < route.size(); index++) {
+		if (route[index] == '*') return path + "js/app.3f9c1a2b.min.js";
+		if (route[index] != ':') {
+			path.push_back(route[index]);
+			continue;
+		}
+		while (index + 1 < route.size() && route[index + 1] != '/') index++;
+		path += "8f3e2a1b";
+	}
+	return path;
+}
+
+// Pattern against path a byte at a time, the way a list of routes is scanned
+static bool linear_match(std::string_view pattern, std::string_view path) {
+	std::size_t pattern_index{}, path_index{};
+	while (pattern_index < pattern.size()) {
+		char pattern_char = pattern[pattern_index];
+		if (pattern_char == '*') return true;
+		if (pattern_char == ':') {
+			std::size_t segment_end = path.find('/', path_index);
+			if (segment_end == path_index) return false;
+			path_index = segment_end == std::string_view::npos ? path.size()
+									   : segment_end;
+			while (pattern_index < pattern.size() &&
+			       pattern[pattern_index] != '/')
+				pattern_index++;
+			continue;
+		}
+		if (path_index == path.size() || path[path_index] != pattern_char)
+			return false;
+		pattern_index++;
+		path_index++;
+	}
+	return path_index == path.size();
+}
+
+static void bench_route_count(std::size_t route_count) {
+	std::vector<std::string> routes;
+	for (std::size_t service{}; routes.size() < route_count; service++)
+		for (std::string_view route : service_routes)
+			if (routes.size() < route_count)
+				routes.push_back(
+				    expand(route, "svc" + std::to_string(service)));
+	http::HTTPRouter<std::size_t> router;
+	for (std::size_t index{}; index < routes.size(); index++)
+		router.addRoute(http::HTTPRequestType::Get, routes[index], index);
+	// Requests spread over the whole table
+	std::vector<std::string> paths;
+	for (std::size_t index{}; index < 64; index++)
+		paths.push_back(sample_path(routes[index * 7919 % routes.size()]));
+
+	std::string suffix = "/" + std::to_string(route_count) + "_routes";
+	http::HTTPRouteParams params;
+	bench::run_benchmark("HTTPRouter_findRoute" + suffix, iterations, 0, [&]() {
+		for (const std::string &path : paths)
+			bench::do_not_optimize(router.findRoute(
+			    http::HTTPRequestType::Get, path, params));
+	});
+	bench::run_benchmark("linear_scan" + suffix, iterations / 100, 0, [&]() {
+		for (const std::string &path : paths) {
+			std::size_t route_index{};
+			while (route_index < routes.size() &&
+			       !linear_match(routes[route_index], path))
+				route_index++;
+			bench::do_not_optimize(route_index);
+		}
+	});
+}
+
+int main() {
+	bench_route_count(20);
+	bench_route_count(200);
+	bench_route_count(2000);
+	return 0;
+}
@@ -0,0 +1,153 @@
+#include "BenchHelpers.hpp"
+#include "http/HTTPServer.hpp"
+#include <arpa/inet.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace blueth;
+
+// Requests/second of the HTTPServer over loopback, with a blocking client on
+// the same machine. The client and the server share the CPU, the numbers are
+// for comparing the connection modes and the revisions of the server, not
+// for the absolute throughput.
+static const char *server_address = "127.0.0.1";
+static constexpr std::uint16_t server_port = 9280;
+static constexpr std::size_t requests_per_case = 50000;
+
+static const std::string keep_alive_request =
+    "GET /plaintext HTTP/1.1\r\nHost: localhost\r\nUser-Agent: bench\r\n"
+    "Accept: */*\r\n\r\n";
+static const std::string close_request =
+    "GET /plaintext HTTP/1.1\r\nHost: localhost\r\nUser-Agent: bench\r\n"
+    "Accept: */*\r\nConnection: close\r\n\r\n";
+
+static int connect_client() {
+	int client_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+	int no_delay = 1;
+	::setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &no_delay,
+		     sizeof(no_delay));
+	sockaddr_in server_sockaddr{};
+	server_sockaddr.sin_family = AF_INET;
+	server_sockaddr.sin_port = htons(server_port);
+	::inet_pton(AF_INET, server_address, &server_sockaddr.sin_addr);
+	if (::connect(client_fd, reinterpret_cast<sockaddr *>(&server_sockaddr),
+		      sizeof(server_sockaddr)) < 0) {
+		std::perror("connect");
+		std::abort();
+	}
+	return client_fd;
+}
+
+static void send_all(int client_fd, const std::string &data) {
+	for (std::size_t sent{}; sent < data.size();) {
+		ssize_t send_ret =
+		    ::send(client_fd, data.data() + sent, data.size() - sent, 0);
+		if (send_ret <= 0) {
+			std::perror("send");
+			std::abort();
+		}
+		sent += send_ret;
+	}
+}
+
+/**
+ * Read until response_count responses are received, every response of the
+ * server has the same size. With response_count 0, read to the end of stream.
+ */
+static void receive_responses(int client_fd, std::size_t response_size,
+			      std::size_t response_count) {
+	static char receive_buffer[64 * 1024];
+	std::size_t expected_bytes = response_size * response_count;
+	for (std::size_t received{}; !response_count || received < expected_bytes;) {
+		ssize_t recv_ret =
+		    ::recv(client_fd, receive_buffer, sizeof(receive_buffer), 0);
+		if (recv_ret == 0 && !response_count) return;
+		if (recv_ret <= 0) {
+			std::fprintf(stderr, "connection closed after %zu bytes\n",
+				     received);
+			std::abort();
+		}
+		received += recv_ret;
+	}
+}
+
+static void print_requests_per_second(const bench::BenchResult &result,
+				      std::size_t requests_per_iteration) {
+	std::printf("    %.0f requests/s\n",
+		    1e9 * result.iterations * requests_per_iteration /
+			result.total_ns);
+}
+
+int main() {
+	http::HTTPServerOptions server_options;
+	server_options.max_events = 256;
+	std::unique_ptr<http::HTTPServer> server =
+	    http::HTTPServer::create(server_address, server_port, server_options);
+	server->addHandler(http::HTTPRequestType::Get, "/plaintext",
+			   [](const http::HTTPRequestMessage &,
+			      http::HTTPResponseMessage &response) {
+				   response.addHeader("Content-Type",
+						      "text/plain");
+				   response.pushBackRawBody("Hello, World!");
+			   });
+	std::thread server_thread{[&server]() { server->start(); }};
+
+	// The size of one response, for framing the rest without a parser
+	int client_fd = connect_client();
+	send_all(client_fd, close_request);
+	std::string close_response;
+	char receive_buffer[4096];
+	for (ssize_t recv_ret;
+	     (recv_ret = ::recv(client_fd, receive_buffer, sizeof(receive_buffer),
+				0)) > 0;)
+		close_response.append(receive_buffer, recv_ret);
+	::close(client_fd);
+	// The keep-alive response lacks the "Connection: close\r\n" header
+	std::size_t response_size =
+	    close_response.size() - std::strlen("Connection: close\r\n");
+
+	client_fd = connect_client();
+	bench::BenchResult keep_alive_result = bench::run_benchmark(
+	    "server/keep_alive", requests_per_case, keep_alive_request.size(),
+	    [&]() {
+		    send_all(client_fd, keep_alive_request);
+		    receive_responses(client_fd, response_size, 1);
+	    });
+	print_requests_per_second(keep_alive_result, 1);
+
+	constexpr std::size_t pipeline_depth = 16;
+	std::string pipelined_batch;
+	for (std::size_t request{}; request < pipeline_depth; request++)
+		pipelined_batch += keep_alive_request;
+	bench::BenchResult pipelined_result = bench::run_benchmark(
+	    "server/keep_alive_pipelined_16", requests_per_case / pipeline_depth,
+	    pipelined_batch.size(), [&]() {
+		    send_all(client_fd, pipelined_batch);
+		    receive_responses(client_fd, response_size, pipeline_depth);
+	    });
+	print_requests_per_second(pipelined_result, pipeline_depth);
+	::close(client_fd);
+
+	// A connection per request, limited by the connection setup and by the
+	// client's ports in TIME_WAIT
+	bench::BenchResult close_result = bench::run_benchmark(
+	    "server/connection_per_request", requests_per_case / 10,
+	    close_request.size(), [&]() {
+		    int request_fd = connect_client();
+		    send_all(request_fd, close_request);
+		    receive_responses(request_fd, 0, 0);
+		    ::close(request_fd);
+	    });
+	print_requests_per_second(close_result, 1);
+
+	server->stop();
+	server_thread.join();
+	return 0;
+}
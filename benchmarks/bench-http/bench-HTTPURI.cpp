@@ -0,0 +1,81 @@
+#include "BenchHelpers.hpp"
+#include "http/HTTPURI.hpp"
+#include <string>
+#include <string_view>
+
+using namespace blueth;
+
+static constexpr std::size_t iterations = 2'000'000;
+
+// Byte at a time decoding, the baseline of the vectorized percent_decode
+static bool scalar_percent_decode(std::string_view encoded, std::string &output,
+				  bool plus_as_space) {
+	for (std::size_t index{}; index < encoded.size(); index++) {
+		char value = encoded[index];
+		if (value == '+' && plus_as_space) {
+			output.push_back(' ');
+		} else if (value == '%') {
+			if (index + 2 >= encoded.size()) return false;
+			int hi_nibble = http::hex_digit_value(encoded[index + 1]);
+			int lo_nibble = http::hex_digit_value(encoded[index + 2]);
+			if (hi_nibble < 0 || lo_nibble < 0) return false;
+			output.push_back(static_cast<char>((hi_nibble << 4) | lo_nibble));
+			index += 2;
+		} else {
+			output.push_back(value);
+		}
+	}
+	return true;
+}
+
+static void bench_decode(const char *name, std::string_view encoded,
+			 bool plus_as_space) {
+	std::string storage;
+	storage.reserve(encoded.size());
+	bench::run_benchmark(std::string{"percent_decode_view/"} + name,
+			     iterations, encoded.size(), [&]() {
+				     bench::do_not_optimize(http::percent_decode_view(
+					 encoded, storage, plus_as_space));
+			     });
+	bench::run_benchmark(std::string{"scalar_decode/"} + name, iterations,
+			     encoded.size(), [&]() {
+				     storage.clear();
+				     bench::do_not_optimize(scalar_percent_decode(
+					 encoded, storage, plus_as_space));
+				     bench::do_not_optimize(storage.data());
+			     });
+}
+
+int main() {
+	bench_decode("clean_path", "/static/js/vendor/app.3f9c1a2b4d5e6f.bundle.min.js",
+		     false);
+	bench_decode("encoded_path",
+		     "/files/Annual%20Report%202021/Q4%20%28final%29.pdf", false);
+	bench_decode("form_query",
+		     "q=blueth+http+parser&lang=en-US&filter=%7B%22year%22%3A2021%7D",
+		     true);
+
+	const std::string target =
+	    "/api/v2/search?q=blueth+http&page=3&per_page=50&sort=desc"
+	    "&token=eyJhbGciOiJIUzI1NiJ9.c2lnbmF0dXJl";
+	bench::run_benchmark("uri_view_and_query_lookup", iterations,
+			     target.size(), [&]() {
+				     http::HTTPURIView uri_view =
+					 http::parse_uri_view(target);
+				     bench::do_not_optimize(uri_view.path);
+				     bench::do_not_optimize(
+					 http::HTTPQueryParams{uri_view.query}
+					     .getValue("token"));
+			     });
+	const std::string cookie_header =
+	    "_ga=GA1.2.1234567890.1690000000; _gid=GA1.2.987654321.1690000000; "
+	    "session=eyJ1c2VyIjoiYWxpY2UifQ.c2lnbmF0dXJl; theme=dark; "
+	    "consent=yes; cart=8f3e2a1b9c; ab_test=variant_b";
+	bench::run_benchmark("cookie_lookup", iterations, cookie_header.size(),
+			     [&]() {
+				     bench::do_not_optimize(
+					 http::HTTPCookies{cookie_header}.getValue(
+					     "session"));
+			     });
+	return 0;
+}
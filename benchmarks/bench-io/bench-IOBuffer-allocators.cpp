@@ -0,0 +1,72 @@
+#include "BenchHelpers.hpp"
+#include "io/IOBuffer.hpp"
+#include "utils/simd.hpp"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace blueth;
+
+static constexpr std::size_t relay_buffer_size = 4 * 1024 * 1024;
+
+// A proxy relay buffer filled with HTTP header lines
+static std::string make_relay_payload() {
+	std::string line = "X-Forwarded-For: 10.0.0.1, 10.0.0.2, 10.0.0.3\r\n";
+	std::string returner;
+	returner.reserve(relay_buffer_size);
+	while (returner.size() + line.size() <= relay_buffer_size)
+		returner += line;
+	return returner;
+}
+
+template <typename Allocator>
+static void run_allocator_benchmarks(const char *allocator_name,
+				     const std::string &payload) {
+	io::IOBuffer<char, Allocator> io_buffer{relay_buffer_size};
+	bench::run_benchmark(std::string{"sequential_copy/"} + allocator_name,
+			     200, payload.size(), [&]() {
+				     io_buffer.clear();
+				     io_buffer.appendRawBytes(payload.c_str(),
+							      payload.size());
+				     bench::do_not_optimize(
+					 io_buffer.getDataSize());
+			     });
+	// A parser scan, looking for every line terminator in the relay buffer
+	bench::run_benchmark(
+	    std::string{"parser_scan/"} + allocator_name, 200, payload.size(),
+	    [&]() {
+		    const char *begin = io_buffer.getStartOffsetPointer();
+		    const char *end = io_buffer.getEndOffsetPointer();
+		    std::size_t num_lines{};
+		    while (begin < end) {
+			    begin = simd::find_first_of_either(begin, end, '\n',
+							       '\n');
+			    if (begin != end) num_lines++, begin++;
+		    }
+		    bench::do_not_optimize(num_lines);
+	    });
+	bench::run_benchmark(
+	    std::string{"grow_64k_to_4m/"} + allocator_name, 50,
+	    relay_buffer_size, [&]() {
+		    io::IOBuffer<char, Allocator> growing_buffer{64 * 1024};
+		    for (std::size_t offset{}; offset < payload.size();
+			 offset += 64 * 1024)
+			    growing_buffer.appendRawBytes(
+				payload.c_str() + offset,
+				std::min<std::size_t>(64 * 1024,
+						      payload.size() - offset));
+		    bench::do_not_optimize(growing_buffer.getDataSize());
+	    });
+}
+
+int main() {
+	std::string payload = make_relay_payload();
+	run_allocator_benchmarks<io::IOBufMallocAllocator>("malloc", payload);
+	run_allocator_benchmarks<io::IOBufCacheLineAllocator>("cache_line",
+							      payload);
+	run_allocator_benchmarks<io::IOBufPageAlignedAllocator>("page_aligned",
+								payload);
+	run_allocator_benchmarks<io::IOBufHugePageAllocator>("huge_page",
+							     payload);
+	return 0;
+}
@@ -0,0 +1,63 @@
+#include "BenchHelpers.hpp"
+#include "io/IOBuffer.hpp"
+#include <cstdio>
+#include <string>
+
+using namespace blueth;
+
+static constexpr std::size_t num_small_appends = 100000;
+static constexpr std::size_t small_append_size = 16;
+static constexpr std::size_t num_reads = 20000;
+static constexpr std::size_t read_size = 1500;
+static constexpr std::size_t consume_size = 1400;
+
+static void append_heavy(const char *policy_name,
+			 io::IOBufGrowthPolicy growth_policy) {
+	char chunk[small_append_size];
+	std::memset(chunk, 'a', sizeof(chunk));
+	std::size_t final_capacity{};
+	bench::run_benchmark(
+	    std::string{"append_heavy/"} + policy_name, 20,
+	    num_small_appends * small_append_size, [&]() {
+		    io::IOBuffer<char> io_buffer{64, growth_policy};
+		    for (std::size_t i{}; i < num_small_appends; i++)
+			    io_buffer.appendRawBytes(chunk, sizeof(chunk));
+		    final_capacity = io_buffer.getCapacity();
+		    bench::do_not_optimize(io_buffer.getDataSize());
+	    });
+	std::printf("    final capacity: %zu bytes\n", final_capacity);
+}
+
+// Simulates a long-lived connection's read buffer: every read appends a
+// packet and the parser consumes most of it, leaving a partial message behind
+static void read_consume_heavy(const char *name, std::size_t threshold) {
+	char packet[read_size];
+	std::memset(packet, 'b', sizeof(packet));
+	std::size_t final_capacity{};
+	bench::run_benchmark(std::string{"read_consume/"} + name, 20,
+			     num_reads * read_size, [&]() {
+				     io::IOBuffer<char> io_buffer{4096};
+				     io_buffer.setCompactionThreshold(threshold);
+				     for (std::size_t i{}; i < num_reads; i++) {
+					     io_buffer.appendRawBytes(
+						 packet, sizeof(packet));
+					     io_buffer.modifyStartOffset(
+						 consume_size);
+				     }
+				     final_capacity = io_buffer.getCapacity();
+				     bench::do_not_optimize(
+					 io_buffer.getDataSize());
+			     });
+	std::printf("    final capacity: %zu bytes\n", final_capacity);
+}
+
+int main() {
+	append_heavy("geometric", io::IOBufGrowthPolicy::geometric());
+	append_heavy("capped_64k", io::IOBufGrowthPolicy::capped(64 * 1024));
+	append_heavy("exact", io::IOBufGrowthPolicy::exact());
+	read_consume_heavy("no_compaction", 0);
+	read_consume_heavy("compaction_1k",
+			   io::IOBuffer<char>::default_compaction_threshold);
+	read_consume_heavy("compaction_16k", 16 * 1024);
+	return 0;
+}
@@ -4,7 +4,9 @@
 #include "net/Socket.hpp"
 #include <asm-generic/errno-base.h>
 #include <asm-generic/errno.h>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
@@ -15,6 +17,7 @@
 #include <stdexcept>
 #include <string>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <unistd.h>
 
 #define CAST_TO_PEERSTATEHOLDER_PTR(pointer) ((PeerStateHolder *)(pointer))
@@ -30,6 +33,8 @@ class AsyncEpollEventLoop final
       public:
 	using HandlerCallbackType =
 	    typename EventLoopBase<PeerState>::HandlerCallbackType;
+	using TimerCallbackType =
+	    typename EventLoopBase<PeerState>::TimerCallbackType;
 	template <typename T1, typename T2, typename T3, typename T4,
 		  typename T5>
 	static std::shared_ptr<EventLoopBase<PeerState>>
@@ -46,7 +51,10 @@ class AsyncEpollEventLoop final
 	void
 	registerCallbackForEvent(HandlerCallbackType callback_fn,
 				 EventType event_type) noexcept(false) override;
+	void registerTimerCallback(TimerCallbackType callback,
+				   int interval_ms) noexcept(false) override;
 	void startEventloop() noexcept(false) override;
+	void stopEventloop() noexcept override;
 	int writeToPeer(PeerStateHolder *peer_state_holder,
 			std::shared_ptr<io::IOBuffer<char>>
 			    io_buffer) noexcept(false) override;
@@ -73,10 +81,21 @@ class AsyncEpollEventLoop final
       private:
 	void epollErrorHandler_(int return_code, const char *str) const
 	    noexcept(false);
+	/**
+	 * Invoke the timer callback if its interval elapsed
+	 *
+	 * @return Milliseconds until the next tick, the epoll_wait timeout
+	 */
+	int runTimer_() noexcept(false);
 
       private:
 	net::Socket socket_;
 	int epoll_fd_;
+	PeerStateHolder listen_state_holder_;
+	// Wakes up epoll_wait on stopEventloop
+	int wakeup_fd_;
+	PeerStateHolder wakeup_state_holder_;
+	std::atomic<bool> stop_requested_{false};
 	int timeout_;
 	size_t max_events_supported_;
 	bool epoll_setup_done_{false};
@@ -84,6 +103,9 @@ class AsyncEpollEventLoop final
 	HandlerCallbackType on_accept_callback_;
 	HandlerCallbackType on_read_callback_;
 	HandlerCallbackType on_write_callback_;
+	TimerCallbackType on_timer_callback_;
+	std::chrono::milliseconds timer_interval_{};
+	std::chrono::steady_clock::time_point next_timer_tick_;
 };
 
 template <typename PeerState>
@@ -149,15 +171,22 @@ AsyncEpollEventLoop<PeerState>::AsyncEpollEventLoop(std::string server_address,
 	      net::Domain::Ipv4, net::SockType::Stream},
       max_events_supported_{max_events_supported}, timeout_{timeout} {
 
+	// A restarted server binds while its old connections are in TIME_WAIT
+	socket_.setSocketOption(net::SockOptLevel::SocketLevel,
+				net::SocketOptions::ReuseAddress);
 	socket_.makeSocketNonBlocking();
 	socket_.bindSock();
 	epoll_fd_ = ::epoll_create1(0);
 	epollErrorHandler_(epoll_fd_, "epoll_create1");
 
-	PeerStateHolder *peer_state = new PeerStateHolder();
-	peer_state->setFileDescriptor(socket_.getFileDescriptor());
-	peer_state->setPeerState(new PeerState());
-	epollAddToWatchlist(socket_.getFileDescriptor(), peer_state, EPOLLIN);
+	listen_state_holder_.setFileDescriptor(socket_.getFileDescriptor());
+	listen_state_holder_.setPeerState(nullptr);
+	epollAddToWatchlist(socket_.getFileDescriptor(), &listen_state_holder_,
+			    EPOLLIN);
+	wakeup_fd_ = ::eventfd(0, EFD_NONBLOCK);
+	epollErrorHandler_(wakeup_fd_, "eventfd");
+	wakeup_state_holder_.setFileDescriptor(wakeup_fd_);
+	epollAddToWatchlist(wakeup_fd_, &wakeup_state_holder_, EPOLLIN);
 	events_ =
 	    (epoll_event *)calloc(max_events_supported_, sizeof(epoll_event));
 	if (events_ == nullptr) {
@@ -170,6 +199,7 @@ AsyncEpollEventLoop<PeerState>::AsyncEpollEventLoop(std::string server_address,
 template <typename PeerState>
 AsyncEpollEventLoop<PeerState>::~AsyncEpollEventLoop() {
 	::close(epoll_fd_);
+	::close(wakeup_fd_);
 	::free(events_);
 }
 
@@ -177,9 +207,9 @@ template <typename PeerState>
 void AsyncEpollEventLoop<PeerState>::registerCallbackForEvent(
     HandlerCallbackType callback, EventType event) noexcept(false) {
 	if (event == EventType::ReadEvent) {
-		on_write_callback_ = std::move(callback);
-	} else if (event == EventType::WriteEvent) {
 		on_read_callback_ = std::move(callback);
+	} else if (event == EventType::WriteEvent) {
+		on_write_callback_ = std::move(callback);
 	} else if (event == EventType::AcceptEvent) {
 		on_accept_callback_ = std::move(callback);
 	} else {
@@ -199,9 +229,10 @@ int AsyncEpollEventLoop<PeerState>::writeToPeer(
 		    "Invalid IOBuffer passed onto the writeToPeer handler"};
 	if (!io_buffer->getDataSize()) return 0;
 	std::size_t num_bytes_to_send = io_buffer->getDataSize();
-	int send_ret =
-	    ::send(peer_state_holder->getFileDescriptor(),
-		   io_buffer->getStartOffsetPointer(), num_bytes_to_send, 0);
+	// A peer which closed the connection must not raise SIGPIPE
+	int send_ret = ::send(peer_state_holder->getFileDescriptor(),
+			      io_buffer->getStartOffsetPointer(),
+			      num_bytes_to_send, MSG_NOSIGNAL);
 	if (send_ret < 0) {
 		if (errno == EAGAIN || errno == EWOULDBLOCK) {
 			return 0;
@@ -210,8 +241,8 @@ int AsyncEpollEventLoop<PeerState>::writeToPeer(
 			throw std::runtime_error{""};
 		}
 	}
-	io_buffer->modifyStartOffset(num_bytes_to_send);
-	return num_bytes_to_send;
+	io_buffer->modifyStartOffset(send_ret);
+	return send_ret;
 }
 
 template <typename PeerState>
@@ -221,12 +252,15 @@ int AsyncEpollEventLoop<PeerState>::readFromPeer(
 	if (!io_buffer)
 		throw std::runtime_error{
 		    "Invalid IOBuffer passed onto the readFromPeer handler"};
-	if (!io_buffer->getAvailableSpace()) return 0;
+	if (!io_buffer->getAvailableSpace()) return -1;
 	int recv_ret = ::recv(peer_state_holder->getFileDescriptor(),
-			      io_buffer->getStartOffsetPointer(),
+			      io_buffer->getEndOffsetPointer(),
 			      io_buffer->getAvailableSpace(), 0);
 	if (recv_ret < 0) {
 		if (errno == EAGAIN || errno == EWOULDBLOCK) {
+			return -1;
+		} else if (errno == ECONNRESET) {
+			// Same as the peer closing the connection
 			return 0;
 		} else {
 			std::perror("recv()");
@@ -237,16 +271,54 @@ int AsyncEpollEventLoop<PeerState>::readFromPeer(
 	return recv_ret;
 }
 
+template <typename PeerState>
+void AsyncEpollEventLoop<PeerState>::registerTimerCallback(
+    TimerCallbackType callback, int interval_ms) noexcept(false) {
+	if (interval_ms <= 0)
+		throw std::runtime_error{"Invalid interval for the timer callback"};
+	on_timer_callback_ = std::move(callback);
+	timer_interval_ = std::chrono::milliseconds{interval_ms};
+	next_timer_tick_ = std::chrono::steady_clock::now() + timer_interval_;
+}
+
+template <typename PeerState>
+void AsyncEpollEventLoop<PeerState>::stopEventloop() noexcept {
+	stop_requested_.store(true, std::memory_order_release);
+	std::uint64_t wakeup_count{1};
+	[[maybe_unused]] ssize_t write_ret =
+	    ::write(wakeup_fd_, &wakeup_count, sizeof(wakeup_count));
+}
+
+template <typename PeerState>
+int AsyncEpollEventLoop<PeerState>::runTimer_() noexcept(false) {
+	std::chrono::steady_clock::time_point now =
+	    std::chrono::steady_clock::now();
+	if (now >= next_timer_tick_) {
+		on_timer_callback_();
+		next_timer_tick_ = now + timer_interval_;
+	}
+	return std::chrono::duration_cast<std::chrono::milliseconds>(
+		   next_timer_tick_ - now)
+	    .count();
+}
+
 // clang-format off
 template <typename PeerState>
 void AsyncEpollEventLoop<PeerState>::startEventloop() noexcept(false) {
-	for (;;) {
+	int wait_timeout = on_timer_callback_ ? runTimer_() : timeout_;
+	while (!stop_requested_.load(std::memory_order_acquire)) {
 		int nready =
-		    epoll_wait(epoll_fd_, events_, max_events_supported_, timeout_);
-		if (!nready) break;
+		    epoll_wait(epoll_fd_, events_, max_events_supported_, wait_timeout);
+		if (nready < 0 && errno == EINTR) continue;
+		// Without a timer, the event loop stops when it's idle for timeout_
+		if (!nready && !on_timer_callback_) break;
 		epollErrorHandler_(nready, "epoll_wait");
 		for (int peer_index{}; peer_index < nready; peer_index++) {
-			if (CAST_TO_PEERSTATEHOLDER_PTR(events_[peer_index].data.ptr)->getFileDescriptor() ==
+			if (events_[peer_index].data.ptr == &wakeup_state_holder_) {
+				std::uint64_t wakeup_count;
+				[[maybe_unused]] ssize_t read_ret =
+				    ::read(wakeup_fd_, &wakeup_count, sizeof(wakeup_count));
+			} else if (CAST_TO_PEERSTATEHOLDER_PTR(events_[peer_index].data.ptr)->getFileDescriptor() ==
 			    socket_.getFileDescriptor()) {
 				// New incomming connection
 				// @@@ Currently we only support IPv4 for the event loop
@@ -275,12 +347,21 @@ void AsyncEpollEventLoop<PeerState>::startEventloop() noexcept(false) {
 				std::uint32_t events{};
 				if (fd_status.want_read) events |= EPOLLIN;
 				if (fd_status.want_write) events |= EPOLLOUT;
+				if (!events) {
+					// The peer could not be set up
+					close(client_fd);
+					delete CAST_TO_PEERSTATE_PTR(peer_state->getPeerState());
+					delete peer_state;
+					continue;
+				}
 				struct epoll_event event;
 				event.events = events;
 				event.data.ptr = CAST_TO_VOID_PTR(peer_state);
 				int ret = epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, client_fd, &event);
 				epollErrorHandler_(ret, "epoll_ctl");
-			} else if (events_[peer_index].events & EPOLLIN) {
+			} else if (events_[peer_index].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+				// A hang-up or an error is reported to the read callback, the
+				// read returns the end of the stream or raises the error
 				PeerStateHolder *peer_state = 
 					CAST_TO_PEERSTATEHOLDER_PTR(events_[peer_index].data.ptr);
 				std::shared_ptr<EventLoopBase<PeerState>> ev_loop = this->getSharedPtr();
@@ -314,6 +395,7 @@ void AsyncEpollEventLoop<PeerState>::startEventloop() noexcept(false) {
 				}
 			}
 		}
+		if (on_timer_callback_) wait_timeout = runTimer_();
 	}
 }
 // clang-format on
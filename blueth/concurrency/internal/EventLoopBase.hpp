@@ -98,6 +98,7 @@ template <typename PeerState> class EventLoopBase {
       public:
 	using HandlerCallbackType = std::function<FDStatus(
 	    PeerStateHolder *, std::shared_ptr<EventLoopBase<PeerState>>)>;
+	using TimerCallbackType = std::function<void()>;
 
 	/**
 	 * Register callbacks for various events like when a file descriptor is
@@ -108,10 +109,25 @@ template <typename PeerState> class EventLoopBase {
 	 * function pointer) which should be invoked when a specific event
 	 * happenes.
 	 * @param event_type Register the callback for the specific event.
+	 * The returned FDStatus is the interest of the peer from then on,
+	 * WantNoReadWrite closes the peer and deletes its state(on accept as
+	 * well, before it is ever registered).
 	 */
 	virtual void
 	registerCallbackForEvent(HandlerCallbackType callback,
 				 EventType event_type) noexcept(false) = 0;
+	/**
+	 * Register a callback which is invoked every interval_ms milliseconds
+	 * from the event loop's thread, for the housekeeping like the idle
+	 * timeouts of the peers. With a timer the event loop doesn't stop when
+	 * it's idle for the timeout of the implementation, only on
+	 * stopEventloop.
+	 *
+	 * @param callback The callback function
+	 * @param interval_ms Interval between the invocations
+	 */
+	virtual void registerTimerCallback(TimerCallbackType callback,
+					   int interval_ms) noexcept(false) = 0;
 	/**
 	 * Start the event loop and start processing the requests (assuming all
 	 * the callbacks on the events are already set) If the callbacks are not
@@ -119,10 +135,17 @@ template <typename PeerState> class EventLoopBase {
 	 * std::runtime_error is thrown.
 	 */
 	virtual void startEventloop() noexcept(false) = 0;
+	/**
+	 * Make startEventloop return after the events it is handling, it may be
+	 * called from any thread
+	 */
+	virtual void stopEventloop() noexcept = 0;
 	/**
 	 * Write the data in the io_buffer into the remote peer pointed by
 	 * peer_fd in a non-blocking way on wire. Returns the amount of bytes
-	 * written and raises an exception on failur.
+	 * written and raises an exception on failur. The written bytes are
+	 * consumed from the io_buffer, a partial write leaves the rest of the
+	 * data in it.
 	 *
 	 * @param peer_state_holder PeerStateHolder object which contains all
 	 * the context information for the write handler to send byte onto the
@@ -142,12 +165,17 @@ template <typename PeerState> class EventLoopBase {
 	 * than the size of the buffer, they must manually resize the IOBuffer
 	 * on their end.
 	 *
+	 * The bytes are appended after the data which is already in the
+	 * io_buffer.
+	 *
 	 * @param peer_state_holder PeerStateHolder object which contains all
 	 * the context information needed for reading bytes off the non-blocking
 	 * socket of the remote peer
 	 * @param io_buffer Pointer to IOBuffer object to store the read bytes
 	 * from the wire in-place
-	 * @return Total number of bytes read from the remote peer
+	 * @return Total number of bytes read from the remote peer, 0 when the
+	 * peer closed the connection and -1 when nothing could be read(the
+	 * socket would block or the io_buffer has no space)
 	 */
 	virtual int readFromPeer(
 	    PeerStateHolder *peer_state_holder, std::shared_ptr<io::IOBuffer<char>> io_buffer) noexcept(false) = 0;
@@ -0,0 +1,318 @@
+#pragma once
+#include "HTTPConstants.hpp"
+#include "HTTPParserCommon.hpp"
+#include "common.hpp"
+#include "io/IOBufChain.hpp"
+#include "io/IOBufSlice.hpp"
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <memory>
+
+// clang-format off
+/* Codec for the chunked transfer-coding(RFC 7230 4.1)
+ *
+ *    chunked-body = *chunk last-chunk trailer-part CRLF
+ *    chunk        = chunk-size [ chunk-ext ] CRLF chunk-data CRLF
+ *    last-chunk   = 1*("0") [ chunk-ext ] CRLF
+ *
+ *    "5\r\nhello\r\n" "6;ext=1\r\n world\r\n" "0\r\n" "Trailer: x\r\n" "\r\n"
+ *                ^^^^^               ^^^^^^
+ *                 sink("hello")       sink(" world")
+ *
+ * HTTPChunkedDecoder is resumable like the message parsers: it keeps its state between the reads and hands the
+ * chunk-data to a body sink as a (pointer, size) run straight out of the receive buffer, so the decoded body is
+ * never buffered by the codec. The encoder frames a chunk around the caller's bytes.
+ */
+// clang-format on
+
+namespace blueth::http {
+
+class HTTPChunkedDecoder {
+      public:
+	// Chunk sizes are limited to 15 hex digits so the size can't overflow
+	static constexpr std::size_t max_chunk_size_digits = 15;
+
+	HTTPChunkedDecoder() = default;
+	/**
+	 * Decode the chunked body in [start_buffer, end_buffer).
+	 * body_sink(const char *data, std::size_t size) is invoked with every run
+	 * of chunk-data.
+	 *
+	 * The decoder stops right after the CRLF which ends the trailer-part,
+	 * the bytes after it belong to the next message.
+	 *
+	 * @return State of the decoder and the number of consumed bytes
+	 */
+	template <typename BodySink>
+	HTTPParseResult<ChunkedDecoderState>
+	decode(const char *start_buffer, const char *end_buffer,
+	       BodySink &&body_sink);
+	/**
+	 * Decode the data region of an io::IOBuffer(or any buffer with the same
+	 * offset API), the buffer's offsets are not modified
+	 */
+	template <typename BufferType, typename BodySink>
+	HTTPParseResult<ChunkedDecoderState>
+	decode(const std::unique_ptr<BufferType> &chunked_body,
+	       BodySink &&body_sink);
+	/**
+	 * Decoding stops with BodyTooLarge as soon as a chunk-size line takes the
+	 * body past max_body_size, before the chunk-data is read
+	 */
+	BLUETH_FORCE_INLINE void setMaxBodySize(std::size_t max_body_size) noexcept;
+	/**
+	 * Sum of the chunk sizes seen so far
+	 */
+	BLUETH_FORCE_INLINE std::size_t getDecodedSize() const noexcept;
+	BLUETH_FORCE_INLINE ChunkedDecoderState getState() const noexcept;
+	BLUETH_FORCE_INLINE bool isDone() const noexcept;
+	/**
+	 * Prepare the decoder for the next chunked body, the maximum body size is
+	 * kept
+	 */
+	void reset() noexcept;
+
+      private:
+	ChunkedDecoderState current_state_{ChunkedDecoderState::ChunkSize};
+	std::size_t chunk_remaining_{};
+	std::size_t chunk_size_digits_{};
+	std::size_t decoded_size_{};
+	std::size_t max_body_size_{std::numeric_limits<std::size_t>::max()};
+};
+
+template <typename BodySink>
+inline HTTPParseResult<ChunkedDecoderState>
+HTTPChunkedDecoder::decode(const char *start_buffer, const char *end_buffer,
+			   BodySink &&body_sink) {
+	const char *const decode_start = start_buffer;
+	while (start_buffer != end_buffer) {
+		switch (current_state_) {
+		case ChunkedDecoderState::ChunkSize: {
+			int digit = hex_digit_value(*start_buffer);
+			if (digit >= 0 &&
+			    chunk_size_digits_ < max_chunk_size_digits) {
+				chunk_remaining_ = chunk_remaining_ * 16 + digit;
+				chunk_size_digits_++;
+				start_buffer++;
+			} else if (digit < 0 && chunk_size_digits_ &&
+				   *start_buffer == ';') {
+				current_state_ =
+				    ChunkedDecoderState::ChunkExtension;
+				start_buffer++;
+			} else if (digit < 0 && chunk_size_digits_ &&
+				   *start_buffer ==
+				       static_cast<char>(LexConsts::CR)) {
+				current_state_ = ChunkedDecoderState::ChunkSizeLF;
+				start_buffer++;
+			} else {
+				current_state_ =
+				    ChunkedDecoderState::ProtocolError;
+			}
+			break;
+		}
+		case ChunkedDecoderState::ChunkExtension: {
+			// The chunk extensions are ignored
+			const char *cr = static_cast<const char *>(
+			    ::memchr(start_buffer, static_cast<int>(LexConsts::CR),
+				     end_buffer - start_buffer));
+			if (cr == nullptr) {
+				start_buffer = end_buffer;
+			} else {
+				current_state_ = ChunkedDecoderState::ChunkSizeLF;
+				start_buffer = cr + 1;
+			}
+			break;
+		}
+		case ChunkedDecoderState::ChunkSizeLF:
+			if (*start_buffer == static_cast<char>(LexConsts::LF)) {
+				if (chunk_remaining_ > max_body_size_ - decoded_size_) {
+					current_state_ =
+					    ChunkedDecoderState::BodyTooLarge;
+					break;
+				}
+				decoded_size_ += chunk_remaining_;
+				current_state_ =
+				    chunk_remaining_
+					? ChunkedDecoderState::ChunkData
+					: ChunkedDecoderState::TrailerBegin;
+				chunk_size_digits_ = 0;
+				start_buffer++;
+			} else {
+				current_state_ =
+				    ChunkedDecoderState::ProtocolError;
+			}
+			break;
+		case ChunkedDecoderState::ChunkData: {
+			std::size_t data_size = std::min<std::size_t>(
+			    chunk_remaining_, end_buffer - start_buffer);
+			body_sink(start_buffer, data_size);
+			start_buffer += data_size;
+			chunk_remaining_ -= data_size;
+			if (!chunk_remaining_)
+				current_state_ = ChunkedDecoderState::ChunkDataCR;
+			break;
+		}
+		case ChunkedDecoderState::ChunkDataCR:
+			if (*start_buffer == static_cast<char>(LexConsts::CR)) {
+				current_state_ = ChunkedDecoderState::ChunkDataLF;
+				start_buffer++;
+			} else {
+				current_state_ =
+				    ChunkedDecoderState::ProtocolError;
+			}
+			break;
+		case ChunkedDecoderState::ChunkDataLF:
+			if (*start_buffer == static_cast<char>(LexConsts::LF)) {
+				current_state_ = ChunkedDecoderState::ChunkSize;
+				start_buffer++;
+			} else {
+				current_state_ =
+				    ChunkedDecoderState::ProtocolError;
+			}
+			break;
+		case ChunkedDecoderState::TrailerBegin:
+			if (*start_buffer == static_cast<char>(LexConsts::CR)) {
+				current_state_ =
+				    ChunkedDecoderState::TrailerEndLF;
+				start_buffer++;
+			} else {
+				current_state_ =
+				    ChunkedDecoderState::TrailerField;
+			}
+			break;
+		case ChunkedDecoderState::TrailerField: {
+			// The trailer fields are skipped
+			const char *cr = static_cast<const char *>(
+			    ::memchr(start_buffer, static_cast<int>(LexConsts::CR),
+				     end_buffer - start_buffer));
+			if (cr == nullptr) {
+				start_buffer = end_buffer;
+			} else {
+				current_state_ =
+				    ChunkedDecoderState::TrailerFieldLF;
+				start_buffer = cr + 1;
+			}
+			break;
+		}
+		case ChunkedDecoderState::TrailerFieldLF:
+			if (*start_buffer == static_cast<char>(LexConsts::LF)) {
+				current_state_ =
+				    ChunkedDecoderState::TrailerBegin;
+				start_buffer++;
+			} else {
+				current_state_ =
+				    ChunkedDecoderState::ProtocolError;
+			}
+			break;
+		case ChunkedDecoderState::TrailerEndLF:
+			if (*start_buffer == static_cast<char>(LexConsts::LF)) {
+				current_state_ =
+				    ChunkedDecoderState::DecodingDone;
+				start_buffer++;
+			} else {
+				current_state_ =
+				    ChunkedDecoderState::ProtocolError;
+			}
+			break;
+		case ChunkedDecoderState::DecodingDone:
+			goto FINISH;
+		case ChunkedDecoderState::ProtocolError:
+			goto FINISH;
+		case ChunkedDecoderState::BodyTooLarge:
+			goto FINISH;
+		}
+	}
+FINISH:
+	return {current_state_,
+		static_cast<std::size_t>(start_buffer - decode_start)};
+}
+
+template <typename BufferType, typename BodySink>
+inline HTTPParseResult<ChunkedDecoderState>
+HTTPChunkedDecoder::decode(const std::unique_ptr<BufferType> &chunked_body,
+			   BodySink &&body_sink) {
+	return decode(chunked_body->getStartOffsetPointer(),
+		      chunked_body->getStartOffsetPointer() +
+			  chunked_body->getDataSize(),
+		      std::forward<BodySink>(body_sink));
+}
+
+BLUETH_FORCE_INLINE inline ChunkedDecoderState
+HTTPChunkedDecoder::getState() const noexcept {
+	return current_state_;
+}
+
+BLUETH_FORCE_INLINE inline bool HTTPChunkedDecoder::isDone() const noexcept {
+	return current_state_ == ChunkedDecoderState::DecodingDone;
+}
+
+BLUETH_FORCE_INLINE inline void
+HTTPChunkedDecoder::setMaxBodySize(std::size_t max_body_size) noexcept {
+	max_body_size_ = max_body_size;
+}
+
+BLUETH_FORCE_INLINE inline std::size_t
+HTTPChunkedDecoder::getDecodedSize() const noexcept {
+	return decoded_size_;
+}
+
+inline void HTTPChunkedDecoder::reset() noexcept {
+	current_state_ = ChunkedDecoderState::ChunkSize;
+	chunk_remaining_ = 0;
+	chunk_size_digits_ = 0;
+	decoded_size_ = 0;
+}
+
+/**
+ * Append a chunk(size line, data and CRLF) to output_buffer. output_buffer is
+ * any buffer with appendRawBytes(data, size): io::IOBuffer,
+ * io::InlineIOBuffer, io::IOBufChain. An empty chunk is not written, since it
+ * would end the chunked body.
+ *
+ * @param output_buffer Buffer to be written into
+ * @param data Chunk data
+ * @param size Size of the chunk data
+ */
+template <typename BufferType>
+inline void EncodeHTTPChunk(BufferType &output_buffer, const char *data,
+			    std::size_t size) noexcept(false) {
+	if (!size) return;
+	// Max 16 hex digits of size_t and the CRLF
+	char size_line[18];
+	char *size_end =
+	    std::to_chars(size_line, size_line + 16, size, 16).ptr;
+	*size_end++ = static_cast<char>(LexConsts::CR);
+	*size_end++ = static_cast<char>(LexConsts::LF);
+	output_buffer.appendRawBytes(size_line, size_end - size_line);
+	output_buffer.appendRawBytes(data, size);
+	output_buffer.appendRawBytes("\r\n", 2);
+}
+
+/**
+ * Append a shared slice as a chunk without copying the chunk data, only the
+ * size line and the CRLF are written into the chain
+ */
+inline void EncodeHTTPChunk(io::IOBufChain<char> &output_chain,
+			    const io::IOBufSlice<char> &chunk) noexcept(false) {
+	if (chunk.empty()) return;
+	char size_line[18];
+	char *size_end =
+	    std::to_chars(size_line, size_line + 16, chunk.size(), 16).ptr;
+	*size_end++ = static_cast<char>(LexConsts::CR);
+	*size_end++ = static_cast<char>(LexConsts::LF);
+	output_chain.appendRawBytes(size_line, size_end - size_line);
+	output_chain.append(chunk);
+	output_chain.appendRawBytes("\r\n", 2);
+}
+
+/**
+ * Append the last-chunk and an empty trailer-part, which ends the chunked body
+ */
+template <typename BufferType>
+inline void EncodeHTTPLastChunk(BufferType &output_buffer) noexcept(false) {
+	output_buffer.appendRawBytes("0\r\n\r\n", 5);
+}
+
+} // namespace blueth::http
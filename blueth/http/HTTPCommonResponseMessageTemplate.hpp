@@ -1,12 +1,181 @@
 #pragma once
 #include "HTTPConstants.hpp"
 #include "HTTPMessage.hpp"
-#include "utils/UnixTime.hpp"
+#include "common.hpp"
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <ctime>
 #include <memory>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+
+// clang-format off
+/* Canned responses(404, 400, ...) are pre-rendered once into an immutable blob, sending one is a copy of the
+ * bytes: there is no message object, no header insert and no number formatting per response.
+ *
+ *    HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nDate: Tue, 20 Jul 2021 10:00:00 GMT\r\n\r\n
+ *                                                      ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^
+ *                                                      date slot, patched from HTTPDateClock
+ *
+ * The only part which changes is the Date header. An HTTPDateClock(one per event loop, or a global one) renders
+ * the date of the current second when it's ticked, and a template copies the 29 bytes into its date slot the
+ * first time it's sent in a new second.
+ */
+// clang-format on
 
 namespace blueth::http {
 
+/**
+ * Write the IMF-fixdate(RFC 7231 7.1.1.1) of unix_time, for example
+ * "Sun, 06 Nov 1994 08:49:37 GMT", at destination
+ */
+inline void format_imf_fixdate(std::time_t unix_time,
+			       char *destination) noexcept {
+	static constexpr std::string_view day_names = "SunMonTueWedThuFriSat";
+	static constexpr std::string_view month_names =
+	    "JanFebMarAprMayJunJulAugSepOctNovDec";
+	std::tm time_struct;
+	::gmtime_r(&unix_time, &time_struct);
+	auto write_two_digits = [&destination](int value) {
+		*destination++ = static_cast<char>('0' + value / 10);
+		*destination++ = static_cast<char>('0' + value % 10);
+	};
+	std::memcpy(destination, day_names.data() + time_struct.tm_wday * 3, 3);
+	destination += 3;
+	*destination++ = ',';
+	*destination++ = ' ';
+	write_two_digits(time_struct.tm_mday);
+	*destination++ = ' ';
+	std::memcpy(destination, month_names.data() + time_struct.tm_mon * 3, 3);
+	destination += 3;
+	*destination++ = ' ';
+	int year = time_struct.tm_year + 1900;
+	write_two_digits(year / 100);
+	write_two_digits(year % 100);
+	*destination++ = ' ';
+	write_two_digits(time_struct.tm_hour);
+	*destination++ = ':';
+	write_two_digits(time_struct.tm_min);
+	*destination++ = ':';
+	write_two_digits(time_struct.tm_sec);
+	std::memcpy(destination, " GMT", 4);
+}
+
+/**
+ * Date header value of the current second. It's rendered by tick(), at most
+ * once per second, the responses only copy it.
+ */
+class HTTPDateClock {
+      public:
+	static constexpr std::size_t date_size = 29;
+
+	HTTPDateClock() noexcept { tick(); }
+	/**
+	 * Re-render the date if the second has changed
+	 *
+	 * @param now Current unix time
+	 * @return true if the date changed
+	 */
+	BLUETH_FORCE_INLINE bool tick(std::time_t now = std::time(nullptr)) noexcept {
+		if (now == current_second_) return false;
+		format_imf_fixdate(now, date_.data());
+		current_second_ = now;
+		return true;
+	}
+	BLUETH_FORCE_INLINE std::string_view getDate() const noexcept {
+		return {date_.data(), date_.size()};
+	}
+	BLUETH_FORCE_INLINE std::time_t getSecond() const noexcept {
+		return current_second_;
+	}
+
+      private:
+	std::time_t current_second_{-1};
+	std::array<char, date_size> date_{};
+};
+
+/**
+ * A response serialized once, with a Date header which is patched in place
+ */
+class HTTPResponseTemplate {
+      public:
+	HTTPResponseTemplate() = default;
+	/**
+	 * Render the message and append a Date header to it, the message must
+	 * not have one. Throws std::invalid_argument if the message can't be
+	 * serialized(see HTTPResponseMessage::buildRawMessage).
+	 */
+	explicit HTTPResponseTemplate(const HTTPResponseMessage &message) noexcept(false);
+	/**
+	 * Copy the date of the clock into the Date header, if the template was
+	 * not patched in the clock's current second yet
+	 */
+	BLUETH_FORCE_INLINE void
+	refreshDate(const HTTPDateClock &date_clock) noexcept;
+	BLUETH_FORCE_INLINE std::string_view getBytes() const noexcept;
+	/**
+	 * The bytes with a fresh Date header, what is sent to a peer
+	 */
+	BLUETH_FORCE_INLINE std::string_view
+	getBytes(const HTTPDateClock &date_clock) noexcept;
+	/**
+	 * Append the bytes with a fresh Date header to io_buffer
+	 */
+	template <typename BufferType>
+	BLUETH_FORCE_INLINE void
+	appendTo(BufferType &io_buffer,
+		 const HTTPDateClock &date_clock) noexcept(false);
+
+      private:
+	std::string raw_bytes_;
+	std::size_t date_offset_{};
+	std::time_t date_second_{-1};
+};
+
+inline HTTPResponseTemplate::HTTPResponseTemplate(
+    const HTTPResponseMessage &message) noexcept(false)
+    : raw_bytes_{message.buildRawMessage()} {
+	if (raw_bytes_.empty())
+		throw std::invalid_argument{
+		    "HTTPResponseTemplate: the message can't be serialized"};
+	// The header is inserted before the CRLF which ends the header section
+	std::size_t header_end = message.rawHeadSize() - 2;
+	std::string date_header = "Date: ";
+	date_header.append(HTTPDateClock::date_size, ' ');
+	date_header += "\r\n";
+	raw_bytes_.insert(header_end, date_header);
+	date_offset_ = header_end + 6;
+}
+
+BLUETH_FORCE_INLINE inline void
+HTTPResponseTemplate::refreshDate(const HTTPDateClock &date_clock) noexcept {
+	if (date_second_ == date_clock.getSecond()) return;
+	std::memcpy(raw_bytes_.data() + date_offset_, date_clock.getDate().data(),
+		    HTTPDateClock::date_size);
+	date_second_ = date_clock.getSecond();
+}
+
+BLUETH_FORCE_INLINE inline std::string_view
+HTTPResponseTemplate::getBytes() const noexcept {
+	return raw_bytes_;
+}
+
+BLUETH_FORCE_INLINE inline std::string_view
+HTTPResponseTemplate::getBytes(const HTTPDateClock &date_clock) noexcept {
+	refreshDate(date_clock);
+	return raw_bytes_;
+}
+
+template <typename BufferType>
+BLUETH_FORCE_INLINE inline void
+HTTPResponseTemplate::appendTo(BufferType &io_buffer,
+			       const HTTPDateClock &date_clock) noexcept(false) {
+	refreshDate(date_clock);
+	io_buffer.appendRawBytes(raw_bytes_.data(), raw_bytes_.size());
+}
+
 // We will add more, if needed
 enum class TemplateType {
 	Ok,
@@ -21,105 +190,79 @@ enum class TemplateType {
 	Unauthorized
 };
 
+// Indexed by TemplateType
+static constexpr std::array<HTTPResponseCodes, 10> template_response_codes{
+    HTTPResponseCodes::Ok,
+    HTTPResponseCodes::BadRequest,
+    HTTPResponseCodes::NotFound,
+    HTTPResponseCodes::Forbidden,
+    HTTPResponseCodes::NotAcceptable,
+    HTTPResponseCodes::MethodNotAllowed,
+    HTTPResponseCodes::UnsupportedMediaType,
+    HTTPResponseCodes::Created,
+    HTTPResponseCodes::MovedPermanently,
+    HTTPResponseCodes::Unauthorized};
+
+/**
+ * Fill an empty message with the status, headers and body of a template type,
+ * without a Date header
+ *
+ * @param http_message_body The body, or the challenge of the WWW-Authenticate
+ * header for TemplateType::Unauthorized
+ */
+inline void
+fill_template_message(HTTPResponseMessage &message, TemplateType type,
+		      std::string http_message_body) noexcept(false) {
+	message.setHTTPVersion(HTTPVersion::HTTP1_1);
+	message.setResponseCode(
+	    template_response_codes[static_cast<std::size_t>(type)]);
+	message.addHeader(HTTPHeaderID::ContentType, "text/html");
+	if (type == TemplateType::Unauthorized) {
+		message.addHeader(HTTPHeaderID::ContentLength, "0");
+		message.addHeader(HTTPHeaderID::WWWAuthenticate,
+				  std::move(http_message_body));
+		return;
+	}
+	message.addHeader(HTTPHeaderID::ContentLength,
+			  std::to_string(http_message_body.size()));
+	message.pushBackRawBody(std::move(http_message_body));
+}
+
 inline std::unique_ptr<HTTPResponseMessage>
 HTTPResponseTemplates(const TemplateType &type, std::string http_message_body) {
 	std::unique_ptr<HTTPResponseMessage> message =
 	    HTTPResponseMessage::create();
-	switch (type) {
-	case TemplateType::Ok:
-		message->setHTTPVersion(HTTPVersion::HTTP1_1);
-		message->setResponseCode(HTTPResponseCodes::Ok);
-		message->addHeader("Content-Type", "text/html");
-		message->addHeader("Content-Length",
-				   std::to_string(http_message_body.size()));
-		message->addHeader("Date", UnixTime{}.getStringTime());
-		message->pushBackRawBody(std::move(http_message_body));
-		break;
-	case TemplateType::BadRequest:
-		message->setHTTPVersion(HTTPVersion::HTTP1_1);
-		message->setResponseCode(HTTPResponseCodes::BadRequest);
-		message->addHeader("Content-Type", "text/html");
-		message->addHeader("Content-Length",
-				   std::to_string(http_message_body.size()));
-		message->addHeader("Date", UnixTime{}.getStringTime());
-		message->pushBackRawBody(std::move(http_message_body));
-		break;
-	case TemplateType::UnsupportedMediaType:
-		message->setHTTPVersion(HTTPVersion::HTTP1_1);
-		message->setResponseCode(
-		    HTTPResponseCodes::UnsupportedMediaType);
-		message->addHeader("Content-Type", "text/html");
-		message->addHeader("Content-Length",
-				   std::to_string(http_message_body.size()));
-		message->addHeader("Date", UnixTime{}.getStringTime());
-		message->pushBackRawBody(std::move(http_message_body));
-		break;
-	case TemplateType::Created:
-		message->setHTTPVersion(HTTPVersion::HTTP1_1);
-		message->setResponseCode(HTTPResponseCodes::Created);
-		message->addHeader("Content-Type", "text/html");
-		message->addHeader("Content-Length",
-				   std::to_string(http_message_body.size()));
-		message->addHeader("Date", UnixTime{}.getStringTime());
-		message->pushBackRawBody(std::move(http_message_body));
-		break;
-	case TemplateType::Forbidden:
-		message->setHTTPVersion(HTTPVersion::HTTP1_1);
-		message->setResponseCode(HTTPResponseCodes::Forbidden);
-		message->addHeader("Content-Type", "text/html");
-		message->addHeader("Content-Length",
-				   std::to_string(http_message_body.size()));
-		message->addHeader("Date", UnixTime{}.getStringTime());
-		message->pushBackRawBody(std::move(http_message_body));
-		break;
-	case TemplateType::MethodNotAllowed:
-		message->setHTTPVersion(HTTPVersion::HTTP1_1);
-		message->setResponseCode(HTTPResponseCodes::MethodNotAllowed);
-		message->addHeader("Content-Type", "text/html");
-		message->addHeader("Content-Length",
-				   std::to_string(http_message_body.size()));
-		message->addHeader("Date", UnixTime{}.getStringTime());
-		message->pushBackRawBody(std::move(http_message_body));
-		break;
-	case TemplateType::MovedPermanently:
-		message->setHTTPVersion(HTTPVersion::HTTP1_1);
-		message->setResponseCode(HTTPResponseCodes::MovedPermanently);
-		message->addHeader("Content-Type", "text/html");
-		message->addHeader("Content-Length",
-				   std::to_string(http_message_body.size()));
-		message->addHeader("Date", UnixTime{}.getStringTime());
-		message->pushBackRawBody(std::move(http_message_body));
-		break;
-	case TemplateType::NotFound:
-		message->setHTTPVersion(HTTPVersion::HTTP1_1);
-		message->setResponseCode(HTTPResponseCodes::NotFound);
-		message->addHeader("Content-Type", "text/html");
-		message->addHeader("Content-Length",
-				   std::to_string(http_message_body.size()));
-		message->addHeader("Date", UnixTime{}.getStringTime());
-		message->pushBackRawBody(std::move(http_message_body));
-		break;
-	case TemplateType::Unauthorized:
-		message->setHTTPVersion(HTTPVersion::HTTP1_1);
-		message->setResponseCode(HTTPResponseCodes::BadRequest);
-		message->addHeader("Content-Type", "text/html");
-		message->addHeader("Content-Length",
-				   std::to_string(http_message_body.size()));
-		message->addHeader("Date", UnixTime{}.getStringTime());
-		message->addHeader("WWW-Authenticate",
-				   std::move(http_message_body));
-		break;
-	case TemplateType::NotAcceptable:
-		message->setHTTPVersion(HTTPVersion::HTTP1_1);
-		message->setResponseCode(HTTPResponseCodes::NotAcceptable);
-		message->addHeader("Content-Type", "text/html");
-		message->addHeader("Content-Length",
-				   std::to_string(http_message_body.size()));
-		message->addHeader("Date", UnixTime{}.getStringTime());
-		message->pushBackRawBody(std::move(http_message_body));
-		break;
-	}
+	fill_template_message(*message, type, std::move(http_message_body));
+	message->addHeader(HTTPHeaderID::Date,
+			   std::string{HTTPDateClock{}.getDate()});
 	return message;
 }
 
+/**
+ * Pre-rendered HTTPResponseTemplates(type, http_message_body)
+ */
+inline HTTPResponseTemplate
+make_response_template(TemplateType type,
+		       std::string http_message_body) noexcept(false) {
+	HTTPResponseMessage message;
+	fill_template_message(message, type, std::move(http_message_body));
+	return HTTPResponseTemplate{message};
+}
+
+/**
+ * Pre-rendered response with an empty body, with "Connection: close" if
+ * connection_close
+ */
+inline HTTPResponseTemplate
+make_empty_response_template(HTTPResponseCodes response_code,
+			     bool connection_close) noexcept(false) {
+	HTTPResponseMessage response;
+	response.setHTTPVersion(HTTPVersion::HTTP1_1);
+	response.setResponseCode(response_code);
+	response.addHeader(HTTPHeaderID::ContentLength, "0");
+	if (connection_close)
+		response.addHeader(HTTPHeaderID::Connection, "close");
+	return HTTPResponseTemplate{response};
+}
+
 } // namespace blueth::http
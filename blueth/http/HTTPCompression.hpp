@@ -0,0 +1,481 @@
+#pragma once
+#include "HTTPConstants.hpp"
+#include "HTTPParserCommon.hpp"
+#include "common.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <list>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <zlib.h>
+
+// clang-format off
+/* Compression of the response bodies(RFC 7231 3.1.2.2, 5.3.4) with zlib
+ *
+ *    Accept-Encoding: gzip;q=1.0, deflate;q=0.5 ---> negotiate_content_coding() ---> HTTPContentCoding::Gzip
+ *
+ *    body chunk ---> HTTPCompressor::compress() ---+---> appendRawBytes(output buffer)
+ *    body chunk ---> HTTPCompressor::compress() ---+
+ *                    HTTPCompressor::finish()   ---+     (gzip trailer)
+ *
+ * HTTPCompressor streams: every chunk is deflated through a fixed staging area into any buffer with
+ * appendRawBytes(data, size)(io::IOBuffer, io::InlineIOBuffer, io::IOBufChain), a body is never held whole by the
+ * compressor. reset() re-arms it for the next body without re-allocating the zlib state.
+ *
+ * HTTPCompressedVariantCache keeps the compressed variants of the bodies which are sent again and again(static
+ * assets, pre-rendered pages) keyed by a hash of their content, so a hot asset is compressed once.
+ */
+// clang-format on
+
+namespace blueth::http {
+
+enum class HTTPContentCoding { Identity, Gzip, Deflate };
+
+/**
+ * Content-Encoding value of the coding, empty for Identity
+ */
+BLUETH_FORCE_INLINE constexpr static std::string_view
+content_coding_name(HTTPContentCoding content_coding) noexcept {
+	switch (content_coding) {
+	case HTTPContentCoding::Gzip:
+		return "gzip";
+	case HTTPContentCoding::Deflate:
+		return "deflate";
+	default:
+		return "";
+	}
+}
+
+struct HTTPCompressionPolicy {
+	// zlib level, 1(fastest) to 9(smallest)
+	int level{6};
+	// Smaller bodies are sent as they are, the framing of the compressed
+	// stream costs more than it saves
+	std::size_t min_size{1024};
+	// Bytes of compressed variants kept by an HTTPCompressedVariantCache
+	std::size_t variant_cache_size{16 * 1024 * 1024};
+};
+
+/**
+ * Quality value(RFC 7231 5.3.1) in thousandths, -1 if it's malformed
+ */
+BLUETH_FORCE_INLINE constexpr static int
+parse_quality_value(std::string_view qvalue) noexcept {
+	if (qvalue.empty() || (qvalue[0] != '0' && qvalue[0] != '1')) return -1;
+	int quality = (qvalue[0] - '0') * 1000;
+	if (qvalue.size() == 1) return quality;
+	if (qvalue[1] != '.' || qvalue.size() > 5) return -1;
+	int scale = 100;
+	for (std::size_t index = 2; index < qvalue.size(); index++, scale /= 10) {
+		if (qvalue[index] < '0' || qvalue[index] > '9') return -1;
+		quality += (qvalue[index] - '0') * scale;
+	}
+	return quality > 1000 ? -1 : quality;
+}
+
+/**
+ * Pick the coding of the response from the Accept-Encoding value, gzip is
+ * preferred when both codings are equally acceptable
+ */
+inline HTTPContentCoding
+negotiate_content_coding(std::string_view accept_encoding) noexcept {
+	// -1 until the coding is listed
+	int gzip_quality = -1, deflate_quality = -1, wildcard_quality = -1;
+	while (!accept_encoding.empty()) {
+		std::size_t comma = accept_encoding.find(',');
+		std::string_view element = accept_encoding.substr(0, comma);
+		accept_encoding.remove_prefix(comma == std::string_view::npos
+						  ? accept_encoding.size()
+						  : comma + 1);
+		std::size_t semicolon = element.find(';');
+		std::string_view coding = trim_ows(element.substr(0, semicolon));
+		int quality = 1000;
+		if (semicolon != std::string_view::npos) {
+			std::string_view parameter =
+			    trim_ows(element.substr(semicolon + 1));
+			if (parameter.size() < 2 ||
+			    to_lower_ascii(parameter[0]) != 'q' || parameter[1] != '=')
+				continue;
+			quality = parse_quality_value(parameter.substr(2));
+			if (quality < 0) continue;
+		}
+		if (case_insensitive_equal(coding, "gzip") ||
+		    case_insensitive_equal(coding, "x-gzip"))
+			gzip_quality = std::max(gzip_quality, quality);
+		else if (case_insensitive_equal(coding, "deflate"))
+			deflate_quality = std::max(deflate_quality, quality);
+		else if (coding == "*")
+			wildcard_quality = std::max(wildcard_quality, quality);
+	}
+	// "*" covers the codings which are not listed
+	if (gzip_quality < 0) gzip_quality = wildcard_quality;
+	if (deflate_quality < 0) deflate_quality = wildcard_quality;
+	if (gzip_quality <= 0 && deflate_quality <= 0)
+		return HTTPContentCoding::Identity;
+	return gzip_quality >= deflate_quality ? HTTPContentCoding::Gzip
+					       : HTTPContentCoding::Deflate;
+}
+
+/**
+ * Whether a body of the media type gets smaller when compressed: text, and the
+ * textual application types(JSON, JavaScript, XML, SVG, ...)
+ */
+inline bool
+is_compressible_content_type(std::string_view content_type) noexcept {
+	std::string_view media_type =
+	    trim_ows(content_type.substr(0, content_type.find(';')));
+	auto has_prefix = [](std::string_view value, std::string_view prefix) {
+		return value.size() >= prefix.size() &&
+		       case_insensitive_equal(value.substr(0, prefix.size()),
+					      prefix);
+	};
+	auto has_suffix = [](std::string_view value, std::string_view suffix) {
+		return value.size() >= suffix.size() &&
+		       case_insensitive_equal(
+			   value.substr(value.size() - suffix.size()), suffix);
+	};
+	if (has_prefix(media_type, "text/")) return true;
+	if (!has_prefix(media_type, "application/") &&
+	    !has_prefix(media_type, "image/svg"))
+		return false;
+	for (std::string_view textual_type :
+	     {"json", "javascript", "xml", "ecmascript", "x-www-form-urlencoded",
+	      "wasm", "svg+xml", "manifest+json", "ld+json"})
+		if (has_suffix(media_type, textual_type)) return true;
+	return false;
+}
+
+/**
+ * 64-bit hash of a body, 8 bytes per multiply. It identifies a body(with its
+ * size) in the HTTPCompressedVariantCache.
+ */
+inline std::uint64_t
+content_hash(const char *data, std::size_t size) noexcept {
+	constexpr std::uint64_t multiplier = 0x9E3779B97F4A7C15ull;
+	constexpr std::uint64_t mix_multiplier = 0xD6E8FEB86659FD93ull;
+	auto mix = [](std::uint64_t lhs, std::uint64_t rhs) {
+		__uint128_t product = static_cast<__uint128_t>(lhs) * rhs;
+		return static_cast<std::uint64_t>(product) ^
+		       static_cast<std::uint64_t>(product >> 64);
+	};
+	std::uint64_t hash = mix(size ^ multiplier, mix_multiplier);
+	std::size_t index{};
+	for (; index + 8 <= size; index += 8) {
+		std::uint64_t word;
+		std::memcpy(&word, data + index, 8);
+		hash = mix(hash ^ word, mix_multiplier);
+	}
+	if (index != size) {
+		std::uint64_t word{};
+		std::memcpy(&word, data + index, size - index);
+		hash = mix(hash ^ word, multiplier);
+	}
+	return mix(hash, mix_multiplier);
+}
+
+/**
+ * Streaming gzip/deflate encoder of a body. The deflate content-coding is the
+ * zlib format(RFC 1950), not a raw deflate stream.
+ */
+class HTTPCompressor {
+      public:
+	static constexpr std::size_t staging_size = 16 * 1024;
+
+	/**
+	 * Throws std::invalid_argument for HTTPContentCoding::Identity and
+	 * std::runtime_error if zlib can't be initialized
+	 */
+	explicit HTTPCompressor(HTTPContentCoding content_coding,
+				int level = Z_DEFAULT_COMPRESSION) noexcept(false);
+	HTTPCompressor(const HTTPCompressor &) = delete;
+	HTTPCompressor &operator=(const HTTPCompressor &) = delete;
+	~HTTPCompressor();
+	/**
+	 * Compress a chunk of the body, the compressed bytes produced so far are
+	 * appended to output_buffer(zlib may hold some of them until the next
+	 * chunk or finish())
+	 */
+	template <typename BufferType>
+	void compress(const char *data, std::size_t size,
+		      BufferType &output_buffer) noexcept(false);
+	/**
+	 * Flush the rest of the stream(and the gzip trailer) into output_buffer
+	 */
+	template <typename BufferType>
+	void finish(BufferType &output_buffer) noexcept(false);
+	/**
+	 * Prepare the compressor for the next body, the zlib state is kept
+	 */
+	void reset() noexcept;
+	BLUETH_FORCE_INLINE HTTPContentCoding getContentCoding() const noexcept;
+	BLUETH_FORCE_INLINE int getLevel() const noexcept;
+
+      private:
+	template <typename BufferType>
+	void deflate_(BufferType &output_buffer, int flush) noexcept(false);
+
+	::z_stream stream_{};
+	HTTPContentCoding content_coding_;
+	int level_;
+	std::unique_ptr<char[]> staging_;
+};
+
+inline HTTPCompressor::HTTPCompressor(HTTPContentCoding content_coding,
+				      int level) noexcept(false)
+    : content_coding_{content_coding}, level_{level},
+      staging_{std::make_unique<char[]>(staging_size)} {
+	if (content_coding == HTTPContentCoding::Identity)
+		throw std::invalid_argument{
+		    "HTTPCompressor: identity is not a compression"};
+	// 16 + window bits asks zlib for the gzip wrapper
+	int window_bits = content_coding == HTTPContentCoding::Gzip ? 16 + 15 : 15;
+	if (::deflateInit2(&stream_, level, Z_DEFLATED, window_bits, 8,
+			   Z_DEFAULT_STRATEGY) != Z_OK)
+		throw std::runtime_error{"HTTPCompressor: deflateInit2 failed"};
+}
+
+inline HTTPCompressor::~HTTPCompressor() { ::deflateEnd(&stream_); }
+
+template <typename BufferType>
+inline void HTTPCompressor::deflate_(BufferType &output_buffer,
+				     int flush) noexcept(false) {
+	int deflate_ret;
+	do {
+		stream_.next_out = reinterpret_cast<Bytef *>(staging_.get());
+		stream_.avail_out = staging_size;
+		deflate_ret = ::deflate(&stream_, flush);
+		if (deflate_ret == Z_STREAM_ERROR)
+			throw std::runtime_error{"HTTPCompressor: deflate failed"};
+		std::size_t produced = staging_size - stream_.avail_out;
+		if (produced) output_buffer.appendRawBytes(staging_.get(), produced);
+		// A full staging area means zlib may have more to give
+	} while (stream_.avail_out == 0 ||
+		 (flush == Z_FINISH && deflate_ret != Z_STREAM_END));
+}
+
+template <typename BufferType>
+inline void HTTPCompressor::compress(const char *data, std::size_t size,
+				     BufferType &output_buffer) noexcept(false) {
+	while (size) {
+		// avail_in is 32-bit
+		std::size_t piece_size = std::min<std::size_t>(
+		    size, std::numeric_limits<::uInt>::max());
+		stream_.next_in =
+		    reinterpret_cast<Bytef *>(const_cast<char *>(data));
+		stream_.avail_in = static_cast<::uInt>(piece_size);
+		deflate_(output_buffer, Z_NO_FLUSH);
+		data += piece_size;
+		size -= piece_size;
+	}
+}
+
+template <typename BufferType>
+inline void HTTPCompressor::finish(BufferType &output_buffer) noexcept(false) {
+	stream_.next_in = nullptr;
+	stream_.avail_in = 0;
+	deflate_(output_buffer, Z_FINISH);
+}
+
+inline void HTTPCompressor::reset() noexcept { ::deflateReset(&stream_); }
+
+BLUETH_FORCE_INLINE inline HTTPContentCoding
+HTTPCompressor::getContentCoding() const noexcept {
+	return content_coding_;
+}
+
+BLUETH_FORCE_INLINE inline int HTTPCompressor::getLevel() const noexcept {
+	return level_;
+}
+
+struct HTTPCompressedVariantCacheStats {
+	std::size_t lookups{};
+	std::size_t hits{};
+	std::size_t insertions{};
+	std::size_t evictions{};
+	// Bytes of the cached variants
+	std::size_t cached_bytes{};
+	BLUETH_FORCE_INLINE double hitRate() const noexcept {
+		return lookups ? static_cast<double>(hits) / lookups : 0;
+	}
+};
+
+/**
+ * LRU cache of the compressed variants of bodies, bounded by the bytes of
+ * the variants. It belongs to one event loop(thread), it does no locking.
+ */
+class HTTPCompressedVariantCache {
+      public:
+	struct Key {
+		std::uint64_t hash;
+		std::size_t size;
+		HTTPContentCoding content_coding;
+		bool operator==(const Key &other) const noexcept = default;
+	};
+	static constexpr std::size_t default_max_bytes = 16 * 1024 * 1024;
+	// Hashes of the recently missed bodies, see insert()
+	static constexpr std::size_t recent_miss_slots = 1024;
+
+	explicit HTTPCompressedVariantCache(
+	    std::size_t max_bytes = default_max_bytes) noexcept;
+	HTTPCompressedVariantCache(const HTTPCompressedVariantCache &) = delete;
+	HTTPCompressedVariantCache &
+	operator=(const HTTPCompressedVariantCache &) = delete;
+	/**
+	 * Key of the coding's variant of body, hash it once and use it for
+	 * find() and insert()
+	 */
+	BLUETH_FORCE_INLINE static Key
+	makeKey(std::string_view body, HTTPContentCoding content_coding) noexcept;
+	/**
+	 * The variant, nullptr on a miss. The returned variant stays valid when
+	 * it's evicted.
+	 */
+	std::shared_ptr<const std::string> find(const Key &key) noexcept;
+	/**
+	 * Keep a compressed variant of a body which was missed. A body is
+	 * admitted on its second miss, so the bodies which are sent once(most
+	 * dynamic responses) don't evict the hot ones.
+	 *
+	 * @return false if the variant was not admitted
+	 */
+	bool insert(const Key &key, std::string_view compressed) noexcept(false);
+	/**
+	 * The variant of body, compressed with compressor and cached(without
+	 * the admission of insert()) on a miss. Meant for the static assets and
+	 * pre-rendered pages.
+	 */
+	std::shared_ptr<const std::string>
+	getOrCompress(std::string_view body,
+		      HTTPCompressor &compressor) noexcept(false);
+	HTTPCompressedVariantCacheStats getStats() const noexcept;
+	void clear() noexcept;
+
+      private:
+	struct KeyHash {
+		std::size_t operator()(const Key &key) const noexcept {
+			return key.hash ^
+			       static_cast<std::size_t>(key.content_coding);
+		}
+	};
+	struct Entry {
+		Key key;
+		std::shared_ptr<const std::string> compressed;
+	};
+	using EntryList = std::list<Entry>;
+
+	std::shared_ptr<const std::string>
+	store_(const Key &key, std::string compressed) noexcept(false);
+
+	std::size_t max_bytes_;
+	// Most recently used first
+	EntryList lru_entries_;
+	std::unordered_map<Key, EntryList::iterator, KeyHash> entry_index_;
+	std::unique_ptr<std::uint64_t[]> recent_misses_;
+	HTTPCompressedVariantCacheStats stats_;
+};
+
+inline HTTPCompressedVariantCache::HTTPCompressedVariantCache(
+    std::size_t max_bytes) noexcept
+    : max_bytes_{max_bytes} {}
+
+BLUETH_FORCE_INLINE inline HTTPCompressedVariantCache::Key
+HTTPCompressedVariantCache::makeKey(std::string_view body,
+				    HTTPContentCoding content_coding) noexcept {
+	return {content_hash(body.data(), body.size()), body.size(),
+		content_coding};
+}
+
+inline std::shared_ptr<const std::string>
+HTTPCompressedVariantCache::find(const Key &key) noexcept {
+	stats_.lookups++;
+	auto entry_iter = entry_index_.find(key);
+	if (entry_iter == entry_index_.end()) return nullptr;
+	stats_.hits++;
+	lru_entries_.splice(lru_entries_.begin(), lru_entries_,
+			    entry_iter->second);
+	return entry_iter->second->compressed;
+}
+
+inline bool
+HTTPCompressedVariantCache::insert(const Key &key,
+				   std::string_view compressed) noexcept(false) {
+	if (!recent_misses_)
+		recent_misses_ =
+		    std::make_unique<std::uint64_t[]>(recent_miss_slots);
+	std::uint64_t &recent_miss = recent_misses_[key.hash % recent_miss_slots];
+	if (recent_miss != key.hash) {
+		recent_miss = key.hash;
+		return false;
+	}
+	recent_miss = 0;
+	return store_(key, std::string{compressed}) != nullptr;
+}
+
+inline std::shared_ptr<const std::string>
+HTTPCompressedVariantCache::getOrCompress(
+    std::string_view body, HTTPCompressor &compressor) noexcept(false) {
+	Key key = makeKey(body, compressor.getContentCoding());
+	if (std::shared_ptr<const std::string> compressed = find(key))
+		return compressed;
+	// Only appendRawBytes is needed by the compressor
+	struct StringSink {
+		std::string &output;
+		void appendRawBytes(const char *data, std::size_t size) {
+			output.append(data, size);
+		}
+	};
+	std::string compressed;
+	StringSink string_sink{compressed};
+	compressor.reset();
+	compressor.compress(body.data(), body.size(), string_sink);
+	compressor.finish(string_sink);
+	// Larger than the whole cache
+	if (compressed.size() > max_bytes_)
+		return std::make_shared<const std::string>(std::move(compressed));
+	return store_(key, std::move(compressed));
+}
+
+inline std::shared_ptr<const std::string>
+HTTPCompressedVariantCache::store_(const Key &key,
+				   std::string compressed) noexcept(false) {
+	if (compressed.size() > max_bytes_) return nullptr;
+	auto entry_iter = entry_index_.find(key);
+	if (entry_iter != entry_index_.end()) {
+		stats_.cached_bytes -= entry_iter->second->compressed->size();
+		lru_entries_.erase(entry_iter->second);
+		entry_index_.erase(entry_iter);
+	}
+	while (!lru_entries_.empty() &&
+	       stats_.cached_bytes + compressed.size() > max_bytes_) {
+		const Entry &evicted = lru_entries_.back();
+		stats_.cached_bytes -= evicted.compressed->size();
+		entry_index_.erase(evicted.key);
+		lru_entries_.pop_back();
+		stats_.evictions++;
+	}
+	stats_.cached_bytes += compressed.size();
+	stats_.insertions++;
+	lru_entries_.push_front(
+	    {key, std::make_shared<const std::string>(std::move(compressed))});
+	entry_index_.emplace(key, lru_entries_.begin());
+	return lru_entries_.front().compressed;
+}
+
+inline HTTPCompressedVariantCacheStats
+HTTPCompressedVariantCache::getStats() const noexcept {
+	return stats_;
+}
+
+inline void HTTPCompressedVariantCache::clear() noexcept {
+	lru_entries_.clear();
+	entry_index_.clear();
+	stats_.cached_bytes = 0;
+}
+
+} // namespace blueth::http
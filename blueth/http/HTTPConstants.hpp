@@ -36,6 +36,7 @@ enum class HTTPResponseCodes {
 	UnsupportedMediaType = 415,
 	RequestRangeNotSatisfiable = 416,
 	ExpectationFailed = 417,
+	RequestHeaderFieldsTooLarge = 431,
 	InternalServerError = 500,
 	NotImplemented = 501,
 	BadGateway = 502,
@@ -45,14 +46,34 @@ enum class HTTPResponseCodes {
 	InvalidHttpCode = 506
 };
 
-enum class HTTPRequestType { Get, Post, Head, Put, Unsupported, Connect };
+enum class HTTPRequestType {
+	Get,
+	Post,
+	Head,
+	Put,
+	Unsupported,
+	Connect,
+	Delete,
+	Options,
+	Patch,
+	Trace
+};
 
 enum class HTTPServerType { PlaintextServer, SSLServer };
 
-enum class HTTPVersion { HTTP1_1, HTTP_2 };
+// HTTP1_0 is HTTP/1.0, a connection isn't persistent by default
+enum class HTTPVersion { HTTP1_0, HTTP1_1, HTTP_2 };
 
 enum class ParserState {
 	ProtocolError,
+	// A well-formed HTTP-version other than 1.0 and 1.1, a server answers
+	// with 505
+	VersionNotSupported,
+	// Errors for a message past HTTPParserLimits, these are final states like
+	// ProtocolError(a server answers with 414, 431 and 413)
+	RequestURITooLarge,
+	HeaderSectionTooLarge,
+	BodyTooLarge,
 	// Request-Line states
 	RequestLineBegin,
 	RequestMethod,
@@ -65,14 +86,16 @@ enum class ParserState {
 	RequestProtocolVersionMajor,
 	RequestProtocolDot,
 	RequestProtocolVersionMinor,
+	RequestLineCR,
 	RequestLineLF,
 	// HTTP 1.x header states
 	HeaderName,
 	HeaderValue,
 	HeaderValueLF,
 	HeaderEndLF,
-	// Request body state
+	// Request body states
 	MessageBody,
+	MessageBodyChunked,
 	// Final state, indicates success in parsing
 	ParsingDone
 };
@@ -96,12 +119,40 @@ enum class ResponseParserState {
 	HeaderValue,
 	HeaderValueLF,
 	HeaderEndLF,
-	// Resonse Body state
+	// Resonse Body states
 	ResponseMessageBody,
+	ResponseMessageBodyChunked,
+	// Body delimited by the server closing the connection(no Content-Length
+	// and no chunked coding), ends at ParseHTTP1_1ResponseEndOfStream
+	ResponseMessageBodyUntilClose,
+	// Limit states(HTTPParserLimits), the response is not usable
+	HeaderSectionTooLarge,
+	BodyTooLarge,
 	// Final state, indicates success in parsing
 	ParsingDone
 };
 
+enum class ChunkedDecoderState {
+	ProtocolError,
+	// The chunks add up to more than the maximum body size
+	BodyTooLarge,
+	// chunk-size [ chunk-ext ] CRLF
+	ChunkSize,
+	ChunkExtension,
+	ChunkSizeLF,
+	// chunk-data CRLF
+	ChunkData,
+	ChunkDataCR,
+	ChunkDataLF,
+	// trailer-part CRLF, after the last-chunk
+	TrailerBegin,
+	TrailerField,
+	TrailerFieldLF,
+	TrailerEndLF,
+	// Final state, the last-chunk and the trailers are consumed
+	DecodingDone
+};
+
 enum class LexConsts { CR = 0x0D, LF = 0x0A, SP = 0x20, HT = 0x09 };
 
 } // namespace blueth::http
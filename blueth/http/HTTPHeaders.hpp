@@ -1,66 +1,457 @@
 #pragma once
 #include "HTTPConstants.hpp"
+#include "HTTPParserCommon.hpp"
+#include "HTTPTokenTable.hpp"
+#include "common.hpp"
+#include "utils/simd.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
 #include <optional>
 #include <string>
-#include <unordered_map>
-#include "common.hpp"
+#include <string_view>
+#include <vector>
+
+// clang-format off
+/* HTTPHeaders is a flat, insertion ordered list of header fields. The names and values of all the fields are
+ * stored back to back in a single string and a field is an entry of offsets into it, the first
+ * 'inline_header_count' entries live inside the object and only a message with more fields spills the entries
+ * over to a std::vector.
+ *
+ *    header_bytes_:  HostexampleContent-Length5Set-Cookiea=1Set-Cookieb=2
+ *                    ^   ^      ^             ^^         ^  ^         ^
+ *    entries_:       {0, 4, 7}  {11, 14, 1}   {26, 10, 3}   {39, 10, 3}    {name offset, name size, value size}
+ *
+ * A name is matched case-insensitively(RFC 7230 3.2). The first entry of each well-known header(HTTPHeaderID)
+ * is indexed by its ID, so their lookup is an array access. The other entries carry a hash of the case-folded
+ * name, a lookup only compares the names(16/32 bytes at a time) of the entries whose hash matches.
+ *
+ * A field may be present more than once(Set-Cookie), getHeaderValue returns the first one and getHeaderValues
+ * all of them, in the order they were added.
+ */
+// clang-format on
 
 namespace blueth::http {
-// A thin wrapper around std::unordered_map container for managing HTTP headers
-// easily
+
+struct HTTPHeaderView {
+	std::string_view name;
+	std::string_view value;
+};
+
+/**
+ * FNV-1a hash of the name with its ASCII letters in lower case
+ */
+BLUETH_FORCE_INLINE constexpr static std::uint32_t
+case_folded_name_hash(std::string_view header_name) {
+	std::uint32_t returner = 2166136261u;
+	for (char name_char : header_name) {
+		returner ^= static_cast<std::uint8_t>(to_lower_ascii(name_char));
+		returner *= 16777619u;
+	}
+	return returner;
+}
+
 class HTTPHeaders {
+      public:
+	static constexpr std::size_t inline_header_count = 16;
+
+	class const_iterator {
+	      public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = HTTPHeaderView;
+		using difference_type = std::ptrdiff_t;
+		using pointer = void;
+		using reference = HTTPHeaderView;
+
+		const_iterator() noexcept = default;
+		const_iterator(const HTTPHeaders *http_headers,
+			       std::size_t index) noexcept
+		    : http_headers_{http_headers}, index_{index} {}
+		HTTPHeaderView operator*() const noexcept {
+			return http_headers_->headerAt_(index_);
+		}
+		const_iterator &operator++() noexcept {
+			index_++;
+			return *this;
+		}
+		const_iterator operator++(int) noexcept {
+			const_iterator returner = *this;
+			index_++;
+			return returner;
+		}
+		bool operator==(const const_iterator &other) const noexcept {
+			return index_ == other.index_;
+		}
+
+	      private:
+		const HTTPHeaders *http_headers_{nullptr};
+		std::size_t index_{};
+	};
+
       private:
-	std::unordered_map<std::string, std::string> http_headers_;
+	struct HeaderEntry {
+		std::uint32_t name_offset;
+		std::uint32_t name_size;
+		// The value starts right after the name
+		std::uint32_t value_size;
+		// case_folded_name_hash of the name, only for HTTPHeaderID::Unknown
+		std::uint32_t name_hash;
+		HTTPHeaderID header_id;
+	};
+	static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+	std::string header_bytes_;
+	std::array<HeaderEntry, inline_header_count> inline_entries_;
+	std::vector<HeaderEntry> spilled_entries_;
+	std::size_t entry_count_{};
+	bool spilled_{false};
+	// Index + 1 of the first entry with the ID, 0 if there is none
+	std::array<std::uint16_t, header_id_count> well_known_index_{};
+
+	BLUETH_FORCE_INLINE HeaderEntry *entryData_() noexcept;
+	BLUETH_FORCE_INLINE const HeaderEntry *entryData_() const noexcept;
+	BLUETH_FORCE_INLINE HTTPHeaderView headerAt_(std::size_t index) const noexcept;
+	BLUETH_FORCE_INLINE bool entryMatches_(const HeaderEntry &entry,
+					       std::string_view header_name,
+					       HTTPHeaderID header_id,
+					       std::uint32_t name_hash) const noexcept;
+	std::size_t findEntry_(std::string_view header_name) const noexcept;
+	void pushEntry_(const HeaderEntry &entry) noexcept(false);
+	void reindexWellKnown_() noexcept;
 
       public:
 	HTTPHeaders() {}
-	void
-	addHeader(std::pair<std::string, std::string> header_pair) noexcept;
-	bool removeHeader(const std::string &header_name) noexcept;
+	HTTPHeaders(const HTTPHeaders &) = delete;
+	HTTPHeaders &operator=(const HTTPHeaders &) = delete;
+	void addHeader(
+	    std::pair<std::string, std::string> header_pair) noexcept(false);
+	/**
+	 * Add a header whose ID is already known(by the parser)
+	 */
+	void addHeader(std::pair<std::string, std::string> header_pair,
+		       HTTPHeaderID header_id) noexcept(false);
+	/**
+	 * Add a well-known header with its canonical name
+	 */
+	void addHeader(HTTPHeaderID header_id,
+		       std::string header_value) noexcept(false);
+	void addHeader(std::string_view header_name,
+		       std::string_view header_value) noexcept(false);
+	void addHeader(std::string_view header_name, std::string_view header_value,
+		       HTTPHeaderID header_id) noexcept(false);
+	/**
+	 * Remove all the headers named header_name
+	 *
+	 * @return false if there was no such header
+	 */
+	bool removeHeader(std::string_view header_name) noexcept;
+	/**
+	 * Remove all the headers, the memory of the name/value bytes and of the
+	 * spilled entries is kept for the next message
+	 */
+	void clear() noexcept;
+	/**
+	 * Size of the buildRawHeader() string, the field lines and the final
+	 * CRLF
+	 */
+	std::size_t rawHeaderSize() const noexcept;
+	/**
+	 * Write the field lines and the final CRLF at destination, which has
+	 * room for rawHeaderSize() bytes
+	 *
+	 * @return End of the written bytes
+	 */
+	char *writeRawHeader(char *destination) const noexcept;
 	std::string buildRawHeader() const noexcept;
 	std::optional<std::string>
-	getHeaderValue(const std::string &header_name) const noexcept;
+	getHeaderValue(std::string_view header_name) const noexcept(false);
+	std::optional<std::string>
+	getHeaderValue(HTTPHeaderID header_id) const noexcept(false);
+	/**
+	 * Same as getHeaderValue without the copy, the view is valid until the
+	 * headers are modified
+	 */
+	std::optional<std::string_view>
+	getHeaderValueView(std::string_view header_name) const noexcept;
+	std::optional<std::string_view>
+	getHeaderValueView(HTTPHeaderID header_id) const noexcept;
+	/**
+	 * Values of all the headers named header_name(Set-Cookie), in the order
+	 * they were added
+	 */
+	std::vector<std::string_view>
+	getHeaderValues(std::string_view header_name) const noexcept(false);
 	std::size_t headerCount() const noexcept;
-	bool headerContains(const std::string &http_name) const noexcept;
+	bool headerContains(std::string_view header_name) const noexcept;
+	bool headerContains(HTTPHeaderID header_id) const noexcept;
+	const_iterator begin() const noexcept;
+	const_iterator end() const noexcept;
 	~HTTPHeaders() {}
 };
 
+BLUETH_FORCE_INLINE inline HTTPHeaders::HeaderEntry *
+HTTPHeaders::entryData_() noexcept {
+	return spilled_ ? spilled_entries_.data() : inline_entries_.data();
+}
+
+BLUETH_FORCE_INLINE inline const HTTPHeaders::HeaderEntry *
+HTTPHeaders::entryData_() const noexcept {
+	return spilled_ ? spilled_entries_.data() : inline_entries_.data();
+}
+
+BLUETH_FORCE_INLINE inline HTTPHeaderView
+HTTPHeaders::headerAt_(std::size_t index) const noexcept {
+	const HeaderEntry &entry = entryData_()[index];
+	const char *name_start = header_bytes_.data() + entry.name_offset;
+	return {{name_start, entry.name_size},
+		{name_start + entry.name_size, entry.value_size}};
+}
+
+BLUETH_FORCE_INLINE inline bool
+HTTPHeaders::entryMatches_(const HeaderEntry &entry,
+			   std::string_view header_name, HTTPHeaderID header_id,
+			   std::uint32_t name_hash) const noexcept {
+	if (header_id != HTTPHeaderID::Unknown)
+		return entry.header_id == header_id;
+	return entry.header_id == HTTPHeaderID::Unknown &&
+	       entry.name_hash == name_hash &&
+	       entry.name_size == header_name.size() &&
+	       simd::equal_ignore_ascii_case(
+		   header_bytes_.data() + entry.name_offset, header_name.data(),
+		   header_name.size());
+}
+
+inline std::size_t
+HTTPHeaders::findEntry_(std::string_view header_name) const noexcept {
+	HTTPHeaderID header_id = header_id_from_name(header_name);
+	if (header_id != HTTPHeaderID::Unknown) {
+		std::uint16_t index =
+		    well_known_index_[static_cast<std::size_t>(header_id)];
+		return index ? index - 1 : npos;
+	}
+	std::uint32_t name_hash = case_folded_name_hash(header_name);
+	const HeaderEntry *entries = entryData_();
+	for (std::size_t index{}; index < entry_count_; index++)
+		if (entryMatches_(entries[index], header_name, header_id,
+				  name_hash))
+			return index;
+	return npos;
+}
+
+inline void HTTPHeaders::pushEntry_(const HeaderEntry &entry) noexcept(false) {
+	if (!spilled_ && entry_count_ == inline_header_count) {
+		spilled_entries_.reserve(inline_header_count * 2);
+		spilled_entries_.assign(inline_entries_.begin(),
+					inline_entries_.end());
+		spilled_ = true;
+	}
+	if (spilled_)
+		spilled_entries_.push_back(entry);
+	else
+		inline_entries_[entry_count_] = entry;
+	entry_count_++;
+}
+
+inline void HTTPHeaders::reindexWellKnown_() noexcept {
+	well_known_index_.fill(0);
+	const HeaderEntry *entries = entryData_();
+	std::size_t index_limit =
+	    std::min<std::size_t>(entry_count_,
+				  std::numeric_limits<std::uint16_t>::max());
+	for (std::size_t index{}; index < index_limit; index++) {
+		std::uint16_t &well_known_index =
+		    well_known_index_[static_cast<std::size_t>(
+			entries[index].header_id)];
+		if (entries[index].header_id != HTTPHeaderID::Unknown &&
+		    !well_known_index)
+			well_known_index = static_cast<std::uint16_t>(index + 1);
+	}
+}
+
 inline void HTTPHeaders::addHeader(
-    std::pair<std::string, std::string> header_pair) noexcept {
-	http_headers_.emplace(std::move(header_pair));
+    std::pair<std::string, std::string> header_pair) noexcept(false) {
+	addHeader(header_pair.first, header_pair.second);
+}
+
+inline void
+HTTPHeaders::addHeader(std::pair<std::string, std::string> header_pair,
+		       HTTPHeaderID header_id) noexcept(false) {
+	addHeader(header_pair.first, header_pair.second, header_id);
+}
+
+inline void HTTPHeaders::addHeader(HTTPHeaderID header_id,
+				   std::string header_value) noexcept(false) {
+	addHeader(header_name_from_id(header_id), header_value, header_id);
+}
+
+inline void
+HTTPHeaders::addHeader(std::string_view header_name,
+		       std::string_view header_value) noexcept(false) {
+	addHeader(header_name, header_value, header_id_from_name(header_name));
+}
+
+inline void HTTPHeaders::addHeader(std::string_view header_name,
+				   std::string_view header_value,
+				   HTTPHeaderID header_id) noexcept(false) {
+	HeaderEntry entry{static_cast<std::uint32_t>(header_bytes_.size()),
+			  static_cast<std::uint32_t>(header_name.size()),
+			  static_cast<std::uint32_t>(header_value.size()),
+			  header_id == HTTPHeaderID::Unknown
+			      ? case_folded_name_hash(header_name)
+			      : 0,
+			  header_id};
+	header_bytes_.append(header_name);
+	header_bytes_.append(header_value);
+	std::uint16_t &well_known_index =
+	    well_known_index_[static_cast<std::size_t>(header_id)];
+	if (header_id != HTTPHeaderID::Unknown && !well_known_index &&
+	    entry_count_ < std::numeric_limits<std::uint16_t>::max())
+		well_known_index = static_cast<std::uint16_t>(entry_count_ + 1);
+	pushEntry_(entry);
 }
 
-inline bool HTTPHeaders::removeHeader(const std::string &header_name) noexcept {
-	if (!http_headers_.contains(header_name)) return false;
-	http_headers_.erase(header_name);
+inline bool HTTPHeaders::removeHeader(std::string_view header_name) noexcept {
+	HTTPHeaderID header_id = header_id_from_name(header_name);
+	std::uint32_t name_hash = header_id == HTTPHeaderID::Unknown
+				      ? case_folded_name_hash(header_name)
+				      : 0;
+	// Drop the matching entries and close the gaps they leave in
+	// header_bytes_, the order of the others is kept
+	HeaderEntry *entries = entryData_();
+	std::size_t kept_count{};
+	std::uint32_t bytes_end{};
+	for (std::size_t index{}; index < entry_count_; index++) {
+		HeaderEntry entry = entries[index];
+		if (entryMatches_(entry, header_name, header_id, name_hash))
+			continue;
+		std::uint32_t entry_size = entry.name_size + entry.value_size;
+		if (entry.name_offset != bytes_end)
+			std::memmove(header_bytes_.data() + bytes_end,
+				     header_bytes_.data() + entry.name_offset,
+				     entry_size);
+		entry.name_offset = bytes_end;
+		bytes_end += entry_size;
+		entries[kept_count++] = entry;
+	}
+	if (kept_count == entry_count_) return false;
+	header_bytes_.resize(bytes_end);
+	entry_count_ = kept_count;
+	if (spilled_) spilled_entries_.resize(kept_count);
+	reindexWellKnown_();
 	return true;
 }
 
+inline void HTTPHeaders::clear() noexcept {
+	header_bytes_.clear();
+	spilled_entries_.clear();
+	spilled_ = false;
+	entry_count_ = 0;
+	well_known_index_.fill(0);
+}
+
+BLUETH_FORCE_INLINE inline bool
+HTTPHeaders::headerContains(std::string_view header_name) const noexcept {
+	return findEntry_(header_name) != npos;
+}
+
 BLUETH_FORCE_INLINE inline bool
-HTTPHeaders::headerContains(const std::string &header_name) const noexcept {
-	return http_headers_.contains(header_name);
+HTTPHeaders::headerContains(HTTPHeaderID header_id) const noexcept {
+	return well_known_index_[static_cast<std::size_t>(header_id)] != 0;
 }
 
 BLUETH_FORCE_INLINE inline std::size_t HTTPHeaders::headerCount() const noexcept {
-	return http_headers_.size();
+	return entry_count_;
+}
+
+inline std::optional<std::string_view>
+HTTPHeaders::getHeaderValueView(std::string_view header_name) const noexcept {
+	std::size_t index = findEntry_(header_name);
+	if (index == npos) return std::nullopt;
+	return headerAt_(index).value;
+}
+
+inline std::optional<std::string_view>
+HTTPHeaders::getHeaderValueView(HTTPHeaderID header_id) const noexcept {
+	std::uint16_t index =
+	    well_known_index_[static_cast<std::size_t>(header_id)];
+	if (!index) return std::nullopt;
+	return headerAt_(index - 1).value;
 }
 
 inline std::optional<std::string>
-HTTPHeaders::getHeaderValue(const std::string &header_name) const noexcept {
-	if (!http_headers_.contains(header_name)) return std::nullopt;
-	return http_headers_.at(header_name);
+HTTPHeaders::getHeaderValue(std::string_view header_name) const
+    noexcept(false) {
+	std::optional<std::string_view> header_value =
+	    getHeaderValueView(header_name);
+	if (!header_value) return std::nullopt;
+	return std::string{*header_value};
 }
 
-inline std::string HTTPHeaders::buildRawHeader() const noexcept {
-	std::string returner;
-	for (const std::pair<std::string, std::string> &header :
-	     http_headers_) {
-		returner += header.first;
-		returner += ": ";
-		returner += header.second;
-		returner += "\r\n";
+inline std::optional<std::string>
+HTTPHeaders::getHeaderValue(HTTPHeaderID header_id) const noexcept(false) {
+	std::optional<std::string_view> header_value =
+	    getHeaderValueView(header_id);
+	if (!header_value) return std::nullopt;
+	return std::string{*header_value};
+}
+
+inline std::vector<std::string_view>
+HTTPHeaders::getHeaderValues(std::string_view header_name) const
+    noexcept(false) {
+	std::vector<std::string_view> returner;
+	HTTPHeaderID header_id = header_id_from_name(header_name);
+	std::uint32_t name_hash = header_id == HTTPHeaderID::Unknown
+				      ? case_folded_name_hash(header_name)
+				      : 0;
+	const HeaderEntry *entries = entryData_();
+	for (std::size_t index{}; index < entry_count_; index++)
+		if (entryMatches_(entries[index], header_name, header_id,
+				  name_hash))
+			returner.push_back(headerAt_(index).value);
+	return returner;
+}
+
+inline HTTPHeaders::const_iterator HTTPHeaders::begin() const noexcept {
+	return const_iterator{this, 0};
+}
+
+inline HTTPHeaders::const_iterator HTTPHeaders::end() const noexcept {
+	return const_iterator{this, entry_count_};
+}
+
+inline std::size_t HTTPHeaders::rawHeaderSize() const noexcept {
+	// "name: value\r\n" for each field and the final "\r\n"
+	return header_bytes_.size() + entry_count_ * 4 + 2;
+}
+
+inline char *HTTPHeaders::writeRawHeader(char *destination) const noexcept {
+	const HeaderEntry *entries = entryData_();
+	for (std::size_t index{}; index < entry_count_; index++) {
+		const HeaderEntry &entry = entries[index];
+		const char *name_start = header_bytes_.data() + entry.name_offset;
+		std::memcpy(destination, name_start, entry.name_size);
+		destination += entry.name_size;
+		*destination++ = ':';
+		*destination++ = static_cast<char>(LexConsts::SP);
+		std::memcpy(destination, name_start + entry.name_size,
+			    entry.value_size);
+		destination += entry.value_size;
+		*destination++ = static_cast<char>(LexConsts::CR);
+		*destination++ = static_cast<char>(LexConsts::LF);
 	}
-	return (returner += "\r\n");
+	*destination++ = static_cast<char>(LexConsts::CR);
+	*destination++ = static_cast<char>(LexConsts::LF);
+	return destination;
+}
+
+inline std::string HTTPHeaders::buildRawHeader() const noexcept {
+	std::string returner(rawHeaderSize(), '\0');
+	writeRawHeader(returner.data());
+	return returner;
 }
 
 } // namespace blueth::http
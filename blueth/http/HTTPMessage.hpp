@@ -1,19 +1,43 @@
 #pragma once
+#include "HTTPChunkedCodec.hpp"
 #include "HTTPConstants.hpp"
 #include "HTTPHeaders.hpp"
 #include "HTTPParserCommon.hpp"
+#include "HTTPTokenTable.hpp"
+#include "HTTPURI.hpp"
 #include "common.hpp"
 #include "io/IOBuffer.hpp"
+#include "io/InlineIOBuffer.hpp"
 #include <algorithm>
+#include <cstring>
 #include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <sys/uio.h>
 
 namespace blueth::http {
 
+// Most request/response bodies are well under 256 bytes, so they are stored
+// inside the message itself and only spill over to the heap when larger.
+// Bodies past message_body_spill_threshold are moved to a memory mapped
+// temporary file when $TMPDIR is disk backed, which the kernel can write back
+// under memory pressure. A spilled body holds a file descriptor for as long as
+// its message owns it, so a server with N bodies of 4MB or more in flight needs
+// N descriptors on top of its connections. Failing to spill(EMFILE, ENOSPC)
+// ends the parse in BodyTooLarge.
+inline constexpr std::size_t message_body_inline_capacity = 256;
+inline constexpr std::size_t message_body_spill_threshold = 4 * 1024 * 1024;
+using HTTPMessageBody = io::InlineIOBuffer<
+    char, message_body_inline_capacity,
+    io::IOBufFileBackedAllocator<message_body_spill_threshold>>;
+// A reset() message keeps the heap memory of its body up to this size, a
+// larger one(a big upload) is given back
+inline constexpr std::size_t message_body_retained_capacity = 64 * 1024;
+
 class HTTPRequestMessage {
       private:
-	static constexpr std::size_t initial_capacity_ = 2048;
 	std::unique_ptr<HTTPHeaders> http_headers_{nullptr};
-	std::unique_ptr<io::IOBuffer<char>> raw_body_{nullptr};
+	HTTPMessageBody raw_body_;
 	HTTPRequestType request_type_;
 	HTTPVersion http_message_version_;
 	std::string target_resource_;
@@ -22,13 +46,26 @@ class HTTPRequestMessage {
 	std::string temp_header_value_holder_;
 	std::string temp_header_name_holder_;
 	std::string temp_http_method_holder_;
+	// Content-Length bytes of the body which are yet to be parsed
+	std::size_t temp_body_remaining_{};
+	// Bytes of the request-line and the headers parsed by the earlier reads
+	std::size_t temp_head_size_{};
+	bool temp_content_length_seen_{false};
+	bool temp_body_chunked_{false};
+	HTTPChunkedDecoder temp_chunked_decoder_;
 
       public:
 	HTTPRequestMessage();
 	BLUETH_FORCE_INLINE static std::unique_ptr<HTTPRequestMessage> create();
+	/**
+	 * Make the message as good as new for the next request on a keep-alive
+	 * connection, the contents are cleared but the memory of the headers,
+	 * the body and the parser's holders is kept
+	 */
+	void reset() noexcept;
 	template <typename T1, typename T2>
 	BLUETH_FORCE_INLINE void addHeader(T1 &&header_name,
-					   T2 &&header_value) noexcept;
+					   T2 &&header_value) noexcept(false);
 	template <typename T>
 	BLUETH_FORCE_INLINE bool removeHeader(T &&header_name) noexcept;
 	BLUETH_FORCE_INLINE const std::unique_ptr<HTTPHeaders> &
@@ -45,30 +82,102 @@ class HTTPRequestMessage {
 	setHTTPTargetResource(T &&target_resource) noexcept;
 	BLUETH_FORCE_INLINE const std::string &
 	getTargetResource() const noexcept;
-	void setRawBody(std::unique_ptr<io::IOBuffer<char>> io_buffer) noexcept;
+	/**
+	 * Components of the target resource, views into the message
+	 */
+	BLUETH_FORCE_INLINE HTTPURIView getURIView() const noexcept;
+	/**
+	 * Copies the data of io_buffer into the message body, throws
+	 * std::invalid_argument if io_buffer is null
+	 */
+	void
+	setRawBody(std::unique_ptr<io::IOBuffer<char>> io_buffer) noexcept(false);
+	void setRawBody(HTTPMessageBody &&message_body) noexcept;
+	BLUETH_FORCE_INLINE const HTTPMessageBody &
+	constGetRawBody() const noexcept;
 	template <typename T>
 	BLUETH_FORCE_INLINE std::optional<std::string>
-	getHeaderValue(T &&header_name) noexcept;
+	getHeaderValue(T &&header_name) noexcept(false);
+	/**
+	 * Size of the request-line and the header section
+	 */
+	std::size_t rawHeadSize() const noexcept;
+	/**
+	 * Write the request-line and the header section at destination,
+	 * which has room for rawHeadSize() bytes
+	 *
+	 * @return End of the written bytes
+	 */
+	char *serializeHead(char *destination) const noexcept;
+	/**
+	 * Append the message to io_buffer, the space for it is made once and
+	 * the head is written in place
+	 */
+	template <typename BufferType>
+	void serializeTo(BufferType &io_buffer) const noexcept(false);
+	/**
+	 * Append the head to head_buffer and point iov at it and at the body,
+	 * the body is not copied. The iovecs are valid until head_buffer or
+	 * the body is modified.
+	 *
+	 * @param iov Array with room for two entries
+	 * @return Number of iovec entries used, 1 if there is no body
+	 */
+	template <typename BufferType>
+	std::size_t fillIovec(BufferType &head_buffer,
+			      ::iovec *iov) const noexcept(false);
 	std::string buildRawMessage() const noexcept;
 
 	// These methods are only implemented to work with the state-machine
-	// parser
-	BLUETH_FORCE_INLINE void pushBackHeaderValue(char char_val) noexcept;
-	BLUETH_FORCE_INLINE void pushBackHeaderName(char char_val) noexcept;
-	BLUETH_FORCE_INLINE void addTempHeadersHolderToMessage() noexcept;
+	// parser. The (data, size) overloads append a whole run of bytes found
+	// by the SIMD parser.
+	BLUETH_FORCE_INLINE void
+	pushBackHeaderValue(char char_val) noexcept(false);
+	BLUETH_FORCE_INLINE void
+	pushBackHeaderValue(const char *data, std::size_t size) noexcept(false);
+	BLUETH_FORCE_INLINE void
+	pushBackHeaderName(char char_val) noexcept(false);
+	BLUETH_FORCE_INLINE void
+	pushBackHeaderName(const char *data, std::size_t size) noexcept(false);
+	BLUETH_FORCE_INLINE bool isTempHeaderValueEmpty() const noexcept;
+	/**
+	 * @return false if the header is a malformed Content-Length, or a
+	 * Content-Length/Transfer-Encoding which conflicts with the framing of
+	 * the earlier headers(RFC 7230 3.3.3)
+	 */
+	BLUETH_FORCE_INLINE bool
+	addTempHeadersHolderToMessage() noexcept(false);
+	BLUETH_FORCE_INLINE void
+	pushBackRawBody(std::string &&raw_body) noexcept(false);
+	BLUETH_FORCE_INLINE void pushBackRawBody(char char_val) noexcept(false);
 	BLUETH_FORCE_INLINE void
-	pushBackRawBody(std::string &&raw_body) noexcept;
-	BLUETH_FORCE_INLINE void pushBackRawBody(char char_val) noexcept;
-	BLUETH_FORCE_INLINE void pushBackTargetResource(char char_val) noexcept;
-	BLUETH_FORCE_INLINE void pushBackRequestMethod(char char_val) noexcept;
-	BLUETH_FORCE_INLINE std::string getTempRequestMethod() const noexcept;
+	pushBackRawBody(const char *data, std::size_t size) noexcept(false);
+	BLUETH_FORCE_INLINE std::size_t getTempBodyRemaining() const noexcept;
+	BLUETH_FORCE_INLINE void consumeTempBody(std::size_t size) noexcept;
+	/**
+	 * @return Size of the request head parsed so far, including size
+	 */
+	BLUETH_FORCE_INLINE std::size_t addTempHeadSize(std::size_t size) noexcept;
+	BLUETH_FORCE_INLINE bool isTempBodyChunked() const noexcept;
+	BLUETH_FORCE_INLINE HTTPChunkedDecoder &getTempChunkedDecoder() noexcept;
+	BLUETH_FORCE_INLINE void
+	pushBackTargetResource(char char_val) noexcept(false);
+	BLUETH_FORCE_INLINE void
+	pushBackTargetResource(const char *data,
+			       std::size_t size) noexcept(false);
+	BLUETH_FORCE_INLINE void
+	pushBackRequestMethod(char char_val) noexcept(false);
+	BLUETH_FORCE_INLINE void
+	pushBackRequestMethod(const char *data,
+			      std::size_t size) noexcept(false);
+	BLUETH_FORCE_INLINE const std::string &
+	getTempRequestMethod() const noexcept;
 };
 
 class HTTPResponseMessage {
       private:
-	static constexpr std::size_t initial_capacity_ = 2048;
 	std::unique_ptr<HTTPHeaders> http_headers_{nullptr};
-	std::unique_ptr<io::IOBuffer<char>> raw_body_{nullptr};
+	HTTPMessageBody raw_body_;
 	HTTPResponseCodes response_code_;
 	HTTPVersion http_message_version_;
 
@@ -80,14 +189,38 @@ class HTTPResponseMessage {
 		char http_code_holder[4];
 		size_t current_index{};
 	} temp_http_status_code_holder_;
+	// Content-Length bytes of the body which are yet to be parsed
+	std::size_t temp_body_remaining_{};
+	// Bytes of the status-line and the headers parsed by the earlier reads
+	std::size_t temp_head_size_{};
+	// Bytes of a body delimited by the end of the connection
+	std::size_t temp_body_size_{};
+	bool temp_content_length_seen_{false};
+	bool temp_transfer_encoding_seen_{false};
+	bool temp_body_chunked_{false};
+	HTTPChunkedDecoder temp_chunked_decoder_;
+	// Method of the request which this response answers
+	HTTPRequestType request_type_{HTTPRequestType::Get};
+
+	// Size of the status-line, 0 if the code is not in 100-599 and the
+	// message can't be serialized
+	BLUETH_FORCE_INLINE std::size_t statusLineSize_() const noexcept;
+	// Write the status-line of statusLineSize_() bytes at destination
+	char *writeStatusLine_(char *destination) const noexcept;
 
       public:
 	HTTPResponseMessage();
 	BLUETH_FORCE_INLINE static std::unique_ptr<HTTPResponseMessage>
 	create();
+	/**
+	 * Make the message as good as new for the next response, the contents
+	 * are cleared but the memory of the headers, the body and the parser's
+	 * holders is kept
+	 */
+	void reset() noexcept;
 	template <typename T1, typename T2>
 	BLUETH_FORCE_INLINE void addHeader(T1 &&header_name,
-					   T2 &&header_value) noexcept;
+					   T2 &&header_value) noexcept(false);
 	template <typename T>
 	BLUETH_FORCE_INLINE bool removeHeader(T &&header_name) noexcept;
 	BLUETH_FORCE_INLINE const std::unique_ptr<HTTPHeaders> &
@@ -100,23 +233,91 @@ class HTTPResponseMessage {
 	BLUETH_FORCE_INLINE HTTPResponseCodes getResponseCode() const noexcept;
 	BLUETH_FORCE_INLINE void setHTTPVersion(HTTPVersion version) noexcept;
 	BLUETH_FORCE_INLINE HTTPVersion getHTTPVersion() const noexcept;
-	void setRawBody(std::unique_ptr<io::IOBuffer<char>> io_buffer) noexcept;
-	BLUETH_FORCE_INLINE const std::unique_ptr<io::IOBuffer<char>> &
+	/**
+	 * Method of the request which this response answers, set it before
+	 * parsing: a response to HEAD and a 2xx response to CONNECT have no body
+	 * whatever their headers say(RFC 7230 3.3.3). Defaults to GET.
+	 */
+	BLUETH_FORCE_INLINE void setRequestType(HTTPRequestType type) noexcept;
+	BLUETH_FORCE_INLINE HTTPRequestType getRequestType() const noexcept;
+	/**
+	 * Copies the data of io_buffer into the message body, throws
+	 * std::invalid_argument if io_buffer is null
+	 */
+	void
+	setRawBody(std::unique_ptr<io::IOBuffer<char>> io_buffer) noexcept(false);
+	void setRawBody(HTTPMessageBody &&message_body) noexcept;
+	BLUETH_FORCE_INLINE const HTTPMessageBody &
 	constGetRawBody() const noexcept;
 	template <typename T>
 	BLUETH_FORCE_INLINE std::optional<std::string>
-	getHeaderValue(T &&header_name) noexcept;
+	getHeaderValue(T &&header_name) noexcept(false);
+	/**
+	 * Size of the status-line and the header section, 0 if the response
+	 * code is not in 100-599. A code without a reason phrase of its own
+	 * gets the one of its class("HTTP/1.1 418 Client Error").
+	 */
+	std::size_t rawHeadSize() const noexcept;
+	/**
+	 * Write the status-line and the header section at destination,
+	 * which has room for rawHeadSize() bytes
+	 *
+	 * @return End of the written bytes
+	 */
+	char *serializeHead(char *destination) const noexcept;
+	/**
+	 * Append the message to io_buffer, the space for it is made once and
+	 * the head is written in place. Throws std::invalid_argument if the
+	 * response code is not in 100-599.
+	 */
+	template <typename BufferType>
+	void serializeTo(BufferType &io_buffer) const noexcept(false);
+	/**
+	 * Append the head to head_buffer and point iov at it and at the body,
+	 * the body is not copied. The iovecs are valid until head_buffer or
+	 * the body is modified. Throws like serializeTo.
+	 *
+	 * @param iov Array with room for two entries
+	 * @return Number of iovec entries used, 1 if there is no body
+	 */
+	template <typename BufferType>
+	std::size_t fillIovec(BufferType &head_buffer,
+			      ::iovec *iov) const noexcept(false);
 	std::string buildRawMessage() const noexcept;
 
 	// These methods are only implemented to work with the incremental
 	// state-machine parser. These methods must not be called by a user of
 	// the class other than the parser.
-	BLUETH_FORCE_INLINE void pushBackHeaderValue(char char_val) noexcept;
-	BLUETH_FORCE_INLINE void pushBackHeaderName(char char_val) noexcept;
-	BLUETH_FORCE_INLINE void addTempHeadersHolderToMessage() noexcept;
 	BLUETH_FORCE_INLINE void
-	pushBackRawBody(std::string &&raw_body) noexcept;
-	BLUETH_FORCE_INLINE void pushBackResponseCode(char char_value) noexcept;
+	pushBackHeaderValue(char char_val) noexcept(false);
+	BLUETH_FORCE_INLINE void
+	pushBackHeaderName(char char_val) noexcept(false);
+	BLUETH_FORCE_INLINE bool isTempHeaderValueEmpty() const noexcept;
+	/**
+	 * @return false if the header is a malformed Content-Length, or a
+	 * Content-Length/Transfer-Encoding which conflicts with the framing of
+	 * the earlier headers(RFC 7230 3.3.3)
+	 */
+	BLUETH_FORCE_INLINE bool
+	addTempHeadersHolderToMessage() noexcept(false);
+	BLUETH_FORCE_INLINE void
+	pushBackRawBody(std::string &&raw_body) noexcept(false);
+	BLUETH_FORCE_INLINE void
+	pushBackRawBody(const char *data, std::size_t size) noexcept(false);
+	BLUETH_FORCE_INLINE std::size_t getTempBodyRemaining() const noexcept;
+	BLUETH_FORCE_INLINE void consumeTempBody(std::size_t size) noexcept;
+	/**
+	 * @return Size of the response head parsed so far, including size
+	 */
+	BLUETH_FORCE_INLINE std::size_t addTempHeadSize(std::size_t size) noexcept;
+	/**
+	 * @return Size of the body parsed so far, including size
+	 */
+	BLUETH_FORCE_INLINE std::size_t addTempBodySize(std::size_t size) noexcept;
+	BLUETH_FORCE_INLINE bool isTempBodyChunked() const noexcept;
+	BLUETH_FORCE_INLINE HTTPChunkedDecoder &getTempChunkedDecoder() noexcept;
+	BLUETH_FORCE_INLINE void
+	pushBackResponseCode(char char_value) noexcept(false);
 	BLUETH_FORCE_INLINE const char *getTempStatusCode() const noexcept;
 };
 
@@ -128,14 +329,36 @@ HTTPRequestMessage::create() {
 inline HTTPRequestMessage::HTTPRequestMessage()
     : request_type_{HTTPRequestType::Unsupported},
       http_message_version_{HTTPVersion::HTTP1_1},
-      http_headers_{std::make_unique<HTTPHeaders>()},
-      raw_body_{io::IOBuffer<char>::create(initial_capacity_)} {}
+      http_headers_{std::make_unique<HTTPHeaders>()} {}
+
+inline void HTTPRequestMessage::reset() noexcept {
+	if (http_headers_)
+		http_headers_->clear();
+	else
+		http_headers_ = std::make_unique<HTTPHeaders>();
+	raw_body_.clear();
+	// An empty body moves back to the inline storage, it can't throw
+	if (raw_body_.getCapacity() > message_body_retained_capacity)
+		raw_body_.shrinkToFit();
+	request_type_ = HTTPRequestType::Unsupported;
+	http_message_version_ = HTTPVersion::HTTP1_1;
+	target_resource_.clear();
+	temp_header_value_holder_.clear();
+	temp_header_name_holder_.clear();
+	temp_http_method_holder_.clear();
+	temp_body_remaining_ = 0;
+	temp_head_size_ = 0;
+	temp_content_length_seen_ = false;
+	temp_body_chunked_ = false;
+	temp_chunked_decoder_.reset();
+}
 
 template <typename T1, typename T2>
 BLUETH_FORCE_INLINE inline void
-HTTPRequestMessage::addHeader(T1 &&header_name, T2 &&header_value) noexcept {
-	http_headers_->addHeader(
-	    {std::forward<T1>(header_name), std::forward<T2>(header_value)});
+HTTPRequestMessage::addHeader(T1 &&header_name,
+			      T2 &&header_value) noexcept(false) {
+	http_headers_->addHeader(std::forward<T1>(header_name),
+				 std::forward<T2>(header_value));
 }
 
 template <typename T>
@@ -155,7 +378,7 @@ HTTPRequestMessage::getHTTPHeaders() noexcept {
 }
 
 BLUETH_FORCE_INLINE inline void HTTPRequestMessage::flushBody() noexcept {
-	raw_body_->clear();
+	raw_body_.clear();
 }
 
 BLUETH_FORCE_INLINE inline void
@@ -189,87 +412,217 @@ HTTPRequestMessage::getTargetResource() const noexcept {
 	return target_resource_;
 }
 
+BLUETH_FORCE_INLINE inline HTTPURIView
+HTTPRequestMessage::getURIView() const noexcept {
+	return parse_uri_view(target_resource_);
+}
+
 inline void HTTPRequestMessage::setRawBody(
-    std::unique_ptr<io::IOBuffer<char>> io_buffer) noexcept {
-	raw_body_ = std::move(io_buffer);
+    std::unique_ptr<io::IOBuffer<char>> io_buffer) noexcept(false) {
+	if (!io_buffer)
+		throw std::invalid_argument{
+		    "HTTPRequestMessage::setRawBody: null io_buffer"};
+	raw_body_.clear();
+	raw_body_.appendRawBytes(io_buffer->getStartOffsetPointer(),
+				 io_buffer->getDataSize());
+}
+
+inline void
+HTTPRequestMessage::setRawBody(HTTPMessageBody &&message_body) noexcept {
+	raw_body_ = std::move(message_body);
+}
+
+BLUETH_FORCE_INLINE inline const HTTPMessageBody &
+HTTPRequestMessage::constGetRawBody() const noexcept {
+	return raw_body_;
 }
 
 template <typename T>
 BLUETH_FORCE_INLINE inline std::optional<std::string>
-HTTPRequestMessage::getHeaderValue(T &&header_name) noexcept {
+HTTPRequestMessage::getHeaderValue(T &&header_name) noexcept(false) {
 	return http_headers_->getHeaderValue(std::forward<T>(header_name));
 }
 
+inline std::size_t HTTPRequestMessage::rawHeadSize() const noexcept {
+	// "METHOD target HTTP/1.1\r\n"
+	return method_from_request_type(request_type_).size() +
+	       target_resource_.size() + 12 + http_headers_->rawHeaderSize();
+}
+
+inline char *
+HTTPRequestMessage::serializeHead(char *destination) const noexcept {
+	std::string_view method = method_from_request_type(request_type_);
+	std::memcpy(destination, method.data(), method.size());
+	destination += method.size();
+	*destination++ = static_cast<char>(LexConsts::SP);
+	std::memcpy(destination, target_resource_.data(),
+		    target_resource_.size());
+	destination += target_resource_.size();
+	std::memcpy(destination, " HTTP/1.1\r\n", 11);
+	return http_headers_->writeRawHeader(destination + 11);
+}
+
+template <typename BufferType>
+inline void
+HTTPRequestMessage::serializeTo(BufferType &io_buffer) const noexcept(false) {
+	std::size_t head_size = rawHeadSize();
+	std::size_t body_size = raw_body_.getDataSize();
+	io_buffer.ensureAvailableSpace(head_size + body_size);
+	char *body_start = serializeHead(io_buffer.getEndOffsetPointer());
+	std::memcpy(body_start, raw_body_.getStartOffsetPointer(), body_size);
+	io_buffer.commitAppend(head_size + body_size);
+}
+
+template <typename BufferType>
+inline std::size_t
+HTTPRequestMessage::fillIovec(BufferType &head_buffer,
+			      ::iovec *iov) const noexcept(false) {
+	std::size_t head_size = rawHeadSize();
+	head_buffer.ensureAvailableSpace(head_size);
+	char *head_start = head_buffer.getEndOffsetPointer();
+	serializeHead(head_start);
+	head_buffer.commitAppend(head_size);
+	iov[0] = {head_start, head_size};
+	if (!raw_body_.getDataSize()) return 1;
+	iov[1] = {raw_body_.getStartOffsetPointer(), raw_body_.getDataSize()};
+	return 2;
+}
+
 inline std::string HTTPRequestMessage::buildRawMessage() const noexcept {
-	std::string returner;
-	switch (request_type_) {
-	case HTTPRequestType::Get:
-		returner += "GET ";
-		break;
-	case HTTPRequestType::Post:
-		returner += "POST ";
-		break;
-	case HTTPRequestType::Head:
-		returner += "HEAD ";
-		break;
-	case HTTPRequestType::Put:
-		returner += "PUT ";
-		break;
-	case HTTPRequestType::Connect:
-		returner += "CONNECT ";
-		break;
-	case HTTPRequestType::Unsupported:
-		returner += "UNSUPPORTED ";
-		break;
-	}
-	returner += target_resource_;
-	returner += " ";
-	returner += "HTTP/1.1";
-	returner += "\r\n";
-	returner += http_headers_->buildRawHeader();
-	returner += std::string{raw_body_->begin(), raw_body_->end()};
+	std::string returner(rawHeadSize() + raw_body_.getDataSize(), '\0');
+	char *body_start = serializeHead(returner.data());
+	std::memcpy(body_start, raw_body_.getStartOffsetPointer(),
+		    raw_body_.getDataSize());
 	return returner;
 }
 
 BLUETH_FORCE_INLINE inline void
-HTTPRequestMessage::pushBackHeaderValue(char char_val) noexcept {
+HTTPRequestMessage::pushBackHeaderValue(char char_val) noexcept(false) {
 	temp_header_value_holder_.push_back(char_val);
 }
 
 BLUETH_FORCE_INLINE inline void
-HTTPRequestMessage::pushBackHeaderName(char char_val) noexcept {
+HTTPRequestMessage::pushBackHeaderValue(const char *data,
+					std::size_t size) noexcept(false) {
+	temp_header_value_holder_.append(data, size);
+}
+
+BLUETH_FORCE_INLINE inline void
+HTTPRequestMessage::pushBackHeaderName(char char_val) noexcept(false) {
 	temp_header_name_holder_.push_back(char_val);
 }
 
 BLUETH_FORCE_INLINE inline void
-HTTPRequestMessage::addTempHeadersHolderToMessage() noexcept {
-	http_headers_->addHeader({std::move(temp_header_name_holder_),
-				  std::move(temp_header_value_holder_)});
+HTTPRequestMessage::pushBackHeaderName(const char *data,
+				       std::size_t size) noexcept(false) {
+	temp_header_name_holder_.append(data, size);
+}
+
+BLUETH_FORCE_INLINE inline bool
+HTTPRequestMessage::isTempHeaderValueEmpty() const noexcept {
+	return temp_header_value_holder_.empty();
+}
+
+BLUETH_FORCE_INLINE inline bool
+HTTPRequestMessage::addTempHeadersHolderToMessage() noexcept(false) {
+	// Trailing whitespace is not a part of the field value(RFC 7230 3.2)
+	while (!temp_header_value_holder_.empty() &&
+	       (temp_header_value_holder_.back() ==
+		    static_cast<char>(LexConsts::SP) ||
+		temp_header_value_holder_.back() ==
+		    static_cast<char>(LexConsts::HT)))
+		temp_header_value_holder_.pop_back();
+	bool returner = true;
+	HTTPHeaderID header_id = header_id_from_name(temp_header_name_holder_);
+	// A message framed two ways is read differently by each hop, which is
+	// how requests get smuggled: a repeated Content-Length must carry the
+	// same value, a Transfer-Encoding can't come with a Content-Length and
+	// chunked must be the final coding, applied once(RFC 7230 3.3.3)
+	if (header_id == HTTPHeaderID::ContentLength) {
+		std::optional<std::size_t> content_length =
+		    parse_content_length(temp_header_value_holder_);
+		returner = content_length.has_value() && !temp_body_chunked_ &&
+			   (!temp_content_length_seen_ ||
+			    *content_length == temp_body_remaining_);
+		temp_body_remaining_ = content_length.value_or(0);
+		temp_content_length_seen_ = true;
+	} else if (header_id == HTTPHeaderID::TransferEncoding) {
+		returner = !temp_body_chunked_ && !temp_content_length_seen_ &&
+			   is_chunked_transfer_coding(
+			       temp_header_value_holder_);
+		temp_body_chunked_ = true;
+	}
+	http_headers_->addHeader(temp_header_name_holder_,
+				 temp_header_value_holder_, header_id);
 	temp_header_name_holder_.clear();
 	temp_header_value_holder_.clear();
+	return returner;
 }
 
 BLUETH_FORCE_INLINE inline void
-HTTPRequestMessage::pushBackRawBody(std::string &&raw_body) noexcept {
-	raw_body_->appendRawBytes(raw_body.c_str(), raw_body.size());
+HTTPRequestMessage::pushBackRawBody(std::string &&raw_body) noexcept(false) {
+	raw_body_.appendRawBytes(raw_body.c_str(), raw_body.size());
 }
 
 BLUETH_FORCE_INLINE inline void
-HTTPRequestMessage::pushBackRawBody(char char_val) noexcept {
-	raw_body_->appendRawBytes(&char_val, 1);
+HTTPRequestMessage::pushBackRawBody(char char_val) noexcept(false) {
+	raw_body_.appendRawBytes(&char_val, 1);
+}
+
+BLUETH_FORCE_INLINE inline void
+HTTPRequestMessage::pushBackRawBody(const char *data,
+				    std::size_t size) noexcept(false) {
+	raw_body_.appendRawBytes(data, size);
+}
+
+BLUETH_FORCE_INLINE inline std::size_t
+HTTPRequestMessage::getTempBodyRemaining() const noexcept {
+	return temp_body_remaining_;
+}
+
+BLUETH_FORCE_INLINE inline void
+HTTPRequestMessage::consumeTempBody(std::size_t size) noexcept {
+	temp_body_remaining_ -= std::min(size, temp_body_remaining_);
+}
+
+BLUETH_FORCE_INLINE inline std::size_t
+HTTPRequestMessage::addTempHeadSize(std::size_t size) noexcept {
+	return temp_head_size_ += size;
+}
+
+BLUETH_FORCE_INLINE inline bool
+HTTPRequestMessage::isTempBodyChunked() const noexcept {
+	return temp_body_chunked_;
+}
+
+BLUETH_FORCE_INLINE inline HTTPChunkedDecoder &
+HTTPRequestMessage::getTempChunkedDecoder() noexcept {
+	return temp_chunked_decoder_;
 }
 
 BLUETH_FORCE_INLINE inline void
-HTTPRequestMessage::pushBackTargetResource(char char_val) noexcept {
+HTTPRequestMessage::pushBackTargetResource(char char_val) noexcept(false) {
 	target_resource_.push_back(char_val);
 }
 
 BLUETH_FORCE_INLINE inline void
-HTTPRequestMessage::pushBackRequestMethod(char char_val) noexcept {
+HTTPRequestMessage::pushBackTargetResource(const char *data,
+					   std::size_t size) noexcept(false) {
+	target_resource_.append(data, size);
+}
+
+BLUETH_FORCE_INLINE inline void
+HTTPRequestMessage::pushBackRequestMethod(char char_val) noexcept(false) {
 	temp_http_method_holder_.push_back(char_val);
 }
 
-BLUETH_FORCE_INLINE inline std::string
+BLUETH_FORCE_INLINE inline void
+HTTPRequestMessage::pushBackRequestMethod(const char *data,
+					  std::size_t size) noexcept(false) {
+	temp_http_method_holder_.append(data, size);
+}
+
+BLUETH_FORCE_INLINE inline const std::string &
 HTTPRequestMessage::getTempRequestMethod() const noexcept {
 	return temp_http_method_holder_;
 }
@@ -282,16 +635,40 @@ HTTPResponseMessage::create() {
 inline HTTPResponseMessage::HTTPResponseMessage()
     : response_code_{HTTPResponseCodes::BadRequest},
       http_message_version_{HTTPVersion::HTTP1_1},
-      http_headers_{std::make_unique<HTTPHeaders>()},
-      raw_body_{io::IOBuffer<char>::create(initial_capacity_)} {
+      http_headers_{std::make_unique<HTTPHeaders>()} {
 	temp_http_status_code_holder_.http_code_holder[3] = '\0';
 }
 
+inline void HTTPResponseMessage::reset() noexcept {
+	if (http_headers_)
+		http_headers_->clear();
+	else
+		http_headers_ = std::make_unique<HTTPHeaders>();
+	raw_body_.clear();
+	// An empty body moves back to the inline storage, it can't throw
+	if (raw_body_.getCapacity() > message_body_retained_capacity)
+		raw_body_.shrinkToFit();
+	response_code_ = HTTPResponseCodes::BadRequest;
+	http_message_version_ = HTTPVersion::HTTP1_1;
+	temp_header_value_holder_.clear();
+	temp_header_name_holder_.clear();
+	temp_http_status_code_holder_.current_index = 0;
+	temp_body_remaining_ = 0;
+	temp_head_size_ = 0;
+	temp_body_size_ = 0;
+	temp_content_length_seen_ = false;
+	temp_transfer_encoding_seen_ = false;
+	temp_body_chunked_ = false;
+	temp_chunked_decoder_.reset();
+	request_type_ = HTTPRequestType::Get;
+}
+
 template <typename T1, typename T2>
 BLUETH_FORCE_INLINE inline void
-HTTPResponseMessage::addHeader(T1 &&header_name, T2 &&header_value) noexcept {
-	http_headers_->addHeader(
-	    {std::forward<T1>(header_name), std::forward<T2>(header_value)});
+HTTPResponseMessage::addHeader(T1 &&header_name,
+			       T2 &&header_value) noexcept(false) {
+	http_headers_->addHeader(std::forward<T1>(header_name),
+				 std::forward<T2>(header_value));
 }
 
 template <typename T>
@@ -311,7 +688,7 @@ HTTPResponseMessage::getHTTPHeaders() noexcept {
 }
 
 BLUETH_FORCE_INLINE inline void HTTPResponseMessage::flushBody() noexcept {
-	raw_body_->clear();
+	raw_body_.clear();
 }
 
 BLUETH_FORCE_INLINE inline void
@@ -334,389 +711,235 @@ HTTPResponseMessage::getHTTPVersion() const noexcept {
 	return http_message_version_;
 }
 
+BLUETH_FORCE_INLINE inline void
+HTTPResponseMessage::setRequestType(HTTPRequestType type) noexcept {
+	request_type_ = type;
+}
+
+BLUETH_FORCE_INLINE inline HTTPRequestType
+HTTPResponseMessage::getRequestType() const noexcept {
+	return request_type_;
+}
+
 inline void HTTPResponseMessage::setRawBody(
-    std::unique_ptr<io::IOBuffer<char>> io_buffer) noexcept {
-	raw_body_ = std::move(io_buffer);
+    std::unique_ptr<io::IOBuffer<char>> io_buffer) noexcept(false) {
+	if (!io_buffer)
+		throw std::invalid_argument{
+		    "HTTPResponseMessage::setRawBody: null io_buffer"};
+	raw_body_.clear();
+	raw_body_.appendRawBytes(io_buffer->getStartOffsetPointer(),
+				 io_buffer->getDataSize());
+}
+
+inline void
+HTTPResponseMessage::setRawBody(HTTPMessageBody &&message_body) noexcept {
+	raw_body_ = std::move(message_body);
 }
 
-BLUETH_FORCE_INLINE inline const std::unique_ptr<io::IOBuffer<char>> &
+BLUETH_FORCE_INLINE inline const HTTPMessageBody &
 HTTPResponseMessage::constGetRawBody() const noexcept {
 	return raw_body_;
 }
 
 template <typename T>
 BLUETH_FORCE_INLINE inline std::optional<std::string>
-HTTPResponseMessage::getHeaderValue(T &&header_name) noexcept {
+HTTPResponseMessage::getHeaderValue(T &&header_name) noexcept(false) {
 	return http_headers_->getHeaderValue(std::forward<T>(header_name));
 }
 
-inline std::string HTTPResponseMessage::buildRawMessage() const noexcept {
-	std::string returner;
-	// Only supports HTTP/1.x message as of now
-	if (http_message_version_ == HTTPVersion::HTTP1_1) {
-		returner += "HTTP/1.1 ";
+BLUETH_FORCE_INLINE inline std::size_t
+HTTPResponseMessage::statusLineSize_() const noexcept {
+	std::string_view status_line =
+	    status_line_from_response_code(response_code_);
+	if (!status_line.empty()) return status_line.size();
+	if (!is_valid_response_code(response_code_)) return 0;
+	std::size_t code_class = static_cast<std::size_t>(response_code_) / 100;
+	// "HTTP/1.1 418 " and the CRLF
+	return 15 + http_status_class_reasons[code_class - 1].size();
+}
+
+inline char *
+HTTPResponseMessage::writeStatusLine_(char *destination) const noexcept {
+	// The status-lines of the codes with a reason phrase are rendered at
+	// compile time, any other code gets the reason of its class
+	std::string_view status_line =
+	    status_line_from_response_code(response_code_);
+	char *line_end = destination;
+	if (!status_line.empty()) {
+		std::memcpy(destination, status_line.data(),
+			    status_line.size());
+		line_end += status_line.size();
 	} else {
-		// TODO(me): HTTP message template
-		return "";
-	}
-	switch (response_code_) {
-	case HTTPResponseCodes::Ok:
-		returner +=
-		    std::to_string(static_cast<int>(HTTPResponseCodes::Ok));
-		returner += " ";
-		returner +=
-		    string_from_response_code(HTTPResponseCodes::Ok).value();
-		break;
-	case HTTPResponseCodes::NotFound:
-		returner += std::to_string(
-		    static_cast<int>(HTTPResponseCodes::NotFound));
-		returner += " ";
-		returner +=
-		    string_from_response_code(HTTPResponseCodes::NotFound)
-			.value();
-		break;
-	case HTTPResponseCodes::BadRequest:
-		returner += std::to_string(
-		    static_cast<int>(HTTPResponseCodes::BadRequest));
-		returner += " ";
-		returner +=
-		    string_from_response_code(HTTPResponseCodes::BadRequest)
-			.value();
-		break;
-	case HTTPResponseCodes::Unauthorized:
-		returner += std::to_string(
-		    static_cast<int>(HTTPResponseCodes::Unauthorized));
-		returner += " ";
-		returner +=
-		    string_from_response_code(HTTPResponseCodes::Unauthorized)
-			.value();
-		break;
-	case HTTPResponseCodes::Created:
-		returner += std::to_string(
-		    static_cast<int>(HTTPResponseCodes::Created));
-		returner += " ";
-		returner +=
-		    string_from_response_code(HTTPResponseCodes::Created)
-			.value();
-		break;
-	case HTTPResponseCodes::Found:
-		returner +=
-		    std::to_string(static_cast<int>(HTTPResponseCodes::Found));
-		returner += " ";
-		returner +=
-		    string_from_response_code(HTTPResponseCodes::Found).value();
-		break;
-	case HTTPResponseCodes::Continue:
-		returner += std::to_string(
-		    static_cast<int>(HTTPResponseCodes::Continue));
-		returner += " ";
-		returner +=
-		    string_from_response_code(HTTPResponseCodes::Continue)
-			.value();
-		break;
-	case HTTPResponseCodes::Accepted:
-		returner += std::to_string(
-		    static_cast<int>(HTTPResponseCodes::Accepted));
-		returner += " ";
-		returner +=
-		    string_from_response_code(HTTPResponseCodes::Accepted)
-			.value();
-		break;
-	case HTTPResponseCodes::NonAuthoritativeInformation:
-		returner += std::to_string(static_cast<int>(
-		    HTTPResponseCodes::NonAuthoritativeInformation));
-		returner += " ";
-		returner += string_from_response_code(
-				HTTPResponseCodes::NonAuthoritativeInformation)
-				.value();
-		break;
-	case HTTPResponseCodes::NoContent:
-		returner += std::to_string(
-		    static_cast<int>(HTTPResponseCodes::NoContent));
-		returner += " ";
-		returner +=
-		    string_from_response_code(HTTPResponseCodes::NoContent)
-			.value();
-		break;
-	case HTTPResponseCodes::ResetContent:
-		returner += std::to_string(
-		    static_cast<int>(HTTPResponseCodes::ResetContent));
-		returner += " ";
-		returner +=
-		    string_from_response_code(HTTPResponseCodes::ResetContent)
-			.value();
-		break;
-	case HTTPResponseCodes::PartialContent:
-		returner += std::to_string(
-		    static_cast<int>(HTTPResponseCodes::PartialContent));
-		returner += " ";
-		returner +=
-		    string_from_response_code(HTTPResponseCodes::PartialContent)
-			.value();
-		break;
-	case HTTPResponseCodes::MultipleChoices:
-		returner += std::to_string(
-		    static_cast<int>(HTTPResponseCodes::MultipleChoices));
-		returner += " ";
-		returner += string_from_response_code(
-				HTTPResponseCodes::MultipleChoices)
-				.value();
-		break;
-	case HTTPResponseCodes::SeeOther:
-		returner += std::to_string(
-		    static_cast<int>(HTTPResponseCodes::SeeOther));
-		returner += " ";
-		returner +=
-		    string_from_response_code(HTTPResponseCodes::SeeOther)
-			.value();
-		break;
-	case HTTPResponseCodes::NotModified:
-		returner += std::to_string(
-		    static_cast<int>(HTTPResponseCodes::NotModified));
-		returner += " ";
-		returner +=
-		    string_from_response_code(HTTPResponseCodes::NotModified)
-			.value();
-		break;
-	case HTTPResponseCodes::UseProxy:
-		returner += std::to_string(
-		    static_cast<int>(HTTPResponseCodes::UseProxy));
-		returner += " ";
-		returner +=
-		    string_from_response_code(HTTPResponseCodes::UseProxy)
-			.value();
-		break;
-	case HTTPResponseCodes::TemporaryRedirect:
-		returner += std::to_string(
-		    static_cast<int>(HTTPResponseCodes::TemporaryRedirect));
-		returner += " ";
-		returner +=
-		    string_from_response_code(HTTPResponseCodes::UseProxy)
-			.value();
-		break;
-	case HTTPResponseCodes::PaymentRequired:
-		returner += std::to_string(
-		    static_cast<int>(HTTPResponseCodes::PaymentRequired));
-		returner += " ";
-		returner += string_from_response_code(
-				HTTPResponseCodes::PaymentRequired)
-				.value();
-		break;
-	case HTTPResponseCodes::Forbidden:
-		returner += std::to_string(
-		    static_cast<int>(HTTPResponseCodes::Forbidden));
-		returner += " ";
-		returner +=
-		    string_from_response_code(HTTPResponseCodes::Forbidden)
-			.value();
-		break;
-	case HTTPResponseCodes::MethodNotAllowed:
-		returner += std::to_string(
-		    static_cast<int>(HTTPResponseCodes::MethodNotAllowed));
-		returner += " ";
-		returner += string_from_response_code(
-				HTTPResponseCodes::MethodNotAllowed)
-				.value();
-		break;
-	case HTTPResponseCodes::NotAcceptable:
-		returner += std::to_string(
-		    static_cast<int>(HTTPResponseCodes::NotAcceptable));
-		returner += " ";
-		returner +=
-		    string_from_response_code(HTTPResponseCodes::NotAcceptable)
-			.value();
-		break;
-	case HTTPResponseCodes::ProxyAuthenticationRequired:
-		returner += std::to_string(static_cast<int>(
-		    HTTPResponseCodes::ProxyAuthenticationRequired));
-		returner += " ";
-		returner += string_from_response_code(
-				HTTPResponseCodes::ProxyAuthenticationRequired)
-				.value();
-		break;
-	case HTTPResponseCodes::RequestTimeOut:
-		returner += std::to_string(
-		    static_cast<int>(HTTPResponseCodes::RequestTimeOut));
-		returner += " ";
-		returner +=
-		    string_from_response_code(HTTPResponseCodes::RequestTimeOut)
-			.value();
-		break;
-	case HTTPResponseCodes::Conflict:
-		returner += std::to_string(
-		    static_cast<int>(HTTPResponseCodes::Conflict));
-		returner += " ";
-		returner +=
-		    string_from_response_code(HTTPResponseCodes::Conflict)
-			.value();
-		break;
-	case HTTPResponseCodes::Gone:
-		returner +=
-		    std::to_string(static_cast<int>(HTTPResponseCodes::Gone));
-		returner += " ";
-		returner +=
-		    string_from_response_code(HTTPResponseCodes::Gone).value();
-		break;
-	case HTTPResponseCodes::LengthRequired:
-		returner += std::to_string(
-		    static_cast<int>(HTTPResponseCodes::LengthRequired));
-		returner += " ";
-		returner +=
-		    string_from_response_code(HTTPResponseCodes::LengthRequired)
-			.value();
-		break;
-	case HTTPResponseCodes::PreconditionFailed:
-		returner += std::to_string(
-		    static_cast<int>(HTTPResponseCodes::PreconditionFailed));
-		returner += " ";
-		returner += string_from_response_code(
-				HTTPResponseCodes::PreconditionFailed)
-				.value();
-		break;
-	case HTTPResponseCodes::RequestEntityTooLarge:
-		returner += std::to_string(
-		    static_cast<int>(HTTPResponseCodes::RequestEntityTooLarge));
-		returner += " ";
-		returner += string_from_response_code(
-				HTTPResponseCodes::RequestEntityTooLarge)
-				.value();
-		break;
-	case HTTPResponseCodes::RequestURITooLarge:
-		returner += std::to_string(
-		    static_cast<int>(HTTPResponseCodes::RequestURITooLarge));
-		returner += " ";
-		returner += string_from_response_code(
-				HTTPResponseCodes::RequestURITooLarge)
-				.value();
-		break;
-	case HTTPResponseCodes::RequestRangeNotSatisfiable:
-		returner += std::to_string(static_cast<int>(
-		    HTTPResponseCodes::RequestRangeNotSatisfiable));
-		returner += " ";
-		returner += string_from_response_code(
-				HTTPResponseCodes::RequestRangeNotSatisfiable)
-				.value();
-		break;
-	case HTTPResponseCodes::ExpectationFailed:
-		returner += std::to_string(
-		    static_cast<int>(HTTPResponseCodes::ExpectationFailed));
-		returner += " ";
-		returner += string_from_response_code(
-				HTTPResponseCodes::ExpectationFailed)
-				.value();
-		break;
-	case HTTPResponseCodes::InternalServerError:
-		returner += std::to_string(
-		    static_cast<int>(HTTPResponseCodes::InternalServerError));
-		returner += " ";
-		returner += string_from_response_code(
-				HTTPResponseCodes::InternalServerError)
-				.value();
-		break;
-	case HTTPResponseCodes::NotImplemented:
-		returner += std::to_string(
-		    static_cast<int>(HTTPResponseCodes::NotImplemented));
-		returner += " ";
-		returner +=
-		    string_from_response_code(HTTPResponseCodes::NotImplemented)
-			.value();
-		break;
-	case HTTPResponseCodes::BadGateway:
-		returner += std::to_string(
-		    static_cast<int>(HTTPResponseCodes::BadGateway));
-		returner += " ";
-		returner +=
-		    string_from_response_code(HTTPResponseCodes::BadGateway)
-			.value();
-		break;
-	case HTTPResponseCodes::ServiceUnavailable:
-		returner += std::to_string(
-		    static_cast<int>(HTTPResponseCodes::ServiceUnavailable));
-		returner += " ";
-		returner += string_from_response_code(
-				HTTPResponseCodes::ServiceUnavailable)
-				.value();
-		break;
-	case HTTPResponseCodes::GatewayTimeOut:
-		returner += std::to_string(
-		    static_cast<int>(HTTPResponseCodes::GatewayTimeOut));
-		returner += " ";
-		returner +=
-		    string_from_response_code(HTTPResponseCodes::GatewayTimeOut)
-			.value();
-		break;
-	case HTTPResponseCodes::HttpVersionNotSupported:
-		returner += std::to_string(static_cast<int>(
-		    HTTPResponseCodes::HttpVersionNotSupported));
-		returner += " ";
-		returner += string_from_response_code(
-				HTTPResponseCodes::HttpVersionNotSupported)
-				.value();
-		break;
-
-	case HTTPResponseCodes::SwitchingProtocols:
-		returner += std::to_string(
-		    static_cast<int>(HTTPResponseCodes::SwitchingProtocols));
-		returner += " ";
-		returner += string_from_response_code(
-				HTTPResponseCodes::SwitchingProtocols)
-				.value();
-		break;
-
-	case HTTPResponseCodes::UnsupportedMediaType:
-		returner += std::to_string(
-		    static_cast<int>(HTTPResponseCodes::UnsupportedMediaType));
-		returner += " ";
-		returner += string_from_response_code(
-				HTTPResponseCodes::UnsupportedMediaType)
-				.value();
-		break;
-	case HTTPResponseCodes::MovedPermanently:
-		returner += std::to_string(
-		    static_cast<int>(HTTPResponseCodes::MovedPermanently));
-		returner += " ";
-		returner += string_from_response_code(
-				HTTPResponseCodes::MovedPermanently)
-				.value();
-		break;
-
-	// For invalid  HTTP status code from a server, we return a empty string
-	case HTTPResponseCodes::InvalidHttpCode:
-		return "";
-		break;
+		int code = static_cast<int>(response_code_);
+		std::string_view reason_phrase =
+		    http_status_class_reasons[code / 100 - 1];
+		std::memcpy(line_end, "HTTP/1.1 ", 9);
+		line_end += 9;
+		*line_end++ = static_cast<char>('0' + code / 100);
+		*line_end++ = static_cast<char>('0' + code / 10 % 10);
+		*line_end++ = static_cast<char>('0' + code % 10);
+		*line_end++ = static_cast<char>(LexConsts::SP);
+		std::memcpy(line_end, reason_phrase.data(),
+			    reason_phrase.size());
+		line_end += reason_phrase.size();
+		*line_end++ = static_cast<char>(LexConsts::CR);
+		*line_end++ = static_cast<char>(LexConsts::LF);
 	}
-	returner += "\r\n";
-	returner += http_headers_->buildRawHeader();
-	returner += std::string{raw_body_->getStartOffsetPointer(),
-				raw_body_->getEndOffsetPointer()};
+	// "HTTP/1.1" to "HTTP/1.0", an HTTP/2 message is written as HTTP/1.1
+	if (http_message_version_ == HTTPVersion::HTTP1_0) destination[7] = '0';
+	return line_end;
+}
+
+inline std::size_t HTTPResponseMessage::rawHeadSize() const noexcept {
+	std::size_t status_line_size = statusLineSize_();
+	if (!status_line_size) return 0;
+	return status_line_size + http_headers_->rawHeaderSize();
+}
+
+inline char *
+HTTPResponseMessage::serializeHead(char *destination) const noexcept {
+	if (!statusLineSize_()) return destination;
+	return http_headers_->writeRawHeader(writeStatusLine_(destination));
+}
+
+template <typename BufferType>
+inline void
+HTTPResponseMessage::serializeTo(BufferType &io_buffer) const noexcept(false) {
+	std::size_t head_size = rawHeadSize();
+	if (!head_size)
+		throw std::invalid_argument{
+		    "HTTPResponseMessage: status code out of range"};
+	std::size_t body_size = raw_body_.getDataSize();
+	io_buffer.ensureAvailableSpace(head_size + body_size);
+	char *body_start = serializeHead(io_buffer.getEndOffsetPointer());
+	std::memcpy(body_start, raw_body_.getStartOffsetPointer(), body_size);
+	io_buffer.commitAppend(head_size + body_size);
+}
+
+template <typename BufferType>
+inline std::size_t
+HTTPResponseMessage::fillIovec(BufferType &head_buffer,
+			       ::iovec *iov) const noexcept(false) {
+	std::size_t head_size = rawHeadSize();
+	if (!head_size)
+		throw std::invalid_argument{
+		    "HTTPResponseMessage: status code out of range"};
+	head_buffer.ensureAvailableSpace(head_size);
+	char *head_start = head_buffer.getEndOffsetPointer();
+	serializeHead(head_start);
+	head_buffer.commitAppend(head_size);
+	iov[0] = {head_start, head_size};
+	if (!raw_body_.getDataSize()) return 1;
+	iov[1] = {raw_body_.getStartOffsetPointer(), raw_body_.getDataSize()};
+	return 2;
+}
+
+inline std::string HTTPResponseMessage::buildRawMessage() const noexcept {
+	// For a invalid HTTP status code from a server, we return a empty
+	// string
+	std::size_t head_size = rawHeadSize();
+	if (!head_size) return "";
+	std::string returner(head_size + raw_body_.getDataSize(), '\0');
+	char *body_start = serializeHead(returner.data());
+	std::memcpy(body_start, raw_body_.getStartOffsetPointer(),
+		    raw_body_.getDataSize());
 	return returner;
 }
 
 BLUETH_FORCE_INLINE inline void
-HTTPResponseMessage::pushBackHeaderValue(char char_val) noexcept {
+HTTPResponseMessage::pushBackHeaderValue(char char_val) noexcept(false) {
 	temp_header_value_holder_.push_back(char_val);
 }
 
 BLUETH_FORCE_INLINE inline void
-HTTPResponseMessage::pushBackHeaderName(char char_val) noexcept {
+HTTPResponseMessage::pushBackHeaderName(char char_val) noexcept(false) {
 	temp_header_name_holder_.push_back(char_val);
 }
 
-BLUETH_FORCE_INLINE inline void
-HTTPResponseMessage::addTempHeadersHolderToMessage() noexcept {
-	http_headers_->addHeader({std::move(temp_header_name_holder_),
-				  std::move(temp_header_value_holder_)});
+BLUETH_FORCE_INLINE inline bool
+HTTPResponseMessage::isTempHeaderValueEmpty() const noexcept {
+	return temp_header_value_holder_.empty();
+}
+
+BLUETH_FORCE_INLINE inline bool
+HTTPResponseMessage::addTempHeadersHolderToMessage() noexcept(false) {
+	// Trailing whitespace is not a part of the field value(RFC 7230 3.2)
+	while (!temp_header_value_holder_.empty() &&
+	       (temp_header_value_holder_.back() ==
+		    static_cast<char>(LexConsts::SP) ||
+		temp_header_value_holder_.back() ==
+		    static_cast<char>(LexConsts::HT)))
+		temp_header_value_holder_.pop_back();
+	bool returner = true;
+	HTTPHeaderID header_id = header_id_from_name(temp_header_name_holder_);
+	// Same rules as the request, except that a final coding other than
+	// chunked is allowed, that body is delimited by the end of the
+	// connection(RFC 7230 3.3.3)
+	if (header_id == HTTPHeaderID::ContentLength) {
+		std::optional<std::size_t> content_length =
+		    parse_content_length(temp_header_value_holder_);
+		returner = content_length.has_value() &&
+			   !temp_transfer_encoding_seen_ &&
+			   (!temp_content_length_seen_ ||
+			    *content_length == temp_body_remaining_);
+		temp_body_remaining_ = content_length.value_or(0);
+		temp_content_length_seen_ = true;
+	} else if (header_id == HTTPHeaderID::TransferEncoding) {
+		returner = !temp_body_chunked_ && !temp_content_length_seen_;
+		temp_transfer_encoding_seen_ = true;
+		temp_body_chunked_ =
+		    is_chunked_transfer_coding(temp_header_value_holder_);
+	}
+	http_headers_->addHeader(temp_header_name_holder_,
+				 temp_header_value_holder_, header_id);
 	temp_header_name_holder_.clear();
 	temp_header_value_holder_.clear();
+	return returner;
+}
+
+BLUETH_FORCE_INLINE inline void
+HTTPResponseMessage::pushBackRawBody(std::string &&raw_body) noexcept(false) {
+	raw_body_.appendRawBytes(raw_body.c_str(), raw_body.size());
+}
+
+BLUETH_FORCE_INLINE inline void
+HTTPResponseMessage::pushBackRawBody(const char *data,
+				     std::size_t size) noexcept(false) {
+	raw_body_.appendRawBytes(data, size);
+}
+
+BLUETH_FORCE_INLINE inline std::size_t
+HTTPResponseMessage::getTempBodyRemaining() const noexcept {
+	return temp_body_remaining_;
 }
 
 BLUETH_FORCE_INLINE inline void
-HTTPResponseMessage::pushBackRawBody(std::string &&raw_body) noexcept {
-	raw_body_->appendRawBytes(raw_body.c_str(), raw_body.size());
+HTTPResponseMessage::consumeTempBody(std::size_t size) noexcept {
+	temp_body_remaining_ -= std::min(size, temp_body_remaining_);
+}
+
+BLUETH_FORCE_INLINE inline std::size_t
+HTTPResponseMessage::addTempHeadSize(std::size_t size) noexcept {
+	return temp_head_size_ += size;
+}
+
+BLUETH_FORCE_INLINE inline std::size_t
+HTTPResponseMessage::addTempBodySize(std::size_t size) noexcept {
+	return temp_body_size_ += size;
+}
+
+BLUETH_FORCE_INLINE inline bool
+HTTPResponseMessage::isTempBodyChunked() const noexcept {
+	return temp_body_chunked_;
+}
+
+BLUETH_FORCE_INLINE inline HTTPChunkedDecoder &
+HTTPResponseMessage::getTempChunkedDecoder() noexcept {
+	return temp_chunked_decoder_;
 }
 
 BLUETH_FORCE_INLINE inline void
-HTTPResponseMessage::pushBackResponseCode(char char_value) noexcept {
+HTTPResponseMessage::pushBackResponseCode(char char_value) noexcept(false) {
 	if (temp_http_status_code_holder_.current_index <= 2)
 		temp_http_status_code_holder_
 		    .http_code_holder[temp_http_status_code_holder_
@@ -0,0 +1,120 @@
+#pragma once
+#include "HTTPMessage.hpp"
+#include "common.hpp"
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// clang-format off
+/* HTTPMessagePool recycles HTTPRequestMessage/HTTPResponseMessage objects across connections. A released message
+ * is reset(), which keeps the memory of its headers, body and parser holders, so once the pool is warm a request
+ * is parsed without any heap allocation.
+ *
+ *    acquire()                      release(message)
+ *        |                                |
+ *        v                                v
+ *   [free list] --miss--> create()    reset() --> [free list] --full--> freed
+ *
+ * A pool belongs to one event loop(thread), it does no locking.
+ */
+// clang-format on
+
+namespace blueth::http {
+
+struct HTTPMessagePoolStats {
+	std::size_t acquired{};
+	std::size_t pool_hits{};
+	std::size_t released{};
+	// Number of messages in the free list
+	std::size_t cached{};
+	BLUETH_FORCE_INLINE double hitRate() const noexcept {
+		return acquired ? static_cast<double>(pool_hits) / acquired : 0;
+	}
+};
+
+template <typename MessageType> class HTTPMessagePool {
+	static_assert(std::is_same_v<MessageType, HTTPRequestMessage> ||
+			  std::is_same_v<MessageType, HTTPResponseMessage>,
+		      "HTTPMessagePool holds HTTP request or response messages");
+
+      public:
+	using message_type = std::unique_ptr<MessageType>;
+	static constexpr std::size_t default_max_cached = 1024;
+
+	/**
+	 * @param max_cached Maximum number of messages kept in the free list,
+	 * the ones released past it are freed
+	 */
+	explicit HTTPMessagePool(std::size_t max_cached = default_max_cached) noexcept(false);
+	HTTPMessagePool(const HTTPMessagePool &) = delete;
+	HTTPMessagePool &operator=(const HTTPMessagePool &) = delete;
+	/**
+	 * Get a message which is as good as new
+	 */
+	message_type acquire() noexcept(false);
+	/**
+	 * Reset the message and keep it for a later acquire()
+	 */
+	void release(message_type message) noexcept;
+	HTTPMessagePoolStats getStats() const noexcept;
+	/**
+	 * Free all the messages in the free list
+	 */
+	void trim() noexcept;
+
+      private:
+	std::vector<message_type> free_messages_;
+	std::size_t max_cached_;
+	std::size_t acquired_{};
+	std::size_t pool_hits_{};
+	std::size_t released_{};
+};
+
+template <typename MessageType>
+inline HTTPMessagePool<MessageType>::HTTPMessagePool(
+    std::size_t max_cached) noexcept(false)
+    : max_cached_{max_cached} {
+	// release() never has to grow the free list
+	free_messages_.reserve(max_cached_);
+}
+
+template <typename MessageType>
+inline typename HTTPMessagePool<MessageType>::message_type
+HTTPMessagePool<MessageType>::acquire() noexcept(false) {
+	acquired_++;
+	if (free_messages_.empty()) return MessageType::create();
+	message_type message = std::move(free_messages_.back());
+	free_messages_.pop_back();
+	pool_hits_++;
+	return message;
+}
+
+template <typename MessageType>
+inline void
+HTTPMessagePool<MessageType>::release(message_type message) noexcept {
+	if (!message) return;
+	released_++;
+	// The free list is full, the message is freed when we return
+	if (free_messages_.size() >= max_cached_) return;
+	message->reset();
+	free_messages_.push_back(std::move(message));
+}
+
+template <typename MessageType>
+inline HTTPMessagePoolStats
+HTTPMessagePool<MessageType>::getStats() const noexcept {
+	HTTPMessagePoolStats stats;
+	stats.acquired = acquired_;
+	stats.pool_hits = pool_hits_;
+	stats.released = released_;
+	stats.cached = free_messages_.size();
+	return stats;
+}
+
+template <typename MessageType>
+inline void HTTPMessagePool<MessageType>::trim() noexcept {
+	free_messages_.clear();
+}
+
+} // namespace blueth::http
@@ -1,26 +1,18 @@
 #pragma once
 #include "HTTPConstants.hpp"
 #include "common.hpp"
+#include "utils/simd.hpp"
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
 #include <optional>
 #include <string>
+#include <string_view>
 
 namespace blueth::http {
 
-#define str3cmp_macro(ptr, c0, c1, c2)                                         \
-	*(ptr + 0) == c0 &&*(ptr + 1) == c1 &&*(ptr + 2) == c2
-
-static bool str3cmp(const char *ptr, const char *cmp) {
-	return str3cmp_macro(ptr, *(cmp + 0), *(cmp + 1), *(cmp + 2));
-}
-#define str4cmp_macro(ptr, c0, c1, c2, c3)                                     \
-	*(ptr + 0) == c0 &&*(ptr + 1) == c1 &&*(ptr + 2) == c2 &&*(ptr + 3) == \
-	    c3
-
-static bool str4cmp(const char *ptr, const char *cmp) {
-	return str4cmp_macro(ptr, *(cmp + 0), *(cmp + 1), *(cmp + 2),
-			     *(cmp + 3));
-}
-
 BLUETH_FORCE_INLINE constexpr static bool is_separator(char value) {
 	switch (value) {
 	case '(':
@@ -66,94 +58,321 @@ BLUETH_FORCE_INLINE constexpr static bool is_text(char value) {
 		 (value == static_cast<char>(LexConsts::HT))));
 }
 
-static std::optional<std::string>
-string_from_response_code(HTTPResponseCodes response_code) {
-	switch (response_code) {
-	case HTTPResponseCodes::Continue:
-		return "Continue";
-	case HTTPResponseCodes::SwitchingProtocols:
-		return "Switching Protocols";
-	case HTTPResponseCodes::Ok:
-		return "OK";
-	case HTTPResponseCodes::Created:
-		return "Created";
-	case HTTPResponseCodes::Accepted:
-		return "Accepted";
-	case HTTPResponseCodes::NonAuthoritativeInformation:
-		return "Non-Authoritative Information";
-	case HTTPResponseCodes::NoContent:
-		return "No Content";
-	case HTTPResponseCodes::ResetContent:
-		return "Reset Content";
-	case HTTPResponseCodes::PartialContent:
-		return "Partial Content";
-	case HTTPResponseCodes::MultipleChoices:
-		return "Multiple Choices";
-	case HTTPResponseCodes::MovedPermanently:
-		return "Moved Permanently";
-	case HTTPResponseCodes::Found:
-		return "Found";
-	case HTTPResponseCodes::SeeOther:
-		return "See Other";
-	case HTTPResponseCodes::NotModified:
-		return "Not Modified";
-	case HTTPResponseCodes::UseProxy:
-		return "Use Proxy";
-	case HTTPResponseCodes::TemporaryRedirect:
-		return "Temporary Redirect";
-	case HTTPResponseCodes::BadRequest:
-		return "Bad Request";
-	case HTTPResponseCodes::Unauthorized:
-		return "Unauthorized";
-	case HTTPResponseCodes::PaymentRequired:
-		return "Payment Required";
-	case HTTPResponseCodes::Forbidden:
-		return "Forbidden";
-	case HTTPResponseCodes::NotFound:
-		return "Not Found";
-	case HTTPResponseCodes::MethodNotAllowed:
-		return "Method Not Allowed";
-	case HTTPResponseCodes::NotAcceptable:
-		return "Not Acceptable";
-	case HTTPResponseCodes::ProxyAuthenticationRequired:
-		return "Proxy Authentication Required";
-	case HTTPResponseCodes::RequestTimeOut:
-		return "Request Time-out";
-	case HTTPResponseCodes::Conflict:
-		return "Conflict";
-	case HTTPResponseCodes::Gone:
-		return "Gone";
-	case HTTPResponseCodes::LengthRequired:
-		return "Length Required";
-	case HTTPResponseCodes::PreconditionFailed:
-		return "Precondition Failed";
-	case HTTPResponseCodes::RequestEntityTooLarge:
-		return "Request Entity Too Large";
-	case HTTPResponseCodes::RequestURITooLarge:
-		return "Request-URI Too Large";
-	case HTTPResponseCodes::UnsupportedMediaType:
-		return "Unsupported Media Type";
-	case HTTPResponseCodes::RequestRangeNotSatisfiable:
-		return "Requested range not satisfiable";
-	case HTTPResponseCodes::ExpectationFailed:
-		return "Expectation Failed";
-	case HTTPResponseCodes::InternalServerError:
-		return "Internal Server Error";
-	case HTTPResponseCodes::NotImplemented:
-		return "Not Implemented";
-	case HTTPResponseCodes::BadGateway:
-		return "Bad Gateway";
-	case HTTPResponseCodes::ServiceUnavailable:
-		return "Service Unavailable";
-	case HTTPResponseCodes::GatewayTimeOut:
-		return "Gateway Time-out";
-	case HTTPResponseCodes::HttpVersionNotSupported:
-		return "HTTP Version not supported";
-	case HTTPResponseCodes::InvalidHttpCode:
+// Character class of the token bytes, for the vectorized scanning of methods
+// and header names
+inline constexpr simd::char_class_set token_char_class =
+    simd::char_class_set::make([](char value) { return is_token(value); });
+
+BLUETH_FORCE_INLINE constexpr static char to_lower_ascii(char value) {
+	return (value >= 'A' && value <= 'Z') ? value + ('a' - 'A') : value;
+}
+
+BLUETH_FORCE_INLINE constexpr static bool
+case_insensitive_equal(std::string_view lhs, std::string_view rhs) {
+	if (lhs.size() != rhs.size()) return false;
+	for (std::size_t index{}; index < lhs.size(); index++)
+		if (to_lower_ascii(lhs[index]) != to_lower_ascii(rhs[index]))
+			return false;
+	return true;
+}
+
+// Value of a hex digit, -1 if value is not one
+BLUETH_FORCE_INLINE constexpr static int hex_digit_value(char value) {
+	if (value >= '0' && value <= '9') return value - '0';
+	if (value >= 'a' && value <= 'f') return value - 'a' + 10;
+	if (value >= 'A' && value <= 'F') return value - 'A' + 10;
+	return -1;
+}
+
+/**
+ * Parse the value of a Content-Length header(1*DIGIT)
+ *
+ * @return The length, or std::nullopt if the value is not a valid length
+ */
+inline std::optional<std::size_t>
+parse_content_length(std::string_view header_value) noexcept {
+	std::size_t returner{};
+	const char *value_end = header_value.data() + header_value.size();
+	auto [parse_end, error] =
+	    std::from_chars(header_value.data(), value_end, returner);
+	if (header_value.empty() || error != std::errc{} ||
+	    parse_end != value_end)
 		return std::nullopt;
+	return returner;
+}
+
+/**
+ * Whether chunked is the final transfer-coding of a Transfer-Encoding header
+ * value(RFC 7230 3.3.1), for example "gzip, chunked"
+ */
+inline bool is_chunked_transfer_coding(std::string_view header_value) noexcept {
+	std::size_t last_comma = header_value.rfind(',');
+	if (last_comma != std::string_view::npos)
+		header_value.remove_prefix(last_comma + 1);
+	while (!header_value.empty() &&
+	       (header_value.front() == static_cast<char>(LexConsts::SP) ||
+		header_value.front() == static_cast<char>(LexConsts::HT)))
+		header_value.remove_prefix(1);
+	while (!header_value.empty() &&
+	       (header_value.back() == static_cast<char>(LexConsts::SP) ||
+		header_value.back() == static_cast<char>(LexConsts::HT)))
+		header_value.remove_suffix(1);
+	return case_insensitive_equal(header_value, "chunked");
+}
+
+/**
+ * value without the leading and trailing whitespace(OWS)
+ */
+BLUETH_FORCE_INLINE constexpr static std::string_view
+trim_ows(std::string_view value) noexcept {
+	while (!value.empty() && (value.front() == static_cast<char>(LexConsts::SP) ||
+				  value.front() == static_cast<char>(LexConsts::HT)))
+		value.remove_prefix(1);
+	while (!value.empty() && (value.back() == static_cast<char>(LexConsts::SP) ||
+				  value.back() == static_cast<char>(LexConsts::HT)))
+		value.remove_suffix(1);
+	return value;
+}
+
+/**
+ * Whether a comma separated header value(RFC 7230 7) lists element, compared
+ * case-insensitively
+ */
+inline bool has_list_element(std::string_view header_value,
+			     std::string_view element) noexcept {
+	while (!header_value.empty()) {
+		std::size_t comma = header_value.find(',');
+		std::string_view list_element = header_value.substr(0, comma);
+		header_value.remove_prefix(comma == std::string_view::npos
+					       ? header_value.size()
+					       : comma + 1);
+		if (case_insensitive_equal(trim_ows(list_element), element))
+			return true;
+	}
+	return false;
+}
+
+/**
+ * Whether a Connection header value lists the close option(RFC 7230 6.1), for
+ * example "close" or "TE, close"
+ */
+inline bool has_connection_close(std::string_view header_value) noexcept {
+	return has_list_element(header_value, "close");
+}
+
+/**
+ * Size limits of the message parsers. A message is rejected as soon as it
+ * crosses a limit, before the rest of it is read or buffered.
+ */
+struct HTTPParserLimits {
+	// Size of the request-target
+	std::size_t max_target_resource_size{8 * 1024};
+	// Size of the request-line(status-line) and all the header fields, with
+	// the CRLFs
+	std::size_t max_header_section_size{64 * 1024};
+	// Size of the Content-Length body or the sum of the chunk sizes
+	std::size_t max_body_size{std::numeric_limits<std::size_t>::max()};
+};
+
+BLUETH_FORCE_INLINE constexpr static bool
+is_parser_error(ParserState parser_state) {
+	switch (parser_state) {
+	case ParserState::ProtocolError:
+	case ParserState::VersionNotSupported:
+	case ParserState::RequestURITooLarge:
+	case ParserState::HeaderSectionTooLarge:
+	case ParserState::BodyTooLarge:
+		return true;
 	default:
-		return std::nullopt;
+		return false;
+	}
+}
+
+// Whether the parser is still in the request-line or the header fields
+BLUETH_FORCE_INLINE constexpr static bool
+is_request_head_state(ParserState parser_state) {
+	switch (parser_state) {
+	case ParserState::MessageBody:
+	case ParserState::MessageBodyChunked:
+	case ParserState::ParsingDone:
+		return false;
+	default:
+		return !is_parser_error(parser_state);
+	}
+}
+
+BLUETH_FORCE_INLINE constexpr static bool
+is_parser_error(ResponseParserState parser_state) {
+	switch (parser_state) {
+	case ResponseParserState::ProtocolError:
+	case ResponseParserState::HeaderSectionTooLarge:
+	case ResponseParserState::BodyTooLarge:
+		return true;
+	default:
+		return false;
 	}
 }
 
+// Whether the parser is still in the status-line or the header fields
+BLUETH_FORCE_INLINE constexpr static bool
+is_response_head_state(ResponseParserState parser_state) {
+	switch (parser_state) {
+	case ResponseParserState::ResponseMessageBody:
+	case ResponseParserState::ResponseMessageBodyChunked:
+	case ResponseParserState::ResponseMessageBodyUntilClose:
+	case ResponseParserState::ParsingDone:
+		return false;
+	default:
+		return !is_parser_error(parser_state);
+	}
+}
+
+/**
+ * Result of parsing a message out of a buffer. 'consumed' is the number of
+ * bytes of the input which belong to the parsed message(when state is
+ * ParsingDone), the next pipelined message starts right after them.
+ */
+template <typename StateType> struct HTTPParseResult {
+	StateType state;
+	std::size_t consumed{};
+};
+
+struct HTTPStatusReason {
+	HTTPResponseCodes response_code;
+	std::string_view reason_phrase;
+};
+
+inline constexpr std::array<HTTPStatusReason, 41> http_status_reasons{{
+    {HTTPResponseCodes::Continue, "Continue"},
+    {HTTPResponseCodes::SwitchingProtocols, "Switching Protocols"},
+    {HTTPResponseCodes::Ok, "OK"},
+    {HTTPResponseCodes::Created, "Created"},
+    {HTTPResponseCodes::Accepted, "Accepted"},
+    {HTTPResponseCodes::NonAuthoritativeInformation,
+     "Non-Authoritative Information"},
+    {HTTPResponseCodes::NoContent, "No Content"},
+    {HTTPResponseCodes::ResetContent, "Reset Content"},
+    {HTTPResponseCodes::PartialContent, "Partial Content"},
+    {HTTPResponseCodes::MultipleChoices, "Multiple Choices"},
+    {HTTPResponseCodes::MovedPermanently, "Moved Permanently"},
+    {HTTPResponseCodes::Found, "Found"},
+    {HTTPResponseCodes::SeeOther, "See Other"},
+    {HTTPResponseCodes::NotModified, "Not Modified"},
+    {HTTPResponseCodes::UseProxy, "Use Proxy"},
+    {HTTPResponseCodes::TemporaryRedirect, "Temporary Redirect"},
+    {HTTPResponseCodes::BadRequest, "Bad Request"},
+    {HTTPResponseCodes::Unauthorized, "Unauthorized"},
+    {HTTPResponseCodes::PaymentRequired, "Payment Required"},
+    {HTTPResponseCodes::Forbidden, "Forbidden"},
+    {HTTPResponseCodes::NotFound, "Not Found"},
+    {HTTPResponseCodes::MethodNotAllowed, "Method Not Allowed"},
+    {HTTPResponseCodes::NotAcceptable, "Not Acceptable"},
+    {HTTPResponseCodes::ProxyAuthenticationRequired,
+     "Proxy Authentication Required"},
+    {HTTPResponseCodes::RequestTimeOut, "Request Time-out"},
+    {HTTPResponseCodes::Conflict, "Conflict"},
+    {HTTPResponseCodes::Gone, "Gone"},
+    {HTTPResponseCodes::LengthRequired, "Length Required"},
+    {HTTPResponseCodes::PreconditionFailed, "Precondition Failed"},
+    {HTTPResponseCodes::RequestEntityTooLarge, "Request Entity Too Large"},
+    {HTTPResponseCodes::RequestURITooLarge, "Request-URI Too Large"},
+    {HTTPResponseCodes::UnsupportedMediaType, "Unsupported Media Type"},
+    {HTTPResponseCodes::RequestRangeNotSatisfiable,
+     "Requested range not satisfiable"},
+    {HTTPResponseCodes::ExpectationFailed, "Expectation Failed"},
+    {HTTPResponseCodes::RequestHeaderFieldsTooLarge,
+     "Request Header Fields Too Large"},
+    {HTTPResponseCodes::InternalServerError, "Internal Server Error"},
+    {HTTPResponseCodes::NotImplemented, "Not Implemented"},
+    {HTTPResponseCodes::BadGateway, "Bad Gateway"},
+    {HTTPResponseCodes::ServiceUnavailable, "Service Unavailable"},
+    {HTTPResponseCodes::GatewayTimeOut, "Gateway Time-out"},
+    {HTTPResponseCodes::HttpVersionNotSupported, "HTTP Version not supported"},
+}};
+
+/**
+ * The HTTP/1.1 status-lines("HTTP/1.1 200 OK\r\n") of http_status_reasons,
+ * rendered at compile time. slots[code - 100] holds (index of the line + 1) or
+ * 0 for a code without a reason phrase.
+ */
+struct StatusLineTable {
+	static constexpr std::size_t max_line_size = 48;
+	static constexpr std::size_t first_code = 100;
+	std::array<std::array<char, max_line_size>, http_status_reasons.size()>
+	    lines{};
+	std::array<std::uint8_t, http_status_reasons.size()> line_sizes{};
+	std::array<std::uint8_t, 500> slots{};
+};
+
+constexpr StatusLineTable make_status_line_table() {
+	StatusLineTable returner;
+	constexpr std::string_view version = "HTTP/1.1 ";
+	for (std::size_t index{}; index < http_status_reasons.size(); index++) {
+		auto [response_code, reason_phrase] = http_status_reasons[index];
+		int code = static_cast<int>(response_code);
+		std::array<char, StatusLineTable::max_line_size> &line =
+		    returner.lines[index];
+		std::size_t line_size{};
+		for (char version_char : version) line[line_size++] = version_char;
+		line[line_size++] = static_cast<char>('0' + code / 100);
+		line[line_size++] = static_cast<char>('0' + code / 10 % 10);
+		line[line_size++] = static_cast<char>('0' + code % 10);
+		line[line_size++] = static_cast<char>(LexConsts::SP);
+		for (char reason_char : reason_phrase) line[line_size++] = reason_char;
+		line[line_size++] = static_cast<char>(LexConsts::CR);
+		line[line_size++] = static_cast<char>(LexConsts::LF);
+		returner.line_sizes[index] = static_cast<std::uint8_t>(line_size);
+		returner.slots[code - StatusLineTable::first_code] =
+		    static_cast<std::uint8_t>(index + 1);
+	}
+	return returner;
+}
+
+inline constexpr StatusLineTable status_line_table = make_status_line_table();
+
+/**
+ * @return The HTTP/1.1 status-line of the code with its CRLF, or an empty view
+ * if the code has no reason phrase
+ */
+BLUETH_FORCE_INLINE constexpr static std::string_view
+status_line_from_response_code(HTTPResponseCodes response_code) {
+	std::size_t slot_index = static_cast<std::size_t>(response_code) -
+				 StatusLineTable::first_code;
+	if (slot_index >= status_line_table.slots.size()) return {};
+	std::uint8_t slot = status_line_table.slots[slot_index];
+	if (!slot) return {};
+	return {status_line_table.lines[slot - 1].data(),
+		status_line_table.line_sizes[slot - 1]};
+}
+
+// The reason phrase of the code, an empty view if it has none
+BLUETH_FORCE_INLINE constexpr static std::string_view
+reason_phrase_from_response_code(HTTPResponseCodes response_code) {
+	std::string_view status_line =
+	    status_line_from_response_code(response_code);
+	// "HTTP/1.1 200 " and the CRLF
+	if (status_line.empty()) return {};
+	return status_line.substr(13, status_line.size() - 15);
+}
+
+// Reason phrases of the status code classes(RFC 7231 6), the reason of a code
+// which has none in http_status_reasons
+inline constexpr std::array<std::string_view, 5> http_status_class_reasons{
+    "Informational", "Success", "Redirection", "Client Error", "Server Error"};
+
+// Whether the code can be put on a status-line, any code of the five classes
+BLUETH_FORCE_INLINE constexpr bool
+is_valid_response_code(HTTPResponseCodes response_code) noexcept {
+	int code = static_cast<int>(response_code);
+	return code >= 100 && code <= 599;
+}
+
+inline std::optional<std::string>
+string_from_response_code(HTTPResponseCodes response_code) {
+	std::string_view reason_phrase =
+	    reason_phrase_from_response_code(response_code);
+	if (reason_phrase.empty()) return std::nullopt;
+	return std::string{reason_phrase};
+}
+
 } // namespace blueth::http
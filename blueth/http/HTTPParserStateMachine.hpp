@@ -1,22 +1,56 @@
 #pragma once
 #include "HTTPMessage.hpp"
 #include "HTTPParserCommon.hpp"
+#include "HTTPTokenTable.hpp"
 #include "common.hpp"
 #include "http/HTTPConstants.hpp"
 #include "io/IOBuffer.hpp"
+#include "utils/simd.hpp"
+#include <algorithm>
 #include <cctype>
+#include <cstddef>
 #include <memory>
+#include <new>
 #include <utility>
 
 namespace blueth::http {
 
-// Parser for HTTP Requet Message
+// Parser for HTTP Requet Message. BufferPointer is a unique_ptr or shared_ptr
+// to any byte container with the io::IOBuffer offset API(io::IOBuffer,
+// io::MirroredRingBuffer)
+//
+// With UseSIMD(the default), the variable length parts(method, target, header
+// names and values) are scanned 16/32 bytes at a time and appended to the
+// message as a whole run, the single byte states are shared with the scalar
+// byte-at-a-time parser(UseSIMD = false). Both keep the same resumable
+// ParserState contract.
+//
+// The parser stops right after the last byte of the message(the end of the
+// headers, or the Content-Length bytes of the body) and sets consumed_bytes to
+// the number of bytes it used from the data region of request_message, the
+// next pipelined request starts at getStartOffsetPointer() + consumed_bytes.
+// The buffer offsets are not modified.
+//
+// The body is not stored in http_message, body_sink(const char *data,
+// std::size_t size) is invoked with every run of body bytes straight out of
+// request_message(the de-chunked data for a chunked body), so a large upload
+// can be streamed to a file or an upstream with constant memory. A request
+// past one of the limits ends in RequestURITooLarge, HeaderSectionTooLarge or
+// BodyTooLarge as soon as the limit is crossed(a Content-Length or a chunk
+// size past max_body_size is rejected before its bytes are read). A request
+// line with an HTTP-version other than 1.0 and 1.1 ends in VersionNotSupported.
+template <bool UseSIMD = true,
+	  typename BufferPointer = std::unique_ptr<io::IOBuffer<char>>,
+	  typename BodySink>
 inline std::unique_ptr<HTTPRequestMessage>
 ParseHTTP1_1RequestMessage(
-    const std::unique_ptr<io::IOBuffer<char>> &request_message,
+    const BufferPointer &request_message,
     ParserState &current_state,
-    std::unique_ptr<HTTPRequestMessage> http_message) {
-	const char *start_buffer = request_message->getStartOffsetPointer();
+    std::unique_ptr<HTTPRequestMessage> http_message,
+    std::size_t &consumed_bytes, const HTTPParserLimits &parser_limits,
+    BodySink &&body_sink) {
+	const char *const parse_start = request_message->getStartOffsetPointer();
+	const char *start_buffer = parse_start;
 	const char *end_buffer = request_message->getEndOffsetPointer();
 
 	// clang-format off
@@ -37,6 +71,14 @@ ParseHTTP1_1RequestMessage(
 			}
 			break;
 		case ParserState::RequestMethod:
+			if constexpr (UseSIMD) {
+				const char *run_end = simd::find_first_not_in_class(
+				    start_buffer, end_buffer, token_char_class);
+				http_message->pushBackRequestMethod(
+				    start_buffer, run_end - start_buffer);
+				start_buffer = run_end;
+				if (start_buffer == end_buffer) break;
+			}
 			if (*start_buffer == static_cast<char>(LexConsts::SP)) {
 				current_state = ParserState::RequestResource;
 				increment_buffer_offset();
@@ -49,6 +91,26 @@ ParseHTTP1_1RequestMessage(
 			}
 			break;
 		case ParserState::RequestResource:
+			if (http_message->getTargetResource().size() >
+			    parser_limits.max_target_resource_size) {
+				current_state = ParserState::RequestURITooLarge;
+				break;
+			}
+			if constexpr (UseSIMD) {
+				// Printable characters without SP
+				const char *run_end = simd::find_first_not_in_range(
+				    start_buffer, end_buffer, 0x21, 0x7E);
+				http_message->pushBackTargetResource(
+				    start_buffer, run_end - start_buffer);
+				start_buffer = run_end;
+				if (http_message->getTargetResource().size() >
+				    parser_limits.max_target_resource_size) {
+					current_state =
+					    ParserState::RequestURITooLarge;
+					break;
+				}
+				if (start_buffer == end_buffer) break;
+			}
 			if (*start_buffer == static_cast<char>(LexConsts::SP)) {
 				current_state = ParserState::RequestProtocolH;
 				increment_buffer_offset();
@@ -103,9 +165,15 @@ ParseHTTP1_1RequestMessage(
 			}
 			break;
 		case ParserState::RequestProtocolVersionMajor:
-			if (std::isdigit(*start_buffer)) {
+			if (*start_buffer == '1') {
+				// HTTP/1.0 until the minor version is 1
+				http_message->setHTTPVersion(
+				    HTTPVersion::HTTP1_0);
 				current_state = ParserState::RequestProtocolDot;
 				increment_buffer_offset();
+			} else if (std::isdigit(*start_buffer)) {
+				current_state =
+				    ParserState::VersionNotSupported;
 			} else {
 				current_state = ParserState::ProtocolError;
 			}
@@ -120,12 +188,22 @@ ParseHTTP1_1RequestMessage(
 			}
 			break;
 		case ParserState::RequestProtocolVersionMinor:
-			if (std::isdigit(*start_buffer)) {
-				http_message->setHTTPVersion(
-				    HTTPVersion::HTTP1_1);
+			if (*start_buffer == '0' || *start_buffer == '1') {
+				if (*start_buffer == '1')
+					http_message->setHTTPVersion(
+					    HTTPVersion::HTTP1_1);
+				current_state = ParserState::RequestLineCR;
 				increment_buffer_offset();
-			} else if (*start_buffer ==
-				   static_cast<char>(LexConsts::CR)) {
+			} else if (std::isdigit(*start_buffer)) {
+				current_state =
+				    ParserState::VersionNotSupported;
+			} else {
+				current_state = ParserState::ProtocolError;
+			}
+			break;
+		// HTTP-version is "HTTP/" DIGIT "." DIGIT
+		case ParserState::RequestLineCR:
+			if (*start_buffer == static_cast<char>(LexConsts::CR)) {
 				current_state = ParserState::RequestLineLF;
 				increment_buffer_offset();
 			} else {
@@ -141,6 +219,14 @@ ParseHTTP1_1RequestMessage(
 			}
 			break;
 		case ParserState::HeaderName:
+			if constexpr (UseSIMD) {
+				const char *run_end = simd::find_first_not_in_class(
+				    start_buffer, end_buffer, token_char_class);
+				http_message->pushBackHeaderName(
+				    start_buffer, run_end - start_buffer);
+				start_buffer = run_end;
+				if (start_buffer == end_buffer) break;
+			}
 			if (is_token(*start_buffer)) {
 				http_message->pushBackHeaderName(*start_buffer);
 				increment_buffer_offset();
@@ -156,17 +242,32 @@ ParseHTTP1_1RequestMessage(
 			}
 			break;
 		case ParserState::HeaderValue:
+			if constexpr (UseSIMD) {
+				if (!http_message->isTempHeaderValueEmpty() ||
+				    (*start_buffer !=
+					 static_cast<char>(LexConsts::SP) &&
+				     *start_buffer !=
+					 static_cast<char>(LexConsts::HT))) {
+					const char *run_end =
+					    simd::find_first_control_char(
+						start_buffer, end_buffer);
+					http_message->pushBackHeaderValue(
+					    start_buffer,
+					    run_end - start_buffer);
+					start_buffer = run_end;
+					if (start_buffer == end_buffer) break;
+				}
+			}
 			if (*start_buffer == static_cast<char>(LexConsts::CR)) {
 				current_state = ParserState::HeaderValueLF;
 				increment_buffer_offset();
-			} else if (*start_buffer ==
-				   static_cast<char>(LexConsts::SP)) {
-				if (*(start_buffer - 1) == ':') {
-					increment_buffer_offset();
-				} else {
-					current_state =
-					    ParserState::ProtocolError;
-				}
+			} else if ((*start_buffer ==
+					static_cast<char>(LexConsts::SP) ||
+				    *start_buffer ==
+					static_cast<char>(LexConsts::HT)) &&
+				   http_message->isTempHeaderValueEmpty()) {
+				// Skip the leading whitespace of the value
+				increment_buffer_offset();
 			} else if (is_text(*start_buffer)) {
 				http_message->pushBackHeaderValue(
 				    *start_buffer);
@@ -176,51 +277,186 @@ ParseHTTP1_1RequestMessage(
 			}
 			break;
 		case ParserState::HeaderValueLF:
-			if (*start_buffer == static_cast<char>(LexConsts::LF)) {
-				increment_buffer_offset();
-				http_message->addTempHeadersHolderToMessage();
-				current_state = ParserState::HeaderName;
-			} else {
+			if (*start_buffer != static_cast<char>(LexConsts::LF)) {
 				current_state = ParserState::ProtocolError;
+				break;
+			}
+			increment_buffer_offset();
+			try {
+				current_state =
+				    http_message->addTempHeadersHolderToMessage()
+					? ParserState::HeaderName
+					: ParserState::ProtocolError;
+			} catch (const std::bad_alloc &) {
+				current_state =
+				    ParserState::HeaderSectionTooLarge;
 			}
 			break;
-		// clang-format off
 		case ParserState::HeaderEndLF:
 			if (*start_buffer == static_cast<char>(LexConsts::LF)) {
-				if (str3cmp(http_message->getTempRequestMethod().c_str(), "GET")) {
-					current_state = ParserState::ParsingDone;
-					http_message->setRequestType(HTTPRequestType::Get);
-					increment_buffer_offset();
-				} else if (str4cmp(http_message->getTempRequestMethod().c_str(), "POST")) {
-					current_state = ParserState::MessageBody;
-					http_message->setRequestType(HTTPRequestType::Post);
-					increment_buffer_offset();
-				} else if (str3cmp(http_message->getTempRequestMethod().c_str(), "PUT")) {
+				http_message->setRequestType(
+				    request_type_from_method(
+					http_message->getTempRequestMethod()));
+				// A request has a body only if it carries a
+				// chunked Transfer-Encoding or a Content-Length,
+				// never both(RFC 7230 3.3.3)
+				increment_buffer_offset();
+				if (http_message->addTempHeadSize(
+					start_buffer - parse_start) >
+				    parser_limits.max_header_section_size) {
+					current_state =
+					    ParserState::HeaderSectionTooLarge;
+				} else if (http_message->isTempBodyChunked()) {
+					http_message->getTempChunkedDecoder()
+					    .setMaxBodySize(
+						parser_limits.max_body_size);
+					current_state =
+					    ParserState::MessageBodyChunked;
+				} else if (http_message->getTempBodyRemaining() >
+					   parser_limits.max_body_size) {
+					current_state = ParserState::BodyTooLarge;
+				} else if (http_message->getTempBodyRemaining()) {
 					current_state = ParserState::MessageBody;
-					http_message->setRequestType(HTTPRequestType::Put);
-					increment_buffer_offset();
-				} else if (str4cmp(http_message->getTempRequestMethod().c_str(), "HEAD")) {
-					current_state = ParserState::ParsingDone;
-					http_message->setRequestType(HTTPRequestType::Head);
-					increment_buffer_offset();
 				} else {
-					http_message->setRequestType(HTTPRequestType::Unsupported);
+					current_state = ParserState::ParsingDone;
 				}
+			} else {
+				current_state = ParserState::ProtocolError;
 			}
 			break;
-		// clang-format on
-		case ParserState::MessageBody:
-			http_message->pushBackRawBody(
-			    std::string{start_buffer, end_buffer});
-			goto FINISH;
+		case ParserState::MessageBody: {
+			std::size_t body_size = std::min<std::size_t>(
+			    http_message->getTempBodyRemaining(),
+			    end_buffer - start_buffer);
+			// The body buffer(in memory or spilled) failed to grow
+			try {
+				body_sink(start_buffer, body_size);
+			} catch (const std::bad_alloc &) {
+				current_state = ParserState::BodyTooLarge;
+				break;
+			}
+			http_message->consumeTempBody(body_size);
+			increment_buffer_offset(body_size);
+			if (!http_message->getTempBodyRemaining())
+				current_state = ParserState::ParsingDone;
+			break;
+		}
+		case ParserState::MessageBodyChunked: {
+			HTTPChunkedDecoder &chunked_decoder =
+			    http_message->getTempChunkedDecoder();
+			HTTPParseResult<ChunkedDecoderState> chunked_result;
+			try {
+				chunked_result = chunked_decoder.decode(
+				    start_buffer, end_buffer, body_sink);
+			} catch (const std::bad_alloc &) {
+				current_state = ParserState::BodyTooLarge;
+				break;
+			}
+			increment_buffer_offset(chunked_result.consumed);
+			if (chunked_result.state ==
+			    ChunkedDecoderState::DecodingDone)
+				current_state = ParserState::ParsingDone;
+			else if (chunked_result.state ==
+				 ChunkedDecoderState::ProtocolError)
+				current_state = ParserState::ProtocolError;
+			else if (chunked_result.state ==
+				 ChunkedDecoderState::BodyTooLarge)
+				current_state = ParserState::BodyTooLarge;
+			break;
+		}
 		case ParserState::ParsingDone:
 			goto FINISH;
 		case ParserState::ProtocolError:
+		case ParserState::VersionNotSupported:
+		case ParserState::RequestURITooLarge:
+		case ParserState::HeaderSectionTooLarge:
+		case ParserState::BodyTooLarge:
 			goto FINISH;
 		}
 	}
 FINISH:
-	return std::move(http_message);
+	consumed_bytes = start_buffer - parse_start;
+	// The head continues in the next read
+	if (is_request_head_state(current_state) &&
+	    http_message->addTempHeadSize(consumed_bytes) >
+		parser_limits.max_header_section_size)
+		current_state = ParserState::HeaderSectionTooLarge;
+	return http_message;
+}
+
+/**
+ * Parse with the default HTTPParserLimits, the body is stored in the message
+ */
+template <bool UseSIMD = true,
+	  typename BufferPointer = std::unique_ptr<io::IOBuffer<char>>>
+inline std::unique_ptr<HTTPRequestMessage>
+ParseHTTP1_1RequestMessage(
+    const BufferPointer &request_message,
+    ParserState &current_state,
+    std::unique_ptr<HTTPRequestMessage> http_message,
+    std::size_t &consumed_bytes,
+    const HTTPParserLimits &parser_limits = HTTPParserLimits{}) {
+	HTTPRequestMessage *message = http_message.get();
+	return ParseHTTP1_1RequestMessage<UseSIMD>(
+	    request_message, current_state, std::move(http_message),
+	    consumed_bytes, parser_limits,
+	    [message](const char *data, std::size_t size) {
+		    message->pushBackRawBody(data, size);
+	    });
+}
+
+template <bool UseSIMD = true,
+	  typename BufferPointer = std::unique_ptr<io::IOBuffer<char>>>
+inline std::unique_ptr<HTTPRequestMessage>
+ParseHTTP1_1RequestMessage(
+    const BufferPointer &request_message,
+    ParserState &current_state,
+    std::unique_ptr<HTTPRequestMessage> http_message) {
+	std::size_t consumed_bytes{};
+	return ParseHTTP1_1RequestMessage<UseSIMD>(
+	    request_message, current_state, std::move(http_message),
+	    consumed_bytes);
+}
+
+/**
+ * Extract every complete request from the data region of request_buffer, so
+ * a pipelining client's batch of requests is handled after a single read.
+ * on_request(std::unique_ptr<HTTPRequestMessage>) is invoked for each complete
+ * request, in order, and the start offset of request_buffer is moved past it.
+ *
+ * A trailing partial request is left in current_state/http_message, the next
+ * call resumes it once more bytes are appended to the buffer.
+ *
+ * @param request_buffer Receive buffer of the connection
+ * @param current_state Parser state of the request in progress
+ * @param http_message Request in progress, replaced after each request
+ * @param on_request Callback for the complete requests
+ * @param parser_limits Size limits of each request
+ * @return Number of complete requests, parsing stops at the first error state
+ */
+template <bool UseSIMD = true,
+	  typename BufferPointer = std::unique_ptr<io::IOBuffer<char>>,
+	  typename RequestHandler>
+inline std::size_t ParseHTTP1_1PipelinedRequests(
+    const BufferPointer &request_buffer,
+    ParserState &current_state,
+    std::unique_ptr<HTTPRequestMessage> &http_message,
+    RequestHandler &&on_request,
+    const HTTPParserLimits &parser_limits = HTTPParserLimits{}) {
+	std::size_t request_count{};
+	while (request_buffer->getDataSize() && !is_parser_error(current_state)) {
+		std::size_t consumed_bytes{};
+		http_message = ParseHTTP1_1RequestMessage<UseSIMD>(
+		    request_buffer, current_state, std::move(http_message),
+		    consumed_bytes, parser_limits);
+		request_buffer->modifyStartOffset(consumed_bytes);
+		if (current_state != ParserState::ParsingDone) break;
+		on_request(std::move(http_message));
+		http_message = HTTPRequestMessage::create();
+		current_state = ParserState::RequestLineBegin;
+		request_count++;
+	}
+	return request_count;
 }
 
 } // namespace blueth::http
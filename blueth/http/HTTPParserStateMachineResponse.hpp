@@ -7,16 +7,49 @@
 #include <cctype>
 #include <cstdlib>
 #include <memory>
+#include <new>
 
-#include <iostream>
-#define print_me(x) std::cout << x << std::endl;
 namespace blueth::http {
 
+/**
+ * Whether a response carries a body, whatever its framing headers say(RFC
+ * 7230 3.3.3): 1xx, 204 and 304 responses, the responses to HEAD and the 2xx
+ * responses to CONNECT don't.
+ */
+BLUETH_FORCE_INLINE constexpr static bool
+response_has_body(HTTPResponseCodes response_code,
+		  HTTPRequestType request_type) {
+	int status_code = static_cast<int>(response_code);
+	if (status_code < 200 || status_code == 204 || status_code == 304)
+		return false;
+	if (request_type == HTTPRequestType::Head) return false;
+	return !(request_type == HTTPRequestType::Connect && status_code < 300);
+}
+
+// Parser for HTTP Response Message. BufferType is any byte container with the
+// io::IOBuffer offset API(io::IOBuffer, io::MirroredRingBuffer)
+//
+// The parser is resumable across reads like the request parser: it stops right
+// after the last byte of the response and sets consumed_bytes to the number of
+// bytes it used from the data region of response_message, the buffer offsets
+// are not modified. The body is framed by the chunked coding, the
+// Content-Length or, without either, by the end of the connection: the parser
+// stays in ResponseMessageBodyUntilClose until the caller reports the end of
+// the stream with ParseHTTP1_1ResponseEndOfStream.
+//
+// The body is not stored in http_message, body_sink(const char *data,
+// std::size_t size) is invoked with every run of body bytes(the de-chunked data
+// for a chunked body), so a client can process a multi-MB response as it
+// arrives. max_target_resource_size of parser_limits is not used.
+template <typename BufferType = io::IOBuffer<char>, typename BodySink>
 inline std::unique_ptr<HTTPResponseMessage> ParseHTTP1_1ResponseMessage(
-    const std::unique_ptr<io::IOBuffer<char>> &response_message,
+    const std::unique_ptr<BufferType> &response_message,
     ResponseParserState &current_state,
-    std::unique_ptr<HTTPResponseMessage> http_message) {
-	const char *start_buffer = response_message->getStartOffsetPointer();
+    std::unique_ptr<HTTPResponseMessage> http_message,
+    std::size_t &consumed_bytes, const HTTPParserLimits &parser_limits,
+    BodySink &&body_sink) {
+	const char *const parse_start = response_message->getStartOffsetPointer();
+	const char *start_buffer = parse_start;
 	const char *end_buffer = response_message->getEndOffsetPointer();
 
 	// clang-format off
@@ -78,6 +111,9 @@ inline std::unique_ptr<HTTPResponseMessage> ParseHTTP1_1ResponseMessage(
 			break;
 		case ResponseParserState::ResponseProtocolVersionMajor:
 			if (*start_buffer == '1') {
+				// HTTP/1.0 until a minor version other than 0
+				http_message->setHTTPVersion(
+				    HTTPVersion::HTTP1_0);
 				current_state =
 				    ResponseParserState::ResponseProtocolDot;
 				increment_buffer_offset();
@@ -98,8 +134,9 @@ inline std::unique_ptr<HTTPResponseMessage> ParseHTTP1_1ResponseMessage(
 			break;
 		case ResponseParserState::ResponseProtocolVersionMinor:
 			if (std::isdigit(*start_buffer)) {
-				http_message->setHTTPVersion(
-				    HTTPVersion::HTTP1_1);
+				if (*start_buffer != '0')
+					http_message->setHTTPVersion(
+					    HTTPVersion::HTTP1_1);
 				increment_buffer_offset();
 			} else if (*start_buffer ==
 				   static_cast<char>(LexConsts::SP)) {
@@ -172,11 +209,14 @@ inline std::unique_ptr<HTTPResponseMessage> ParseHTTP1_1ResponseMessage(
 				current_state =
 				    ResponseParserState::HeaderValueLF;
 				increment_buffer_offset();
+			} else if ((*start_buffer ==
+					static_cast<char>(LexConsts::SP) ||
+				    *start_buffer ==
+					static_cast<char>(LexConsts::HT)) &&
+				   http_message->isTempHeaderValueEmpty()) {
+				// Skip the leading whitespace of the value
+				increment_buffer_offset();
 			} else if (is_text(*start_buffer)) {
-				if (*(start_buffer - 1) == ':') {
-					increment_buffer_offset();
-					break;
-				}
 				http_message->pushBackHeaderValue(
 				    *start_buffer);
 				increment_buffer_offset();
@@ -186,44 +226,192 @@ inline std::unique_ptr<HTTPResponseMessage> ParseHTTP1_1ResponseMessage(
 			}
 			break;
 		case ResponseParserState::HeaderValueLF:
-			if (*start_buffer == static_cast<char>(LexConsts::LF)) {
-				increment_buffer_offset();
-				http_message->addTempHeadersHolderToMessage();
-				current_state = ResponseParserState::HeaderName;
-			} else {
+			if (*start_buffer != static_cast<char>(LexConsts::LF)) {
 				current_state =
 				    ResponseParserState::ProtocolError;
+				break;
+			}
+			increment_buffer_offset();
+			try {
+				current_state =
+				    http_message->addTempHeadersHolderToMessage()
+					? ResponseParserState::HeaderName
+					: ResponseParserState::ProtocolError;
+			} catch (const std::bad_alloc &) {
+				current_state =
+				    ResponseParserState::HeaderSectionTooLarge;
 			}
 			break;
 		case ResponseParserState::HeaderEndLF:
 			if (*start_buffer == static_cast<char>(LexConsts::LF)) {
-				if (http_message->constGetHTTPHeaders()
-					->headerContains("Content-Length")) {
+				// A response is framed by the chunked coding or
+				// by Content-Length, never both. One with neither
+				// is delimited by the end of the connection(RFC
+				// 7230 3.3.3)
+				increment_buffer_offset();
+				if (http_message->addTempHeadSize(
+					start_buffer - parse_start) >
+				    parser_limits.max_header_section_size) {
+					current_state = ResponseParserState::
+					    HeaderSectionTooLarge;
+				} else if (!response_has_body(
+					       http_message->getResponseCode(),
+					       http_message->getRequestType())) {
+					current_state =
+					    ResponseParserState::ParsingDone;
+				} else if (http_message->isTempBodyChunked()) {
+					http_message->getTempChunkedDecoder()
+					    .setMaxBodySize(
+						parser_limits.max_body_size);
+					current_state = ResponseParserState::
+					    ResponseMessageBodyChunked;
+				} else if (!http_message->constGetHTTPHeaders()
+						->headerContains(
+						    HTTPHeaderID::ContentLength)) {
+					current_state = ResponseParserState::
+					    ResponseMessageBodyUntilClose;
+				} else if (http_message->getTempBodyRemaining() >
+					   parser_limits.max_body_size) {
+					current_state =
+					    ResponseParserState::BodyTooLarge;
+				} else if (http_message->getTempBodyRemaining()) {
 					current_state = ResponseParserState::
 					    ResponseMessageBody;
 				} else {
 					current_state =
 					    ResponseParserState::ParsingDone;
 				}
-				increment_buffer_offset();
 			} else {
 				current_state =
 				    ResponseParserState::ProtocolError;
 			}
 			break;
-		case ResponseParserState::ResponseMessageBody:
-			http_message->pushBackRawBody(
-			    std::string{start_buffer, end_buffer});
-			current_state = ResponseParserState::ParsingDone;
-			goto FINISH;
+		case ResponseParserState::ResponseMessageBody: {
+			std::size_t body_size = std::min<std::size_t>(
+			    http_message->getTempBodyRemaining(),
+			    end_buffer - start_buffer);
+			// The body buffer(in memory or spilled) failed to grow
+			try {
+				body_sink(start_buffer, body_size);
+			} catch (const std::bad_alloc &) {
+				current_state =
+				    ResponseParserState::BodyTooLarge;
+				break;
+			}
+			http_message->consumeTempBody(body_size);
+			increment_buffer_offset(body_size);
+			if (!http_message->getTempBodyRemaining())
+				current_state = ResponseParserState::ParsingDone;
+			break;
+		}
+		case ResponseParserState::ResponseMessageBodyChunked: {
+			HTTPChunkedDecoder &chunked_decoder =
+			    http_message->getTempChunkedDecoder();
+			HTTPParseResult<ChunkedDecoderState> chunked_result;
+			try {
+				chunked_result = chunked_decoder.decode(
+				    start_buffer, end_buffer, body_sink);
+			} catch (const std::bad_alloc &) {
+				current_state =
+				    ResponseParserState::BodyTooLarge;
+				break;
+			}
+			increment_buffer_offset(chunked_result.consumed);
+			if (chunked_result.state ==
+			    ChunkedDecoderState::DecodingDone)
+				current_state = ResponseParserState::ParsingDone;
+			else if (chunked_result.state ==
+				 ChunkedDecoderState::ProtocolError)
+				current_state =
+				    ResponseParserState::ProtocolError;
+			else if (chunked_result.state ==
+				 ChunkedDecoderState::BodyTooLarge)
+				current_state =
+				    ResponseParserState::BodyTooLarge;
+			break;
+		}
+		case ResponseParserState::ResponseMessageBodyUntilClose: {
+			std::size_t body_size = end_buffer - start_buffer;
+			if (http_message->addTempBodySize(body_size) >
+			    parser_limits.max_body_size) {
+				current_state =
+				    ResponseParserState::BodyTooLarge;
+				break;
+			}
+			try {
+				body_sink(start_buffer, body_size);
+			} catch (const std::bad_alloc &) {
+				current_state =
+				    ResponseParserState::BodyTooLarge;
+				break;
+			}
+			increment_buffer_offset(body_size);
+			break;
+		}
 		case ResponseParserState::ParsingDone:
 			goto FINISH;
 		case ResponseParserState::ProtocolError:
 			goto FINISH;
+		case ResponseParserState::HeaderSectionTooLarge:
+			goto FINISH;
+		case ResponseParserState::BodyTooLarge:
+			goto FINISH;
 		}
 	}
 FINISH:
-	return std::move(http_message);
+	consumed_bytes = start_buffer - parse_start;
+	// The head continues in the next read
+	if (is_response_head_state(current_state) &&
+	    http_message->addTempHeadSize(consumed_bytes) >
+		parser_limits.max_header_section_size)
+		current_state = ResponseParserState::HeaderSectionTooLarge;
+	return http_message;
+}
+
+/**
+ * Parse with the default HTTPParserLimits, the body is stored in the message
+ */
+template <typename BufferType = io::IOBuffer<char>>
+inline std::unique_ptr<HTTPResponseMessage> ParseHTTP1_1ResponseMessage(
+    const std::unique_ptr<BufferType> &response_message,
+    ResponseParserState &current_state,
+    std::unique_ptr<HTTPResponseMessage> http_message,
+    std::size_t &consumed_bytes,
+    const HTTPParserLimits &parser_limits = HTTPParserLimits{}) {
+	HTTPResponseMessage *message = http_message.get();
+	return ParseHTTP1_1ResponseMessage(
+	    response_message, current_state, std::move(http_message),
+	    consumed_bytes, parser_limits,
+	    [message](const char *data, std::size_t size) {
+		    message->pushBackRawBody(data, size);
+	    });
+}
+
+template <typename BufferType = io::IOBuffer<char>>
+inline std::unique_ptr<HTTPResponseMessage> ParseHTTP1_1ResponseMessage(
+    const std::unique_ptr<BufferType> &response_message,
+    ResponseParserState &current_state,
+    std::unique_ptr<HTTPResponseMessage> http_message) {
+	std::size_t consumed_bytes{};
+	return ParseHTTP1_1ResponseMessage(response_message, current_state,
+					   std::move(http_message),
+					   consumed_bytes);
+}
+
+/**
+ * Report that the server closed the connection(a read returned 0). A body
+ * delimited by the close is complete, any other response which is not parsed
+ * yet was truncated.
+ *
+ * @param current_state Parser state of the response in progress
+ */
+BLUETH_FORCE_INLINE inline void
+ParseHTTP1_1ResponseEndOfStream(ResponseParserState &current_state) noexcept {
+	if (current_state == ResponseParserState::ResponseMessageBodyUntilClose)
+		current_state = ResponseParserState::ParsingDone;
+	else if (current_state != ResponseParserState::ParsingDone &&
+		 !is_parser_error(current_state))
+		current_state = ResponseParserState::ProtocolError;
 }
 
 } // namespace blueth::http
@@ -31,6 +31,7 @@ class HTTPProxyClient {
 	std::optional<std::string> proxy_username_;
 	std::optional<std::string> proxy_passphrase_;
 	bool proxy_connection_made_{false};
+	constexpr static std::size_t response_read_size = 2048;
 
       public:
 	/**
@@ -193,13 +194,29 @@ HTTPProxyReturnCode HTTPProxyClient::makeConnection(
 	if (write_ret < 0) return HTTPProxyReturnCode::NetworkError;
 	net::NetworkStream<char>::const_buffer_reference_type proxy_response =
 	    network_handler_->constGetIOBuffer();
-	std::unique_ptr<HTTPResponseMessage> http_response_message =
+	std::unique_ptr<HTTPResponseMessage> parsed_message =
 	    HTTPResponseMessage::create();
+	// A 2xx response to CONNECT has no body, the tunnel starts right after
+	// its head
+	parsed_message->setRequestType(HTTPRequestType::Connect);
 	ResponseParserState current_state =
 	    ResponseParserState::ResponseProtocolH;
-	std::unique_ptr<HTTPResponseMessage> parsed_message =
-	    ParseHTTP1_1ResponseMessage(proxy_response, current_state,
-					std::move(http_response_message));
+	// The response may take several reads, the bytes after it(if the
+	// origin-server already sent some) are left in the buffer for readProxy
+	while (current_state != ResponseParserState::ParsingDone &&
+	       !is_parser_error(current_state)) {
+		int read_ret = network_handler_->streamRead(response_read_size);
+		if (read_ret < 0) return HTTPProxyReturnCode::NetworkError;
+		if (read_ret == 0) {
+			ParseHTTP1_1ResponseEndOfStream(current_state);
+			break;
+		}
+		std::size_t consumed_bytes{};
+		parsed_message = ParseHTTP1_1ResponseMessage(
+		    proxy_response, current_state, std::move(parsed_message),
+		    consumed_bytes);
+		proxy_response->modifyStartOffset(consumed_bytes);
+	}
 	if (current_state == ResponseParserState::ProtocolError)
 		return HTTPProxyReturnCode::InvalidResponse;
 	if (current_state == ResponseParserState::ParsingDone) {
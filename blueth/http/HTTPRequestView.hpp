@@ -0,0 +1,358 @@
+#pragma once
+#include "HTTPConstants.hpp"
+#include "HTTPMessage.hpp"
+#include "HTTPParserCommon.hpp"
+#include "HTTPTokenTable.hpp"
+#include "common.hpp"
+#include "utils/simd.hpp"
+#include <array>
+#include <cctype>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// clang-format off
+/* HTTPRequestView is a non-owning HTTP request: the method, target, header names/values and the body are all
+ * string_views into the receive buffer and the headers are stored in a fixed size inline array, so parsing a
+ * request does not allocate.
+ *
+ *    receive buffer:  G E T   / i n d e x   H T T P / 1 . 1 \r \n H o s t :   a \r \n \r \n
+ *                     ^^^^^   ^^^^^^^^^^^                        ^^^^^^^     ^
+ *                     method  target                             name        value
+ *
+ * The views are only valid as long as the bytes stay in the buffer(i.e. until the caller moves the start offset
+ * past the request or overwrites the buffer), toMessage() copies the request into an owning HTTPRequestMessage.
+ */
+// clang-format on
+
+namespace blueth::http {
+
+template <std::size_t MaxHeaders = 32> class HTTPRequestView {
+      public:
+	using const_header_iterator =
+	    typename std::array<HTTPHeaderView, MaxHeaders>::const_iterator;
+	static constexpr std::size_t max_headers = MaxHeaders;
+
+	HTTPRequestView() = default;
+	BLUETH_FORCE_INLINE std::string_view getMethod() const noexcept;
+	BLUETH_FORCE_INLINE HTTPRequestType getRequestType() const noexcept;
+	BLUETH_FORCE_INLINE std::string_view getTargetResource() const noexcept;
+	BLUETH_FORCE_INLINE HTTPVersion getHTTPVersion() const noexcept;
+	BLUETH_FORCE_INLINE std::string_view getBody() const noexcept;
+	BLUETH_FORCE_INLINE std::size_t headerCount() const noexcept;
+	BLUETH_FORCE_INLINE const_header_iterator cbegin() const noexcept;
+	BLUETH_FORCE_INLINE const_header_iterator cend() const noexcept;
+	/**
+	 * Case-insensitive lookup of the first header with header_name
+	 *
+	 * @param header_name Name of the header
+	 * @return View of the header value or std::nullopt if there is no such
+	 * header
+	 */
+	std::optional<std::string_view>
+	getHeaderValue(std::string_view header_name) const noexcept;
+	/**
+	 * Copy the request into an owning HTTPRequestMessage
+	 */
+	std::unique_ptr<HTTPRequestMessage> toMessage() const;
+	/**
+	 * Drop all the views, the header array is reused
+	 */
+	void clear() noexcept;
+
+	// These methods are only implemented to work with the view parser
+	BLUETH_FORCE_INLINE void setMethod(std::string_view method) noexcept;
+	BLUETH_FORCE_INLINE void setTargetResource(std::string_view target) noexcept;
+	BLUETH_FORCE_INLINE void setHTTPVersion(HTTPVersion version) noexcept;
+	BLUETH_FORCE_INLINE void setBody(std::string_view body) noexcept;
+	/**
+	 * @return false if the inline header array is full
+	 */
+	BLUETH_FORCE_INLINE bool addHeader(std::string_view header_name,
+					   std::string_view header_value) noexcept;
+
+      private:
+	std::string_view method_;
+	std::string_view target_resource_;
+	std::string_view body_;
+	HTTPRequestType request_type_{HTTPRequestType::Unsupported};
+	HTTPVersion http_version_{HTTPVersion::HTTP1_1};
+	std::size_t header_count_{};
+	std::array<HTTPHeaderView, MaxHeaders> headers_;
+};
+
+template <std::size_t MaxHeaders>
+BLUETH_FORCE_INLINE inline std::string_view
+HTTPRequestView<MaxHeaders>::getMethod() const noexcept {
+	return method_;
+}
+
+template <std::size_t MaxHeaders>
+BLUETH_FORCE_INLINE inline HTTPRequestType
+HTTPRequestView<MaxHeaders>::getRequestType() const noexcept {
+	return request_type_;
+}
+
+template <std::size_t MaxHeaders>
+BLUETH_FORCE_INLINE inline std::string_view
+HTTPRequestView<MaxHeaders>::getTargetResource() const noexcept {
+	return target_resource_;
+}
+
+template <std::size_t MaxHeaders>
+BLUETH_FORCE_INLINE inline HTTPVersion
+HTTPRequestView<MaxHeaders>::getHTTPVersion() const noexcept {
+	return http_version_;
+}
+
+template <std::size_t MaxHeaders>
+BLUETH_FORCE_INLINE inline std::string_view
+HTTPRequestView<MaxHeaders>::getBody() const noexcept {
+	return body_;
+}
+
+template <std::size_t MaxHeaders>
+BLUETH_FORCE_INLINE inline std::size_t
+HTTPRequestView<MaxHeaders>::headerCount() const noexcept {
+	return header_count_;
+}
+
+template <std::size_t MaxHeaders>
+BLUETH_FORCE_INLINE inline
+    typename HTTPRequestView<MaxHeaders>::const_header_iterator
+    HTTPRequestView<MaxHeaders>::cbegin() const noexcept {
+	return headers_.cbegin();
+}
+
+template <std::size_t MaxHeaders>
+BLUETH_FORCE_INLINE inline
+    typename HTTPRequestView<MaxHeaders>::const_header_iterator
+    HTTPRequestView<MaxHeaders>::cend() const noexcept {
+	return headers_.cbegin() + header_count_;
+}
+
+template <std::size_t MaxHeaders>
+inline std::optional<std::string_view>
+HTTPRequestView<MaxHeaders>::getHeaderValue(
+    std::string_view header_name) const noexcept {
+	for (std::size_t index{}; index < header_count_; index++)
+		if (case_insensitive_equal(headers_[index].name, header_name))
+			return headers_[index].value;
+	return std::nullopt;
+}
+
+template <std::size_t MaxHeaders>
+inline std::unique_ptr<HTTPRequestMessage>
+HTTPRequestView<MaxHeaders>::toMessage() const {
+	std::unique_ptr<HTTPRequestMessage> returner =
+	    HTTPRequestMessage::create();
+	returner->setRequestType(request_type_);
+	returner->setHTTPVersion(http_version_);
+	returner->setHTTPTargetResource(std::string{target_resource_});
+	for (std::size_t index{}; index < header_count_; index++)
+		returner->addHeader(headers_[index].name, headers_[index].value);
+	if (!body_.empty()) returner->pushBackRawBody(std::string{body_});
+	return returner;
+}
+
+template <std::size_t MaxHeaders>
+inline void HTTPRequestView<MaxHeaders>::clear() noexcept {
+	method_ = {};
+	target_resource_ = {};
+	body_ = {};
+	request_type_ = HTTPRequestType::Unsupported;
+	http_version_ = HTTPVersion::HTTP1_1;
+	header_count_ = 0;
+}
+
+template <std::size_t MaxHeaders>
+BLUETH_FORCE_INLINE inline void
+HTTPRequestView<MaxHeaders>::setMethod(std::string_view method) noexcept {
+	method_ = method;
+	request_type_ = request_type_from_method(method);
+}
+
+template <std::size_t MaxHeaders>
+BLUETH_FORCE_INLINE inline void HTTPRequestView<MaxHeaders>::setTargetResource(
+    std::string_view target_resource) noexcept {
+	target_resource_ = target_resource;
+}
+
+template <std::size_t MaxHeaders>
+BLUETH_FORCE_INLINE inline void
+HTTPRequestView<MaxHeaders>::setHTTPVersion(HTTPVersion version) noexcept {
+	http_version_ = version;
+}
+
+template <std::size_t MaxHeaders>
+BLUETH_FORCE_INLINE inline void
+HTTPRequestView<MaxHeaders>::setBody(std::string_view body) noexcept {
+	body_ = body;
+}
+
+template <std::size_t MaxHeaders>
+BLUETH_FORCE_INLINE inline bool
+HTTPRequestView<MaxHeaders>::addHeader(std::string_view header_name,
+				       std::string_view header_value) noexcept {
+	if (header_count_ == MaxHeaders) return false;
+	headers_[header_count_++] = HTTPHeaderView{header_name, header_value};
+	return true;
+}
+
+/**
+ * Parse a complete HTTP/1.1 request out of [start_buffer, end_buffer) into
+ * request_view without copying any bytes.
+ *
+ * Unlike ParseHTTP1_1RequestMessage, the view parser is not incremental: if
+ * the request is incomplete the returned state is the state in which the input
+ * ran out(for example HeaderValue, or MessageBody when the Content-Length
+ * bytes haven't arrived yet) and the caller parses again from the start of the
+ * request once more bytes are read. This costs a re-scan of a partial request,
+ * but keeps every view pointing into a single contiguous buffer.
+ *
+ * On ParsingDone, 'consumed' is the size of the request head plus the
+ * Content-Length bytes of the body. A request with Transfer-Encoding has no
+ * body view, its body starts at 'consumed'. A request with more than
+ * MaxHeaders headers, or with a framing the message parser rejects(differing
+ * Content-Lengths, Transfer-Encoding with a Content-Length or without a final
+ * chunked coding) is a ProtocolError. An HTTP-version other than 1.0 and 1.1
+ * is VersionNotSupported.
+ *
+ * @param start_buffer Start of the request
+ * @param end_buffer One past the last byte read so far
+ * @param request_view View to be filled, cleared before parsing
+ * @return Parser state and the number of consumed bytes
+ */
+template <std::size_t MaxHeaders>
+inline HTTPParseResult<ParserState>
+ParseHTTP1_1RequestView(const char *start_buffer, const char *end_buffer,
+			HTTPRequestView<MaxHeaders> &request_view) noexcept {
+	const char *const request_start = start_buffer;
+	request_view.clear();
+	auto result = [&](ParserState state) -> HTTPParseResult<ParserState> {
+		return {state, static_cast<std::size_t>(start_buffer -
+							request_start)};
+	};
+	// Request-Line
+	const char *run_end = simd::find_first_not_in_class(
+	    start_buffer, end_buffer, token_char_class);
+	if (run_end == end_buffer) return result(ParserState::RequestMethod);
+	if (run_end == start_buffer ||
+	    *run_end != static_cast<char>(LexConsts::SP))
+		return result(ParserState::ProtocolError);
+	request_view.setMethod({start_buffer, run_end});
+	start_buffer = run_end + 1;
+	run_end = simd::find_first_not_in_range(start_buffer, end_buffer, 0x21,
+						0x7E);
+	if (run_end == end_buffer)
+		return result(ParserState::RequestResource);
+	if (run_end == start_buffer ||
+	    *run_end != static_cast<char>(LexConsts::SP))
+		return result(ParserState::ProtocolError);
+	request_view.setTargetResource({start_buffer, run_end});
+	start_buffer = run_end + 1;
+	// "HTTP/" DIGIT "." DIGIT CRLF
+	constexpr std::string_view protocol_pattern = "HTTP/#.#\r\n";
+	for (char pattern_char : protocol_pattern) {
+		if (start_buffer == end_buffer)
+			return result(ParserState::RequestProtocolH);
+		if (pattern_char == '#' ? !std::isdigit(*start_buffer)
+					: pattern_char != *start_buffer)
+			return result(ParserState::ProtocolError);
+		++start_buffer;
+	}
+	// start_buffer is past "#.#\r\n"
+	if (start_buffer[-5] != '1' || start_buffer[-3] > '1')
+		return result(ParserState::VersionNotSupported);
+	request_view.setHTTPVersion(start_buffer[-3] == '0'
+					? HTTPVersion::HTTP1_0
+					: HTTPVersion::HTTP1_1);
+	// Headers
+	std::optional<std::size_t> content_length;
+	bool transfer_encoding{false};
+	for (;;) {
+		if (start_buffer == end_buffer)
+			return result(ParserState::HeaderName);
+		if (*start_buffer == static_cast<char>(LexConsts::CR)) {
+			if (start_buffer + 1 == end_buffer)
+				return result(ParserState::HeaderEndLF);
+			if (start_buffer[1] != static_cast<char>(LexConsts::LF))
+				return result(ParserState::ProtocolError);
+			start_buffer += 2;
+			break;
+		}
+		run_end = simd::find_first_not_in_class(
+		    start_buffer, end_buffer, token_char_class);
+		if (run_end == end_buffer)
+			return result(ParserState::HeaderName);
+		if (run_end == start_buffer || *run_end != ':')
+			return result(ParserState::ProtocolError);
+		std::string_view header_name{start_buffer, run_end};
+		start_buffer = run_end + 1;
+		while (start_buffer != end_buffer &&
+		       (*start_buffer == static_cast<char>(LexConsts::SP) ||
+			*start_buffer == static_cast<char>(LexConsts::HT)))
+			++start_buffer;
+		run_end = simd::find_first_control_char(start_buffer, end_buffer);
+		if (run_end == end_buffer)
+			return result(ParserState::HeaderValue);
+		if (*run_end != static_cast<char>(LexConsts::CR))
+			return result(ParserState::ProtocolError);
+		if (run_end + 1 == end_buffer)
+			return result(ParserState::HeaderValueLF);
+		if (run_end[1] != static_cast<char>(LexConsts::LF))
+			return result(ParserState::ProtocolError);
+		const char *value_end = run_end;
+		while (value_end != start_buffer &&
+		       (value_end[-1] == static_cast<char>(LexConsts::SP) ||
+			value_end[-1] == static_cast<char>(LexConsts::HT)))
+			--value_end;
+		std::string_view header_value{start_buffer, value_end};
+		if (!request_view.addHeader(header_name, header_value))
+			return result(ParserState::ProtocolError);
+		// Same framing rules as HTTPRequestMessage, see
+		// addTempHeadersHolderToMessage()
+		if (case_insensitive_equal(header_name, "Content-Length")) {
+			std::optional<std::size_t> body_size =
+			    parse_content_length(header_value);
+			if (!body_size || transfer_encoding ||
+			    (content_length && *content_length != *body_size))
+				return result(ParserState::ProtocolError);
+			content_length = body_size;
+		} else if (case_insensitive_equal(header_name,
+						  "Transfer-Encoding")) {
+			if (transfer_encoding || content_length ||
+			    !is_chunked_transfer_coding(header_value))
+				return result(ParserState::ProtocolError);
+			transfer_encoding = true;
+		}
+		start_buffer = run_end + 2;
+	}
+	if (content_length) {
+		if (static_cast<std::size_t>(end_buffer - start_buffer) <
+		    *content_length)
+			return result(ParserState::MessageBody);
+		request_view.setBody({start_buffer, *content_length});
+		start_buffer += *content_length;
+	}
+	return result(ParserState::ParsingDone);
+}
+
+/**
+ * Parse the data region of an io::IOBuffer(or any buffer with the same offset
+ * API), the buffer's offsets are not modified
+ */
+template <typename BufferType, std::size_t MaxHeaders>
+inline HTTPParseResult<ParserState>
+ParseHTTP1_1RequestView(const std::unique_ptr<BufferType> &request_message,
+			HTTPRequestView<MaxHeaders> &request_view) noexcept {
+	return ParseHTTP1_1RequestView(
+	    request_message->getStartOffsetPointer(),
+	    request_message->getStartOffsetPointer() +
+		request_message->getDataSize(),
+	    request_view);
+}
+
+} // namespace blueth::http
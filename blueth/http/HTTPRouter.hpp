@@ -0,0 +1,333 @@
+#pragma once
+#include "HTTPConstants.hpp"
+#include "common.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// clang-format off
+// Request router on a compressed radix trie, one trie per method
+//
+//    routes: /users  /users/:id  /users/:id/posts  /usage  /static/*path
+//
+//    "/"
+//     +-- "us"
+//     |    +-- "ers"          GET /users
+//     |    |    +-- "/"
+//     |    |         +-- :id                 GET /users/:id
+//     |    |              +-- "/posts"       GET /users/:id/posts
+//     |    +-- "age"          GET /usage
+//     +-- "static/"
+//          +-- *path          GET /static/*path
+//
+// The static edges hold byte strings and are split on their common prefixes, so a lookup compares every byte of
+// the path once. A ":name" segment captures one path segment, a "*name" segment(the last one of a pattern)
+// captures the rest of the path. The static edges are tried first, then the parameter, then the wildcard, and
+// the lookup backtracks when a branch fails further down.
+//
+// The captures are string_views into the looked up path, kept in an HTTPRouteParams with room for
+// max_route_params of them: a lookup never allocates.
+// clang-format on
+
+namespace blueth::http {
+
+static constexpr std::size_t max_route_params = 8;
+
+/**
+ * The :param and *wildcard captures of a matched route, in the order of the
+ * pattern. The names view the router and the values view the path which was
+ * looked up.
+ */
+class HTTPRouteParams {
+      public:
+	struct Param {
+		std::string_view name;
+		std::string_view value;
+	};
+
+	/**
+	 * Value of the capture named name
+	 */
+	std::optional<std::string_view>
+	getValue(std::string_view name) const noexcept;
+	BLUETH_FORCE_INLINE std::size_t size() const noexcept;
+	BLUETH_FORCE_INLINE bool empty() const noexcept;
+	BLUETH_FORCE_INLINE const Param &operator[](std::size_t index) const noexcept;
+	BLUETH_FORCE_INLINE const Param *begin() const noexcept;
+	BLUETH_FORCE_INLINE const Param *end() const noexcept;
+	BLUETH_FORCE_INLINE void clear() noexcept;
+
+      private:
+	template <typename Handler> friend class HTTPRouter;
+	std::array<Param, max_route_params> params_{};
+	std::size_t param_count_{};
+};
+
+inline std::optional<std::string_view>
+HTTPRouteParams::getValue(std::string_view name) const noexcept {
+	for (std::size_t index{}; index < param_count_; index++)
+		if (params_[index].name == name) return params_[index].value;
+	return std::nullopt;
+}
+
+BLUETH_FORCE_INLINE inline std::size_t HTTPRouteParams::size() const noexcept {
+	return param_count_;
+}
+
+BLUETH_FORCE_INLINE inline bool HTTPRouteParams::empty() const noexcept {
+	return !param_count_;
+}
+
+BLUETH_FORCE_INLINE inline const HTTPRouteParams::Param &
+HTTPRouteParams::operator[](std::size_t index) const noexcept {
+	return params_[index];
+}
+
+BLUETH_FORCE_INLINE inline const HTTPRouteParams::Param *
+HTTPRouteParams::begin() const noexcept {
+	return params_.data();
+}
+
+BLUETH_FORCE_INLINE inline const HTTPRouteParams::Param *
+HTTPRouteParams::end() const noexcept {
+	return params_.data() + param_count_;
+}
+
+BLUETH_FORCE_INLINE inline void HTTPRouteParams::clear() noexcept {
+	param_count_ = 0;
+}
+
+template <typename Handler> class HTTPRouter {
+      public:
+	HTTPRouter() = default;
+	HTTPRouter(const HTTPRouter &) = delete;
+	HTTPRouter &operator=(const HTTPRouter &) = delete;
+	HTTPRouter(HTTPRouter &&) noexcept = default;
+	HTTPRouter &operator=(HTTPRouter &&) noexcept = default;
+	/**
+	 * Route the requests with request_type on the paths matching pattern,
+	 * the handler of an identical pattern is replaced. Patterns start with
+	 * '/'; a segment ":name" captures a segment and a last segment "*name"
+	 * captures the rest of the path. For example "/users/:id" matches
+	 * "/users/42" with id "42", and a "*path" segment after "/files/"
+	 * matches "/files/a/b.txt" with path "a/b.txt".
+	 *
+	 * Throws std::invalid_argument for a malformed pattern, or a capture
+	 * whose name differs from the one already routed at the same place
+	 * ("/users/:id" and "/users/:name")
+	 */
+	void addRoute(HTTPRequestType request_type, std::string_view pattern,
+		      Handler handler) noexcept(false);
+	/**
+	 * Handler of the route matching path, nullptr if there is none. params
+	 * gets the captures, they are valid while path is.
+	 */
+	const Handler *findRoute(HTTPRequestType request_type,
+				 std::string_view path,
+				 HTTPRouteParams &params) const noexcept;
+	BLUETH_FORCE_INLINE std::size_t routeCount() const noexcept;
+
+      private:
+	static constexpr std::uint32_t no_handler =
+	    std::numeric_limits<std::uint32_t>::max();
+	static constexpr std::size_t method_count =
+	    static_cast<std::size_t>(HTTPRequestType::Trace) + 1;
+
+	struct Node {
+		// Bytes of the static edge into the node, or the name of the
+		// capture for a parameter/wildcard node
+		std::string label;
+		// First byte of every static child, in the order of static_children
+		std::string child_first_bytes;
+		std::vector<std::unique_ptr<Node>> static_children;
+		std::unique_ptr<Node> param_child;
+		std::unique_ptr<Node> wildcard_child;
+		std::uint32_t handler_index{no_handler};
+	};
+
+	/**
+	 * Node at the end of the static bytes, from node, splitting an edge or
+	 * adding one if needed
+	 */
+	static Node *insertStatic_(Node *node,
+				   std::string_view static_bytes) noexcept(false);
+	static Node *captureChild_(std::unique_ptr<Node> &capture_child,
+				   std::string_view capture_name) noexcept(false);
+	const Handler *match_(const Node &node, std::string_view path,
+			      HTTPRouteParams &params) const noexcept;
+
+	std::array<std::unique_ptr<Node>, method_count> method_roots_;
+	std::vector<Handler> handlers_;
+};
+
+template <typename Handler>
+inline typename HTTPRouter<Handler>::Node *
+HTTPRouter<Handler>::insertStatic_(Node *node,
+				   std::string_view static_bytes) noexcept(false) {
+	while (!static_bytes.empty()) {
+		std::size_t child_index =
+		    node->child_first_bytes.find(static_bytes.front());
+		if (child_index == std::string::npos) {
+			std::unique_ptr<Node> child = std::make_unique<Node>();
+			child->label = static_bytes;
+			node->child_first_bytes.push_back(static_bytes.front());
+			node->static_children.push_back(std::move(child));
+			return node->static_children.back().get();
+		}
+		std::unique_ptr<Node> &child = node->static_children[child_index];
+		std::size_t common_size{};
+		while (common_size < child->label.size() &&
+		       common_size < static_bytes.size() &&
+		       child->label[common_size] == static_bytes[common_size])
+			common_size++;
+		if (common_size < child->label.size()) {
+			// Split the edge, the child keeps the rest of its bytes
+			std::unique_ptr<Node> split_node = std::make_unique<Node>();
+			split_node->label = child->label.substr(0, common_size);
+			child->label.erase(0, common_size);
+			split_node->child_first_bytes.push_back(child->label.front());
+			split_node->static_children.push_back(std::move(child));
+			child = std::move(split_node);
+		}
+		node = child.get();
+		static_bytes.remove_prefix(common_size);
+	}
+	return node;
+}
+
+template <typename Handler>
+inline typename HTTPRouter<Handler>::Node *
+HTTPRouter<Handler>::captureChild_(std::unique_ptr<Node> &capture_child,
+				   std::string_view capture_name) noexcept(false) {
+	if (!capture_child) {
+		capture_child = std::make_unique<Node>();
+		capture_child->label = capture_name;
+	} else if (capture_child->label != capture_name) {
+		throw std::invalid_argument{
+		    "HTTPRouter: conflicting capture names at the same place"};
+	}
+	return capture_child.get();
+}
+
+template <typename Handler>
+inline void HTTPRouter<Handler>::addRoute(HTTPRequestType request_type,
+					  std::string_view pattern,
+					  Handler handler) noexcept(false) {
+	if (pattern.empty() || pattern.front() != '/')
+		throw std::invalid_argument{
+		    "HTTPRouter: a pattern must start with '/'"};
+	std::size_t method_index = static_cast<std::size_t>(request_type);
+	if (request_type == HTTPRequestType::Unsupported ||
+	    method_index >= method_count)
+		throw std::invalid_argument{"HTTPRouter: unsupported method"};
+	std::unique_ptr<Node> &root = method_roots_[method_index];
+	if (!root) root = std::make_unique<Node>();
+
+	Node *node = root.get();
+	std::size_t capture_count{};
+	while (!pattern.empty()) {
+		// Static bytes up to the next capture, which starts a segment
+		std::size_t capture_start{};
+		while (capture_start < pattern.size() &&
+		       !((pattern[capture_start] == ':' ||
+			  pattern[capture_start] == '*') &&
+			 capture_start && pattern[capture_start - 1] == '/'))
+			capture_start++;
+		node = insertStatic_(node, pattern.substr(0, capture_start));
+		pattern.remove_prefix(capture_start);
+		if (pattern.empty()) break;
+
+		if (++capture_count > max_route_params)
+			throw std::invalid_argument{
+			    "HTTPRouter: too many captures in the pattern"};
+		std::size_t segment_end = pattern.find('/');
+		std::string_view capture_name =
+		    pattern.substr(1, segment_end == std::string_view::npos
+					  ? std::string_view::npos
+					  : segment_end - 1);
+		if (pattern.front() == '*') {
+			if (segment_end != std::string_view::npos)
+				throw std::invalid_argument{
+				    "HTTPRouter: a wildcard must be the last segment"};
+			node = captureChild_(node->wildcard_child, capture_name);
+			break;
+		}
+		if (capture_name.empty())
+			throw std::invalid_argument{
+			    "HTTPRouter: a parameter must have a name"};
+		node = captureChild_(node->param_child, capture_name);
+		pattern.remove_prefix(capture_name.size() + 1);
+	}
+	if (node->handler_index != no_handler) {
+		handlers_[node->handler_index] = std::move(handler);
+		return;
+	}
+	node->handler_index = static_cast<std::uint32_t>(handlers_.size());
+	handlers_.push_back(std::move(handler));
+}
+
+template <typename Handler>
+inline const Handler *
+HTTPRouter<Handler>::match_(const Node &node, std::string_view path,
+			    HTTPRouteParams &params) const noexcept {
+	if (path.empty()) {
+		if (node.handler_index != no_handler)
+			return &handlers_[node.handler_index];
+	} else {
+		std::size_t child_index = node.child_first_bytes.find(path.front());
+		if (child_index != std::string::npos) {
+			const Node &child = *node.static_children[child_index];
+			if (path.starts_with(child.label))
+				if (const Handler *handler = match_(
+					child, path.substr(child.label.size()), params))
+					return handler;
+		}
+		// A parameter captures a non-empty segment
+		if (node.param_child && path.front() != '/') {
+			std::size_t segment_end = path.find('/');
+			if (segment_end == std::string_view::npos)
+				segment_end = path.size();
+			params.params_[params.param_count_++] = {
+			    node.param_child->label, path.substr(0, segment_end)};
+			if (const Handler *handler = match_(
+				*node.param_child, path.substr(segment_end), params))
+				return handler;
+			params.param_count_--;
+		}
+	}
+	if (node.wildcard_child &&
+	    node.wildcard_child->handler_index != no_handler) {
+		params.params_[params.param_count_++] = {node.wildcard_child->label,
+							 path};
+		return &handlers_[node.wildcard_child->handler_index];
+	}
+	return nullptr;
+}
+
+template <typename Handler>
+inline const Handler *
+HTTPRouter<Handler>::findRoute(HTTPRequestType request_type,
+			       std::string_view path,
+			       HTTPRouteParams &params) const noexcept {
+	params.clear();
+	std::size_t method_index = static_cast<std::size_t>(request_type);
+	if (method_index >= method_count || !method_roots_[method_index])
+		return nullptr;
+	return match_(*method_roots_[method_index], path, params);
+}
+
+template <typename Handler>
+BLUETH_FORCE_INLINE inline std::size_t
+HTTPRouter<Handler>::routeCount() const noexcept {
+	return handlers_.size();
+}
+
+} // namespace blueth::http
@@ -0,0 +1,663 @@
+#pragma once
+#include "HTTPCommonResponseMessageTemplate.hpp"
+#include "HTTPCompression.hpp"
+#include "HTTPConstants.hpp"
+#include "HTTPMessage.hpp"
+#include "HTTPMessagePool.hpp"
+#include "HTTPParserCommon.hpp"
+#include "HTTPParserStateMachine.hpp"
+#include "HTTPRouter.hpp"
+#include "HTTPTokenTable.hpp"
+#include "common.hpp"
+#include "concurrency/AsyncEventLoop.hpp"
+#include "concurrency/internal/EventLoopBase.hpp"
+#include "io/IOBuffer.hpp"
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <unordered_set>
+
+namespace blueth::http {
+
+// clang-format off
+/* HTTP/1.1 server on the epoll event loop(concurrency::AsyncEpollEventLoop)
+ *
+ *                 +--------+  bytes   +--------+  request  +---------+
+ *   socket ------>| read   |--------->| parser |---------->| handler |
+ *                 | buffer |          +--------+           +---------+
+ *                 +--------+                                    |
+ *                                                               | response
+ *                 +--------+  flush(writeToPeer)  +--------+    |
+ *   socket <------| write  |<--------------------| render |<---+
+ *                 | buffer |                     +--------+
+ *                 +--------+
+ *
+ * A connection serves any number of requests(keep-alive) until the client sends
+ * "Connection: close", the handler answers with it, a request is malformed or
+ * the connection times out. Pipelined requests are answered in order: every
+ * complete request in the read buffer is handled and its response appended to
+ * the write buffer before the buffer is flushed. The connection stops reading
+ * while its responses don't fit in the socket buffer, so a client that doesn't
+ * read its responses can't make the server buffer without bounds.
+ *
+ * The error responses(400, 413, ...) and the 404 of the default handler are
+ * pre-rendered HTTPResponseTemplates, copied straight into the write buffer.
+ * Every response carries the Date of the server's HTTPDateClock, which is
+ * ticked by the timer.
+ *
+ * The request message of a connection is reset() after every request and goes
+ * back to the server's HTTPMessagePool when the connection is closed, the
+ * response given to the handlers is one reused object as well. Past the first
+ * requests, the messages don't allocate.
+ *
+ * With HTTPServerOptions::compression set, a textual body is gzip/deflate
+ * encoded for the clients whose Accept-Encoding allows it. The compressed
+ * variants of the bodies which are sent repeatedly are cached.
+ */
+// clang-format on
+
+using HTTPRequestHandler =
+    std::function<void(const HTTPRequestMessage &, HTTPResponseMessage &)>;
+// Handler of a route with :param or *wildcard captures
+using HTTPRouteHandler = std::function<void(
+    const HTTPRequestMessage &, const HTTPRouteParams &, HTTPResponseMessage &)>;
+
+struct HTTPServerOptions {
+	// Maximum number of events per epoll_wait
+	std::size_t max_events{1024};
+	int backlog{1024};
+	// A connection without any read or write for this long is closed
+	std::chrono::milliseconds idle_timeout{60 * 1000};
+	// A request head(request-line and header fields) must be received
+	// within this time of its first byte, against the slow-header clients
+	std::chrono::milliseconds header_read_timeout{10 * 1000};
+	// Resolution of the timeouts above
+	std::chrono::milliseconds timer_interval{250};
+	// Initial capacity of the per-connection read and write buffers
+	std::size_t buffer_size{16 * 1024};
+	// Request messages of the closed connections kept for the new ones
+	std::size_t max_pooled_messages{1024};
+	// Compress the textual responses of the clients which accept it, off
+	// when empty
+	std::optional<HTTPCompressionPolicy> compression{};
+	HTTPParserLimits parser_limits{};
+};
+
+/**
+ * State of a client connection, it's the PeerState of the event loop. The
+ * buffers are allocated when the connection is accepted and reused by every
+ * request on it.
+ */
+struct HTTPServerConnection {
+	std::shared_ptr<io::IOBuffer<char>> read_buffer;
+	std::shared_ptr<io::IOBuffer<char>> write_buffer;
+	ParserState parser_state{ParserState::RequestLineBegin};
+	std::unique_ptr<HTTPRequestMessage> request_in_progress;
+	// Last read or write on the connection
+	std::chrono::steady_clock::time_point last_activity;
+	// First byte of the request head in progress
+	std::chrono::steady_clock::time_point head_started;
+	// Once the write buffer is flushed the server stops sending and the
+	// connection is closed at the client's end of stream
+	bool close_after_write{false};
+};
+
+class HTTPServer {
+      public:
+	using EventLoopType = concurrency::EventLoopBase<HTTPServerConnection>;
+	HTTPServer(std::string server_address, std::uint16_t server_port,
+		   HTTPServerOptions server_options = HTTPServerOptions{}) noexcept(false);
+	static std::unique_ptr<HTTPServer>
+	create(std::string server_address, std::uint16_t server_port,
+	       HTTPServerOptions server_options = HTTPServerOptions{}) noexcept(false);
+	HTTPServer(const HTTPServer &) = delete;
+	HTTPServer &operator=(const HTTPServer &) = delete;
+	/**
+	 * Register the handler of the requests with request_type on the paths
+	 * matching the pattern(see HTTPRouter::addRoute), "/users" or
+	 * "/users/:id". The pattern is matched against the path of the
+	 * request-target, still percent-encoded. Register the handlers before
+	 * start().
+	 *
+	 * The response is HTTP 200 with an empty body when the handler starts,
+	 * the server adds the Content-Length header if the handler didn't.
+	 */
+	void addHandler(HTTPRequestType request_type, std::string path,
+			HTTPRequestHandler request_handler) noexcept(false);
+	/**
+	 * Same as above, the handler gets the captures of the pattern
+	 */
+	void addHandler(HTTPRequestType request_type, std::string path,
+			HTTPRouteHandler route_handler) noexcept(false);
+	/**
+	 * Handler of the requests without a registered handler, by default they
+	 * get a pre-rendered 404 with an empty body
+	 */
+	void setDefaultHandler(HTTPRequestHandler request_handler) noexcept;
+	/**
+	 * Serve the connections on the calling thread until stop() is called,
+	 * a stopped server is not restarted
+	 */
+	void start() noexcept(false);
+	/**
+	 * Make start() return, the open connections are closed. It may be
+	 * called from any thread(or from a handler).
+	 */
+	void stop() noexcept;
+
+      private:
+	concurrency::FDStatus
+	onAccept_(concurrency::PeerStateHolder *peer_state_holder) noexcept;
+	concurrency::FDStatus
+	onRead_(concurrency::PeerStateHolder *peer_state_holder,
+		const std::shared_ptr<EventLoopType> &event_loop) noexcept;
+	concurrency::FDStatus
+	onWrite_(concurrency::PeerStateHolder *peer_state_holder,
+		 const std::shared_ptr<EventLoopType> &event_loop) noexcept;
+	void onTimer_() noexcept;
+	/**
+	 * Parse the complete requests in the read buffer and append their
+	 * responses to the write buffer
+	 */
+	void processRequests_(HTTPServerConnection &connection) noexcept(false);
+	void handleRequest_(HTTPServerConnection &connection,
+			    const HTTPRequestMessage &request) noexcept(false);
+	/**
+	 * Append the pre-rendered response of the code, the connection is
+	 * closed after it
+	 */
+	void appendErrorResponse_(HTTPServerConnection &connection,
+				  HTTPResponseCodes response_code) noexcept(false);
+	void appendResponse_(
+	    HTTPServerConnection &connection, HTTPResponseMessage &response,
+	    HTTPContentCoding content_coding = HTTPContentCoding::Identity) noexcept(false);
+	/**
+	 * Replace a compressible body with its content_coding variant, the
+	 * response varies on Accept-Encoding from then on
+	 */
+	void compressBody_(HTTPResponseMessage &response,
+			   HTTPContentCoding content_coding) noexcept(false);
+	/**
+	 * Write the write buffer to the peer until it's empty or the socket
+	 * would block
+	 */
+	concurrency::FDStatus
+	flush_(concurrency::PeerStateHolder *peer_state_holder,
+	       HTTPServerConnection &connection,
+	       const std::shared_ptr<EventLoopType> &event_loop) noexcept(false);
+	/**
+	 * @return The status which makes the event loop close the connection
+	 */
+	concurrency::FDStatus
+	closeConnection_(concurrency::PeerStateHolder *peer_state_holder) noexcept;
+	void closeRemainingConnections_() noexcept;
+
+	HTTPServerOptions server_options_;
+	std::shared_ptr<EventLoopType> event_loop_;
+	HTTPRouter<HTTPRouteHandler> router_;
+	// Empty for the pre-rendered 404
+	HTTPRequestHandler default_handler_;
+	std::unordered_set<concurrency::PeerStateHolder *> connections_;
+	HTTPMessagePool<HTTPRequestMessage> request_pool_;
+	// Handed to the handlers, reset() for every request
+	HTTPResponseMessage response_;
+	// Only with HTTPServerOptions::compression
+	std::unique_ptr<HTTPCompressedVariantCache> variant_cache_;
+	std::unique_ptr<HTTPCompressor> gzip_compressor_;
+	std::unique_ptr<HTTPCompressor> deflate_compressor_;
+	std::unique_ptr<io::IOBuffer<char>> compression_buffer_;
+	HTTPDateClock date_clock_;
+	HTTPResponseTemplate not_found_template_;
+	std::array<std::pair<HTTPResponseCodes, HTTPResponseTemplate>, 7>
+	    error_templates_;
+};
+
+
+inline HTTPServer::HTTPServer(std::string server_address,
+			      std::uint16_t server_port,
+			      HTTPServerOptions server_options) noexcept(false)
+    : server_options_{server_options},
+      event_loop_{
+	  concurrency::AsyncEpollEventLoop<HTTPServerConnection>::create(
+	      std::move(server_address), server_port,
+	      server_options.max_events, server_options.backlog, -1)},
+      request_pool_{server_options.max_pooled_messages} {
+	event_loop_->registerCallbackForEvent(
+	    [this](concurrency::PeerStateHolder *peer_state_holder,
+		   std::shared_ptr<EventLoopType>) {
+		    return onAccept_(peer_state_holder);
+	    },
+	    concurrency::EventType::AcceptEvent);
+	event_loop_->registerCallbackForEvent(
+	    [this](concurrency::PeerStateHolder *peer_state_holder,
+		   std::shared_ptr<EventLoopType> event_loop) {
+		    return onRead_(peer_state_holder, event_loop);
+	    },
+	    concurrency::EventType::ReadEvent);
+	event_loop_->registerCallbackForEvent(
+	    [this](concurrency::PeerStateHolder *peer_state_holder,
+		   std::shared_ptr<EventLoopType> event_loop) {
+		    return onWrite_(peer_state_holder, event_loop);
+	    },
+	    concurrency::EventType::WriteEvent);
+	event_loop_->registerTimerCallback(
+	    [this]() { onTimer_(); },
+	    static_cast<int>(server_options_.timer_interval.count()));
+	not_found_template_ =
+	    make_empty_response_template(HTTPResponseCodes::NotFound, false);
+	std::size_t template_index{};
+	for (HTTPResponseCodes response_code :
+	     {HTTPResponseCodes::BadRequest, HTTPResponseCodes::RequestURITooLarge,
+	      HTTPResponseCodes::RequestHeaderFieldsTooLarge,
+	      HTTPResponseCodes::RequestEntityTooLarge,
+	      HTTPResponseCodes::InternalServerError,
+	      HTTPResponseCodes::NotImplemented,
+	      HTTPResponseCodes::HttpVersionNotSupported})
+		error_templates_[template_index++] = {
+		    response_code, make_empty_response_template(response_code, true)};
+	if (server_options_.compression) {
+		const HTTPCompressionPolicy &policy = *server_options_.compression;
+		variant_cache_ = std::make_unique<HTTPCompressedVariantCache>(
+		    policy.variant_cache_size);
+		gzip_compressor_ = std::make_unique<HTTPCompressor>(
+		    HTTPContentCoding::Gzip, policy.level);
+		deflate_compressor_ = std::make_unique<HTTPCompressor>(
+		    HTTPContentCoding::Deflate, policy.level);
+		compression_buffer_ =
+		    io::IOBuffer<char>::create(server_options_.buffer_size);
+	}
+}
+
+inline std::unique_ptr<HTTPServer>
+HTTPServer::create(std::string server_address, std::uint16_t server_port,
+		   HTTPServerOptions server_options) noexcept(false) {
+	return std::make_unique<HTTPServer>(std::move(server_address),
+					    server_port, server_options);
+}
+
+inline void HTTPServer::addHandler(HTTPRequestType request_type,
+				   std::string path,
+				   HTTPRequestHandler request_handler) noexcept(false) {
+	router_.addRoute(
+	    request_type, path,
+	    [request_handler = std::move(request_handler)](
+		const HTTPRequestMessage &request, const HTTPRouteParams &,
+		HTTPResponseMessage &response) { request_handler(request, response); });
+}
+
+inline void HTTPServer::addHandler(HTTPRequestType request_type,
+				   std::string path,
+				   HTTPRouteHandler route_handler) noexcept(false) {
+	router_.addRoute(request_type, path, std::move(route_handler));
+}
+
+inline void
+HTTPServer::setDefaultHandler(HTTPRequestHandler request_handler) noexcept {
+	default_handler_ = std::move(request_handler);
+}
+
+inline void HTTPServer::start() noexcept(false) {
+	try {
+		event_loop_->startEventloop();
+	} catch (...) {
+		closeRemainingConnections_();
+		throw;
+	}
+	closeRemainingConnections_();
+}
+
+inline void HTTPServer::stop() noexcept { event_loop_->stopEventloop(); }
+
+inline concurrency::FDStatus HTTPServer::onAccept_(
+    concurrency::PeerStateHolder *peer_state_holder) noexcept {
+	HTTPServerConnection *connection = static_cast<HTTPServerConnection *>(
+	    peer_state_holder->getPeerState());
+	try {
+		connection->read_buffer = std::make_shared<io::IOBuffer<char>>(
+		    server_options_.buffer_size);
+		connection->write_buffer = std::make_shared<io::IOBuffer<char>>(
+		    server_options_.buffer_size);
+		connection->request_in_progress = request_pool_.acquire();
+		connections_.insert(peer_state_holder);
+	} catch (const std::exception &) {
+		return closeConnection_(peer_state_holder);
+	}
+	connection->last_activity = std::chrono::steady_clock::now();
+	return concurrency::WantRead;
+}
+
+inline concurrency::FDStatus
+HTTPServer::onRead_(concurrency::PeerStateHolder *peer_state_holder,
+		    const std::shared_ptr<EventLoopType> &event_loop) noexcept {
+	HTTPServerConnection &connection = *static_cast<HTTPServerConnection *>(
+	    peer_state_holder->getPeerState());
+	io::IOBuffer<char> &read_buffer = *connection.read_buffer;
+	try {
+		// The parser consumes a partial request, the buffer holds at most
+		// the requests which are not handled yet
+		if (!read_buffer.getDataSize())
+			read_buffer.clear();
+		else
+			read_buffer.compact();
+		if (!read_buffer.getAvailableSpace()) read_buffer.reserve();
+		int read_ret =
+		    event_loop->readFromPeer(peer_state_holder, connection.read_buffer);
+		if (!read_ret) return closeConnection_(peer_state_holder);
+		if (read_ret > 0) {
+			connection.last_activity = std::chrono::steady_clock::now();
+			if (connection.close_after_write)
+				// Drain the client's bytes until its end of stream
+				read_buffer.clear();
+			else
+				processRequests_(connection);
+		}
+		if (connection.write_buffer->getDataSize())
+			return flush_(peer_state_holder, connection, event_loop);
+		return concurrency::WantRead;
+	} catch (const std::exception &) {
+		return closeConnection_(peer_state_holder);
+	}
+}
+
+inline concurrency::FDStatus
+HTTPServer::onWrite_(concurrency::PeerStateHolder *peer_state_holder,
+		     const std::shared_ptr<EventLoopType> &event_loop) noexcept {
+	HTTPServerConnection &connection = *static_cast<HTTPServerConnection *>(
+	    peer_state_holder->getPeerState());
+	try {
+		return flush_(peer_state_holder, connection, event_loop);
+	} catch (const std::exception &) {
+		return closeConnection_(peer_state_holder);
+	}
+}
+
+inline void HTTPServer::onTimer_() noexcept {
+	date_clock_.tick();
+	std::chrono::steady_clock::time_point now =
+	    std::chrono::steady_clock::now();
+	for (concurrency::PeerStateHolder *peer_state_holder : connections_) {
+		const HTTPServerConnection &connection =
+		    *static_cast<HTTPServerConnection *>(
+			peer_state_holder->getPeerState());
+		bool head_in_progress =
+		    connection.parser_state != ParserState::RequestLineBegin &&
+		    is_request_head_state(connection.parser_state);
+		if ((head_in_progress &&
+		     now - connection.head_started >
+			 server_options_.header_read_timeout) ||
+		    now - connection.last_activity > server_options_.idle_timeout)
+			// The next read sees the end of stream and closes the
+			// connection, the event loop owns its state
+			::shutdown(peer_state_holder->getFileDescriptor(), SHUT_RDWR);
+	}
+}
+
+inline void
+HTTPServer::processRequests_(HTTPServerConnection &connection) noexcept(false) {
+	io::IOBuffer<char> &read_buffer = *connection.read_buffer;
+	while (read_buffer.getDataSize() && !connection.close_after_write) {
+		if (connection.parser_state == ParserState::RequestLineBegin)
+			connection.head_started = connection.last_activity;
+		std::size_t consumed_bytes{};
+		connection.request_in_progress = ParseHTTP1_1RequestMessage(
+		    connection.read_buffer, connection.parser_state,
+		    std::move(connection.request_in_progress), consumed_bytes,
+		    server_options_.parser_limits);
+		read_buffer.modifyStartOffset(consumed_bytes);
+		switch (connection.parser_state) {
+		case ParserState::ParsingDone:
+			handleRequest_(connection, *connection.request_in_progress);
+			connection.request_in_progress->reset();
+			connection.parser_state = ParserState::RequestLineBegin;
+			break;
+		case ParserState::ProtocolError:
+			appendErrorResponse_(connection, HTTPResponseCodes::BadRequest);
+			break;
+		case ParserState::VersionNotSupported:
+			appendErrorResponse_(
+			    connection,
+			    HTTPResponseCodes::HttpVersionNotSupported);
+			break;
+		case ParserState::RequestURITooLarge:
+			appendErrorResponse_(connection,
+					     HTTPResponseCodes::RequestURITooLarge);
+			break;
+		case ParserState::HeaderSectionTooLarge:
+			appendErrorResponse_(
+			    connection, HTTPResponseCodes::RequestHeaderFieldsTooLarge);
+			break;
+		case ParserState::BodyTooLarge:
+			appendErrorResponse_(connection,
+					     HTTPResponseCodes::RequestEntityTooLarge);
+			break;
+		default:
+			// The rest of the request is not received yet
+			return;
+		}
+	}
+}
+
+inline void
+HTTPServer::handleRequest_(HTTPServerConnection &connection,
+			   const HTTPRequestMessage &request) noexcept(false) {
+	std::optional<std::string> connection_header =
+	    request.constGetHTTPHeaders()->getHeaderValue(HTTPHeaderID::Connection);
+	// An HTTP/1.0 connection only persists on "Connection: keep-alive"
+	bool http1_0_keep_alive =
+	    request.getHTTPVersion() == HTTPVersion::HTTP1_0 &&
+	    connection_header && has_list_element(*connection_header, "keep-alive");
+	if ((connection_header && has_connection_close(*connection_header)) ||
+	    (request.getHTTPVersion() == HTTPVersion::HTTP1_0 &&
+	     !http1_0_keep_alive))
+		connection.close_after_write = true;
+	HTTPRouteParams route_params;
+	std::string_view request_path = request.getURIView().path;
+	const HTTPRouteHandler *route_handler = router_.findRoute(
+	    request.getRequestType(), request_path, route_params);
+	// HEAD is answered by the GET handler, appendResponse_ drops the body
+	if (!route_handler && request.getRequestType() == HTTPRequestType::Head)
+		route_handler = router_.findRoute(HTTPRequestType::Get,
+						  request_path, route_params);
+	if (!route_handler && !default_handler_) {
+		// A method the server doesn't know, rather than a missing route
+		if (request.getRequestType() == HTTPRequestType::Unsupported)
+			appendErrorResponse_(connection,
+					     HTTPResponseCodes::NotImplemented);
+		else
+			not_found_template_.appendTo(*connection.write_buffer,
+						     date_clock_);
+		return;
+	}
+	HTTPContentCoding content_coding = HTTPContentCoding::Identity;
+	if (server_options_.compression) {
+		std::optional<std::string_view> accept_encoding =
+		    request.constGetHTTPHeaders()->getHeaderValueView(
+			HTTPHeaderID::AcceptEncoding);
+		if (accept_encoding)
+			content_coding = negotiate_content_coding(*accept_encoding);
+	}
+	response_.reset();
+	response_.setResponseCode(HTTPResponseCodes::Ok);
+	response_.setRequestType(request.getRequestType());
+	try {
+		if (route_handler)
+			(*route_handler)(request, route_params, response_);
+		else
+			default_handler_(request, response_);
+	} catch (const std::exception &) {
+		appendErrorResponse_(connection,
+				     HTTPResponseCodes::InternalServerError);
+		return;
+	}
+	// The handler set a code which can't be put on a status-line
+	if (!is_valid_response_code(response_.getResponseCode())) {
+		appendErrorResponse_(connection,
+				     HTTPResponseCodes::InternalServerError);
+		return;
+	}
+	if (http1_0_keep_alive && !connection.close_after_write &&
+	    !response_.constGetHTTPHeaders()->headerContains(
+		HTTPHeaderID::Connection))
+		response_.addHeader(header_name_from_id(HTTPHeaderID::Connection),
+				    "keep-alive");
+	appendResponse_(connection, response_, content_coding);
+}
+
+inline void HTTPServer::appendErrorResponse_(
+    HTTPServerConnection &connection,
+    HTTPResponseCodes response_code) noexcept(false) {
+	connection.close_after_write = true;
+	for (auto &[template_code, response_template] : error_templates_) {
+		if (template_code == response_code) {
+			response_template.appendTo(*connection.write_buffer,
+						   date_clock_);
+			return;
+		}
+	}
+	HTTPResponseMessage response;
+	response.setResponseCode(response_code);
+	appendResponse_(connection, response);
+}
+
+inline void HTTPServer::appendResponse_(
+    HTTPServerConnection &connection, HTTPResponseMessage &response,
+    HTTPContentCoding content_coding) noexcept(false) {
+	int response_code = static_cast<int>(response.getResponseCode());
+	bool has_body = response_code >= 200 &&
+			response.getResponseCode() != HTTPResponseCodes::NoContent &&
+			response.getResponseCode() != HTTPResponseCodes::NotModified;
+	// A HEAD response is compressed as well, for the Content-Length
+	if (has_body && server_options_.compression)
+		compressBody_(response, content_coding);
+	const std::unique_ptr<HTTPHeaders> &response_headers =
+	    response.constGetHTTPHeaders();
+	if (has_body && !response_headers->headerContains(HTTPHeaderID::ContentLength))
+		response.addHeader(
+		    "Content-Length",
+		    std::to_string(response.constGetRawBody().getDataSize()));
+	// The Content-Length of a HEAD response is the one of the GET response
+	if (!has_body || response.getRequestType() == HTTPRequestType::Head)
+		response.flushBody();
+	std::optional<std::string> connection_header =
+	    response_headers->getHeaderValue(HTTPHeaderID::Connection);
+	if (connection_header && has_connection_close(*connection_header))
+		connection.close_after_write = true;
+	else if (connection.close_after_write)
+		response.addHeader("Connection", "close");
+	if (!response_headers->headerContains(HTTPHeaderID::Date))
+		response.addHeader(header_name_from_id(HTTPHeaderID::Date),
+				   date_clock_.getDate());
+	response.serializeTo(*connection.write_buffer);
+}
+
+inline void
+HTTPServer::compressBody_(HTTPResponseMessage &response,
+			  HTTPContentCoding content_coding) noexcept(false) {
+	const HTTPMessageBody &body = response.constGetRawBody();
+	const std::unique_ptr<HTTPHeaders> &response_headers =
+	    response.constGetHTTPHeaders();
+	if (body.getDataSize() < server_options_.compression->min_size ||
+	    response.getResponseCode() == HTTPResponseCodes::PartialContent ||
+	    response_headers->headerContains(HTTPHeaderID::ContentEncoding))
+		return;
+	std::optional<std::string_view> content_type =
+	    response_headers->getHeaderValueView(HTTPHeaderID::ContentType);
+	if (!content_type || !is_compressible_content_type(*content_type)) return;
+
+	// Caches must not hand this body to a client with another
+	// Accept-Encoding, whichever coding this client gets
+	std::optional<std::string_view> vary =
+	    response_headers->getHeaderValueView(HTTPHeaderID::Vary);
+	if (!vary) {
+		response.addHeader(header_name_from_id(HTTPHeaderID::Vary),
+				   "Accept-Encoding");
+	} else if (*vary != "*" &&
+		   !has_list_element(*vary, "Accept-Encoding")) {
+		std::string vary_value{*vary};
+		vary_value += ", Accept-Encoding";
+		response.removeHeader(header_name_from_id(HTTPHeaderID::Vary));
+		response.addHeader(header_name_from_id(HTTPHeaderID::Vary),
+				   vary_value);
+	}
+	if (content_coding == HTTPContentCoding::Identity) return;
+
+	std::string_view body_bytes{body.getStartOffsetPointer(),
+				    body.getDataSize()};
+	HTTPCompressedVariantCache::Key variant_key =
+	    HTTPCompressedVariantCache::makeKey(body_bytes, content_coding);
+	std::shared_ptr<const std::string> cached_variant =
+	    variant_cache_->find(variant_key);
+	std::string_view compressed;
+	if (cached_variant) {
+		compressed = *cached_variant;
+	} else {
+		HTTPCompressor &compressor =
+		    content_coding == HTTPContentCoding::Gzip ? *gzip_compressor_
+							      : *deflate_compressor_;
+		compression_buffer_->clear();
+		compressor.reset();
+		compressor.compress(body_bytes.data(), body_bytes.size(),
+				    *compression_buffer_);
+		compressor.finish(*compression_buffer_);
+		compressed = {compression_buffer_->getStartOffsetPointer(),
+			      compression_buffer_->getDataSize()};
+		// An incompressible body goes out as it is
+		if (compressed.size() >= body_bytes.size()) return;
+		variant_cache_->insert(variant_key, compressed);
+	}
+	response.removeHeader(header_name_from_id(HTTPHeaderID::ContentLength));
+	response.addHeader(header_name_from_id(HTTPHeaderID::ContentEncoding),
+			   content_coding_name(content_coding));
+	response.flushBody();
+	response.pushBackRawBody(compressed.data(), compressed.size());
+}
+
+inline concurrency::FDStatus
+HTTPServer::flush_(concurrency::PeerStateHolder *peer_state_holder,
+		   HTTPServerConnection &connection,
+		   const std::shared_ptr<EventLoopType> &event_loop) noexcept(false) {
+	io::IOBuffer<char> &write_buffer = *connection.write_buffer;
+	while (write_buffer.getDataSize()) {
+		if (event_loop->writeToPeer(peer_state_holder,
+					    connection.write_buffer) <= 0)
+			// Resumed on the writable event, no reads until then
+			return concurrency::WantWrite;
+		connection.last_activity = std::chrono::steady_clock::now();
+	}
+	write_buffer.clear();
+	if (connection.close_after_write)
+		// The client reads the responses up to our FIN, closing with its
+		// unread requests in our receive buffer would reset the connection
+		::shutdown(peer_state_holder->getFileDescriptor(), SHUT_WR);
+	return concurrency::WantRead;
+}
+
+inline concurrency::FDStatus HTTPServer::closeConnection_(
+    concurrency::PeerStateHolder *peer_state_holder) noexcept {
+	HTTPServerConnection *connection = static_cast<HTTPServerConnection *>(
+	    peer_state_holder->getPeerState());
+	request_pool_.release(std::move(connection->request_in_progress));
+	connections_.erase(peer_state_holder);
+	return concurrency::WantNoReadWrite;
+}
+
+inline void HTTPServer::closeRemainingConnections_() noexcept {
+	for (concurrency::PeerStateHolder *peer_state_holder : connections_) {
+		::close(peer_state_holder->getFileDescriptor());
+		delete static_cast<HTTPServerConnection *>(
+		    peer_state_holder->getPeerState());
+		delete peer_state_holder;
+	}
+	connections_.clear();
+}
+
+} // namespace blueth::http
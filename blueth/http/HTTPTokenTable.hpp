@@ -0,0 +1,304 @@
+#pragma once
+#include "HTTPConstants.hpp"
+#include "HTTPParserCommon.hpp"
+#include "common.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// clang-format off
+/* Interning of the HTTP methods and the well-known header names into small integer IDs.
+ *
+ * The IDs are found with a perfect hash which is generated at compile time: the hash only looks at the length
+ * and four bytes of the token(first, middle and the last two), and make_perfect_hash_table searches for a seed
+ * under which no two tokens of the table land in the same slot. A lookup is then one hash, one table load and a
+ * single comparison against the candidate token, no matter how many tokens are in the table.
+ *
+ *    "Content-Length" -> hash(14, 'c', '-', 'h', 't', seed) & 511 -> slots[...] = ContentLength -> compare
+ *
+ * The header names are matched case-insensitively(RFC 7230 3.2), the methods are case-sensitive.
+ */
+// clang-format on
+
+namespace blueth::http {
+
+enum class HTTPHeaderID : std::uint8_t {
+	Unknown,
+	Accept,
+	AcceptCharset,
+	AcceptEncoding,
+	AcceptLanguage,
+	AcceptRanges,
+	AccessControlAllowCredentials,
+	AccessControlAllowHeaders,
+	AccessControlAllowMethods,
+	AccessControlAllowOrigin,
+	AccessControlExposeHeaders,
+	AccessControlMaxAge,
+	AccessControlRequestHeaders,
+	AccessControlRequestMethod,
+	Age,
+	Allow,
+	AltSvc,
+	Authorization,
+	CacheControl,
+	Connection,
+	ContentDisposition,
+	ContentEncoding,
+	ContentLanguage,
+	ContentLength,
+	ContentLocation,
+	ContentRange,
+	ContentSecurityPolicy,
+	ContentType,
+	Cookie,
+	Date,
+	ETag,
+	Expect,
+	Expires,
+	Forwarded,
+	From,
+	Host,
+	IfMatch,
+	IfModifiedSince,
+	IfNoneMatch,
+	IfRange,
+	IfUnmodifiedSince,
+	KeepAlive,
+	LastModified,
+	Link,
+	Location,
+	MaxForwards,
+	Origin,
+	Pragma,
+	ProxyAuthenticate,
+	ProxyAuthorization,
+	ProxyConnection,
+	Range,
+	Referer,
+	RetryAfter,
+	Server,
+	SetCookie,
+	StrictTransportSecurity,
+	TE,
+	Trailer,
+	TransferEncoding,
+	Upgrade,
+	UpgradeInsecureRequests,
+	UserAgent,
+	Vary,
+	Via,
+	WWWAuthenticate,
+	XContentTypeOptions,
+	XForwardedFor,
+	XForwardedHost,
+	XForwardedProto,
+	XFrameOptions,
+	XPoweredBy,
+	XRequestID,
+	XRequestedWith,
+	Count
+};
+
+static constexpr std::size_t header_id_count =
+    static_cast<std::size_t>(HTTPHeaderID::Count);
+
+// Canonical names of the well-known headers, indexed by HTTPHeaderID
+static constexpr std::array<std::string_view, header_id_count>
+    well_known_header_names{
+	"",
+	"Accept",
+	"Accept-Charset",
+	"Accept-Encoding",
+	"Accept-Language",
+	"Accept-Ranges",
+	"Access-Control-Allow-Credentials",
+	"Access-Control-Allow-Headers",
+	"Access-Control-Allow-Methods",
+	"Access-Control-Allow-Origin",
+	"Access-Control-Expose-Headers",
+	"Access-Control-Max-Age",
+	"Access-Control-Request-Headers",
+	"Access-Control-Request-Method",
+	"Age",
+	"Allow",
+	"Alt-Svc",
+	"Authorization",
+	"Cache-Control",
+	"Connection",
+	"Content-Disposition",
+	"Content-Encoding",
+	"Content-Language",
+	"Content-Length",
+	"Content-Location",
+	"Content-Range",
+	"Content-Security-Policy",
+	"Content-Type",
+	"Cookie",
+	"Date",
+	"ETag",
+	"Expect",
+	"Expires",
+	"Forwarded",
+	"From",
+	"Host",
+	"If-Match",
+	"If-Modified-Since",
+	"If-None-Match",
+	"If-Range",
+	"If-Unmodified-Since",
+	"Keep-Alive",
+	"Last-Modified",
+	"Link",
+	"Location",
+	"Max-Forwards",
+	"Origin",
+	"Pragma",
+	"Proxy-Authenticate",
+	"Proxy-Authorization",
+	"Proxy-Connection",
+	"Range",
+	"Referer",
+	"Retry-After",
+	"Server",
+	"Set-Cookie",
+	"Strict-Transport-Security",
+	"TE",
+	"Trailer",
+	"Transfer-Encoding",
+	"Upgrade",
+	"Upgrade-Insecure-Requests",
+	"User-Agent",
+	"Vary",
+	"Via",
+	"WWW-Authenticate",
+	"X-Content-Type-Options",
+	"X-Forwarded-For",
+	"X-Forwarded-Host",
+	"X-Forwarded-Proto",
+	"X-Frame-Options",
+	"X-Powered-By",
+	"X-Request-ID",
+	"X-Requested-With",
+    };
+
+// Names of the methods, indexed by HTTPRequestType
+static constexpr std::array<std::string_view, 10> http_method_names{
+    "GET",	   "POST",    "HEAD",	 "PUT",	  "UNSUPPORTED",
+    "CONNECT", "DELETE", "OPTIONS", "PATCH", "TRACE"};
+
+template <bool CaseInsensitive>
+BLUETH_FORCE_INLINE constexpr static std::uint32_t
+token_hash(std::string_view token, std::uint32_t seed) {
+	auto fold = [](char value) -> std::uint8_t {
+		return CaseInsensitive ? to_lower_ascii(value) : value;
+	};
+	std::size_t size = token.size();
+	std::uint32_t returner =
+	    seed ^ (static_cast<std::uint32_t>(size) * 0x9E3779B1u);
+	returner = (returner ^ fold(token[0])) * 0x01000193u;
+	returner = (returner ^ fold(token[size / 2])) * 0x01000193u;
+	returner = (returner ^ fold(token[size - 1])) * 0x01000193u;
+	returner = (returner ^ fold(token[size > 1 ? size - 2 : 0])) * 0x01000193u;
+	return returner ^ (returner >> 15);
+}
+
+/**
+ * Slot table of a perfect hash, a slot holds (index of the token + 1) or 0 if
+ * it's empty
+ */
+template <std::size_t TableSize> struct PerfectHashTable {
+	static_assert((TableSize & (TableSize - 1)) == 0,
+		      "TableSize must be a power of two");
+	static constexpr std::uint32_t slot_mask = TableSize - 1;
+	std::uint32_t seed{};
+	bool found{false};
+	std::array<std::uint8_t, TableSize> slots{};
+};
+
+/**
+ * Search for a seed which maps every non-empty token to its own slot, the
+ * empty tokens(placeholders like HTTPHeaderID::Unknown) are left out of the
+ * table. found is false if no seed below max_seed works, which is checked
+ * with a static_assert by the users.
+ */
+template <std::size_t TableSize, bool CaseInsensitive, std::size_t N>
+constexpr PerfectHashTable<TableSize>
+make_perfect_hash_table(const std::array<std::string_view, N> &tokens,
+			std::uint32_t max_seed = 1u << 16) {
+	static_assert(N < 256, "slot index must fit a byte");
+	PerfectHashTable<TableSize> returner;
+	for (std::uint32_t seed = 1; seed < max_seed; seed++) {
+		returner.slots = {};
+		returner.found = true;
+		for (std::size_t index{}; index < N; index++) {
+			if (tokens[index].empty()) continue;
+			std::uint32_t slot =
+			    token_hash<CaseInsensitive>(tokens[index], seed) &
+			    PerfectHashTable<TableSize>::slot_mask;
+			if (returner.slots[slot]) {
+				returner.found = false;
+				break;
+			}
+			returner.slots[slot] = index + 1;
+		}
+		if (returner.found) {
+			returner.seed = seed;
+			return returner;
+		}
+	}
+	return returner;
+}
+
+static constexpr PerfectHashTable<512> header_name_hash_table =
+    make_perfect_hash_table<512, true>(well_known_header_names);
+static_assert(header_name_hash_table.found,
+	      "no perfect hash seed for the header names");
+
+static constexpr PerfectHashTable<32> http_method_hash_table =
+    make_perfect_hash_table<32, false>(http_method_names);
+static_assert(http_method_hash_table.found,
+	      "no perfect hash seed for the methods");
+
+/**
+ * @return ID of a well-known header name(case-insensitive), or
+ * HTTPHeaderID::Unknown
+ */
+BLUETH_FORCE_INLINE constexpr static HTTPHeaderID
+header_id_from_name(std::string_view header_name) {
+	if (header_name.empty()) return HTTPHeaderID::Unknown;
+	std::uint8_t slot =
+	    header_name_hash_table.slots[token_hash<true>(
+					     header_name,
+					     header_name_hash_table.seed) &
+					 header_name_hash_table.slot_mask];
+	if (slot && case_insensitive_equal(well_known_header_names[slot - 1],
+					   header_name))
+		return static_cast<HTTPHeaderID>(slot - 1);
+	return HTTPHeaderID::Unknown;
+}
+
+BLUETH_FORCE_INLINE constexpr static std::string_view
+header_name_from_id(HTTPHeaderID header_id) {
+	return well_known_header_names[static_cast<std::size_t>(header_id)];
+}
+
+BLUETH_FORCE_INLINE constexpr static HTTPRequestType
+request_type_from_method(std::string_view method) {
+	if (method.empty()) return HTTPRequestType::Unsupported;
+	std::uint8_t slot =
+	    http_method_hash_table
+		.slots[token_hash<false>(method, http_method_hash_table.seed) &
+		       http_method_hash_table.slot_mask];
+	if (slot && http_method_names[slot - 1] == method)
+		return static_cast<HTTPRequestType>(slot - 1);
+	return HTTPRequestType::Unsupported;
+}
+
+BLUETH_FORCE_INLINE constexpr static std::string_view
+method_from_request_type(HTTPRequestType request_type) {
+	return http_method_names[static_cast<std::size_t>(request_type)];
+}
+
+} // namespace blueth::http
@@ -0,0 +1,329 @@
+#pragma once
+#include "HTTPConstants.hpp"
+#include "HTTPParserCommon.hpp"
+#include "common.hpp"
+#include "utils/simd.hpp"
+#include <cstddef>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// clang-format off
+/* Zero-copy parsing of a request-target, its query string and a Cookie header. Every component is a string_view
+ * into the parsed string, nothing is decoded or copied until percent_decode is called on a component.
+ *
+ *    http://example.com:8080/api/items/42?sort=desc&page=2#top
+ *    ^^^^   ^^^^^^^^^^^^^^^^ ^^^^^^^^^^^^^ ^^^^^^^^^^^^^^^^ ^^^
+ *    scheme authority        path          query            fragment
+ *
+ * The origin-form("/path?query", what a client sends to a server) has no scheme and authority, an
+ * authority-form target(CONNECT) has only the authority.
+ *
+ *    HTTPPathSegments{"/api/items/42"}    -> "api", "items", "42"
+ *    HTTPQueryParams{"sort=desc&page=2"}  -> {"sort", "desc"}, {"page", "2"}
+ *    HTTPCookies{"theme=dark; tz=UTC"}    -> {"theme", "dark"}, {"tz", "UTC"}
+ */
+// clang-format on
+
+namespace blueth::http {
+
+struct HTTPURIView {
+	std::string_view scheme;
+	std::string_view authority;
+	std::string_view path;
+	// Without the leading '?'
+	std::string_view query;
+	// Without the leading '#'
+	std::string_view fragment;
+};
+
+/**
+ * Split a request-target into its components
+ *
+ * @param target The request-target, the views of the returned
+ * HTTPURIView point into it
+ */
+BLUETH_FORCE_INLINE constexpr static HTTPURIView
+parse_uri_view(std::string_view target) noexcept {
+	HTTPURIView returner;
+	std::size_t fragment_start = target.find('#');
+	if (fragment_start != std::string_view::npos) {
+		returner.fragment = target.substr(fragment_start + 1);
+		target = target.substr(0, fragment_start);
+	}
+	std::size_t query_start = target.find('?');
+	if (query_start != std::string_view::npos) {
+		returner.query = target.substr(query_start + 1);
+		target = target.substr(0, query_start);
+	}
+	if (target.empty() || target.front() == '/' || target == "*") {
+		returner.path = target;
+		return returner;
+	}
+	std::size_t scheme_end = target.find("://");
+	if (scheme_end == std::string_view::npos) {
+		// authority-form, "host:port" of a CONNECT
+		returner.authority = target;
+		return returner;
+	}
+	returner.scheme = target.substr(0, scheme_end);
+	target.remove_prefix(scheme_end + 3);
+	std::size_t path_start = target.find('/');
+	returner.authority = target.substr(0, path_start);
+	if (path_start != std::string_view::npos)
+		returner.path = target.substr(path_start);
+	return returner;
+}
+
+/**
+ * Iteration over the items of a string separated by Separator, the items are
+ * turned into a value_type by ItemTraits::make(std::string_view item). Empty
+ * items are skipped when ItemTraits::skip_empty is true. The iteration
+ * doesn't allocate, the items are views into the string.
+ */
+template <char Separator, typename ItemTraits> class HTTPSplitView {
+      public:
+	using value_type = typename ItemTraits::value_type;
+
+	class const_iterator {
+	      public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = typename ItemTraits::value_type;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const value_type *;
+		using reference = const value_type &;
+
+		constexpr const_iterator() noexcept = default;
+		constexpr explicit const_iterator(std::string_view rest) noexcept
+		    : rest_{rest}, at_end_{false} {
+			advance_();
+		}
+		constexpr reference operator*() const noexcept { return item_; }
+		constexpr pointer operator->() const noexcept { return &item_; }
+		constexpr const_iterator &operator++() noexcept {
+			advance_();
+			return *this;
+		}
+		constexpr const_iterator operator++(int) noexcept {
+			const_iterator returner = *this;
+			advance_();
+			return returner;
+		}
+		constexpr bool operator==(const const_iterator &other) const noexcept {
+			return at_end_ == other.at_end_ &&
+			       (at_end_ || rest_.data() == other.rest_.data());
+		}
+
+	      private:
+		constexpr void advance_() noexcept {
+			for (;;) {
+				if (!has_rest_) {
+					at_end_ = true;
+					return;
+				}
+				std::size_t separator = rest_.find(Separator);
+				std::string_view item = rest_.substr(0, separator);
+				if (separator == std::string_view::npos) {
+					has_rest_ = false;
+					rest_ = rest_.substr(rest_.size());
+				} else {
+					rest_.remove_prefix(separator + 1);
+				}
+				if (ItemTraits::skip_empty && ItemTraits::is_empty(item))
+					continue;
+				item_ = ItemTraits::make(item);
+				return;
+			}
+		}
+
+		std::string_view rest_;
+		value_type item_{};
+		bool has_rest_{true};
+		bool at_end_{true};
+	};
+
+	constexpr HTTPSplitView() noexcept = default;
+	constexpr explicit HTTPSplitView(std::string_view value) noexcept
+	    : value_{value} {}
+	constexpr const_iterator begin() const noexcept {
+		return value_.empty() ? const_iterator{} : const_iterator{value_};
+	}
+	constexpr const_iterator end() const noexcept { return const_iterator{}; }
+	constexpr bool empty() const noexcept { return begin() == end(); }
+
+      protected:
+	std::string_view value_;
+};
+
+struct HTTPPathSegmentTraits {
+	using value_type = std::string_view;
+	static constexpr bool skip_empty = false;
+	static constexpr bool is_empty(std::string_view item) noexcept {
+		return item.empty();
+	}
+	static constexpr std::string_view make(std::string_view item) noexcept {
+		return item;
+	}
+};
+
+/**
+ * The '/' separated segments of a path(still percent-encoded). The leading
+ * '/' doesn't start a segment, "/a//b/" is "a", "", "b", "" and "/" has no
+ * segments.
+ */
+class HTTPPathSegments
+    : public HTTPSplitView<'/', HTTPPathSegmentTraits> {
+      public:
+	constexpr explicit HTTPPathSegments(std::string_view path) noexcept
+	    : HTTPSplitView{path.starts_with('/') ? path.substr(1) : path} {}
+};
+
+struct HTTPNameValueView {
+	std::string_view name;
+	std::string_view value;
+};
+
+struct HTTPQueryParamTraits {
+	using value_type = HTTPNameValueView;
+	static constexpr bool skip_empty = true;
+	static constexpr bool is_empty(std::string_view item) noexcept {
+		return item.empty();
+	}
+	static constexpr HTTPNameValueView make(std::string_view item) noexcept {
+		std::size_t equal_sign = item.find('=');
+		if (equal_sign == std::string_view::npos) return {item, {}};
+		return {item.substr(0, equal_sign), item.substr(equal_sign + 1)};
+	}
+};
+
+/**
+ * The name=value pairs of a query string(application/x-www-form-urlencoded),
+ * a pair without '=' has an empty value. Names and values are still
+ * percent-encoded, decode them with percent_decode(..., true).
+ */
+class HTTPQueryParams : public HTTPSplitView<'&', HTTPQueryParamTraits> {
+      public:
+	using HTTPSplitView::HTTPSplitView;
+	/**
+	 * @return Value of the first parameter named name(compared without
+	 * decoding) or std::nullopt
+	 */
+	constexpr std::optional<std::string_view>
+	getValue(std::string_view name) const noexcept {
+		for (const HTTPNameValueView &param : *this)
+			if (param.name == name) return param.value;
+		return std::nullopt;
+	}
+};
+
+struct HTTPCookieTraits {
+	static constexpr bool is_space(char value) noexcept {
+		return value == static_cast<char>(LexConsts::SP) ||
+		       value == static_cast<char>(LexConsts::HT);
+	}
+	static constexpr std::string_view trim(std::string_view item) noexcept {
+		while (!item.empty() && is_space(item.front())) item.remove_prefix(1);
+		while (!item.empty() && is_space(item.back())) item.remove_suffix(1);
+		return item;
+	}
+	using value_type = HTTPNameValueView;
+	static constexpr bool skip_empty = true;
+	static constexpr bool is_empty(std::string_view item) noexcept {
+		return trim(item).empty();
+	}
+	static constexpr HTTPNameValueView make(std::string_view item) noexcept {
+		item = trim(item);
+		std::size_t equal_sign = item.find('=');
+		if (equal_sign == std::string_view::npos) return {{}, item};
+		std::string_view value = trim(item.substr(equal_sign + 1));
+		// A cookie-value may be in double quotes(RFC 6265 4.1.1)
+		if (value.size() >= 2 && value.front() == '"' && value.back() == '"')
+			value = value.substr(1, value.size() - 2);
+		return {trim(item.substr(0, equal_sign)), value};
+	}
+};
+
+/**
+ * The cookie-pairs of a Cookie header value("name=value; name2=value2"). A
+ * pair without '=' is a nameless cookie, the way the browsers send it.
+ */
+class HTTPCookies : public HTTPSplitView<';', HTTPCookieTraits> {
+      public:
+	using HTTPSplitView::HTTPSplitView;
+	/**
+	 * @return Value of the first cookie named name or std::nullopt
+	 */
+	constexpr std::optional<std::string_view>
+	getValue(std::string_view name) const noexcept {
+		for (const HTTPNameValueView &cookie : *this)
+			if (cookie.name == name) return cookie.value;
+		return std::nullopt;
+	}
+};
+
+/**
+ * Whether the component has anything to decode(a '%', or a '+' with
+ * plus_as_space)
+ */
+BLUETH_FORCE_INLINE inline bool
+needs_percent_decoding(std::string_view encoded,
+		       bool plus_as_space = false) noexcept {
+	const char *encoded_end = encoded.data() + encoded.size();
+	return simd::find_first_of_either(encoded.data(), encoded_end, '%',
+					  plus_as_space ? '+' : '%') !=
+	       encoded_end;
+}
+
+/**
+ * Append the percent-decoded component to output. The runs without a '%'
+ * (or '+') are found 16/32 bytes at a time and appended as a whole.
+ *
+ * @param encoded The percent-encoded component
+ * @param output Receives the decoded bytes
+ * @param plus_as_space Decode '+' as a space, for the query string
+ * @return false if there is a malformed escape('%' not followed by two hex
+ * digits), the output then holds the bytes decoded before it
+ */
+inline bool percent_decode(std::string_view encoded, std::string &output,
+			   bool plus_as_space = false) noexcept(false) {
+	const char *encoded_start = encoded.data();
+	const char *encoded_end = encoded_start + encoded.size();
+	char second_char = plus_as_space ? '+' : '%';
+	output.reserve(output.size() + encoded.size());
+	while (encoded_start != encoded_end) {
+		const char *escape = simd::find_first_of_either(
+		    encoded_start, encoded_end, '%', second_char);
+		output.append(encoded_start, escape);
+		if (escape == encoded_end) break;
+		if (*escape == '+') {
+			output.push_back(static_cast<char>(LexConsts::SP));
+			encoded_start = escape + 1;
+			continue;
+		}
+		if (encoded_end - escape < 3) return false;
+		int hi_nibble = hex_digit_value(escape[1]);
+		int lo_nibble = hex_digit_value(escape[2]);
+		if (hi_nibble < 0 || lo_nibble < 0) return false;
+		output.push_back(static_cast<char>((hi_nibble << 4) | lo_nibble));
+		encoded_start = escape + 3;
+	}
+	return true;
+}
+
+/**
+ * Decode only if there is something to decode: the component itself is
+ * returned when it has no escapes, otherwise it's decoded into storage.
+ *
+ * @return View of the decoded component, std::nullopt on a malformed escape
+ */
+inline std::optional<std::string_view>
+percent_decode_view(std::string_view encoded, std::string &storage,
+		    bool plus_as_space = false) noexcept(false) {
+	if (!needs_percent_decoding(encoded, plus_as_space)) return encoded;
+	storage.clear();
+	if (!percent_decode(encoded, storage, plus_as_space)) return std::nullopt;
+	return std::string_view{storage};
+}
+
+} // namespace blueth::http
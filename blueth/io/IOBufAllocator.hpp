@@ -0,0 +1,271 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/magic.h>
+#include <new>
+#include <sys/mman.h>
+#include <sys/vfs.h>
+#include <unistd.h>
+
+/**
+ * Allocator policies for the memory of io::IOBuffer. The policy is a template
+ * parameter of IOBuffer, so the choice is made per buffer class(for example,
+ * small message bodies use IOBufMallocAllocator and the large proxy relay
+ * buffers use IOBufHugePageAllocator).
+ *
+ * A policy provides two static functions:
+ *
+ * reallocate(ptr, old_size, new_size, used_size): Returns a block of at least
+ * new_size bytes which holds the first used_size bytes of ptr(ptr may be
+ * nullptr, with old_size == 0). Throws std::bad_alloc on failure.
+ *
+ * deallocate(ptr, size): Release the block of 'size' bytes returned by an
+ * earlier reallocate.
+ */
+namespace blueth::io {
+
+struct IOBufMallocAllocator {
+	static void *reallocate(void *ptr,
+				[[maybe_unused]] std::size_t old_size,
+				std::size_t new_size,
+				[[maybe_unused]] std::size_t used_size) {
+		void *returner = ::realloc(ptr, new_size);
+		if (returner == nullptr) throw std::bad_alloc{};
+		return returner;
+	}
+	static void deallocate(void *ptr,
+			       [[maybe_unused]] std::size_t size) noexcept {
+		::free(ptr);
+	}
+};
+
+template <std::size_t Alignment> struct IOBufAlignedAllocator {
+	static_assert((Alignment & (Alignment - 1)) == 0,
+		      "Alignment must be a power of two");
+	static void *reallocate(void *ptr,
+				[[maybe_unused]] std::size_t old_size,
+				std::size_t new_size, std::size_t used_size) {
+		// aligned_alloc needs the size to be a multiple of alignment
+		std::size_t alloc_size =
+		    ((new_size + Alignment - 1) / Alignment) * Alignment;
+		void *returner = ::aligned_alloc(Alignment, alloc_size);
+		if (returner == nullptr) throw std::bad_alloc{};
+		if (ptr) {
+			if (used_size) ::memcpy(returner, ptr, used_size);
+			::free(ptr);
+		}
+		return returner;
+	}
+	static void deallocate(void *ptr,
+			       [[maybe_unused]] std::size_t size) noexcept {
+		::free(ptr);
+	}
+};
+
+using IOBufCacheLineAllocator = IOBufAlignedAllocator<64>;
+using IOBufPageAlignedAllocator = IOBufAlignedAllocator<4096>;
+
+/**
+ * Backs the buffers with 2MB pages to cut the TLB misses on large buffers. We
+ * first try an explicit MAP_HUGETLB mapping(needs reserved huge pages,
+ * vm.nr_hugepages) and fall back to a regular mapping with MADV_HUGEPAGE so
+ * that the transparent huge page daemon can back it. Buffers smaller than half
+ * a huge page are not worth a dedicated mapping and use malloc.
+ */
+struct IOBufHugePageAllocator {
+	static constexpr std::size_t huge_page_size = 2 * 1024 * 1024;
+	static constexpr std::size_t min_mapping_size = huge_page_size / 2;
+
+	static constexpr std::size_t mappingSize(std::size_t size) noexcept {
+		return ((size + huge_page_size - 1) / huge_page_size) *
+		       huge_page_size;
+	}
+	static void *reallocate(void *ptr, std::size_t old_size,
+				std::size_t new_size, std::size_t used_size) {
+		bool old_mapped = old_size >= min_mapping_size;
+		bool new_mapped = new_size >= min_mapping_size;
+		if (!old_mapped && !new_mapped)
+			return IOBufMallocAllocator::reallocate(
+			    ptr, old_size, new_size, used_size);
+		if (old_mapped && new_mapped &&
+		    mappingSize(old_size) == mappingSize(new_size))
+			return ptr;
+		void *returner =
+		    new_mapped ? mapHugePages_(mappingSize(new_size))
+			       : IOBufMallocAllocator::reallocate(
+				     nullptr, 0, new_size, 0);
+		if (ptr) {
+			if (used_size) ::memcpy(returner, ptr, used_size);
+			deallocate(ptr, old_size);
+		}
+		return returner;
+	}
+	static void deallocate(void *ptr, std::size_t size) noexcept {
+		if (size >= min_mapping_size)
+			::munmap(ptr, mappingSize(size));
+		else
+			::free(ptr);
+	}
+
+      private:
+	static void *mapHugePages_(std::size_t size) {
+		void *returner =
+		    ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+			   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (returner != MAP_FAILED) return returner;
+		// THP can only back 2MB aligned ranges, so we map one extra
+		// huge page and trim the unaligned head and tail
+		returner = ::mmap(nullptr, size + huge_page_size,
+				  PROT_READ | PROT_WRITE,
+				  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (returner == MAP_FAILED) throw std::bad_alloc{};
+		char *mapping = static_cast<char *>(returner);
+		std::size_t head =
+		    (huge_page_size -
+		     (reinterpret_cast<std::uintptr_t>(mapping) %
+		      huge_page_size)) %
+		    huge_page_size;
+		if (head) ::munmap(mapping, head);
+		if (huge_page_size - head)
+			::munmap(mapping + head + size, huge_page_size - head);
+		::madvise(mapping + head, size, MADV_HUGEPAGE);
+		return mapping + head;
+	}
+};
+
+/**
+ * Spills large buffers to a memory mapped temporary file, so a body of hundreds
+ * of MB doesn't have to live in anonymous heap memory. The dirty pages of a
+ * file mapping on a disk can be written back and evicted by the kernel under
+ * memory pressure. Buffers smaller than SpillThreshold use malloc.
+ *
+ * The backing file is an unnamed O_TMPFILE in $TMPDIR(or /tmp). When the
+ * directory is tmpfs/ramfs(its pages are RAM or swap, like the heap) or has no
+ * O_TMPFILE support, nothing is spilled and every buffer uses malloc, see
+ * isSpillAvailable(). Each spilled buffer holds a file descriptor and a
+ * mapping, which is kept in a header page right before the returned memory so
+ * the mapping can be grown in place with ftruncate + mremap without copying the
+ * bytes.
+ *
+ * The descriptor stays open until the buffer is deallocated, so every live
+ * buffer past SpillThreshold counts against RLIMIT_NOFILE next to the sockets.
+ * When the file can't be opened, grown or mapped(EMFILE, ENOSPC, ENOMEM) the
+ * allocation throws std::bad_alloc, nothing is printed, the caller decides.
+ */
+template <std::size_t SpillThreshold = 1024 * 1024>
+struct IOBufFileBackedAllocator {
+	static constexpr std::size_t spill_threshold = SpillThreshold;
+
+	static void *reallocate(void *ptr, std::size_t old_size,
+				std::size_t new_size, std::size_t used_size) {
+		bool old_mapped = isSpilled_(old_size);
+		bool new_mapped = isSpilled_(new_size);
+		if (!old_mapped && !new_mapped)
+			return IOBufMallocAllocator::reallocate(
+			    ptr, old_size, new_size, used_size);
+		if (old_mapped && new_mapped)
+			return remapFile_(ptr, old_size, new_size);
+		void *returner =
+		    new_mapped ? mapFile_(new_size)
+			       : IOBufMallocAllocator::reallocate(nullptr, 0,
+								  new_size, 0);
+		if (ptr) {
+			std::size_t copy_size = std::min(used_size, new_size);
+			if (copy_size) ::memcpy(returner, ptr, copy_size);
+			deallocate(ptr, old_size);
+		}
+		return returner;
+	}
+	static void deallocate(void *ptr, std::size_t size) noexcept {
+		if (!isSpilled_(size)) {
+			::free(ptr);
+			return;
+		}
+		char *mapping = static_cast<char *>(ptr) - headerSize_();
+		int fd = *reinterpret_cast<int *>(mapping);
+		::munmap(mapping, headerSize_() + mappingSize_(size));
+		::close(fd);
+	}
+	/**
+	 * Whether the large buffers are spilled, probed once per process: the
+	 * temporary directory must support O_TMPFILE and not be tmpfs/ramfs
+	 */
+	static bool isSpillAvailable() noexcept {
+		static const bool spill_available = probeTmpDir_();
+		return spill_available;
+	}
+
+      private:
+	static bool isSpilled_(std::size_t size) noexcept {
+		return size >= spill_threshold && isSpillAvailable();
+	}
+	// Unnamed temporary file in $TMPDIR(or /tmp), -1 on failure
+	static int openTmpFile_() noexcept {
+		const char *tmp_dir = ::getenv("TMPDIR");
+		return ::open(tmp_dir ? tmp_dir : "/tmp",
+			      O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+	}
+	static bool probeTmpDir_() noexcept {
+		int fd = openTmpFile_();
+		if (fd < 0) return false;
+		struct statfs fs_stats {};
+		bool disk_backed = ::fstatfs(fd, &fs_stats) == 0 &&
+				   fs_stats.f_type != TMPFS_MAGIC &&
+				   fs_stats.f_type != RAMFS_MAGIC;
+		::close(fd);
+		return disk_backed;
+	}
+	static std::size_t headerSize_() noexcept {
+		static const std::size_t page_size = ::sysconf(_SC_PAGESIZE);
+		return page_size;
+	}
+	static std::size_t mappingSize_(std::size_t size) noexcept {
+		return ((size + headerSize_() - 1) / headerSize_()) *
+		       headerSize_();
+	}
+	static void *mapFile_(std::size_t size) {
+		int fd = openTmpFile_();
+		if (fd < 0) throw std::bad_alloc{};
+		std::size_t total_size = headerSize_() + mappingSize_(size);
+		if (::ftruncate(fd, total_size) < 0) {
+			::close(fd);
+			throw std::bad_alloc{};
+		}
+		void *mapping =
+		    ::mmap(nullptr, total_size, PROT_READ | PROT_WRITE,
+			   MAP_SHARED, fd, 0);
+		if (mapping == MAP_FAILED) {
+			::close(fd);
+			throw std::bad_alloc{};
+		}
+		*static_cast<int *>(mapping) = fd;
+		// Bodies are written and read front to back. The advice covers
+		// the header too, a split VMA can't be grown with a single
+		// mremap
+		::madvise(mapping, total_size, MADV_SEQUENTIAL);
+		return static_cast<char *>(mapping) + headerSize_();
+	}
+	static void *remapFile_(void *ptr, std::size_t old_size,
+				std::size_t new_size) {
+		if (mappingSize_(old_size) == mappingSize_(new_size))
+			return ptr;
+		char *mapping = static_cast<char *>(ptr) - headerSize_();
+		int fd = *reinterpret_cast<int *>(mapping);
+		std::size_t old_total = headerSize_() + mappingSize_(old_size);
+		std::size_t new_total = headerSize_() + mappingSize_(new_size);
+		if (new_total > old_total && ::ftruncate(fd, new_total) < 0)
+			throw std::bad_alloc{};
+		void *new_mapping =
+		    ::mremap(mapping, old_total, new_total, MREMAP_MAYMOVE);
+		if (new_mapping == MAP_FAILED) throw std::bad_alloc{};
+		if (new_total < old_total) ::ftruncate(fd, new_total);
+		::madvise(new_mapping, new_total, MADV_SEQUENTIAL);
+		return static_cast<char *>(new_mapping) + headerSize_();
+	}
+};
+
+} // namespace blueth::io
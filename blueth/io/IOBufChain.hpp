@@ -0,0 +1,423 @@
+#pragma once
+#include "IOBufSlice.hpp"
+#include "IOBuffer.hpp"
+#include "common.hpp"
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <stdexcept>
+#include <sys/uio.h>
+#include <utility>
+#include <vector>
+
+// clang-format off
+/* IOBufChain is a chain of reference counted IOBuffer segments. Each segment is
+ * a [start, end) view into a shared IOBuffer, so the same underlying memory can
+ * be referenced by many segments(and many chains) without copying the bytes.
+ *
+ *      segment 0            segment 1                segment 2
+ *    +-----------+    +-------------------+    +-----------------+
+ *    | IOBuffer A| -> | IOBuffer B [s, e) | -> | IOBuffer B [e, x)| ...
+ *    +-----------+    +-------------------+    +-----------------+
+ *
+ * Appending/Prepending a buffer or another chain is O(1), splitting the chain
+ * at an offset only splits the segment which contains the offset(both halves
+ * still point to the same memory) and the bytes are only copied into a single
+ * contiguous region when a user explicitly asks for it(coalesce).
+ *
+ * Since the memory of a segment may be shared, we never write into a segment
+ * unless it is the only reference to the underlying IOBuffer. Segments appended
+ * from an IOBufSlice are immutable and are never written into.
+ */
+// clang-format on
+
+namespace blueth::io {
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> = true>
+class IOBufChain {
+      public:
+	using value_type = typename IOBufTraits<T>::value_type;
+	using pointer_type = typename IOBufTraits<T>::pointer_type;
+	using const_pointer_type = typename IOBufTraits<T>::const_pointer_type;
+	using size_type = typename IOBufTraits<T>::size_type;
+	using buffer_type = std::shared_ptr<IOBuffer<T>>;
+
+	/**
+	 * A view of [start, end) into a (possibly shared) IOBuffer. The offsets
+	 * are relative to the start of the underlying memory, not to the
+	 * IOBuffer's start_offset. Segments of an IOBufSlice have no buffer,
+	 * the offsets are relative to slice_data which is kept alive by
+	 * slice_owner.
+	 */
+	struct Segment {
+		buffer_type buffer;
+		size_type start;
+		size_type end;
+		typename IOBufSlice<T>::owner_type slice_owner{};
+		const_pointer_type slice_data{nullptr};
+		BLUETH_FORCE_INLINE const_pointer_type data() const noexcept {
+			return (buffer ? buffer->getBuffer() : slice_data) +
+			       start;
+		}
+		BLUETH_FORCE_INLINE size_type size() const noexcept {
+			return end - start;
+		}
+	};
+	using segment_container = std::deque<Segment>;
+	using const_segment_iterator =
+	    typename segment_container::const_iterator;
+
+	static constexpr size_type default_segment_capacity = 4096;
+	static std::unique_ptr<IOBufChain<T>> create();
+	IOBufChain() = default;
+	~IOBufChain() = default;
+	IOBufChain(IOBufChain &&) noexcept = default;
+	IOBufChain &operator=(IOBufChain &&) noexcept = default;
+	IOBufChain(const IOBufChain &) = delete;
+	IOBufChain &operator=(const IOBufChain &) = delete;
+	/**
+	 * Append the data region of the IOBuffer to the end of the chain
+	 * without copying the bytes. The chain takes the ownership of the
+	 * buffer.
+	 *
+	 * @param io_buffer Buffer to be appended
+	 */
+	void append(std::unique_ptr<IOBuffer<T>> io_buffer) noexcept(false);
+	/**
+	 * Append the data region of a shared IOBuffer without copying the bytes,
+	 * the caller must not modify the data region of the buffer afterwards.
+	 *
+	 * @param io_buffer Buffer to be appended
+	 */
+	void append(buffer_type io_buffer) noexcept(false);
+	/**
+	 * Move all the segments of other chain to the end of current chain
+	 *
+	 * @param io_chain Source chain, left empty after the call
+	 */
+	void append(IOBufChain &&io_chain) noexcept(false);
+	/**
+	 * Append an immutable shared slice without copying the bytes, the
+	 * same slice can be appended to the chains of many peers
+	 *
+	 * @param io_slice Slice to be appended
+	 */
+	void append(const IOBufSlice<T> &io_slice) noexcept(false);
+	void prepend(std::unique_ptr<IOBuffer<T>> io_buffer) noexcept(false);
+	void prepend(buffer_type io_buffer) noexcept(false);
+	void prepend(IOBufChain &&io_chain) noexcept(false);
+	void prepend(const IOBufSlice<T> &io_slice) noexcept(false);
+	/**
+	 * Copy raw bytes to the end of the chain. The bytes are written into
+	 * the spare capacity of the last segment when we are the only owner of
+	 * it, otherwise a new segment is allocated.
+	 *
+	 * @param data Raw data to be appended
+	 * @param size Size of bytes to be appended
+	 */
+	void appendRawBytes(const_pointer_type data,
+			    size_type size) noexcept(false);
+	/**
+	 * Split the chain at offset, the first 'offset' bytes are returned as
+	 * a new chain and the current chain holds the remaining bytes. No
+	 * bytes are copied, the segment on the boundary is shared by both.
+	 *
+	 * If offset is greater than the data size of the chain, an exception
+	 * of type std::out_of_range is thrown
+	 *
+	 * @param offset Number of bytes to split from the front
+	 * @return Chain with the first 'offset' bytes
+	 */
+	IOBufChain splitAt(size_type offset) noexcept(false);
+	/**
+	 * Share all the segments of the current chain with a new chain,
+	 * only the reference count of the underlying buffers are incremented
+	 */
+	IOBufChain clone() const;
+	/**
+	 * Drop 'size' bytes from front/back of the chain(for example, after
+	 * a partial writev on a Non-blocking socket)
+	 */
+	void trimStart(size_type size) noexcept;
+	void trimEnd(size_type size) noexcept;
+	/**
+	 * Copy all the segments into a single contiguous IOBuffer, the chain
+	 * will only contain one segment after the call. Chains with zero or one
+	 * segment are not touched.
+	 *
+	 * @return Pointer to the start of contiguous data of the chain
+	 */
+	const_pointer_type coalesce() noexcept(false);
+	/**
+	 * Fill the iovec array with the segments(in order) for writev/sendmsg
+	 *
+	 * @param iov Pointer to the iovec array
+	 * @param iov_len Size of the iovec array
+	 * @return Number of iovec entries used
+	 */
+	size_type fillIovec(::iovec *iov, size_type iov_len) const noexcept;
+	std::vector<::iovec> getIovec() const;
+	constexpr size_type getDataSize() const noexcept;
+	size_type segmentCount() const noexcept;
+	bool empty() const noexcept;
+	void clear() noexcept;
+	const_segment_iterator cbegin() const noexcept;
+	const_segment_iterator cend() const noexcept;
+
+      private:
+	void pushBackSegment_(buffer_type &&io_buffer) noexcept(false);
+	void pushFrontSegment_(buffer_type &&io_buffer) noexcept(false);
+
+	segment_container segments_;
+	size_type data_size_{};
+};
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline std::unique_ptr<IOBufChain<T>> IOBufChain<T, U>::create() {
+	return std::make_unique<IOBufChain<T>>();
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline void
+IOBufChain<T, U>::pushBackSegment_(buffer_type &&io_buffer) noexcept(false) {
+	if (!io_buffer) throw std::runtime_error{"invalid IOBuffer"};
+	if (!io_buffer->getDataSize()) return;
+	size_type start = io_buffer->getStartOffset();
+	size_type end = io_buffer->getEndOffset();
+	data_size_ += (end - start);
+	segments_.push_back(Segment{std::move(io_buffer), start, end});
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline void
+IOBufChain<T, U>::pushFrontSegment_(buffer_type &&io_buffer) noexcept(false) {
+	if (!io_buffer) throw std::runtime_error{"invalid IOBuffer"};
+	if (!io_buffer->getDataSize()) return;
+	size_type start = io_buffer->getStartOffset();
+	size_type end = io_buffer->getEndOffset();
+	data_size_ += (end - start);
+	segments_.push_front(Segment{std::move(io_buffer), start, end});
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline void IOBufChain<T, U>::append(
+    std::unique_ptr<IOBuffer<T>> io_buffer) noexcept(false) {
+	pushBackSegment_(buffer_type{std::move(io_buffer)});
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline void IOBufChain<T, U>::append(buffer_type io_buffer) noexcept(false) {
+	pushBackSegment_(std::move(io_buffer));
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline void IOBufChain<T, U>::append(IOBufChain &&io_chain) noexcept(false) {
+	if (segments_.empty()) {
+		std::swap(segments_, io_chain.segments_);
+		std::swap(data_size_, io_chain.data_size_);
+		return;
+	}
+	for (Segment &segment : io_chain.segments_)
+		segments_.push_back(std::move(segment));
+	data_size_ += io_chain.data_size_;
+	io_chain.clear();
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline void
+IOBufChain<T, U>::append(const IOBufSlice<T> &io_slice) noexcept(false) {
+	if (io_slice.empty()) return;
+	data_size_ += io_slice.size();
+	segments_.push_back(Segment{nullptr, 0, io_slice.size(),
+				    io_slice.getOwner(), io_slice.data()});
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline void IOBufChain<T, U>::prepend(
+    std::unique_ptr<IOBuffer<T>> io_buffer) noexcept(false) {
+	pushFrontSegment_(buffer_type{std::move(io_buffer)});
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline void IOBufChain<T, U>::prepend(buffer_type io_buffer) noexcept(false) {
+	pushFrontSegment_(std::move(io_buffer));
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline void IOBufChain<T, U>::prepend(IOBufChain &&io_chain) noexcept(false) {
+	for (auto it = io_chain.segments_.rbegin();
+	     it != io_chain.segments_.rend(); ++it)
+		segments_.push_front(std::move(*it));
+	data_size_ += io_chain.data_size_;
+	io_chain.clear();
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline void
+IOBufChain<T, U>::prepend(const IOBufSlice<T> &io_slice) noexcept(false) {
+	if (io_slice.empty()) return;
+	data_size_ += io_slice.size();
+	segments_.push_front(Segment{nullptr, 0, io_slice.size(),
+				     io_slice.getOwner(), io_slice.data()});
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline void IOBufChain<T, U>::appendRawBytes(const_pointer_type data,
+					     size_type size) noexcept(false) {
+	if (!size) return;
+	if (!segments_.empty()) {
+		Segment &tail = segments_.back();
+		// We can only write into the tail when nobody else can see the
+		// memory past our end offset
+		if (tail.buffer && tail.buffer.use_count() == 1 &&
+		    tail.end == tail.buffer->getEndOffset() &&
+		    tail.buffer->getAvailableSpace() >= size) {
+			tail.buffer->appendRawBytes(data, size);
+			tail.end += size;
+			data_size_ += size;
+			return;
+		}
+	}
+	buffer_type io_buffer = std::make_shared<IOBuffer<T>>(
+	    std::max(size, default_segment_capacity));
+	io_buffer->appendRawBytes(data, size);
+	pushBackSegment_(std::move(io_buffer));
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline IOBufChain<T, U>
+IOBufChain<T, U>::splitAt(size_type offset) noexcept(false) {
+	if (offset > data_size_)
+		throw std::out_of_range{"split offset is past the chain size"};
+	IOBufChain<T, U> head;
+	while (offset) {
+		Segment &front = segments_.front();
+		if (front.size() <= offset) {
+			offset -= front.size();
+			head.data_size_ += front.size();
+			data_size_ -= front.size();
+			head.segments_.push_back(std::move(front));
+			segments_.pop_front();
+		} else {
+			// Both the chains share the boundary segment's memory
+			head.segments_.push_back(front);
+			head.segments_.back().end = front.start + offset;
+			head.data_size_ += offset;
+			data_size_ -= offset;
+			front.start += offset;
+			offset = 0;
+		}
+	}
+	return head;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline IOBufChain<T, U> IOBufChain<T, U>::clone() const {
+	IOBufChain<T, U> returner;
+	returner.segments_ = segments_;
+	returner.data_size_ = data_size_;
+	return returner;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline void IOBufChain<T, U>::trimStart(size_type size) noexcept {
+	while (size && !segments_.empty()) {
+		Segment &front = segments_.front();
+		if (front.size() <= size) {
+			size -= front.size();
+			data_size_ -= front.size();
+			segments_.pop_front();
+		} else {
+			front.start += size;
+			data_size_ -= size;
+			size = 0;
+		}
+	}
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline void IOBufChain<T, U>::trimEnd(size_type size) noexcept {
+	while (size && !segments_.empty()) {
+		Segment &back = segments_.back();
+		if (back.size() <= size) {
+			size -= back.size();
+			data_size_ -= back.size();
+			segments_.pop_back();
+		} else {
+			back.end -= size;
+			data_size_ -= size;
+			size = 0;
+		}
+	}
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline typename IOBufTraits<T>::const_pointer_type
+IOBufChain<T, U>::coalesce() noexcept(false) {
+	if (segments_.empty()) return nullptr;
+	if (segments_.size() == 1) return segments_.front().data();
+	buffer_type io_buffer = std::make_shared<IOBuffer<T>>(data_size_);
+	for (const Segment &segment : segments_)
+		io_buffer->appendRawBytes(segment.data(), segment.size());
+	segments_.clear();
+	data_size_ = 0;
+	pushBackSegment_(std::move(io_buffer));
+	return segments_.front().data();
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline typename IOBufTraits<T>::size_type
+IOBufChain<T, U>::fillIovec(::iovec *iov, size_type iov_len) const noexcept {
+	size_type index{};
+	for (auto it = segments_.cbegin();
+	     it != segments_.cend() && index < iov_len; ++it, ++index) {
+		iov[index].iov_base = (void *)it->data();
+		iov[index].iov_len = it->size();
+	}
+	return index;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline std::vector<::iovec> IOBufChain<T, U>::getIovec() const {
+	std::vector<::iovec> returner(segments_.size());
+	fillIovec(returner.data(), returner.size());
+	return returner;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr typename IOBufTraits<T>::size_type
+IOBufChain<T, U>::getDataSize() const noexcept {
+	return data_size_;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline typename IOBufTraits<T>::size_type
+IOBufChain<T, U>::segmentCount() const noexcept {
+	return segments_.size();
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline bool IOBufChain<T, U>::empty() const noexcept {
+	return data_size_ == 0;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline void IOBufChain<T, U>::clear() noexcept {
+	segments_.clear();
+	data_size_ = 0;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline typename IOBufChain<T, U>::const_segment_iterator
+IOBufChain<T, U>::cbegin() const noexcept {
+	return segments_.cbegin();
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline typename IOBufChain<T, U>::const_segment_iterator
+IOBufChain<T, U>::cend() const noexcept {
+	return segments_.cend();
+}
+
+} // namespace blueth::io
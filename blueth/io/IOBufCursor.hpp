@@ -0,0 +1,351 @@
+#pragma once
+#include "IOBuffer.hpp"
+#include "common.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+
+// clang-format off
+/* Cursor and Appender are lightweight views for decoding/encoding binary protocols in place over an IOBuffer
+ * (or anything with the same offset API, like InlineIOBuffer and MirroredRingBuffer)
+ *
+ *          start_offset     cursor         end_offset
+ *             |               |                |
+ *             v               v                v
+ *    +--------+---------------+----------------+--------------+
+ *    |        |   consumed    |   remaining    |  spare space |
+ *    +--------+---------------+----------------+--------------+
+ *                                              ^
+ *                                              |
+ *                                        Appender writes here
+ *
+ * The Cursor never modifies the buffer. Once a frame is decoded, the caller
+ * commits it with io_buffer->modifyStartOffset(cursor.getConsumed()).
+ * Multi-byte integers are read/written big-endian(network byte order) unless
+ * an other std::endian is given.
+ */
+// clang-format on
+
+namespace blueth::io {
+
+/**
+ * Load an unsigned/signed integer of sizeof(IntType) bytes from 'data'
+ *
+ * @param data Memory to read from, must have at least sizeof(IntType) bytes
+ * @return Decoded integer
+ */
+template <typename IntType, std::endian Endian = std::endian::big,
+	  typename T>
+BLUETH_FORCE_INLINE constexpr IntType loadInteger(const T *data) noexcept {
+	static_assert(std::is_integral_v<IntType>);
+	using UnsignedType = std::make_unsigned_t<IntType>;
+	UnsignedType returner{};
+	// The compiler folds this loop into a single load(+ bswap)
+	for (std::size_t i{}; i < sizeof(IntType); i++) {
+		std::size_t shift = Endian == std::endian::big
+					? (sizeof(IntType) - 1 - i) * 8
+					: i * 8;
+		returner |= static_cast<UnsignedType>(
+				static_cast<std::uint8_t>(data[i]))
+			    << shift;
+	}
+	return static_cast<IntType>(returner);
+}
+
+/**
+ * Store 'value' as sizeof(IntType) bytes into 'data'
+ */
+template <typename IntType, std::endian Endian = std::endian::big,
+	  typename T>
+BLUETH_FORCE_INLINE constexpr void storeInteger(T *data,
+						IntType value) noexcept {
+	static_assert(std::is_integral_v<IntType>);
+	using UnsignedType = std::make_unsigned_t<IntType>;
+	UnsignedType unsigned_value = static_cast<UnsignedType>(value);
+	for (std::size_t i{}; i < sizeof(IntType); i++) {
+		std::size_t shift = Endian == std::endian::big
+					? (sizeof(IntType) - 1 - i) * 8
+					: i * 8;
+		data[i] = static_cast<T>(
+		    static_cast<std::uint8_t>(unsigned_value >> shift));
+	}
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> = true>
+class Cursor {
+      public:
+	using value_type = typename IOBufTraits<T>::value_type;
+	using const_pointer_type = typename IOBufTraits<T>::const_pointer_type;
+	using size_type = typename IOBufTraits<T>::size_type;
+	// Longest LEB128 encoding of a 64 bit value
+	static constexpr size_type max_varint_size = 10;
+
+	constexpr Cursor(const_pointer_type data, size_type size) noexcept
+	    : begin_{data}, current_{data}, end_{data + size} {}
+	/**
+	 * @param io_buffer Any buffer with getStartOffsetPointer() and
+	 * getDataSize(), the cursor covers its current data region
+	 */
+	template <typename BufferType>
+	explicit constexpr Cursor(const BufferType &io_buffer) noexcept
+	    : Cursor(io_buffer.getStartOffsetPointer(),
+		     io_buffer.getDataSize()) {}
+	constexpr size_type getRemaining() const noexcept;
+	constexpr size_type getConsumed() const noexcept;
+	constexpr bool canRead(size_type size) const noexcept;
+	constexpr bool isAtEnd() const noexcept;
+	constexpr const_pointer_type getCurrentPointer() const noexcept;
+	/**
+	 * Read an integer and advance, throws std::out_of_range if there are
+	 * not enough bytes left
+	 */
+	template <typename IntType, std::endian Endian = std::endian::big>
+	constexpr IntType read() noexcept(false);
+	/**
+	 * Same as read() but doesn't advance the cursor
+	 */
+	template <typename IntType, std::endian Endian = std::endian::big>
+	constexpr IntType peek() const noexcept(false);
+	constexpr void skip(size_type size) noexcept(false);
+	constexpr void retreat(size_type size) noexcept(false);
+	/**
+	 * @return View over the next 'size' bytes of the underlying buffer, no
+	 * copy is made
+	 */
+	constexpr std::span<const value_type>
+	readSpan(size_type size) noexcept(false);
+	/**
+	 * Decode an unsigned LEB128 varint(protobuf style). Throws
+	 * std::out_of_range if the varint is truncated and
+	 * std::runtime_error if it's longer than max_varint_size bytes
+	 */
+	constexpr std::uint64_t readVarint() noexcept(false);
+	/**
+	 * Decode a zig-zag encoded signed varint
+	 */
+	constexpr std::int64_t readSignedVarint() noexcept(false);
+
+      private:
+	constexpr void checkRemaining_(size_type size) const noexcept(false);
+
+	const_pointer_type begin_;
+	const_pointer_type current_;
+	const_pointer_type end_;
+};
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+BLUETH_FORCE_INLINE inline constexpr typename IOBufTraits<T>::size_type
+Cursor<T, U>::getRemaining() const noexcept {
+	return end_ - current_;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+BLUETH_FORCE_INLINE inline constexpr typename IOBufTraits<T>::size_type
+Cursor<T, U>::getConsumed() const noexcept {
+	return current_ - begin_;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+BLUETH_FORCE_INLINE inline constexpr bool
+Cursor<T, U>::canRead(size_type size) const noexcept {
+	return getRemaining() >= size;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+BLUETH_FORCE_INLINE inline constexpr bool
+Cursor<T, U>::isAtEnd() const noexcept {
+	return current_ == end_;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+BLUETH_FORCE_INLINE inline constexpr
+    typename IOBufTraits<T>::const_pointer_type
+    Cursor<T, U>::getCurrentPointer() const noexcept {
+	return current_;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+BLUETH_FORCE_INLINE inline constexpr void
+Cursor<T, U>::checkRemaining_(size_type size) const noexcept(false) {
+	if (!canRead(size)) [[unlikely]]
+		throw std::out_of_range{"Cursor: not enough bytes to read"};
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+template <typename IntType, std::endian Endian>
+BLUETH_FORCE_INLINE inline constexpr IntType
+Cursor<T, U>::read() noexcept(false) {
+	checkRemaining_(sizeof(IntType));
+	IntType returner = loadInteger<IntType, Endian>(current_);
+	current_ += sizeof(IntType);
+	return returner;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+template <typename IntType, std::endian Endian>
+BLUETH_FORCE_INLINE inline constexpr IntType
+Cursor<T, U>::peek() const noexcept(false) {
+	checkRemaining_(sizeof(IntType));
+	return loadInteger<IntType, Endian>(current_);
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+BLUETH_FORCE_INLINE inline constexpr void
+Cursor<T, U>::skip(size_type size) noexcept(false) {
+	checkRemaining_(size);
+	current_ += size;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+BLUETH_FORCE_INLINE inline constexpr void
+Cursor<T, U>::retreat(size_type size) noexcept(false) {
+	if (getConsumed() < size)
+		throw std::out_of_range{"Cursor: retreat past the beginning"};
+	current_ -= size;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+BLUETH_FORCE_INLINE inline constexpr std::span<
+    const typename IOBufTraits<T>::value_type>
+Cursor<T, U>::readSpan(size_type size) noexcept(false) {
+	checkRemaining_(size);
+	std::span<const value_type> returner{current_, size};
+	current_ += size;
+	return returner;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr std::uint64_t Cursor<T, U>::readVarint() noexcept(false) {
+	std::uint64_t returner{};
+	for (size_type i{}; i < max_varint_size; i++) {
+		checkRemaining_(1);
+		std::uint8_t byte = static_cast<std::uint8_t>(*current_++);
+		returner |= static_cast<std::uint64_t>(byte & 0x7F) << (i * 7);
+		if (!(byte & 0x80)) return returner;
+	}
+	throw std::runtime_error{"Cursor: malformed varint"};
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr std::int64_t
+Cursor<T, U>::readSignedVarint() noexcept(false) {
+	std::uint64_t value = readVarint();
+	return static_cast<std::int64_t>(value >> 1) ^
+	       -static_cast<std::int64_t>(value & 1);
+}
+
+/**
+ * Appender writes straight into the spare capacity of a buffer, growing it with
+ * reserve() when needed. BufferType is IOBuffer or InlineIOBuffer.
+ */
+template <typename BufferType> class Appender {
+      public:
+	using value_type = typename BufferType::value_type;
+	using pointer_type = typename BufferType::pointer_type;
+	using size_type = typename BufferType::size_type;
+
+	/**
+	 * @param io_buffer Buffer to append to, must outlive the Appender
+	 * @param min_growth Minimum number of bytes to reserve whenever the
+	 * buffer runs out of space, to amortize small writes
+	 */
+	explicit Appender(BufferType &io_buffer,
+			  size_type min_growth = 256) noexcept
+	    : io_buffer_{io_buffer}, min_growth_{min_growth} {}
+	/**
+	 * Make sure at least 'size' bytes of spare capacity are available
+	 */
+	void ensure(size_type size) noexcept(false);
+	/**
+	 * Pointer to the spare capacity for direct writes(for example read(2)
+	 * or a compressor), followed by append(size) to commit the bytes
+	 */
+	pointer_type getWritableData() const noexcept;
+	size_type getWritableSize() const noexcept;
+	void append(size_type size) noexcept;
+	template <typename IntType, std::endian Endian = std::endian::big>
+	void write(IntType value) noexcept(false);
+	void push(const value_type *data, size_type size) noexcept(false);
+	/**
+	 * Encode 'value' as an unsigned LEB128 varint
+	 */
+	void writeVarint(std::uint64_t value) noexcept(false);
+	void writeSignedVarint(std::int64_t value) noexcept(false);
+
+      private:
+	BufferType &io_buffer_;
+	size_type min_growth_;
+};
+
+template <typename BufferType>
+BLUETH_FORCE_INLINE inline void
+Appender<BufferType>::ensure(size_type size) noexcept(false) {
+	if (io_buffer_.getAvailableSpace() >= size) [[likely]]
+		return;
+	io_buffer_.reserve(io_buffer_.getEndOffset() +
+			   std::max({size, min_growth_,
+				     io_buffer_.getCapacity()}));
+}
+
+template <typename BufferType>
+BLUETH_FORCE_INLINE inline typename BufferType::pointer_type
+Appender<BufferType>::getWritableData() const noexcept {
+	return io_buffer_.getEndOffsetPointer();
+}
+
+template <typename BufferType>
+BLUETH_FORCE_INLINE inline typename BufferType::size_type
+Appender<BufferType>::getWritableSize() const noexcept {
+	return io_buffer_.getAvailableSpace();
+}
+
+template <typename BufferType>
+BLUETH_FORCE_INLINE inline void
+Appender<BufferType>::append(size_type size) noexcept {
+	io_buffer_.modifyEndOffset(size);
+}
+
+template <typename BufferType>
+template <typename IntType, std::endian Endian>
+BLUETH_FORCE_INLINE inline void
+Appender<BufferType>::write(IntType value) noexcept(false) {
+	ensure(sizeof(IntType));
+	storeInteger<IntType, Endian>(getWritableData(), value);
+	append(sizeof(IntType));
+}
+
+template <typename BufferType>
+BLUETH_FORCE_INLINE inline void
+Appender<BufferType>::push(const value_type *data,
+			   size_type size) noexcept(false) {
+	ensure(size);
+	::memcpy(getWritableData(), data, size);
+	append(size);
+}
+
+template <typename BufferType>
+inline void
+Appender<BufferType>::writeVarint(std::uint64_t value) noexcept(false) {
+	ensure(Cursor<value_type>::max_varint_size);
+	pointer_type data = getWritableData();
+	size_type size{};
+	while (value >= 0x80) {
+		data[size++] = static_cast<value_type>((value & 0x7F) | 0x80);
+		value >>= 7;
+	}
+	data[size++] = static_cast<value_type>(value);
+	append(size);
+}
+
+template <typename BufferType>
+inline void
+Appender<BufferType>::writeSignedVarint(std::int64_t value) noexcept(false) {
+	writeVarint((static_cast<std::uint64_t>(value) << 1) ^
+		    static_cast<std::uint64_t>(value >> 63));
+}
+
+} // namespace blueth::io
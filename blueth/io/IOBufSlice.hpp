@@ -0,0 +1,247 @@
+#pragma once
+#include "IOBuffer.hpp"
+#include "common.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+// clang-format off
+/* IOBufSlice is an immutable, reference counted view of [data, data + size) into memory which is kept alive by
+ * an owner. Copying or slicing a IOBufSlice only bumps the reference count of the owner, so a payload can be
+ * queued to the output of many peers at once without a copy per peer.
+ *
+ *     owner(IOBuffer, std::string, mmap region, ...)
+ *    +-----------------------------------------------+
+ *    |        | slice A              |               |
+ *    +--------+----------------------+---------------+
+ *                  | slice B |                            Both A and B keep the owner alive
+ *
+ * The owner can be any memory the slice adopts without copying: an IOBuffer, a std::string, a read-only mmap
+ * of a file or a raw pointer with a custom deleter.
+ */
+// clang-format on
+
+namespace blueth::io {
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> = true>
+class IOBufSlice {
+      public:
+	using value_type = typename IOBufTraits<T>::value_type;
+	using const_pointer_type = typename IOBufTraits<T>::const_pointer_type;
+	using const_iterator = typename IOBufTraits<T>::const_iterator;
+	using size_type = typename IOBufTraits<T>::size_type;
+	using owner_type = std::shared_ptr<const void>;
+
+	IOBufSlice() = default;
+	/**
+	 * @param owner Keeps the memory pointed by data alive
+	 * @param data Start of the slice
+	 * @param size Size of the slice
+	 */
+	IOBufSlice(owner_type owner, const_pointer_type data,
+		   size_type size) noexcept;
+	/**
+	 * Copy the bytes into a new shared allocation(the only factory which
+	 * copies)
+	 */
+	static IOBufSlice copyBuffer(const_pointer_type data,
+				     size_type size) noexcept(false);
+	/**
+	 * Adopt the data region of an IOBuffer, the buffer is freed when the
+	 * last slice is destroyed
+	 */
+	static IOBufSlice
+	takeOwnership(std::unique_ptr<IOBuffer<T>> io_buffer) noexcept(false);
+	/**
+	 * Adopt the bytes of a std::string without copying them
+	 */
+	static IOBufSlice adoptString(std::string &&str) noexcept(false);
+	/**
+	 * Adopt externally allocated memory, deleter(data) is invoked when the
+	 * last slice is destroyed
+	 */
+	template <typename Deleter>
+	static IOBufSlice wrapMemory(const_pointer_type data, size_type size,
+				     Deleter deleter) noexcept(false);
+	/**
+	 * Map a file read-only into memory. Throws std::runtime_error if the
+	 * file can't be opened or mapped.
+	 *
+	 * @param file_path Path of the file to be mapped
+	 */
+	static IOBufSlice mapFile(const char *file_path) noexcept(false);
+	/**
+	 * A sub-slice of [offset, offset + size) which shares the same owner,
+	 * throws std::out_of_range if the range is past the current slice
+	 */
+	IOBufSlice slice(size_type offset, size_type size) const noexcept(false);
+	IOBufSlice slice(size_type offset) const noexcept(false);
+	BLUETH_FORCE_INLINE const_pointer_type data() const noexcept;
+	BLUETH_FORCE_INLINE size_type size() const noexcept;
+	BLUETH_FORCE_INLINE bool empty() const noexcept;
+	BLUETH_FORCE_INLINE const_iterator cbegin() const noexcept;
+	BLUETH_FORCE_INLINE const_iterator cend() const noexcept;
+	BLUETH_FORCE_INLINE std::string_view toStringView() const noexcept;
+	/**
+	 * Number of slices(and IOBufChain segments) sharing the owner
+	 */
+	long useCount() const noexcept;
+	const owner_type &getOwner() const noexcept;
+
+      private:
+	owner_type owner_{};
+	const_pointer_type data_{nullptr};
+	size_type size_{};
+};
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline IOBufSlice<T, U>::IOBufSlice(owner_type owner, const_pointer_type data,
+				    size_type size) noexcept
+    : owner_{std::move(owner)}, data_{data}, size_{size} {}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline IOBufSlice<T, U>
+IOBufSlice<T, U>::copyBuffer(const_pointer_type data,
+			     size_type size) noexcept(false) {
+	std::shared_ptr<value_type[]> memory =
+	    std::make_shared_for_overwrite<value_type[]>(size);
+	if (size) ::memcpy(memory.get(), data, size);
+	const_pointer_type memory_ptr = memory.get();
+	return IOBufSlice{std::move(memory), memory_ptr, size};
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline IOBufSlice<T, U> IOBufSlice<T, U>::takeOwnership(
+    std::unique_ptr<IOBuffer<T>> io_buffer) noexcept(false) {
+	if (!io_buffer) throw std::runtime_error{"invalid IOBuffer"};
+	const_pointer_type data = io_buffer->getStartOffsetPointer();
+	size_type size = io_buffer->getDataSize();
+	return IOBufSlice{std::shared_ptr<IOBuffer<T>>{std::move(io_buffer)},
+			  data, size};
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline IOBufSlice<T, U>
+IOBufSlice<T, U>::adoptString(std::string &&str) noexcept(false) {
+	std::shared_ptr<std::string> holder =
+	    std::make_shared<std::string>(std::move(str));
+	// The data pointer must be taken after the move, short strings live
+	// inside the std::string object
+	const_pointer_type data =
+	    reinterpret_cast<const_pointer_type>(holder->data());
+	size_type size = holder->size();
+	return IOBufSlice{std::move(holder), data, size};
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+template <typename Deleter>
+inline IOBufSlice<T, U>
+IOBufSlice<T, U>::wrapMemory(const_pointer_type data, size_type size,
+			     Deleter deleter) noexcept(false) {
+	return IOBufSlice{owner_type{data, std::move(deleter)}, data, size};
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline IOBufSlice<T, U>
+IOBufSlice<T, U>::mapFile(const char *file_path) noexcept(false) {
+	int fd = ::open(file_path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		std::perror("open");
+		throw std::runtime_error{"cannot open the file to be mapped"};
+	}
+	struct stat file_stat;
+	if (::fstat(fd, &file_stat) < 0) {
+		std::perror("fstat");
+		::close(fd);
+		throw std::runtime_error{"fstat"};
+	}
+	size_type size = file_stat.st_size;
+	if (!size) {
+		::close(fd);
+		return IOBufSlice{};
+	}
+	void *mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	// The mapping holds its own reference to the file
+	::close(fd);
+	if (mapping == MAP_FAILED) {
+		std::perror("mmap");
+		throw std::runtime_error{"mmap"};
+	}
+	return wrapMemory(static_cast<const_pointer_type>(mapping), size,
+			  [size](const value_type *ptr) {
+				  ::munmap((void *)ptr, size);
+			  });
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline IOBufSlice<T, U>
+IOBufSlice<T, U>::slice(size_type offset, size_type size) const
+    noexcept(false) {
+	if (offset > size_ || size > size_ - offset)
+		throw std::out_of_range{"slice range is past the IOBufSlice"};
+	return IOBufSlice{owner_, data_ + offset, size};
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline IOBufSlice<T, U>
+IOBufSlice<T, U>::slice(size_type offset) const noexcept(false) {
+	if (offset > size_)
+		throw std::out_of_range{"slice range is past the IOBufSlice"};
+	return IOBufSlice{owner_, data_ + offset, size_ - offset};
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+BLUETH_FORCE_INLINE inline typename IOBufTraits<T>::const_pointer_type
+IOBufSlice<T, U>::data() const noexcept {
+	return data_;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+BLUETH_FORCE_INLINE inline typename IOBufTraits<T>::size_type
+IOBufSlice<T, U>::size() const noexcept {
+	return size_;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+BLUETH_FORCE_INLINE inline bool IOBufSlice<T, U>::empty() const noexcept {
+	return size_ == 0;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+BLUETH_FORCE_INLINE inline typename IOBufTraits<T>::const_iterator
+IOBufSlice<T, U>::cbegin() const noexcept {
+	return data_;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+BLUETH_FORCE_INLINE inline typename IOBufTraits<T>::const_iterator
+IOBufSlice<T, U>::cend() const noexcept {
+	return data_ + size_;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+BLUETH_FORCE_INLINE inline std::string_view
+IOBufSlice<T, U>::toStringView() const noexcept {
+	return std::string_view{reinterpret_cast<const char *>(data_), size_};
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline long IOBufSlice<T, U>::useCount() const noexcept {
+	return owner_.use_count();
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline const typename IOBufSlice<T, U>::owner_type &
+IOBufSlice<T, U>::getOwner() const noexcept {
+	return owner_;
+}
+
+} // namespace blueth::io
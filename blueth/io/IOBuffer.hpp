@@ -1,8 +1,11 @@
 #pragma once
+#include "IOBufAllocator.hpp"
+#include <algorithm>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <exception>
+#include <functional>
 #include <memory>
 #include <string>
 #include <type_traits>
@@ -63,7 +66,53 @@ template <typename T> struct is_byte_type : std::false_type {};
 template <> struct is_byte_type<char> : std::true_type {};
 template <> struct is_byte_type<std::uint8_t> : std::true_type {};
 
-template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> = true>
+/**
+ * Decides the new capacity of an IOBuffer when an append runs out of space.
+ *
+ * Geometric: Double the capacity(or grow to the required size if that's more)
+ * Exact: Grow to exactly the required size
+ * Capped: Double the capacity, but never grow by more than max_step bytes at
+ * once
+ */
+struct IOBufGrowthPolicy {
+	enum class Kind { Geometric, Exact, Capped };
+	Kind kind{Kind::Geometric};
+	std::size_t max_step{};
+	static constexpr IOBufGrowthPolicy geometric() noexcept {
+		return {Kind::Geometric, 0};
+	}
+	static constexpr IOBufGrowthPolicy exact() noexcept {
+		return {Kind::Exact, 0};
+	}
+	static constexpr IOBufGrowthPolicy
+	capped(std::size_t max_step) noexcept {
+		return {Kind::Capped, max_step};
+	}
+	/**
+	 * @param capacity Current capacity of the buffer
+	 * @param required Minimum capacity needed to satisfy the append
+	 * @return New capacity of the buffer, always >= required
+	 */
+	constexpr std::size_t
+	nextCapacity(std::size_t capacity,
+		     std::size_t required) const noexcept {
+		std::size_t returner = required;
+		switch (kind) {
+		case Kind::Geometric:
+			returner = capacity * 2;
+			break;
+		case Kind::Exact:
+			break;
+		case Kind::Capped:
+			returner = capacity + std::min(capacity, max_step);
+			break;
+		}
+		return std::max(returner, required);
+	}
+};
+
+template <typename T, typename Allocator = IOBufMallocAllocator,
+	  std::enable_if_t<is_byte_type<T>::value, bool> = true>
 class IOBuffer {
       public:
 	using value_type = typename IOBufTraits<T>::value_type;
@@ -76,14 +125,20 @@ class IOBuffer {
 	using const_iterator = typename IOBufTraits<T>::const_iterator;
 	using size_type = typename IOBufTraits<T>::size_type;
 	using difference_type = typename IOBufTraits<T>::difference_type;
+	static constexpr size_type default_compaction_threshold = 1024;
 	/**
 	 * Allocate a new IOBuffer object with requested capacity
 	 *
 	 * @param capacity Initial capacity of the underlying buffer
+	 * @param growth_policy How the buffer grows when an append runs out of
+	 * space
 	 * @return Unique pointer to IOBuffer<T> object
 	 */
-	static std::unique_ptr<IOBuffer<T>> create(size_type capacity);
-	IOBuffer(size_type capacity);
+	static std::unique_ptr<IOBuffer<T, Allocator>>
+	create(size_type capacity, IOBufGrowthPolicy growth_policy =
+				       IOBufGrowthPolicy::geometric());
+	IOBuffer(size_type capacity, IOBufGrowthPolicy growth_policy =
+					 IOBufGrowthPolicy::geometric());
 	~IOBuffer();
 	constexpr IOBuffer(IOBuffer &&io_buffer) noexcept;
 	constexpr IOBuffer &operator=(IOBuffer &&io_buffer) noexcept;
@@ -125,7 +180,8 @@ class IOBuffer {
 	constexpr std::pair<const_pointer_type, const_pointer_type>
 	getOffset(size_type offset_len) const noexcept;
 	/**
-	 * Append raw bytes to end of data offset on the buffer
+	 * Append raw bytes to end of data offset on the buffer, the bytes may
+	 * be a part of this buffer's data
 	 *
 	 * @param bytes Raw data to be appended
 	 * @param size Size of bytes to be appended
@@ -133,12 +189,24 @@ class IOBuffer {
 	constexpr void appendRawBytes(const_pointer_type data,
 				      size_type size) noexcept(false);
 	/**
-	 * Append data bytes form other IOBuffer into current buffer
+	 * Append data bytes form other IOBuffer into current buffer, io_buffer
+	 * may be *this
 	 *
 	 * @param io_buffer Source IOBuffer object
 	 */
 	constexpr void
-	appendRawBytes(const IOBuffer<value_type> &io_buffer) noexcept(false);
+	appendRawBytes(const IOBuffer &io_buffer) noexcept(false);
+	/**
+	 * Make room for 'size' bytes after the end offset(compacting or growing
+	 * the buffer the way an append does), so they can be written in place
+	 * at getEndOffsetPointer() and committed with commitAppend(size)
+	 */
+	constexpr void ensureAvailableSpace(size_type size) noexcept(false);
+	/**
+	 * Move the end offset past 'size' bytes written in place, unlike
+	 * modifyEndOffset it takes any size the buffer can hold
+	 */
+	constexpr void commitAppend(size_type size) noexcept;
 	/**
 	 * Clear the buffer
 	 */
@@ -185,164 +253,231 @@ class IOBuffer {
 	 * Internally implemented as `capacity = 2*capacity;`
 	 */
 	void reserve(size_type mem_size = 0) noexcept(false);
+	/**
+	 * Move the data bytes to the front of the buffer, reclaiming the
+	 * headroom(already consumed bytes before start_offset)
+	 */
+	void compact() noexcept;
+	/**
+	 * Compact the buffer and release the unused memory, the capacity is
+	 * equal to the data size after this call
+	 */
+	void shrinkToFit() noexcept(false);
+	void setGrowthPolicy(IOBufGrowthPolicy growth_policy) noexcept;
+	constexpr IOBufGrowthPolicy getGrowthPolicy() const noexcept;
+	/**
+	 * When an append doesn't fit at the end of the buffer and the headroom
+	 * is at least 'threshold' bytes, we compact the buffer before we try to
+	 * grow it.
+	 *
+	 * @param threshold Headroom size in bytes, 0 disables the compaction
+	 */
+	void setCompactionThreshold(size_type threshold) noexcept;
+	constexpr size_type getCompactionThreshold() const noexcept;
 
       private:
+	/**
+	 * Make sure we have 'size' bytes of free space after end_offset, by
+	 * compacting or growing the buffer
+	 */
+	void makeSpaceForAppend_(size_type size) noexcept(false);
+
 	pointer_type internal_buffer_{nullptr};
 	size_type start_offset_{};
 	size_type end_offset_{};
 	size_type capacity_{};
+	IOBufGrowthPolicy growth_policy_{};
+	size_type compaction_threshold_{default_compaction_threshold};
 };
 
-template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
-inline std::unique_ptr<IOBuffer<T>>
-IOBuffer<T, U>::create(typename IOBufTraits<T>::size_type capacity) {
-	return std::make_unique<IOBuffer<T>>(capacity);
+template <typename T, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline std::unique_ptr<IOBuffer<T, A>>
+IOBuffer<T, A, U>::create(typename IOBufTraits<T>::size_type capacity,
+		       IOBufGrowthPolicy growth_policy) {
+	return std::make_unique<IOBuffer<T, A>>(capacity, growth_policy);
 }
 
-template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
-inline IOBuffer<T, U>::IOBuffer(typename IOBufTraits<T>::size_type capacity) {
+template <typename T, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline IOBuffer<T, A, U>::IOBuffer(typename IOBufTraits<T>::size_type capacity,
+				IOBufGrowthPolicy growth_policy)
+    : growth_policy_{growth_policy} {
 	reserve(capacity);
 }
 
-template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
-inline constexpr IOBuffer<T, U>::IOBuffer(IOBuffer<T, U> &&io_buffer) noexcept {
+template <typename T, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr IOBuffer<T, A, U>::IOBuffer(
+    IOBuffer<T, A, U> &&io_buffer) noexcept {
 	std::swap(internal_buffer_, io_buffer.internal_buffer_);
 	std::swap(start_offset_, io_buffer.start_offset_);
 	std::swap(end_offset_, io_buffer.end_offset_);
+	std::swap(capacity_, io_buffer.capacity_);
+	std::swap(growth_policy_, io_buffer.growth_policy_);
+	std::swap(compaction_threshold_, io_buffer.compaction_threshold_);
 }
 
-template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
-inline constexpr IOBuffer<T, U> &
-IOBuffer<T, U>::operator=(IOBuffer<T, U> &&io_buffer) noexcept {
-	if (!internal_buffer_) {
+template <typename T, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr IOBuffer<T, A, U> &
+IOBuffer<T, A, U>::operator=(IOBuffer<T, A, U> &&io_buffer) noexcept {
+	if (this != &io_buffer) {
 		std::swap(internal_buffer_, io_buffer.internal_buffer_);
 		std::swap(start_offset_, io_buffer.start_offset_);
 		std::swap(end_offset_, io_buffer.end_offset_);
+		std::swap(capacity_, io_buffer.capacity_);
+		std::swap(growth_policy_, io_buffer.growth_policy_);
+		std::swap(compaction_threshold_,
+			  io_buffer.compaction_threshold_);
 	}
+	return *this;
 }
 
-template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
-inline void IOBuffer<T, U>::reserve(
+template <typename T, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline void IOBuffer<T, A, U>::reserve(
     typename IOBufTraits<T>::size_type mem_size) noexcept(false) {
 	if (!mem_size) { mem_size = capacity_ * 2; }
-	typename IOBufTraits<T>::pointer_type tmp_ptr =
-	    (typename IOBufTraits<T>::pointer_type)::realloc(internal_buffer_,
-							     mem_size);
-	if (tmp_ptr == nullptr) { throw std::bad_alloc{}; }
-	internal_buffer_ = tmp_ptr;
+	internal_buffer_ =
+	    (typename IOBufTraits<T>::pointer_type)A::reallocate(
+		internal_buffer_, capacity_, mem_size,
+		std::min(end_offset_, mem_size));
 	capacity_ = mem_size;
 }
 
-template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+template <typename T, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
 inline constexpr typename IOBufTraits<T>::size_type
-IOBuffer<T, U>::getStartOffset() noexcept {
+IOBuffer<T, A, U>::getStartOffset() noexcept {
 	return start_offset_;
 }
 
-template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
-inline constexpr void IOBuffer<T, U>::clear() noexcept {
+template <typename T, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr void IOBuffer<T, A, U>::clear() noexcept {
 	// Next time we do any write operation, we "overwrite" the previous
 	// bytes
 	start_offset_ = 0;
 	end_offset_ = 0;
 }
 
-template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+template <typename T, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
 inline constexpr typename IOBufTraits<T>::size_type
-IOBuffer<T, U>::getEndOffset() const noexcept {
+IOBuffer<T, A, U>::getEndOffset() const noexcept {
 	return end_offset_;
 }
 
-template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+template <typename T, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
 inline constexpr void
-IOBuffer<T, U>::modifyStartOffset(int offset_len) noexcept {
+IOBuffer<T, A, U>::modifyStartOffset(int offset_len) noexcept {
 	start_offset_ += offset_len;
 }
 
-template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
-inline constexpr void IOBuffer<T, U>::setStartOffset(int offset_len) noexcept {
+template <typename T, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr void
+IOBuffer<T, A, U>::setStartOffset(int offset_len) noexcept {
 	start_offset_ = offset_len;
 }
 
-template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+template <typename T, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
 inline constexpr typename IOBufTraits<T>::size_type
-IOBuffer<T, U>::getDataSize() const noexcept {
+IOBuffer<T, A, U>::getDataSize() const noexcept {
 	return end_offset_ - start_offset_;
 }
 
-template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
-inline IOBuffer<T, U>::~IOBuffer<T, U>() {
-	if (internal_buffer_ != nullptr) { ::free(internal_buffer_); }
+template <typename T, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline IOBuffer<T, A, U>::~IOBuffer() {
+	if (internal_buffer_ != nullptr)
+		A::deallocate(internal_buffer_, capacity_);
 }
 
-template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+template <typename T, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
 inline constexpr typename IOBufTraits<T>::size_type
-IOBuffer<T, U>::getCapacity() const noexcept {
+IOBuffer<T, A, U>::getCapacity() const noexcept {
 	return capacity_;
 }
 
-template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+template <typename T, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
 inline constexpr typename IOBufTraits<T>::pointer_type
-IOBuffer<T, U>::getBuffer() noexcept {
+IOBuffer<T, A, U>::getBuffer() noexcept {
 	return internal_buffer_;
 }
 
-template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+template <typename T, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
 inline constexpr typename IOBufTraits<T>::pointer_type
-IOBuffer<T, U>::getStartOffsetPointer() const noexcept {
+IOBuffer<T, A, U>::getStartOffsetPointer() const noexcept {
 	return internal_buffer_ + start_offset_;
 }
 
-template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+template <typename T, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
 inline constexpr typename IOBufTraits<T>::pointer_type
-IOBuffer<T, U>::getEndOffsetPointer() noexcept {
+IOBuffer<T, A, U>::getEndOffsetPointer() noexcept {
 	return internal_buffer_ + end_offset_;
 }
 
-template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+template <typename T, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
 inline constexpr typename IOBufTraits<T>::pointer_type
-IOBuffer<T, U>::getBufferEnd() noexcept {
+IOBuffer<T, A, U>::getBufferEnd() noexcept {
 	return (internal_buffer_ + capacity_ - 1);
 }
 
-template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
-inline constexpr void IOBuffer<T, U>::setEndOffset(int offset_len) noexcept {
+template <typename T, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr void IOBuffer<T, A, U>::setEndOffset(int offset_len) noexcept {
 	end_offset_ = offset_len;
 }
 
-template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
-inline constexpr void IOBuffer<T, U>::modifyEndOffset(int offset_len) noexcept {
+template <typename T, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr void
+IOBuffer<T, A, U>::modifyEndOffset(int offset_len) noexcept {
 	end_offset_ += offset_len;
 }
 
-template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+template <typename T, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
 inline constexpr typename IOBufTraits<T>::iterator
-IOBuffer<T, U>::begin() noexcept {
+IOBuffer<T, A, U>::begin() noexcept {
 	return &internal_buffer_[start_offset_];
 }
 
-template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+template <typename T, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
 inline constexpr typename IOBufTraits<T>::iterator
-IOBuffer<T, U>::end() noexcept {
+IOBuffer<T, A, U>::end() noexcept {
 	return &internal_buffer_[end_offset_];
 }
 
-template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+template <typename T, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
 inline constexpr typename IOBufTraits<T>::const_iterator
-IOBuffer<T, U>::cbegin() const noexcept {
+IOBuffer<T, A, U>::cbegin() const noexcept {
 	return &internal_buffer_[start_offset_];
 }
 
-template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+template <typename T, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
 inline constexpr typename IOBufTraits<T>::const_iterator
-IOBuffer<T, U>::cend() const noexcept {
+IOBuffer<T, A, U>::cend() const noexcept {
 	return &internal_buffer_[end_offset_];
 }
 
-template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+template <typename T, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
 inline constexpr std::pair<typename IOBufTraits<T>::const_pointer_type,
 			   typename IOBufTraits<T>::const_pointer_type>
-IOBuffer<T, U>::getOffset(
+IOBuffer<T, A, U>::getOffset(
     typename IOBufTraits<T>::size_type start_offset,
     typename IOBufTraits<T>::size_type end_offset) const noexcept {
 	if (start_offset <= capacity_ && end_offset <= capacity_) {
@@ -352,10 +487,11 @@ IOBuffer<T, U>::getOffset(
 	return {nullptr, nullptr};
 }
 
-template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+template <typename T, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
 inline constexpr std::pair<typename IOBufTraits<T>::const_pointer_type,
 			   typename IOBufTraits<T>::const_pointer_type>
-IOBuffer<T, U>::getOffset(
+IOBuffer<T, A, U>::getOffset(
     typename IOBufTraits<T>::size_type offset_len) const noexcept {
 	if (offset_len <= capacity_) {
 		return {&internal_buffer_[start_offset_],
@@ -364,38 +500,117 @@ IOBuffer<T, U>::getOffset(
 	return {nullptr, nullptr};
 }
 
-template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+template <typename T, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
 inline constexpr typename IOBufTraits<T>::size_type
-IOBuffer<T, U>::getAvailableSpace() const noexcept {
+IOBuffer<T, A, U>::getAvailableSpace() const noexcept {
 	return capacity_ - (end_offset_);
 }
 
-template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
-inline constexpr void IOBuffer<T, U>::appendRawBytes(
+template <typename T, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr void IOBuffer<T, A, U>::appendRawBytes(
     typename IOBufTraits<T>::const_pointer_type data,
     typename IOBufTraits<T>::size_type size) noexcept(false) {
-	if (getAvailableSpace() >= size) {
-		::memcpy(internal_buffer_ + end_offset_, data, size);
-		end_offset_ += size;
-	} else {
-		reserve(capacity_ + size);
-		appendRawBytes(data, size);
+	if (getAvailableSpace() < size) {
+		// The source may be our own data region(a self-append), which
+		// moves when the buffer is compacted or grown
+		const_pointer_type data_start = getStartOffsetPointer();
+		bool aliased = !std::less<>{}(data, data_start) &&
+			       std::less<>{}(data, getEndOffsetPointer());
+		size_type data_offset = aliased ? data - data_start : 0;
+		makeSpaceForAppend_(size);
+		if (aliased) data = getStartOffsetPointer() + data_offset;
+	}
+	::memcpy(internal_buffer_ + end_offset_, data, size);
+	end_offset_ += size;
+}
+
+template <typename T, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr void IOBuffer<T, A, U>::appendRawBytes(
+    const IOBuffer<T, A, U> &io_buffer) noexcept(false) {
+	appendRawBytes(io_buffer.getStartOffsetPointer(),
+		       io_buffer.getDataSize());
+}
+
+template <typename T, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr void IOBuffer<T, A, U>::ensureAvailableSpace(
+    typename IOBufTraits<T>::size_type size) noexcept(false) {
+	if (getAvailableSpace() < size) makeSpaceForAppend_(size);
+}
+
+template <typename T, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr void IOBuffer<T, A, U>::commitAppend(
+    typename IOBufTraits<T>::size_type size) noexcept {
+	end_offset_ += size;
+}
+
+template <typename T, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline void IOBuffer<T, A, U>::makeSpaceForAppend_(
+    typename IOBufTraits<T>::size_type size) noexcept(false) {
+	if (compaction_threshold_ && start_offset_ >= compaction_threshold_) {
+		compact();
+		if (getAvailableSpace() >= size) return;
 	}
+	reserve(growth_policy_.nextCapacity(capacity_, end_offset_ + size));
 }
 
-template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
-inline constexpr void IOBuffer<T, U>::appendRawBytes(
-    const IOBuffer<typename IOBufTraits<T>::value_type>
-	&io_buffer) noexcept(false) {
-	if (io_buffer.getDataSize() <= getAvailableSpace()) {
-		::memcpy(internal_buffer_ + end_offset_,
-			 io_buffer.getStartOffsetPointer(),
-			 io_buffer.getDataSize());
-		end_offset_ += io_buffer.getDataSize();
-	} else {
-		reserve(io_buffer.getCapacity());
-		appendRawBytes(io_buffer);
+template <typename T, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline void IOBuffer<T, A, U>::compact() noexcept {
+	if (!start_offset_) return;
+	size_type data_size = getDataSize();
+	if (data_size)
+		::memmove(internal_buffer_, internal_buffer_ + start_offset_,
+			  data_size);
+	start_offset_ = 0;
+	end_offset_ = data_size;
+}
+
+template <typename T, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline void IOBuffer<T, A, U>::shrinkToFit() noexcept(false) {
+	compact();
+	if (capacity_ == end_offset_) return;
+	if (!end_offset_) {
+		A::deallocate(internal_buffer_, capacity_);
+		internal_buffer_ = nullptr;
+		capacity_ = 0;
+		return;
 	}
+	reserve(end_offset_);
+}
+
+template <typename T, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline void
+IOBuffer<T, A, U>::setGrowthPolicy(IOBufGrowthPolicy growth_policy) noexcept {
+	growth_policy_ = growth_policy;
+}
+
+template <typename T, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr IOBufGrowthPolicy
+IOBuffer<T, A, U>::getGrowthPolicy() const noexcept {
+	return growth_policy_;
+}
+
+template <typename T, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline void IOBuffer<T, A, U>::setCompactionThreshold(
+    typename IOBufTraits<T>::size_type threshold) noexcept {
+	compaction_threshold_ = threshold;
+}
+
+template <typename T, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr typename IOBufTraits<T>::size_type
+IOBuffer<T, A, U>::getCompactionThreshold() const noexcept {
+	return compaction_threshold_;
 }
 
 } // namespace blueth::io
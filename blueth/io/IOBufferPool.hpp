@@ -0,0 +1,311 @@
+#pragma once
+#include "IOBuffer.hpp"
+#include "common.hpp"
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// clang-format off
+/* IOBufferPool recycles IOBuffer objects instead of going through the
+ * make_unique + realloc/free cycle for every message/connection.
+ *
+ * Buffers are grouped into power-of-two size classes(256 bytes to 4MB). Each
+ * thread keeps a small cache per size class, which is accessed without any
+ * locking. When a thread's cache is full, the buffer is moved to a bounded
+ * global overflow list(protected by a mutex) and if that is full as well, the
+ * buffer is freed.
+ *
+ *    acquire(size)                            release(handle)
+ *         |                                         |
+ *         v                                         v
+ *   [thread cache] --miss--> [global overflow] --miss--> IOBuffer::create()
+ *
+ * Requests larger than the biggest size class are not pooled.
+ */
+// clang-format on
+
+namespace blueth::io {
+
+struct IOBufferPoolStats {
+	std::size_t acquired{};
+	std::size_t pool_hits{};
+	std::size_t pool_misses{};
+	std::size_t released{};
+	// Number of buffers currently handed out to the users of the pool
+	std::size_t outstanding{};
+	// Highest value of 'outstanding' seen so far
+	std::size_t high_water{};
+	// Number of buffers cached in the global overflow lists
+	std::size_t cached_global{};
+	BLUETH_FORCE_INLINE double hitRate() const noexcept {
+		return acquired ? static_cast<double>(pool_hits) / acquired : 0;
+	}
+};
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> = true>
+class IOBufferPool {
+      public:
+	using size_type = typename IOBufTraits<T>::size_type;
+	using buffer_type = std::unique_ptr<IOBuffer<T>>;
+
+	static constexpr size_type min_size_class_shift = 8;  // 256 bytes
+	static constexpr size_type max_size_class_shift = 22; // 4 MB
+	static constexpr size_type num_size_classes =
+	    max_size_class_shift - min_size_class_shift + 1;
+	static constexpr size_type max_thread_cache_per_class = 16;
+	static constexpr size_type max_global_cache_per_class = 64;
+
+	/**
+	 * RAII handle to a pooled IOBuffer, the buffer is returned to the pool
+	 * when the handle goes out of scope.
+	 */
+	class Handle {
+	      public:
+		Handle() = default;
+		Handle(IOBufferPool *pool, buffer_type io_buffer) noexcept
+		    : pool_{pool}, io_buffer_{std::move(io_buffer)} {}
+		Handle(Handle &&handle) noexcept
+		    : pool_{std::exchange(handle.pool_, nullptr)},
+		      io_buffer_{std::move(handle.io_buffer_)} {}
+		Handle &operator=(Handle &&handle) noexcept {
+			if (this != &handle) {
+				reset();
+				pool_ = std::exchange(handle.pool_, nullptr);
+				io_buffer_ = std::move(handle.io_buffer_);
+			}
+			return *this;
+		}
+		Handle(const Handle &) = delete;
+		Handle &operator=(const Handle &) = delete;
+		~Handle() { reset(); }
+		BLUETH_FORCE_INLINE IOBuffer<T> *operator->() const noexcept {
+			return io_buffer_.get();
+		}
+		BLUETH_FORCE_INLINE IOBuffer<T> &operator*() const noexcept {
+			return *io_buffer_;
+		}
+		BLUETH_FORCE_INLINE IOBuffer<T> *get() const noexcept {
+			return io_buffer_.get();
+		}
+		BLUETH_FORCE_INLINE explicit operator bool() const noexcept {
+			return io_buffer_ != nullptr;
+		}
+		/**
+		 * Detach the buffer from the pool, the caller owns the buffer
+		 * and it will never be returned to the pool
+		 */
+		BLUETH_NODISCARD buffer_type release() noexcept {
+			if (pool_) pool_->detach_();
+			pool_ = nullptr;
+			return std::move(io_buffer_);
+		}
+		/**
+		 * Return the buffer to the pool before the handle goes out of
+		 * scope
+		 */
+		void reset() noexcept {
+			if (pool_ && io_buffer_)
+				pool_->release_(std::move(io_buffer_));
+			pool_ = nullptr;
+			io_buffer_ = nullptr;
+		}
+
+	      private:
+		IOBufferPool *pool_{nullptr};
+		buffer_type io_buffer_{nullptr};
+	};
+
+	/**
+	 * Process wide pool for the IOBuffer<T> type
+	 */
+	static IOBufferPool &getInstance();
+	/**
+	 * Get a cleared buffer with at least 'capacity' bytes of capacity
+	 *
+	 * @param capacity Minimum capacity of the buffer
+	 * @return RAII handle to the buffer
+	 */
+	Handle acquire(size_type capacity) noexcept(false);
+	/**
+	 * Snapshot of the pool's statistics
+	 */
+	IOBufferPoolStats getStats() const noexcept;
+	/**
+	 * Free all the buffers in the global overflow lists and the calling
+	 * thread's cache
+	 */
+	void trim() noexcept;
+	/**
+	 * Size class index for the requested capacity, num_size_classes if the
+	 * capacity is larger than the largest size class
+	 */
+	static constexpr size_type sizeClassIndex(size_type capacity) noexcept;
+	static constexpr size_type sizeClassCapacity(size_type index) noexcept;
+
+      private:
+	IOBufferPool() = default;
+	struct ThreadCache {
+		IOBufferPool *pool{nullptr};
+		std::array<std::vector<buffer_type>, num_size_classes> buffers;
+		~ThreadCache();
+	};
+	struct GlobalList {
+		std::mutex mutex;
+		std::vector<buffer_type> buffers;
+	};
+	ThreadCache &threadCache_() noexcept;
+	void release_(buffer_type io_buffer) noexcept;
+	void detach_() noexcept;
+	void pushGlobal_(size_type index, buffer_type io_buffer) noexcept;
+
+	std::array<GlobalList, num_size_classes> global_lists_;
+	std::atomic<std::size_t> acquired_{0};
+	std::atomic<std::size_t> pool_hits_{0};
+	std::atomic<std::size_t> released_{0};
+	std::atomic<std::size_t> outstanding_{0};
+	std::atomic<std::size_t> high_water_{0};
+	std::atomic<std::size_t> cached_global_{0};
+};
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline IOBufferPool<T, U> &IOBufferPool<T, U>::getInstance() {
+	static IOBufferPool<T, U> pool_instance;
+	return pool_instance;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr typename IOBufferPool<T, U>::size_type
+IOBufferPool<T, U>::sizeClassIndex(size_type capacity) noexcept {
+	if (capacity <= (size_type{1} << min_size_class_shift)) return 0;
+	size_type shift = std::bit_width(capacity - 1);
+	if (shift > max_size_class_shift) return num_size_classes;
+	return shift - min_size_class_shift;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr typename IOBufferPool<T, U>::size_type
+IOBufferPool<T, U>::sizeClassCapacity(size_type index) noexcept {
+	return size_type{1} << (index + min_size_class_shift);
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline IOBufferPool<T, U>::ThreadCache::~ThreadCache() {
+	// Hand the cached buffers over to the global lists when the thread
+	// exits, so that other threads can still make use of them
+	if (!pool) return;
+	for (size_type index{}; index < num_size_classes; index++)
+		for (buffer_type &io_buffer : buffers[index])
+			pool->pushGlobal_(index, std::move(io_buffer));
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline typename IOBufferPool<T, U>::ThreadCache &
+IOBufferPool<T, U>::threadCache_() noexcept {
+	static thread_local ThreadCache thread_cache;
+	thread_cache.pool = this;
+	return thread_cache;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline typename IOBufferPool<T, U>::Handle
+IOBufferPool<T, U>::acquire(size_type capacity) noexcept(false) {
+	acquired_.fetch_add(1, std::memory_order_relaxed);
+	std::size_t outstanding =
+	    outstanding_.fetch_add(1, std::memory_order_relaxed) + 1;
+	std::size_t high_water = high_water_.load(std::memory_order_relaxed);
+	while (outstanding > high_water &&
+	       !high_water_.compare_exchange_weak(high_water, outstanding,
+						  std::memory_order_relaxed))
+		;
+	size_type index = sizeClassIndex(capacity);
+	if (index == num_size_classes)
+		return Handle{this, IOBuffer<T>::create(capacity)};
+	std::vector<buffer_type> &local_list = threadCache_().buffers[index];
+	if (!local_list.empty()) {
+		buffer_type io_buffer = std::move(local_list.back());
+		local_list.pop_back();
+		pool_hits_.fetch_add(1, std::memory_order_relaxed);
+		return Handle{this, std::move(io_buffer)};
+	}
+	GlobalList &global_list = global_lists_[index];
+	{
+		std::lock_guard<std::mutex> lock{global_list.mutex};
+		if (!global_list.buffers.empty()) {
+			buffer_type io_buffer =
+			    std::move(global_list.buffers.back());
+			global_list.buffers.pop_back();
+			cached_global_.fetch_sub(1, std::memory_order_relaxed);
+			pool_hits_.fetch_add(1, std::memory_order_relaxed);
+			return Handle{this, std::move(io_buffer)};
+		}
+	}
+	return Handle{this, IOBuffer<T>::create(sizeClassCapacity(index))};
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline void IOBufferPool<T, U>::release_(buffer_type io_buffer) noexcept {
+	released_.fetch_add(1, std::memory_order_relaxed);
+	outstanding_.fetch_sub(1, std::memory_order_relaxed);
+	// A user may have grown the buffer, so we put it back in the largest
+	// size class which it can satisfy
+	size_type capacity = io_buffer->getCapacity();
+	if (capacity < sizeClassCapacity(0)) return;
+	size_type index = std::bit_width(capacity) - 1 - min_size_class_shift;
+	if (index >= num_size_classes) return;
+	io_buffer->clear();
+	std::vector<buffer_type> &local_list = threadCache_().buffers[index];
+	if (local_list.size() < max_thread_cache_per_class) {
+		local_list.push_back(std::move(io_buffer));
+		return;
+	}
+	pushGlobal_(index, std::move(io_buffer));
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline void IOBufferPool<T, U>::detach_() noexcept {
+	released_.fetch_add(1, std::memory_order_relaxed);
+	outstanding_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline void IOBufferPool<T, U>::pushGlobal_(size_type index,
+					    buffer_type io_buffer) noexcept {
+	GlobalList &global_list = global_lists_[index];
+	std::lock_guard<std::mutex> lock{global_list.mutex};
+	// The global list is full, io_buffer is freed when we return
+	if (global_list.buffers.size() >= max_global_cache_per_class) return;
+	global_list.buffers.push_back(std::move(io_buffer));
+	cached_global_.fetch_add(1, std::memory_order_relaxed);
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline IOBufferPoolStats IOBufferPool<T, U>::getStats() const noexcept {
+	IOBufferPoolStats stats;
+	stats.acquired = acquired_.load(std::memory_order_relaxed);
+	stats.pool_hits = pool_hits_.load(std::memory_order_relaxed);
+	stats.pool_misses = stats.acquired - stats.pool_hits;
+	stats.released = released_.load(std::memory_order_relaxed);
+	stats.outstanding = outstanding_.load(std::memory_order_relaxed);
+	stats.high_water = high_water_.load(std::memory_order_relaxed);
+	stats.cached_global = cached_global_.load(std::memory_order_relaxed);
+	return stats;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline void IOBufferPool<T, U>::trim() noexcept {
+	for (std::vector<buffer_type> &local_list : threadCache_().buffers)
+		local_list.clear();
+	for (GlobalList &global_list : global_lists_) {
+		std::lock_guard<std::mutex> lock{global_list.mutex};
+		cached_global_.fetch_sub(global_list.buffers.size(),
+					 std::memory_order_relaxed);
+		global_list.buffers.clear();
+	}
+}
+
+} // namespace blueth::io
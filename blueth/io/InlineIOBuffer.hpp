@@ -0,0 +1,376 @@
+#pragma once
+#include "IOBuffer.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <utility>
+
+// clang-format off
+/* InlineIOBuffer is an IOBuffer with 'InlineCapacity' bytes of storage inside
+ * the object itself. The bytes only spill over to the heap once the data
+ * outgrows the inline storage, so a small body embedded in a message costs no
+ * extra allocation and lives on the same cache lines as the message.
+ *
+ *    +----------------------------------+
+ *    | internal_buffer_ ---+            |        internal_buffer_ points either
+ *    | offsets, capacity   |            |        to inline_storage_ or to the
+ *    | inline_storage_[N] <+            |        heap memory after a spill
+ *    +----------------------------------+
+ *
+ * It supports the same offset API as io::IOBuffer, the heap memory comes from
+ * the Allocator policy(see IOBufAllocator.hpp).
+ */
+// clang-format on
+
+namespace blueth::io {
+
+template <typename T, std::size_t InlineCapacity,
+	  typename Allocator = IOBufMallocAllocator,
+	  std::enable_if_t<is_byte_type<T>::value, bool> = true>
+class InlineIOBuffer {
+      public:
+	using value_type = typename IOBufTraits<T>::value_type;
+	using pointer_type = typename IOBufTraits<T>::pointer_type;
+	using const_pointer_type = typename IOBufTraits<T>::const_pointer_type;
+	using iterator = typename IOBufTraits<T>::iterator;
+	using const_iterator = typename IOBufTraits<T>::const_iterator;
+	using size_type = typename IOBufTraits<T>::size_type;
+	static constexpr size_type inline_capacity = InlineCapacity;
+
+	static std::unique_ptr<InlineIOBuffer> create();
+	InlineIOBuffer() noexcept;
+	/**
+	 * @param capacity Initial capacity, the memory is allocated on the heap
+	 * right away if it's larger than InlineCapacity
+	 */
+	explicit InlineIOBuffer(size_type capacity) noexcept(false);
+	~InlineIOBuffer();
+	InlineIOBuffer(InlineIOBuffer &&io_buffer) noexcept;
+	InlineIOBuffer &operator=(InlineIOBuffer &&io_buffer) noexcept;
+	InlineIOBuffer(const InlineIOBuffer &) = delete;
+	InlineIOBuffer &operator=(const InlineIOBuffer &) = delete;
+	constexpr void setStartOffset(int offset_len) noexcept;
+	constexpr void modifyStartOffset(int offset_len) noexcept;
+	constexpr size_type getStartOffset() const noexcept;
+	constexpr void setEndOffset(int offset_len) noexcept;
+	constexpr void modifyEndOffset(int offset_len) noexcept;
+	constexpr size_type getEndOffset() const noexcept;
+	/**
+	 * Append raw bytes to end of data offset, spilling to the heap if the
+	 * inline storage is outgrown
+	 *
+	 * @param data Raw data to be appended
+	 * @param size Size of bytes to be appended
+	 */
+	void appendRawBytes(const_pointer_type data,
+			    size_type size) noexcept(false);
+	constexpr void clear() noexcept;
+	constexpr pointer_type getBuffer() const noexcept;
+	constexpr pointer_type getStartOffsetPointer() const noexcept;
+	constexpr pointer_type getEndOffsetPointer() const noexcept;
+	constexpr size_type getCapacity() const noexcept;
+	constexpr size_type getAvailableSpace() const noexcept;
+	constexpr size_type getDataSize() const noexcept;
+	constexpr iterator begin() noexcept;
+	constexpr iterator end() noexcept;
+	constexpr const_iterator cbegin() const noexcept;
+	constexpr const_iterator cend() const noexcept;
+	/**
+	 * True when the bytes are still stored inside the object
+	 */
+	constexpr bool isInline() const noexcept;
+	/**
+	 * Make sure the capacity is at least mem_size bytes, never shrinks
+	 */
+	void reserve(size_type mem_size) noexcept(false);
+	void compact() noexcept;
+	/**
+	 * Compact the data and move it back to the inline storage if it fits,
+	 * otherwise shrink the heap memory to the data size
+	 */
+	void shrinkToFit() noexcept(false);
+	void setGrowthPolicy(IOBufGrowthPolicy growth_policy) noexcept;
+
+      private:
+	void moveFrom_(InlineIOBuffer &io_buffer) noexcept;
+
+	pointer_type internal_buffer_{inline_storage_};
+	size_type start_offset_{};
+	size_type end_offset_{};
+	size_type capacity_{InlineCapacity};
+	IOBufGrowthPolicy growth_policy_{};
+	alignas(16) value_type inline_storage_[InlineCapacity];
+};
+
+template <typename T, std::size_t N, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline std::unique_ptr<InlineIOBuffer<T, N, A, U>>
+InlineIOBuffer<T, N, A, U>::create() {
+	return std::make_unique<InlineIOBuffer<T, N, A, U>>();
+}
+
+template <typename T, std::size_t N, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline InlineIOBuffer<T, N, A, U>::InlineIOBuffer() noexcept {}
+
+template <typename T, std::size_t N, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline InlineIOBuffer<T, N, A, U>::InlineIOBuffer(size_type capacity) noexcept(
+    false) {
+	reserve(capacity);
+}
+
+template <typename T, std::size_t N, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline InlineIOBuffer<T, N, A, U>::~InlineIOBuffer() {
+	if (!isInline()) A::deallocate(internal_buffer_, capacity_);
+}
+
+template <typename T, std::size_t N, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline void
+InlineIOBuffer<T, N, A, U>::moveFrom_(InlineIOBuffer &io_buffer) noexcept {
+	if (io_buffer.isInline()) {
+		// Inline bytes can't be stolen, only the data region is copied
+		internal_buffer_ = inline_storage_;
+		capacity_ = N;
+		::memcpy(inline_storage_,
+			 io_buffer.inline_storage_ + io_buffer.start_offset_,
+			 io_buffer.getDataSize());
+		end_offset_ = io_buffer.getDataSize();
+		start_offset_ = 0;
+	} else {
+		internal_buffer_ = io_buffer.internal_buffer_;
+		capacity_ = io_buffer.capacity_;
+		start_offset_ = io_buffer.start_offset_;
+		end_offset_ = io_buffer.end_offset_;
+	}
+	growth_policy_ = io_buffer.growth_policy_;
+	io_buffer.internal_buffer_ = io_buffer.inline_storage_;
+	io_buffer.capacity_ = N;
+	io_buffer.start_offset_ = 0;
+	io_buffer.end_offset_ = 0;
+}
+
+template <typename T, std::size_t N, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline InlineIOBuffer<T, N, A, U>::InlineIOBuffer(
+    InlineIOBuffer &&io_buffer) noexcept {
+	moveFrom_(io_buffer);
+}
+
+template <typename T, std::size_t N, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline InlineIOBuffer<T, N, A, U> &
+InlineIOBuffer<T, N, A, U>::operator=(InlineIOBuffer &&io_buffer) noexcept {
+	if (this != &io_buffer) {
+		if (!isInline()) A::deallocate(internal_buffer_, capacity_);
+		moveFrom_(io_buffer);
+	}
+	return *this;
+}
+
+template <typename T, std::size_t N, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr void
+InlineIOBuffer<T, N, A, U>::setStartOffset(int offset_len) noexcept {
+	start_offset_ = offset_len;
+}
+
+template <typename T, std::size_t N, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr void
+InlineIOBuffer<T, N, A, U>::modifyStartOffset(int offset_len) noexcept {
+	start_offset_ += offset_len;
+}
+
+template <typename T, std::size_t N, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr typename IOBufTraits<T>::size_type
+InlineIOBuffer<T, N, A, U>::getStartOffset() const noexcept {
+	return start_offset_;
+}
+
+template <typename T, std::size_t N, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr void
+InlineIOBuffer<T, N, A, U>::setEndOffset(int offset_len) noexcept {
+	end_offset_ = offset_len;
+}
+
+template <typename T, std::size_t N, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr void
+InlineIOBuffer<T, N, A, U>::modifyEndOffset(int offset_len) noexcept {
+	end_offset_ += offset_len;
+}
+
+template <typename T, std::size_t N, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr typename IOBufTraits<T>::size_type
+InlineIOBuffer<T, N, A, U>::getEndOffset() const noexcept {
+	return end_offset_;
+}
+
+template <typename T, std::size_t N, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline void
+InlineIOBuffer<T, N, A, U>::appendRawBytes(const_pointer_type data,
+					size_type size) noexcept(false) {
+	if (getAvailableSpace() < size) {
+		// Same as IOBuffer, a source in our data region moves with it
+		const_pointer_type data_start = getStartOffsetPointer();
+		bool aliased = !std::less<>{}(data, data_start) &&
+			       std::less<>{}(data, getEndOffsetPointer());
+		size_type data_offset = aliased ? data - data_start : 0;
+		if (start_offset_) compact();
+		if (getAvailableSpace() < size)
+			reserve(growth_policy_.nextCapacity(
+			    capacity_, end_offset_ + size));
+		if (aliased) data = getStartOffsetPointer() + data_offset;
+	}
+	::memcpy(internal_buffer_ + end_offset_, data, size);
+	end_offset_ += size;
+}
+
+template <typename T, std::size_t N, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr void InlineIOBuffer<T, N, A, U>::clear() noexcept {
+	start_offset_ = 0;
+	end_offset_ = 0;
+}
+
+template <typename T, std::size_t N, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr typename IOBufTraits<T>::pointer_type
+InlineIOBuffer<T, N, A, U>::getBuffer() const noexcept {
+	return internal_buffer_;
+}
+
+template <typename T, std::size_t N, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr typename IOBufTraits<T>::pointer_type
+InlineIOBuffer<T, N, A, U>::getStartOffsetPointer() const noexcept {
+	return internal_buffer_ + start_offset_;
+}
+
+template <typename T, std::size_t N, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr typename IOBufTraits<T>::pointer_type
+InlineIOBuffer<T, N, A, U>::getEndOffsetPointer() const noexcept {
+	return internal_buffer_ + end_offset_;
+}
+
+template <typename T, std::size_t N, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr typename IOBufTraits<T>::size_type
+InlineIOBuffer<T, N, A, U>::getCapacity() const noexcept {
+	return capacity_;
+}
+
+template <typename T, std::size_t N, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr typename IOBufTraits<T>::size_type
+InlineIOBuffer<T, N, A, U>::getAvailableSpace() const noexcept {
+	return capacity_ - end_offset_;
+}
+
+template <typename T, std::size_t N, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr typename IOBufTraits<T>::size_type
+InlineIOBuffer<T, N, A, U>::getDataSize() const noexcept {
+	return end_offset_ - start_offset_;
+}
+
+template <typename T, std::size_t N, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr typename IOBufTraits<T>::iterator
+InlineIOBuffer<T, N, A, U>::begin() noexcept {
+	return internal_buffer_ + start_offset_;
+}
+
+template <typename T, std::size_t N, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr typename IOBufTraits<T>::iterator
+InlineIOBuffer<T, N, A, U>::end() noexcept {
+	return internal_buffer_ + end_offset_;
+}
+
+template <typename T, std::size_t N, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr typename IOBufTraits<T>::const_iterator
+InlineIOBuffer<T, N, A, U>::cbegin() const noexcept {
+	return internal_buffer_ + start_offset_;
+}
+
+template <typename T, std::size_t N, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr typename IOBufTraits<T>::const_iterator
+InlineIOBuffer<T, N, A, U>::cend() const noexcept {
+	return internal_buffer_ + end_offset_;
+}
+
+template <typename T, std::size_t N, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr bool InlineIOBuffer<T, N, A, U>::isInline() const noexcept {
+	return internal_buffer_ == inline_storage_;
+}
+
+template <typename T, std::size_t N, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline void
+InlineIOBuffer<T, N, A, U>::reserve(size_type mem_size) noexcept(false) {
+	if (mem_size <= capacity_) return;
+	if (isInline()) {
+		// Spill the inline bytes over to the heap
+		pointer_type tmp_ptr =
+		    (pointer_type)A::reallocate(nullptr, 0, mem_size, 0);
+		::memcpy(tmp_ptr, inline_storage_, end_offset_);
+		internal_buffer_ = tmp_ptr;
+	} else {
+		internal_buffer_ = (pointer_type)A::reallocate(
+		    internal_buffer_, capacity_, mem_size, end_offset_);
+	}
+	capacity_ = mem_size;
+}
+
+template <typename T, std::size_t N, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline void InlineIOBuffer<T, N, A, U>::compact() noexcept {
+	if (!start_offset_) return;
+	size_type data_size = getDataSize();
+	if (data_size)
+		::memmove(internal_buffer_, internal_buffer_ + start_offset_,
+			  data_size);
+	start_offset_ = 0;
+	end_offset_ = data_size;
+}
+
+template <typename T, std::size_t N, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline void InlineIOBuffer<T, N, A, U>::shrinkToFit() noexcept(false) {
+	compact();
+	if (isInline()) return;
+	if (end_offset_ <= N) {
+		::memcpy(inline_storage_, internal_buffer_, end_offset_);
+		A::deallocate(internal_buffer_, capacity_);
+		internal_buffer_ = inline_storage_;
+		capacity_ = N;
+		return;
+	}
+	internal_buffer_ = (pointer_type)A::reallocate(
+	    internal_buffer_, capacity_, end_offset_, end_offset_);
+	capacity_ = end_offset_;
+}
+
+template <typename T, std::size_t N, typename A,
+	  std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline void InlineIOBuffer<T, N, A, U>::setGrowthPolicy(
+    IOBufGrowthPolicy growth_policy) noexcept {
+	growth_policy_ = growth_policy;
+}
+
+} // namespace blueth::io
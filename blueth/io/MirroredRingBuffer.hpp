@@ -0,0 +1,318 @@
+#pragma once
+#include "IOBuffer.hpp"
+#include "common.hpp"
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <utility>
+
+// clang-format off
+/* MirroredRingBuffer is a fixed capacity ring buffer of bytes whose memory is
+ * mapped twice, back to back, in the virtual address space. Both the mappings
+ * are backed by the same memfd pages, so a byte written at buffer[i] is also
+ * visible at buffer[i + capacity].
+ *
+ *           start_offset          end_offset
+ *                |                    |
+ *                v                    v
+ *    +-----------+----------+  +------+----------------+
+ *    |           |   Data   |  | Data |                |
+ *    +-----------+----------+  +------+----------------+
+ *    ^        mapping 1     ^  ^        mapping 2       ^
+ *    buffer_start   (same physical pages)          buffer_start + 2*capacity
+ *
+ * Since the data region never wraps around from the reader's(or writer's) point
+ * of view, the unread bytes are always a contiguous span [start, end) and the
+ * free space is always a contiguous span [end, start + capacity). Parsers which
+ * work on (begin, end) pointers(ParseHTTP1_1RequestMessage,
+ * codec::LineBasedFrameDecoder) work unchanged, and we never memmove the data to
+ * the front of the buffer.
+ *
+ * The start_offset is always kept within [0, capacity) and end_offset within
+ * [start_offset, start_offset + capacity]. Capacity is rounded up to a multiple
+ * of the page size.
+ */
+// clang-format on
+
+namespace blueth::io {
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> = true>
+class MirroredRingBuffer {
+      public:
+	using value_type = typename IOBufTraits<T>::value_type;
+	using pointer_type = typename IOBufTraits<T>::pointer_type;
+	using const_pointer_type = typename IOBufTraits<T>::const_pointer_type;
+	using iterator = typename IOBufTraits<T>::iterator;
+	using const_iterator = typename IOBufTraits<T>::const_iterator;
+	using size_type = typename IOBufTraits<T>::size_type;
+
+	/**
+	 * Allocate a new MirroredRingBuffer, if the memfd or the mappings
+	 * can't be created an exception of type std::runtime_error is thrown
+	 *
+	 * @param capacity Minimum capacity of the ring, rounded up to the page
+	 * size
+	 * @return Unique pointer to the MirroredRingBuffer<T> object
+	 */
+	static std::unique_ptr<MirroredRingBuffer<T>>
+	create(size_type capacity) noexcept(false);
+	MirroredRingBuffer(size_type capacity) noexcept(false);
+	~MirroredRingBuffer();
+	MirroredRingBuffer(MirroredRingBuffer &&ring_buffer) noexcept;
+	MirroredRingBuffer &operator=(MirroredRingBuffer &&ring_buffer) noexcept;
+	MirroredRingBuffer(const MirroredRingBuffer &) = delete;
+	MirroredRingBuffer &operator=(const MirroredRingBuffer &) = delete;
+	/**
+	 * Consume(offset_len > 0) bytes from the start of the data region
+	 */
+	constexpr void modifyStartOffset(int offset_len) noexcept;
+	constexpr void setStartOffset(int offset_len) noexcept;
+	constexpr size_type getStartOffset() const noexcept;
+	/**
+	 * Commit(offset_len > 0) bytes which were written directly into
+	 * getEndOffsetPointer(), for example by recv()
+	 */
+	constexpr void modifyEndOffset(int offset_len) noexcept;
+	constexpr void setEndOffset(int offset_len) noexcept;
+	constexpr size_type getEndOffset() const noexcept;
+	/**
+	 * Copy raw bytes into the free space of the ring. Since the ring never
+	 * grows, an exception of type std::runtime_error is thrown if the
+	 * bytes don't fit.
+	 *
+	 * @param data Raw data to be appended
+	 * @param size Size of bytes to be appended
+	 */
+	void appendRawBytes(const_pointer_type data,
+			    size_type size) noexcept(false);
+	constexpr void clear() noexcept;
+	constexpr pointer_type getBuffer() const noexcept;
+	constexpr pointer_type getStartOffsetPointer() const noexcept;
+	constexpr pointer_type getEndOffsetPointer() const noexcept;
+	constexpr size_type getCapacity() const noexcept;
+	constexpr size_type getAvailableSpace() const noexcept;
+	constexpr size_type getDataSize() const noexcept;
+	constexpr iterator begin() noexcept;
+	constexpr iterator end() noexcept;
+	constexpr const_iterator cbegin() const noexcept;
+	constexpr const_iterator cend() const noexcept;
+
+      private:
+	constexpr void normalizeOffsets_() noexcept;
+	void release_() noexcept;
+
+	pointer_type internal_buffer_{nullptr};
+	size_type start_offset_{};
+	size_type end_offset_{};
+	size_type capacity_{};
+	int memfd_{-1};
+};
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline std::unique_ptr<MirroredRingBuffer<T>>
+MirroredRingBuffer<T, U>::create(size_type capacity) noexcept(false) {
+	return std::make_unique<MirroredRingBuffer<T>>(capacity);
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline MirroredRingBuffer<T, U>::MirroredRingBuffer(size_type capacity) noexcept(
+    false) {
+	size_type page_size = ::sysconf(_SC_PAGESIZE);
+	if (!capacity) capacity = page_size;
+	capacity_ = ((capacity + page_size - 1) / page_size) * page_size;
+	memfd_ = ::memfd_create("blueth-ring-buffer", MFD_CLOEXEC);
+	if (memfd_ < 0) {
+		std::perror("memfd_create");
+		throw std::runtime_error{"memfd_create"};
+	}
+	if (::ftruncate(memfd_, capacity_) < 0) {
+		std::perror("ftruncate");
+		release_();
+		throw std::runtime_error{"ftruncate"};
+	}
+	// Reserve 2*capacity of contiguous address space first, then place
+	// the two views of the memfd on top of the reservation
+	void *reserved = ::mmap(nullptr, 2 * capacity_, PROT_NONE,
+				MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (reserved == MAP_FAILED) {
+		std::perror("mmap");
+		release_();
+		throw std::runtime_error{"mmap"};
+	}
+	internal_buffer_ = static_cast<pointer_type>(reserved);
+	for (size_type mirror{}; mirror < 2; mirror++) {
+		void *view = ::mmap(internal_buffer_ + (mirror * capacity_),
+				    capacity_, PROT_READ | PROT_WRITE,
+				    MAP_SHARED | MAP_FIXED, memfd_, 0);
+		if (view == MAP_FAILED) {
+			std::perror("mmap");
+			release_();
+			throw std::runtime_error{"mmap"};
+		}
+	}
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline void MirroredRingBuffer<T, U>::release_() noexcept {
+	if (internal_buffer_) ::munmap(internal_buffer_, 2 * capacity_);
+	if (memfd_ >= 0) ::close(memfd_);
+	internal_buffer_ = nullptr;
+	memfd_ = -1;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline MirroredRingBuffer<T, U>::~MirroredRingBuffer() {
+	release_();
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline MirroredRingBuffer<T, U>::MirroredRingBuffer(
+    MirroredRingBuffer &&ring_buffer) noexcept {
+	std::swap(internal_buffer_, ring_buffer.internal_buffer_);
+	std::swap(start_offset_, ring_buffer.start_offset_);
+	std::swap(end_offset_, ring_buffer.end_offset_);
+	std::swap(capacity_, ring_buffer.capacity_);
+	std::swap(memfd_, ring_buffer.memfd_);
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline MirroredRingBuffer<T, U> &
+MirroredRingBuffer<T, U>::operator=(MirroredRingBuffer &&ring_buffer) noexcept {
+	if (this != &ring_buffer) {
+		std::swap(internal_buffer_, ring_buffer.internal_buffer_);
+		std::swap(start_offset_, ring_buffer.start_offset_);
+		std::swap(end_offset_, ring_buffer.end_offset_);
+		std::swap(capacity_, ring_buffer.capacity_);
+		std::swap(memfd_, ring_buffer.memfd_);
+	}
+	return *this;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr void MirroredRingBuffer<T, U>::normalizeOffsets_() noexcept {
+	// Once the reader moves into the second mapping, we move both the
+	// offsets back by one capacity, they point to the same bytes
+	if (start_offset_ >= capacity_) {
+		start_offset_ -= capacity_;
+		end_offset_ -= capacity_;
+	}
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr void
+MirroredRingBuffer<T, U>::modifyStartOffset(int offset_len) noexcept {
+	start_offset_ += offset_len;
+	normalizeOffsets_();
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr void
+MirroredRingBuffer<T, U>::setStartOffset(int offset_len) noexcept {
+	start_offset_ = offset_len;
+	normalizeOffsets_();
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr typename IOBufTraits<T>::size_type
+MirroredRingBuffer<T, U>::getStartOffset() const noexcept {
+	return start_offset_;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr void
+MirroredRingBuffer<T, U>::modifyEndOffset(int offset_len) noexcept {
+	end_offset_ += offset_len;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr void
+MirroredRingBuffer<T, U>::setEndOffset(int offset_len) noexcept {
+	end_offset_ = offset_len;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr typename IOBufTraits<T>::size_type
+MirroredRingBuffer<T, U>::getEndOffset() const noexcept {
+	return end_offset_;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline void
+MirroredRingBuffer<T, U>::appendRawBytes(const_pointer_type data,
+					 size_type size) noexcept(false) {
+	if (size > getAvailableSpace())
+		throw std::runtime_error{"not enough space in the ring buffer"};
+	::memcpy(internal_buffer_ + end_offset_, data, size);
+	end_offset_ += size;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr void MirroredRingBuffer<T, U>::clear() noexcept {
+	start_offset_ = 0;
+	end_offset_ = 0;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr typename IOBufTraits<T>::pointer_type
+MirroredRingBuffer<T, U>::getBuffer() const noexcept {
+	return internal_buffer_;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr typename IOBufTraits<T>::pointer_type
+MirroredRingBuffer<T, U>::getStartOffsetPointer() const noexcept {
+	return internal_buffer_ + start_offset_;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr typename IOBufTraits<T>::pointer_type
+MirroredRingBuffer<T, U>::getEndOffsetPointer() const noexcept {
+	return internal_buffer_ + end_offset_;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr typename IOBufTraits<T>::size_type
+MirroredRingBuffer<T, U>::getCapacity() const noexcept {
+	return capacity_;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr typename IOBufTraits<T>::size_type
+MirroredRingBuffer<T, U>::getAvailableSpace() const noexcept {
+	return capacity_ - getDataSize();
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr typename IOBufTraits<T>::size_type
+MirroredRingBuffer<T, U>::getDataSize() const noexcept {
+	return end_offset_ - start_offset_;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr typename IOBufTraits<T>::iterator
+MirroredRingBuffer<T, U>::begin() noexcept {
+	return internal_buffer_ + start_offset_;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr typename IOBufTraits<T>::iterator
+MirroredRingBuffer<T, U>::end() noexcept {
+	return internal_buffer_ + end_offset_;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr typename IOBufTraits<T>::const_iterator
+MirroredRingBuffer<T, U>::cbegin() const noexcept {
+	return internal_buffer_ + start_offset_;
+}
+
+template <typename T, std::enable_if_t<is_byte_type<T>::value, bool> U>
+inline constexpr typename IOBufTraits<T>::const_iterator
+MirroredRingBuffer<T, U>::cend() const noexcept {
+	return internal_buffer_ + end_offset_;
+}
+
+} // namespace blueth::io
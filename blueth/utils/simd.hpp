@@ -1,5 +1,7 @@
 #pragma once
 #include "common.hpp"
+#include <cstddef>
+#include <cstdint>
 #include <ctime>
 #include <emmintrin.h>
 #include <immintrin.h>
@@ -69,6 +71,7 @@ class char_vector_128 {
 	BLUETH_FORCE_INLINE __m128i m128i() const noexcept { return data_; }
 };
 
+#ifdef __AVX2__
 class bool_vector_256 {
       private:
 	__m256i data_;
@@ -138,9 +141,11 @@ static char *find_char_256_avx2(char *buffer_start, char *buffer_end,
 		if (*buffer_start == find_char) return buffer_start;
 	return buffer_end;
 }
+#endif
 
 static char *find_char_128_sse4_2(char *buffer_start, char *buffer_end,
 				  char find_char) {
+#if defined(__SSSE3__)
 	char_vector_128 find_char_vector{_mm_set1_epi8(find_char)};
 	for (; buffer_start + 16 < buffer_end; buffer_start += 16) {
 		char_vector_128 buffer_pack{
@@ -153,9 +158,296 @@ static char *find_char_128_sse4_2(char *buffer_start, char *buffer_end,
 			return buffer_start +
 			       buffer_eq_find_char.get_first_true_in_mask();
 	}
+#endif
 	for (; buffer_start < buffer_end; ++buffer_start)
 		if (*buffer_start == find_char) return buffer_start;
 	return buffer_end;
 }
 
+/**
+ * A set of ASCII(0-127) bytes, used for finding the first byte which is not a
+ * member of the set 16/32 bytes at a time. The set is stored as two 16 entry
+ * tables indexed by the low and the high nibble of a byte, a byte is a member
+ * if (lo_nibble_bits[byte & 0xF] & hi_nibble_bits[byte >> 4]) != 0, which is
+ * two pshufb lookups per vector. Bytes >= 0x80 are never members.
+ */
+struct char_class_set {
+	alignas(16) std::uint8_t lo_nibble_bits[16]{};
+	alignas(16) std::uint8_t hi_nibble_bits[16]{};
+	bool contains[256]{};
+
+	/**
+	 * @param predicate constexpr callable, predicate(char) returns true
+	 * for the members of the set
+	 */
+	template <typename Predicate>
+	static constexpr char_class_set make(Predicate predicate) noexcept {
+		char_class_set returner{};
+		for (int hi_nibble{}; hi_nibble < 8; hi_nibble++)
+			returner.hi_nibble_bits[hi_nibble] = 1 << hi_nibble;
+		for (int value{}; value < 128; value++) {
+			if (!predicate(static_cast<char>(value))) continue;
+			returner.lo_nibble_bits[value & 0x0F] |=
+			    1 << (value >> 4);
+			returner.contains[value] = true;
+		}
+		return returner;
+	}
+};
+
+#ifdef __AVX2__
+/**
+ * Returns the mask of bytes in 'buffer_pack' which are NOT members of the set
+ */
+BLUETH_FORCE_INLINE static inline int
+char_class_mismatch_mask_256(__m256i buffer_pack, __m256i lo_nibble_bits,
+			     __m256i hi_nibble_bits) noexcept {
+	__m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi16(buffer_pack, 4),
+					      _mm256_set1_epi8(0x0F));
+	__m256i membership = _mm256_and_si256(
+	    _mm256_shuffle_epi8(lo_nibble_bits, buffer_pack),
+	    _mm256_shuffle_epi8(hi_nibble_bits, hi_nibbles));
+	bool_vector_256 not_member{
+	    _mm256_cmpeq_epi8(membership, _mm256_setzero_si256())};
+	return not_member.mask();
+}
+#endif
+
+#if defined(__SSSE3__)
+BLUETH_FORCE_INLINE static inline int
+char_class_mismatch_mask_128(__m128i buffer_pack, __m128i lo_nibble_bits,
+			     __m128i hi_nibble_bits) noexcept {
+	__m128i hi_nibbles = _mm_and_si128(_mm_srli_epi16(buffer_pack, 4),
+					   _mm_set1_epi8(0x0F));
+	__m128i membership =
+	    _mm_and_si128(_mm_shuffle_epi8(lo_nibble_bits, buffer_pack),
+			  _mm_shuffle_epi8(hi_nibble_bits, hi_nibbles));
+	bool_vector_128 not_member{
+	    _mm_cmpeq_epi8(membership, _mm_setzero_si128())};
+	return not_member.mask();
+}
+#endif
+
+/**
+ * Find the first byte in [buffer_start, buffer_end) which is not a member of
+ * 'char_class', returns buffer_end if all the bytes are members. Without
+ * SSSE3 the bytes are looked up one at a time.
+ */
+BLUETH_FORCE_INLINE static inline const char *
+find_first_not_in_class(const char *buffer_start, const char *buffer_end,
+			const char_class_set &char_class) noexcept {
+#if defined(__SSSE3__)
+	__m128i lo_nibble_bits =
+	    _mm_load_si128((const __m128i *)char_class.lo_nibble_bits);
+	__m128i hi_nibble_bits =
+	    _mm_load_si128((const __m128i *)char_class.hi_nibble_bits);
+#ifdef __AVX2__
+	__m256i lo_nibble_bits_256 = _mm256_broadcastsi128_si256(lo_nibble_bits);
+	__m256i hi_nibble_bits_256 = _mm256_broadcastsi128_si256(hi_nibble_bits);
+	for (; buffer_start + 32 <= buffer_end; buffer_start += 32) {
+		int mask = char_class_mismatch_mask_256(
+		    _mm256_lddqu_si256((const __m256i *)buffer_start),
+		    lo_nibble_bits_256, hi_nibble_bits_256);
+		if (mask) return buffer_start + __builtin_ctz(mask);
+	}
+#endif
+	for (; buffer_start + 16 <= buffer_end; buffer_start += 16) {
+		int mask = char_class_mismatch_mask_128(
+		    _mm_lddqu_si128((const __m128i *)buffer_start),
+		    lo_nibble_bits, hi_nibble_bits);
+		if (mask) return buffer_start + __builtin_ctz(mask);
+	}
+#endif
+	for (; buffer_start < buffer_end; ++buffer_start)
+		if (!char_class.contains[static_cast<std::uint8_t>(
+			*buffer_start)])
+			return buffer_start;
+	return buffer_end;
+}
+
+/**
+ * Find the first byte in [buffer_start, buffer_end) which is outside the
+ * unsigned range [range_low, range_high], returns buffer_end if there is none.
+ */
+BLUETH_FORCE_INLINE static inline const char *
+find_first_not_in_range(const char *buffer_start, const char *buffer_end,
+			std::uint8_t range_low,
+			std::uint8_t range_high) noexcept {
+#ifdef __AVX2__
+	__m256i low_256 = _mm256_set1_epi8(range_low);
+	__m256i high_256 = _mm256_set1_epi8(range_high);
+	for (; buffer_start + 32 <= buffer_end; buffer_start += 32) {
+		__m256i buffer_pack =
+		    _mm256_lddqu_si256((const __m256i *)buffer_start);
+		__m256i clamped = _mm256_min_epu8(
+		    _mm256_max_epu8(buffer_pack, low_256), high_256);
+		bool_vector_256 in_range{
+		    _mm256_cmpeq_epi8(clamped, buffer_pack)};
+		int mask = ~in_range.mask();
+		if (mask) return buffer_start + __builtin_ctz(mask);
+	}
+#endif
+#if defined(__SSSE3__)
+	__m128i low_128 = _mm_set1_epi8(range_low);
+	__m128i high_128 = _mm_set1_epi8(range_high);
+	for (; buffer_start + 16 <= buffer_end; buffer_start += 16) {
+		__m128i buffer_pack =
+		    _mm_lddqu_si128((const __m128i *)buffer_start);
+		__m128i clamped =
+		    _mm_min_epu8(_mm_max_epu8(buffer_pack, low_128), high_128);
+		bool_vector_128 in_range{_mm_cmpeq_epi8(clamped, buffer_pack)};
+		int mask = ~in_range.mask() & 0xFFFF;
+		if (mask) return buffer_start + __builtin_ctz(mask);
+	}
+#endif
+	for (; buffer_start < buffer_end; ++buffer_start) {
+		std::uint8_t value = static_cast<std::uint8_t>(*buffer_start);
+		if (value < range_low || value > range_high)
+			return buffer_start;
+	}
+	return buffer_end;
+}
+
+/**
+ * Find the first control character(0x00-0x1F except HT, and DEL) in
+ * [buffer_start, buffer_end), which ends a HTTP header field value. Bytes
+ * >= 0x80(obs-text) are not control characters.
+ */
+BLUETH_FORCE_INLINE static inline const char *
+find_first_control_char(const char *buffer_start,
+			const char *buffer_end) noexcept {
+#ifdef __AVX2__
+	__m256i space_256 = _mm256_set1_epi8(0x20);
+	__m256i tab_256 = _mm256_set1_epi8(0x09);
+	__m256i del_256 = _mm256_set1_epi8(0x7F);
+	for (; buffer_start + 32 <= buffer_end; buffer_start += 32) {
+		__m256i buffer_pack =
+		    _mm256_lddqu_si256((const __m256i *)buffer_start);
+		// buffer_pack < 0x20(unsigned) iff max(buffer_pack, 0x20) != pack
+		bool_vector_256 printable{_mm256_cmpeq_epi8(
+		    _mm256_max_epu8(buffer_pack, space_256), buffer_pack)};
+		bool_vector_256 tab{_mm256_cmpeq_epi8(buffer_pack, tab_256)};
+		bool_vector_256 del{_mm256_cmpeq_epi8(buffer_pack, del_256)};
+		int mask = ~(printable | tab).mask() | del.mask();
+		if (mask) return buffer_start + __builtin_ctz(mask);
+	}
+#endif
+#if defined(__SSSE3__)
+	__m128i space_128 = _mm_set1_epi8(0x20);
+	__m128i tab_128 = _mm_set1_epi8(0x09);
+	__m128i del_128 = _mm_set1_epi8(0x7F);
+	for (; buffer_start + 16 <= buffer_end; buffer_start += 16) {
+		__m128i buffer_pack =
+		    _mm_lddqu_si128((const __m128i *)buffer_start);
+		bool_vector_128 printable{_mm_cmpeq_epi8(
+		    _mm_max_epu8(buffer_pack, space_128), buffer_pack)};
+		bool_vector_128 tab{_mm_cmpeq_epi8(buffer_pack, tab_128)};
+		bool_vector_128 del{_mm_cmpeq_epi8(buffer_pack, del_128)};
+		int mask = (~(printable | tab).mask() & 0xFFFF) | del.mask();
+		if (mask) return buffer_start + __builtin_ctz(mask);
+	}
+#endif
+	for (; buffer_start < buffer_end; ++buffer_start) {
+		std::uint8_t value = static_cast<std::uint8_t>(*buffer_start);
+		if ((value < 0x20 && value != 0x09) || value == 0x7F)
+			return buffer_start;
+	}
+	return buffer_end;
+}
+
+/**
+ * Find the first byte in [buffer_start, buffer_end) which is equal to
+ * first_char or second_char, returns buffer_end if there is none.
+ */
+BLUETH_FORCE_INLINE static inline const char *
+find_first_of_either(const char *buffer_start, const char *buffer_end,
+		     char first_char, char second_char) noexcept {
+#ifdef __AVX2__
+	__m256i first_256 = _mm256_set1_epi8(first_char);
+	__m256i second_256 = _mm256_set1_epi8(second_char);
+	for (; buffer_start + 32 <= buffer_end; buffer_start += 32) {
+		__m256i buffer_pack =
+		    _mm256_lddqu_si256((const __m256i *)buffer_start);
+		bool_vector_256 first_eq{_mm256_cmpeq_epi8(buffer_pack, first_256)};
+		bool_vector_256 second_eq{
+		    _mm256_cmpeq_epi8(buffer_pack, second_256)};
+		int mask = (first_eq | second_eq).mask();
+		if (mask) return buffer_start + __builtin_ctz(mask);
+	}
+#endif
+#if defined(__SSSE3__)
+	__m128i first_128 = _mm_set1_epi8(first_char);
+	__m128i second_128 = _mm_set1_epi8(second_char);
+	for (; buffer_start + 16 <= buffer_end; buffer_start += 16) {
+		__m128i buffer_pack =
+		    _mm_lddqu_si128((const __m128i *)buffer_start);
+		bool_vector_128 first_eq{_mm_cmpeq_epi8(buffer_pack, first_128)};
+		bool_vector_128 second_eq{_mm_cmpeq_epi8(buffer_pack, second_128)};
+		int mask = (first_eq | second_eq).mask();
+		if (mask) return buffer_start + __builtin_ctz(mask);
+	}
+#endif
+	for (; buffer_start < buffer_end; ++buffer_start)
+		if (*buffer_start == first_char || *buffer_start == second_char)
+			return buffer_start;
+	return buffer_end;
+}
+
+#ifdef __AVX2__
+// ASCII upper case letters of buffer_pack turned into lower case
+BLUETH_FORCE_INLINE static inline __m256i
+to_lower_ascii_256(__m256i buffer_pack) noexcept {
+	// Bytes >= 0x80 are negative, so they are never in ['A', 'Z']
+	__m256i upper_case = _mm256_and_si256(
+	    _mm256_cmpgt_epi8(buffer_pack, _mm256_set1_epi8('A' - 1)),
+	    _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), buffer_pack));
+	return _mm256_or_si256(
+	    buffer_pack, _mm256_and_si256(upper_case, _mm256_set1_epi8(0x20)));
+}
+#endif
+
+#if defined(__SSSE3__)
+BLUETH_FORCE_INLINE static inline __m128i
+to_lower_ascii_128(__m128i buffer_pack) noexcept {
+	__m128i upper_case =
+	    _mm_and_si128(_mm_cmpgt_epi8(buffer_pack, _mm_set1_epi8('A' - 1)),
+			  _mm_cmplt_epi8(buffer_pack, _mm_set1_epi8('Z' + 1)));
+	return _mm_or_si128(buffer_pack,
+			    _mm_and_si128(upper_case, _mm_set1_epi8(0x20)));
+}
+#endif
+
+/**
+ * Whether the 'size' bytes at lhs and rhs are equal when the ASCII letters are
+ * compared case-insensitively, 16/32 bytes at a time.
+ */
+BLUETH_FORCE_INLINE static inline bool
+equal_ignore_ascii_case(const char *lhs, const char *rhs,
+			std::size_t size) noexcept {
+	const char *lhs_end = lhs + size;
+#ifdef __AVX2__
+	for (; lhs + 32 <= lhs_end; lhs += 32, rhs += 32) {
+		bool_vector_256 equal{_mm256_cmpeq_epi8(
+		    to_lower_ascii_256(_mm256_lddqu_si256((const __m256i *)lhs)),
+		    to_lower_ascii_256(_mm256_lddqu_si256((const __m256i *)rhs)))};
+		if (equal.mask() != -1) return false;
+	}
+#endif
+#if defined(__SSSE3__)
+	for (; lhs + 16 <= lhs_end; lhs += 16, rhs += 16) {
+		bool_vector_128 equal{_mm_cmpeq_epi8(
+		    to_lower_ascii_128(_mm_lddqu_si128((const __m128i *)lhs)),
+		    to_lower_ascii_128(_mm_lddqu_si128((const __m128i *)rhs)))};
+		if (equal.mask() != 0xFFFF) return false;
+	}
+#endif
+	for (; lhs < lhs_end; ++lhs, ++rhs) {
+		char lhs_char = *lhs, rhs_char = *rhs;
+		if (lhs_char >= 'A' && lhs_char <= 'Z') lhs_char += 'a' - 'A';
+		if (rhs_char >= 'A' && rhs_char <= 'Z') rhs_char += 'a' - 'A';
+		if (lhs_char != rhs_char) return false;
+	}
+	return true;
+}
+
 } // end namespace blueth::simd
@@ -0,0 +1,197 @@
+#include <HTTPConstants.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <http/HTTPParserStateMachine.hpp>
+#include <http/HTTPParserStateMachineResponse.hpp>
+#include <io/IOBuffer.hpp>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// clang-format off
+/* Differential fuzzer of the HTTP/1.1 parsers
+ *
+ *    data[0]: bit 0 selects the request(0) or the response(1) parser,
+ *             the other bits seed the fragment sizes
+ *    data[1..]: the bytes on the wire
+ *
+ * The bytes are parsed twice: whole by the SIMD parser and fed in random fragments(1 to 64 bytes) to the
+ * scalar parser, the way they trickle in from a socket. Both runs must end in the same state and produce the
+ * same messages, otherwise the fuzzer traps. The sanitizers catch the out-of-bounds reads on the way.
+ *
+ * Build with clang: cmake -DBLUETH_BUILD_FUZZERS=ON -DCMAKE_CXX_COMPILER=clang++
+ * Without libFuzzer(BLUETH_FUZZ_STANDALONE), the binary replays the files passed as arguments, e.g. the
+ * seed corpus in tests/fuzz/corpus/
+ */
+// clang-format on
+
+using namespace blueth;
+
+namespace {
+
+constexpr std::size_t max_fragment_size = 64;
+
+struct ParsedMessage {
+	std::string start_line;
+	std::vector<std::string> header_lines;
+	std::string body;
+
+	bool operator==(const ParsedMessage &) const = default;
+};
+
+struct ParseOutcome {
+	std::vector<ParsedMessage> messages;
+	int final_state;
+
+	bool operator==(const ParseOutcome &) const = default;
+};
+
+/**
+ * Fragment sizes from a small LCG, so a crashing input replays the same
+ * fragmentation
+ */
+class FragmentSizes {
+      public:
+	explicit FragmentSizes(std::uint32_t seed) : state_{seed} {}
+	std::size_t next() noexcept {
+		state_ = state_ * 1664525u + 1013904223u;
+		return (state_ >> 16) % max_fragment_size + 1;
+	}
+
+      private:
+	std::uint32_t state_;
+};
+
+std::vector<std::string> sorted_header_lines(const http::HTTPHeaders &headers) {
+	// HTTPHeaders doesn't keep the insertion order
+	std::vector<std::string> returner;
+	std::string raw_header = headers.buildRawHeader();
+	std::size_t line_start{};
+	for (std::size_t line_end = raw_header.find("\r\n");
+	     line_end != std::string::npos && line_end != line_start;
+	     line_end = raw_header.find("\r\n", line_start)) {
+		returner.emplace_back(raw_header, line_start,
+				      line_end - line_start);
+		line_start = line_end + 2;
+	}
+	std::sort(returner.begin(), returner.end());
+	return returner;
+}
+
+std::string body_string(const http::HTTPMessageBody &body) {
+	return std::string{body.getStartOffsetPointer(), body.getDataSize()};
+}
+
+template <bool UseSIMD>
+ParseOutcome parse_requests(const char *data, std::size_t size,
+			    FragmentSizes *fragment_sizes) {
+	std::unique_ptr<io::IOBuffer<char>> io_buffer =
+	    io::IOBuffer<char>::create(size + 1);
+	http::ParserState current_state = http::ParserState::RequestLineBegin;
+	std::unique_ptr<http::HTTPRequestMessage> http_message =
+	    http::HTTPRequestMessage::create();
+	ParseOutcome returner;
+	auto on_request = [&](std::unique_ptr<http::HTTPRequestMessage> request) {
+		returner.messages.push_back(
+		    {std::string{http::method_from_request_type(
+			 request->getRequestType())} +
+			 " " + request->getTargetResource(),
+		     sorted_header_lines(*request->constGetHTTPHeaders()),
+		     body_string(request->constGetRawBody())});
+	};
+	for (std::size_t offset{}; offset < size;) {
+		std::size_t fragment_size =
+		    fragment_sizes ? std::min(fragment_sizes->next(), size - offset)
+				   : size;
+		io_buffer->appendRawBytes(data + offset, fragment_size);
+		offset += fragment_size;
+		http::ParseHTTP1_1PipelinedRequests<UseSIMD>(
+		    io_buffer, current_state, http_message, on_request);
+	}
+	returner.final_state = static_cast<int>(current_state);
+	return returner;
+}
+
+// Responses are parsed back to back like a pipelined stream, the end of the
+// input is the server closing the connection
+ParseOutcome parse_responses(const char *data, std::size_t size,
+			     FragmentSizes *fragment_sizes) {
+	std::unique_ptr<io::IOBuffer<char>> io_buffer =
+	    io::IOBuffer<char>::create(size + 1);
+	http::ResponseParserState current_state =
+	    http::ResponseParserState::ResponseProtocolH;
+	std::unique_ptr<http::HTTPResponseMessage> http_message =
+	    http::HTTPResponseMessage::create();
+	ParseOutcome returner;
+	auto add_response = [&]() {
+		returner.messages.push_back(
+		    {std::to_string(
+			 static_cast<int>(http_message->getResponseCode())),
+		     sorted_header_lines(*http_message->constGetHTTPHeaders()),
+		     body_string(http_message->constGetRawBody())});
+		http_message = http::HTTPResponseMessage::create();
+		current_state = http::ResponseParserState::ResponseProtocolH;
+	};
+	for (std::size_t offset{}; offset < size;) {
+		std::size_t fragment_size =
+		    fragment_sizes ? std::min(fragment_sizes->next(), size - offset)
+				   : size;
+		io_buffer->appendRawBytes(data + offset, fragment_size);
+		offset += fragment_size;
+		while (io_buffer->getDataSize() &&
+		       !http::is_parser_error(current_state)) {
+			std::size_t consumed_bytes{};
+			http_message = http::ParseHTTP1_1ResponseMessage(
+			    io_buffer, current_state, std::move(http_message),
+			    consumed_bytes);
+			io_buffer->modifyStartOffset(consumed_bytes);
+			if (current_state !=
+			    http::ResponseParserState::ParsingDone)
+				break;
+			add_response();
+		}
+	}
+	if (current_state != http::ResponseParserState::ResponseProtocolH) {
+		http::ParseHTTP1_1ResponseEndOfStream(current_state);
+		if (current_state == http::ResponseParserState::ParsingDone)
+			add_response();
+	}
+	returner.final_state = static_cast<int>(current_state);
+	return returner;
+}
+
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t *data,
+				      std::size_t size) {
+	if (size < 2) return 0;
+	const char *wire_bytes = reinterpret_cast<const char *>(data + 1);
+	std::size_t wire_size = size - 1;
+	FragmentSizes fragment_sizes{data[0]};
+	if (data[0] & 1) {
+		if (parse_responses(wire_bytes, wire_size, nullptr) !=
+		    parse_responses(wire_bytes, wire_size, &fragment_sizes))
+			__builtin_trap();
+	} else {
+		if (parse_requests<true>(wire_bytes, wire_size, nullptr) !=
+		    parse_requests<false>(wire_bytes, wire_size, &fragment_sizes))
+			__builtin_trap();
+	}
+	return 0;
+}
+
+#ifdef BLUETH_FUZZ_STANDALONE
+int main(int argc, char *argv[]) {
+	for (int arg_index = 1; arg_index < argc; arg_index++) {
+		std::ifstream input_file{argv[arg_index], std::ios::binary};
+		std::string input{std::istreambuf_iterator<char>{input_file},
+				  std::istreambuf_iterator<char>{}};
+		LLVMFuzzerTestOneInput(
+		    reinterpret_cast<const std::uint8_t *>(input.data()),
+		    input.size());
+	}
+	return 0;
+}
+#endif
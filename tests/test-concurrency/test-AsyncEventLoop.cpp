@@ -44,7 +44,7 @@ on_write(concurrency::PeerStateHolder *peer_state_holder,
 	    io_context->writeToPeer(peer_state_holder, peer_state->io_buffer);
 	EXPECT_EQ(written_bytes, server_reply.size());
 	std::cout << "written: " << written_bytes << std::endl;
-	return concurrency::WantWrite;
+	return concurrency::WantNoReadWrite;
 }
 
 concurrency::FDStatus
@@ -57,7 +57,8 @@ on_read(concurrency::PeerStateHolder *peer_state_holder,
 			      peer_state->io_buffer->getEndOffsetPointer()};
 	std::cout << "read: " << read_data << std::endl;
 	EXPECT_EQ(read_data, client_reply);
-	return concurrency::WantNoReadWrite;
+	peer_state->io_buffer->clear();
+	return concurrency::WantWrite;
 }
 
 concurrency::FDStatus
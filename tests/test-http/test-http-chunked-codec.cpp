@@ -0,0 +1,136 @@
+#include <HTTPConstants.hpp>
+#include <gtest/gtest.h>
+#include <http/HTTPChunkedCodec.hpp>
+#include <http/HTTPParserStateMachine.hpp>
+#include <http/HTTPParserStateMachineResponse.hpp>
+#include <io/IOBuffer.hpp>
+#include <string>
+
+using namespace blueth;
+TEST(HTTPChunkedCodec, Decoder) {
+	std::string chunked_body = "5\r\nhello\r\n"
+				   "6;name=value\r\n world\r\n"
+				   "A\r\n0123456789\r\n"
+				   "0\r\n"
+				   "Expires: never\r\n"
+				   "\r\n"
+				   "GET / HTTP/1.1\r\n";
+	std::size_t body_end = chunked_body.find("GET");
+	// Feed the body split at every offset, the decoded body and the consumed
+	// bytes must not depend on the reads
+	for (std::size_t split{}; split <= body_end; split++) {
+		http::HTTPChunkedDecoder chunked_decoder;
+		std::string decoded_body;
+		auto body_sink = [&decoded_body](const char *data,
+						 std::size_t size) {
+			decoded_body.append(data, size);
+		};
+		const char *begin = chunked_body.data();
+		http::HTTPParseResult<http::ChunkedDecoderState> result =
+		    chunked_decoder.decode(begin, begin + split, body_sink);
+		ASSERT_EQ(result.consumed, split);
+		result = chunked_decoder.decode(
+		    begin + split, begin + chunked_body.size(), body_sink);
+		ASSERT_TRUE(result.state ==
+			    http::ChunkedDecoderState::DecodingDone);
+		ASSERT_EQ(split + result.consumed, body_end);
+		ASSERT_EQ(decoded_body, "hello world0123456789");
+	}
+	{ // Malformed chunk size and missing CRLF after the chunk data
+		http::HTTPChunkedDecoder chunked_decoder;
+		std::string bad_size = "z\r\n";
+		auto body_sink = [](const char *, std::size_t) {};
+		ASSERT_TRUE(chunked_decoder
+				.decode(bad_size.data(),
+					bad_size.data() + bad_size.size(),
+					body_sink)
+				.state == http::ChunkedDecoderState::ProtocolError);
+		chunked_decoder.reset();
+		std::string bad_data = "2\r\nabc\r\n";
+		ASSERT_TRUE(chunked_decoder
+				.decode(bad_data.data(),
+					bad_data.data() + bad_data.size(),
+					body_sink)
+				.state == http::ChunkedDecoderState::ProtocolError);
+		chunked_decoder.reset();
+		std::string too_large = "10000000000000000\r\n";
+		ASSERT_TRUE(chunked_decoder
+				.decode(too_large.data(),
+					too_large.data() + too_large.size(),
+					body_sink)
+				.state == http::ChunkedDecoderState::ProtocolError);
+	}
+}
+
+TEST(HTTPChunkedCodec, EncoderRoundTrip) {
+	std::unique_ptr<io::IOBuffer<char>> io_buffer =
+	    io::IOBuffer<char>::create(64);
+	std::string large_chunk(1000, 'x');
+	http::EncodeHTTPChunk(*io_buffer, "hello", 5);
+	http::EncodeHTTPChunk(*io_buffer, "", 0);
+	http::EncodeHTTPChunk(*io_buffer, large_chunk.c_str(),
+			      large_chunk.size());
+	http::EncodeHTTPLastChunk(*io_buffer);
+	std::string encoded{io_buffer->getStartOffsetPointer(),
+			    io_buffer->getDataSize()};
+	ASSERT_EQ(encoded.substr(0, 15), "5\r\nhello\r\n3e8\r\n");
+	ASSERT_EQ(encoded.substr(encoded.size() - 7), "\r\n0\r\n\r\n");
+	http::HTTPChunkedDecoder chunked_decoder;
+	std::string decoded_body;
+	http::HTTPParseResult<http::ChunkedDecoderState> result =
+	    chunked_decoder.decode(io_buffer,
+				   [&decoded_body](const char *data,
+						   std::size_t size) {
+					   decoded_body.append(data, size);
+				   });
+	ASSERT_TRUE(result.state == http::ChunkedDecoderState::DecodingDone);
+	ASSERT_EQ(result.consumed, encoded.size());
+	ASSERT_EQ(decoded_body, "hello" + large_chunk);
+
+	// The slice is appended to the chain without a copy
+	io::IOBufChain<char> io_chain;
+	io::IOBufSlice<char> chunk =
+	    io::IOBufSlice<char>::adoptString(std::string(300, 'y'));
+	http::EncodeHTTPChunk(io_chain, chunk);
+	http::EncodeHTTPLastChunk(io_chain);
+	ASSERT_EQ(chunk.useCount(), 2);
+	ASSERT_EQ(io_chain.getDataSize(), 5 + 300 + 2 + 5);
+}
+
+TEST(HTTPChunkedCodec, Parsers) {
+	std::string chunked_request = "POST /upload HTTP/1.1\r\n"
+				      "Transfer-Encoding: gzip, Chunked\r\n\r\n"
+				      "3\r\nabc\r\n2\r\nde\r\n0\r\n\r\n"
+				      "GET / HTTP/1.1\r\n\r\n";
+	std::unique_ptr<io::IOBuffer<char>> io_buffer =
+	    io::IOBuffer<char>::create(1024);
+	io_buffer->appendRawBytes(chunked_request.c_str(),
+				  chunked_request.size());
+	http::ParserState current_state = http::ParserState::RequestLineBegin;
+	std::size_t consumed_bytes{};
+	std::unique_ptr<http::HTTPRequestMessage> parsed_request =
+	    http::ParseHTTP1_1RequestMessage(io_buffer, current_state,
+					     http::HTTPRequestMessage::create(),
+					     consumed_bytes);
+	ASSERT_TRUE(current_state == http::ParserState::ParsingDone);
+	ASSERT_EQ(consumed_bytes, chunked_request.find("GET"));
+	ASSERT_EQ(std::string(parsed_request->constGetRawBody().cbegin(),
+			      parsed_request->constGetRawBody().cend()),
+		  "abcde");
+
+	std::string chunked_response = "HTTP/1.1 200 OK\r\n"
+				       "Transfer-Encoding: chunked\r\n\r\n"
+				       "4\r\nWiki\r\n5\r\npedia\r\n0\r\n\r\n";
+	io_buffer->clear();
+	io_buffer->appendRawBytes(chunked_response.c_str(),
+				  chunked_response.size());
+	http::ResponseParserState response_state =
+	    http::ResponseParserState::ResponseProtocolH;
+	std::unique_ptr<http::HTTPResponseMessage> parsed_response =
+	    http::ParseHTTP1_1ResponseMessage(
+		io_buffer, response_state, http::HTTPResponseMessage::create());
+	ASSERT_TRUE(response_state == http::ResponseParserState::ParsingDone);
+	ASSERT_EQ(std::string(parsed_response->constGetRawBody().cbegin(),
+			      parsed_response->constGetRawBody().cend()),
+		  "Wikipedia");
+}
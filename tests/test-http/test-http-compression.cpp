@@ -0,0 +1,139 @@
+#include "io/IOBufChain.hpp"
+#include "io/IOBuffer.hpp"
+#include <gtest/gtest.h>
+#include <http/HTTPCompression.hpp>
+#include <memory>
+#include <string>
+#include <zlib.h>
+
+using namespace blueth;
+
+namespace {
+
+std::string inflate_body(std::string_view compressed, int window_bits) {
+	::z_stream stream{};
+	inflateInit2(&stream, window_bits);
+	std::string decompressed(256 * 1024, '\0');
+	stream.next_in =
+	    reinterpret_cast<Bytef *>(const_cast<char *>(compressed.data()));
+	stream.avail_in = static_cast<uInt>(compressed.size());
+	stream.next_out = reinterpret_cast<Bytef *>(decompressed.data());
+	stream.avail_out = static_cast<uInt>(decompressed.size());
+	int inflate_ret = ::inflate(&stream, Z_FINISH);
+	decompressed.resize(inflate_ret == Z_STREAM_END ? stream.total_out : 0);
+	::inflateEnd(&stream);
+	return decompressed;
+}
+
+std::string json_body(std::size_t record_count) {
+	std::string body = "[";
+	for (std::size_t record{}; record < record_count; record++)
+		body += R"({"id":)" + std::to_string(record) +
+			R"(,"name":"blueth","tags":["http","parser"]},)";
+	body.back() = ']';
+	return body;
+}
+
+} // namespace
+
+TEST(HttpCompression, NegotiateContentCoding) {
+	using http::HTTPContentCoding;
+	ASSERT_EQ(http::negotiate_content_coding("gzip, deflate, br"),
+		  HTTPContentCoding::Gzip);
+	ASSERT_EQ(http::negotiate_content_coding("deflate"),
+		  HTTPContentCoding::Deflate);
+	ASSERT_EQ(http::negotiate_content_coding("gzip;q=0.5 , DEFLATE;q=0.8"),
+		  HTTPContentCoding::Deflate);
+	ASSERT_EQ(http::negotiate_content_coding("x-gzip"), HTTPContentCoding::Gzip);
+	ASSERT_EQ(http::negotiate_content_coding("*"), HTTPContentCoding::Gzip);
+	ASSERT_EQ(http::negotiate_content_coding("*;q=0.3, gzip;q=0"),
+		  HTTPContentCoding::Deflate);
+	ASSERT_EQ(http::negotiate_content_coding("gzip;q=0, deflate;q=0.000"),
+		  HTTPContentCoding::Identity);
+	ASSERT_EQ(http::negotiate_content_coding("br, identity"),
+		  HTTPContentCoding::Identity);
+	// Malformed quality values drop the element
+	ASSERT_EQ(http::negotiate_content_coding("gzip;q=2, deflate;q=abc"),
+		  HTTPContentCoding::Identity);
+	ASSERT_EQ(http::negotiate_content_coding(""), HTTPContentCoding::Identity);
+
+	ASSERT_TRUE(http::is_compressible_content_type("text/html; charset=utf-8"));
+	ASSERT_TRUE(http::is_compressible_content_type("application/json"));
+	ASSERT_TRUE(http::is_compressible_content_type("image/svg+xml"));
+	ASSERT_TRUE(http::is_compressible_content_type("application/vnd.api+json"));
+	ASSERT_FALSE(http::is_compressible_content_type("image/png"));
+	ASSERT_FALSE(http::is_compressible_content_type("application/octet-stream"));
+}
+
+TEST(HttpCompression, StreamingCompressor) {
+	std::string body = json_body(500);
+	for (http::HTTPContentCoding content_coding :
+	     {http::HTTPContentCoding::Gzip, http::HTTPContentCoding::Deflate}) {
+		int window_bits =
+		    content_coding == http::HTTPContentCoding::Gzip ? 16 + 15 : 15;
+		http::HTTPCompressor compressor{content_coding, 6};
+		// The body in small chunks, into a single buffer
+		std::unique_ptr<io::IOBuffer<char>> output_buffer =
+		    io::IOBuffer<char>::create(512);
+		for (std::size_t offset{}; offset < body.size(); offset += 1000)
+			compressor.compress(body.data() + offset,
+					    std::min<std::size_t>(1000, body.size() - offset),
+					    *output_buffer);
+		compressor.finish(*output_buffer);
+		std::string_view compressed{output_buffer->getStartOffsetPointer(),
+					    output_buffer->getDataSize()};
+		ASSERT_LT(compressed.size(), body.size() / 4);
+		ASSERT_EQ(inflate_body(compressed, window_bits), body);
+
+		// Re-used for the next body, into a chain of buffers
+		compressor.reset();
+		io::IOBufChain<char> output_chain;
+		compressor.compress(body.data(), body.size(), output_chain);
+		compressor.finish(output_chain);
+		ASSERT_EQ(inflate_body({output_chain.coalesce(),
+					output_chain.getDataSize()},
+				       window_bits),
+			  body);
+	}
+	ASSERT_THROW(http::HTTPCompressor{http::HTTPContentCoding::Identity},
+		     std::invalid_argument);
+}
+
+TEST(HttpCompression, VariantCache) {
+	std::string hot_body = json_body(200);
+	std::string other_body = json_body(201);
+	http::HTTPCompressor compressor{http::HTTPContentCoding::Gzip};
+	http::HTTPCompressedVariantCache variant_cache;
+
+	std::shared_ptr<const std::string> compressed =
+	    variant_cache.getOrCompress(hot_body, compressor);
+	ASSERT_EQ(inflate_body(*compressed, 16 + 15), hot_body);
+	ASSERT_EQ(variant_cache.getOrCompress(hot_body, compressor), compressed);
+	http::HTTPCompressedVariantCacheStats stats = variant_cache.getStats();
+	ASSERT_EQ(stats.hits, 1);
+	ASSERT_EQ(stats.cached_bytes, compressed->size());
+	// Same body, other coding
+	ASSERT_EQ(variant_cache.find(http::HTTPCompressedVariantCache::makeKey(
+		      hot_body, http::HTTPContentCoding::Deflate)),
+		  nullptr);
+
+	// insert() admits a body on its second miss
+	http::HTTPCompressedVariantCache::Key other_key =
+	    http::HTTPCompressedVariantCache::makeKey(
+		other_body, http::HTTPContentCoding::Gzip);
+	ASSERT_FALSE(variant_cache.insert(other_key, "first"));
+	ASSERT_EQ(variant_cache.find(other_key), nullptr);
+	ASSERT_TRUE(variant_cache.insert(other_key, "second"));
+	ASSERT_EQ(*variant_cache.find(other_key), "second");
+
+	// The least recently used variant is evicted
+	http::HTTPCompressedVariantCache small_cache{compressed->size() + 4};
+	small_cache.getOrCompress(hot_body, compressor);
+	std::shared_ptr<const std::string> other_compressed =
+	    small_cache.getOrCompress(other_body, compressor);
+	ASSERT_EQ(small_cache.getStats().evictions, 1);
+	ASSERT_EQ(small_cache.find(http::HTTPCompressedVariantCache::makeKey(
+		      hot_body, http::HTTPContentCoding::Gzip)),
+		  nullptr);
+	ASSERT_EQ(inflate_body(*other_compressed, 16 + 15), other_body);
+}
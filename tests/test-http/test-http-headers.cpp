@@ -0,0 +1,101 @@
+#include <cctype>
+#include <gtest/gtest.h>
+#include <http/HTTPHeaders.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace blueth;
+
+TEST(HttpHeaders, OrderAndMultipleValues) {
+	http::HTTPHeaders http_headers;
+	http_headers.addHeader("Content-Type", "text/html");
+	http_headers.addHeader("Set-Cookie", "a=1; Path=/");
+	http_headers.addHeader("X-Request-Id", "42");
+	http_headers.addHeader("set-cookie", "b=2");
+	ASSERT_EQ(http_headers.headerCount(), 4);
+	ASSERT_EQ(http_headers.getHeaderValue("Set-Cookie"), "a=1; Path=/");
+	ASSERT_EQ(http_headers.getHeaderValues("SET-COOKIE"),
+		  (std::vector<std::string_view>{"a=1; Path=/", "b=2"}));
+	std::vector<std::string> header_lines;
+	for (http::HTTPHeaderView header : http_headers)
+		header_lines.push_back(std::string{header.name} + ":" +
+				       std::string{header.value});
+	ASSERT_EQ(header_lines,
+		  (std::vector<std::string>{"Content-Type:text/html",
+					    "Set-Cookie:a=1; Path=/",
+					    "X-Request-Id:42", "set-cookie:b=2"}));
+	std::string raw_header = http_headers.buildRawHeader();
+	ASSERT_EQ(raw_header, "Content-Type: text/html\r\n"
+			      "Set-Cookie: a=1; Path=/\r\n"
+			      "X-Request-Id: 42\r\n"
+			      "set-cookie: b=2\r\n\r\n");
+	ASSERT_EQ(raw_header.size(), http_headers.rawHeaderSize());
+
+	// All the values go and the others keep their order
+	ASSERT_TRUE(http_headers.removeHeader("Set-Cookie"));
+	ASSERT_FALSE(http_headers.removeHeader("Set-Cookie"));
+	ASSERT_EQ(http_headers.headerCount(), 2);
+	ASSERT_EQ(http_headers.buildRawHeader(), "Content-Type: text/html\r\n"
+						 "X-Request-Id: 42\r\n\r\n");
+	ASSERT_EQ(http_headers.getHeaderValue(http::HTTPHeaderID::ContentType),
+		  "text/html");
+}
+
+TEST(HttpHeaders, CaseInsensitiveUnknownNames) {
+	http::HTTPHeaders http_headers;
+	// Longer than a vector, so the names are compared 32/16 bytes at a time
+	std::string long_name = "X-Application-Specific-Correlation-Identifier";
+	http_headers.addHeader(long_name, "abc");
+	http_headers.addHeader("X-Custom", "value");
+	std::string upper_name = long_name;
+	for (char &name_char : upper_name)
+		name_char = std::toupper(name_char);
+	ASSERT_EQ(http_headers.getHeaderValueView(upper_name), "abc");
+	ASSERT_EQ(http_headers.getHeaderValue("x-custom"), "value");
+	ASSERT_TRUE(http_headers.headerContains("X-CUSTOM"));
+	// Same size, differs only in the last byte
+	ASSERT_FALSE(http_headers.headerContains(
+	    "X-Application-Specific-Correlation-Identifiex"));
+	ASSERT_FALSE(http_headers.headerContains("X-Custon"));
+	ASSERT_FALSE(http_headers.getHeaderValue("X-Missing").has_value());
+}
+
+TEST(HttpHeaders, SpillPastInlineEntries) {
+	http::HTTPHeaders http_headers;
+	std::size_t header_count = http::HTTPHeaders::inline_header_count * 2 + 3;
+	for (std::size_t index{}; index < header_count; index++)
+		http_headers.addHeader("X-Header-" + std::to_string(index),
+				       std::to_string(index));
+	http_headers.addHeader(http::HTTPHeaderID::Host, "www.example.com");
+	ASSERT_EQ(http_headers.headerCount(), header_count + 1);
+	for (std::size_t index{}; index < header_count; index++)
+		ASSERT_EQ(http_headers.getHeaderValue("x-header-" +
+						      std::to_string(index)),
+			  std::to_string(index));
+	ASSERT_EQ(http_headers.getHeaderValue("HOST"), "www.example.com");
+	ASSERT_TRUE(http_headers.removeHeader("X-Header-0"));
+	ASSERT_EQ((*http_headers.begin()).name, "X-Header-1");
+	ASSERT_EQ(http_headers.getHeaderValue(http::HTTPHeaderID::Host),
+		  "www.example.com");
+	ASSERT_EQ(http_headers.buildRawHeader().size(),
+		  http_headers.rawHeaderSize());
+}
+
+TEST(HttpHeaders, ClearKeepsWorking) {
+	http::HTTPHeaders http_headers;
+	for (std::size_t index{}; index < http::HTTPHeaders::inline_header_count + 4;
+	     index++)
+		http_headers.addHeader("X-Header-" + std::to_string(index),
+				       std::to_string(index));
+	http_headers.addHeader(http::HTTPHeaderID::Host, "www.example.com");
+	http_headers.clear();
+	ASSERT_EQ(http_headers.headerCount(), 0);
+	ASSERT_FALSE(http_headers.headerContains(http::HTTPHeaderID::Host));
+	ASSERT_FALSE(http_headers.headerContains("X-Header-0"));
+	ASSERT_EQ(http_headers.buildRawHeader(), "\r\n");
+	http_headers.addHeader("Content-Type", "text/plain");
+	ASSERT_EQ(http_headers.getHeaderValue(http::HTTPHeaderID::ContentType),
+		  "text/plain");
+	ASSERT_EQ(http_headers.buildRawHeader(), "Content-Type: text/plain\r\n\r\n");
+}
@@ -0,0 +1,110 @@
+#include "io/IOBuffer.hpp"
+#include <gtest/gtest.h>
+#include <http/HTTPMessagePool.hpp>
+#include <http/HTTPParserStateMachine.hpp>
+#include <http/HTTPParserStateMachineResponse.hpp>
+#include <memory>
+#include <string>
+
+using namespace blueth;
+
+static std::unique_ptr<http::HTTPRequestMessage>
+parse_request(const std::string &raw_request,
+	      std::unique_ptr<http::HTTPRequestMessage> http_message,
+	      http::ParserState &current_state) {
+	std::unique_ptr<io::IOBuffer<char>> io_buffer =
+	    io::IOBuffer<char>::create(2048);
+	io_buffer->appendRawBytes(raw_request.c_str(), raw_request.size());
+	current_state = http::ParserState::RequestLineBegin;
+	return http::ParseHTTP1_1RequestMessage(io_buffer, current_state,
+						std::move(http_message));
+}
+
+TEST(HttpMessagePool, RequestReset) {
+	http::ParserState current_state;
+	std::unique_ptr<http::HTTPRequestMessage> http_message =
+	    parse_request("POST /upload?id=1 HTTP/1.1\r\n"
+			  "Host: www.example.com\r\n"
+			  "Transfer-Encoding: chunked\r\n\r\n"
+			  "5\r\nhello\r\n0\r\n\r\n",
+			  http::HTTPRequestMessage::create(), current_state);
+	ASSERT_EQ(current_state, http::ParserState::ParsingDone);
+	ASSERT_EQ(std::string(http_message->constGetRawBody().cbegin(),
+			      http_message->constGetRawBody().cend()),
+		  "hello");
+
+	// Nothing of the first request is left in the second one
+	http_message->reset();
+	ASSERT_EQ(http_message->constGetHTTPHeaders()->headerCount(), 0);
+	ASSERT_EQ(http_message->constGetRawBody().getDataSize(), 0);
+	ASSERT_TRUE(http_message->getTargetResource().empty());
+	http_message = parse_request("GET /index.html HTTP/1.1\r\n"
+				     "Host: www.example.org\r\n\r\n",
+				     std::move(http_message), current_state);
+	ASSERT_EQ(current_state, http::ParserState::ParsingDone);
+	ASSERT_EQ(http_message->getRequestType(), http::HTTPRequestType::Get);
+	ASSERT_EQ(http_message->getTargetResource(), "/index.html");
+	ASSERT_EQ(http_message->constGetHTTPHeaders()->headerCount(), 1);
+	ASSERT_EQ(http_message->getHeaderValue("Host"), "www.example.org");
+	ASSERT_EQ(http_message->constGetRawBody().getDataSize(), 0);
+	ASSERT_EQ(http_message->buildRawMessage(),
+		  "GET /index.html HTTP/1.1\r\nHost: www.example.org\r\n\r\n");
+
+	// A large body doesn't stay with the message
+	std::string large_body(http::message_body_retained_capacity * 2, 'x');
+	http_message->pushBackRawBody(large_body.data(), large_body.size());
+	http_message->reset();
+	ASSERT_TRUE(http_message->constGetRawBody().isInline());
+}
+
+TEST(HttpMessagePool, ResponseReset) {
+	std::unique_ptr<http::HTTPResponseMessage> http_message =
+	    http::HTTPResponseMessage::create();
+	http_message->setRequestType(http::HTTPRequestType::Head);
+	http_message->setResponseCode(http::HTTPResponseCodes::NotFound);
+	http_message->addHeader("Content-Length", "5");
+	http_message->pushBackRawBody("hello");
+	http_message->reset();
+	ASSERT_EQ(http_message->getRequestType(), http::HTTPRequestType::Get);
+	ASSERT_EQ(http_message->constGetHTTPHeaders()->headerCount(), 0);
+
+	std::string raw_response = "HTTP/1.1 200 OK\r\n"
+				   "Content-Length: 2\r\n\r\nok";
+	std::unique_ptr<io::IOBuffer<char>> io_buffer =
+	    io::IOBuffer<char>::create(2048);
+	io_buffer->appendRawBytes(raw_response.c_str(), raw_response.size());
+	http::ResponseParserState current_state =
+	    http::ResponseParserState::ResponseProtocolH;
+	http_message = http::ParseHTTP1_1ResponseMessage(
+	    io_buffer, current_state, std::move(http_message));
+	ASSERT_EQ(current_state, http::ResponseParserState::ParsingDone);
+	ASSERT_EQ(http_message->getResponseCode(), http::HTTPResponseCodes::Ok);
+	ASSERT_EQ(http_message->buildRawMessage(), raw_response);
+}
+
+TEST(HttpMessagePool, AcquireRelease) {
+	http::HTTPMessagePool<http::HTTPRequestMessage> message_pool{1};
+	std::unique_ptr<http::HTTPRequestMessage> first_message =
+	    message_pool.acquire();
+	std::unique_ptr<http::HTTPRequestMessage> second_message =
+	    message_pool.acquire();
+	first_message->setHTTPTargetResource("/first");
+	first_message->addHeader("Host", "www.example.com");
+	http::HTTPRequestMessage *first_pointer = first_message.get();
+	message_pool.release(std::move(first_message));
+	// The pool is full, this one is freed
+	message_pool.release(std::move(second_message));
+	message_pool.release(nullptr);
+
+	std::unique_ptr<http::HTTPRequestMessage> reused_message =
+	    message_pool.acquire();
+	ASSERT_EQ(reused_message.get(), first_pointer);
+	ASSERT_TRUE(reused_message->getTargetResource().empty());
+	ASSERT_EQ(reused_message->constGetHTTPHeaders()->headerCount(), 0);
+
+	http::HTTPMessagePoolStats stats = message_pool.getStats();
+	ASSERT_EQ(stats.acquired, 3);
+	ASSERT_EQ(stats.pool_hits, 1);
+	ASSERT_EQ(stats.released, 2);
+	ASSERT_EQ(stats.cached, 0);
+}
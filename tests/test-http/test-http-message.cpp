@@ -3,6 +3,7 @@
 #include <http/HTTPConstants.hpp>
 #include <http/HTTPMessage.hpp>
 #include <memory>
+#include <stdexcept>
 #include <string>
 
 using namespace blueth;
@@ -11,9 +12,9 @@ TEST(HttpTestOne, HttpGet) {
 		std::unique_ptr<http::HTTPRequestMessage> http_message =
 		    http::HTTPRequestMessage::create();
 		std::string sample_request = "GET /index.php HTTP/1.1\r\n"
-					     "Accept: */*\r\n"
+					     "Host: Proxygen.fb.com\r\n"
 					     "User-Agent: FB/CXX-Bot/12.32\r\n"
-					     "Host: Proxygen.fb.com\r\n\r\n";
+					     "Accept: */*\r\n\r\n";
 		std::unique_ptr<io::IOBuffer<char>> io_buffer =
 		    io::IOBuffer<char>::create(2048);
 		io_buffer->appendRawBytes(sample_request.c_str(),
@@ -58,9 +59,22 @@ TEST(HttpTestOne, HttpGet) {
 		connect_request_message.addHeader("Proxy-Connection",
 						  "Keep-Alive");
 		std::string expected = "CONNECT www.foo.com:443 HTTP/1.1\r\n"
+				       "Host: www.foo.com:443\r\n"
 				       "User-Agent: blueth/http-client\r\n"
-				       "Proxy-Connection: Keep-Alive\r\n"
-				       "Host: www.foo.com:443\r\n\r\n";
+				       "Proxy-Connection: Keep-Alive\r\n\r\n";
 		ASSERT_EQ(connect_request_message.buildRawMessage(), expected);
 	}
+	{ // Body copied from an IOBuffer, larger than the inline storage
+		http::HTTPRequestMessage http_message;
+		std::string body(1024, 'x');
+		std::unique_ptr<io::IOBuffer<char>> io_buffer =
+		    io::IOBuffer<char>::create(2048);
+		io_buffer->appendRawBytes(body.c_str(), body.size());
+		http_message.setRawBody(std::move(io_buffer));
+		ASSERT_EQ(http_message.constGetRawBody().getDataSize(),
+			  body.size());
+		ASSERT_THROW(http_message.setRawBody(
+				 std::unique_ptr<io::IOBuffer<char>>{}),
+			     std::invalid_argument);
+	}
 }
@@ -0,0 +1,169 @@
+#include <HTTPConstants.hpp>
+#include <atomic>
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <http/HTTPRequestView.hpp>
+#include <io/IOBuffer.hpp>
+#include <new>
+#include <string>
+
+// Counts the heap allocations made while an AllocationCounter is alive, the
+// view parser must not allocate. The other tests of the binary(the server
+// threads) are not counted.
+static std::atomic<bool> counting_allocations{};
+static std::atomic<std::size_t> allocation_count{};
+
+void *operator new(std::size_t size) {
+	if (counting_allocations.load(std::memory_order_relaxed))
+		allocation_count.fetch_add(1, std::memory_order_relaxed);
+	if (void *ptr = std::malloc(size ? size : 1)) return ptr;
+	throw std::bad_alloc{};
+}
+[[gnu::noinline]] void operator delete(void *ptr) noexcept { std::free(ptr); }
+[[gnu::noinline]] void operator delete(void *ptr, std::size_t) noexcept {
+	std::free(ptr);
+}
+
+namespace {
+
+class AllocationCounter {
+      public:
+	AllocationCounter() noexcept {
+		allocation_count.store(0, std::memory_order_relaxed);
+		counting_allocations.store(true, std::memory_order_relaxed);
+	}
+	~AllocationCounter() {
+		counting_allocations.store(false, std::memory_order_relaxed);
+	}
+	std::size_t count() const noexcept {
+		return allocation_count.load(std::memory_order_relaxed);
+	}
+};
+
+} // namespace
+
+using namespace blueth;
+TEST(HTTPRequestView, TestOne) {
+	{ // Valid HTTP GET message, no allocations while parsing
+		std::string sample_request = "GET /index.php HTTP/1.1\r\n"
+					     "Accept: */*\r\n"
+					     "User-Agent: FB/CXX-Bot/12.32\r\n"
+					     "Host:   Proxygen.fb.com \t\r\n\r\n";
+		http::HTTPRequestView<> request_view;
+		std::size_t parse_allocations{};
+		http::HTTPParseResult<http::ParserState> result;
+		{
+			AllocationCounter allocation_counter;
+			result = http::ParseHTTP1_1RequestView(
+			    sample_request.data(),
+			    sample_request.data() + sample_request.size(),
+			    request_view);
+			parse_allocations = allocation_counter.count();
+		}
+		ASSERT_EQ(parse_allocations, 0);
+		ASSERT_TRUE(result.state == http::ParserState::ParsingDone);
+		ASSERT_EQ(result.consumed, sample_request.size());
+		ASSERT_TRUE(request_view.getRequestType() ==
+			    http::HTTPRequestType::Get);
+		ASSERT_EQ(request_view.getMethod(), "GET");
+		ASSERT_EQ(request_view.getTargetResource(), "/index.php");
+		ASSERT_TRUE(request_view.getHTTPVersion() ==
+			    http::HTTPVersion::HTTP1_1);
+		ASSERT_EQ(request_view.headerCount(), 3);
+		ASSERT_EQ(*request_view.getHeaderValue("user-agent"),
+			  "FB/CXX-Bot/12.32");
+		ASSERT_EQ(*request_view.getHeaderValue("HOST"),
+			  "Proxygen.fb.com");
+		ASSERT_FALSE(request_view.getHeaderValue("Cookie").has_value());
+		ASSERT_TRUE(request_view.getBody().empty());
+		// Views point into the receive buffer
+		ASSERT_EQ(request_view.getMethod().data(), sample_request.data());
+		std::unique_ptr<http::HTTPRequestMessage> request_message =
+		    request_view.toMessage();
+		ASSERT_EQ(request_message->constGetHTTPHeaders()->headerCount(),
+			  3);
+		ASSERT_EQ(request_message->getTargetResource(), "/index.php");
+	}
+	{ // HTTP/1.0 request
+		std::string sample_request = "GET / HTTP/1.0\r\n\r\n";
+		http::HTTPRequestView<> request_view;
+		http::HTTPParseResult<http::ParserState> result =
+		    http::ParseHTTP1_1RequestView(
+			sample_request.data(),
+			sample_request.data() + sample_request.size(),
+			request_view);
+		ASSERT_TRUE(result.state == http::ParserState::ParsingDone);
+		ASSERT_TRUE(request_view.getHTTPVersion() ==
+			    http::HTTPVersion::HTTP1_0);
+		sample_request = "GET / HTTP/1.7\r\n\r\n";
+		result = http::ParseHTTP1_1RequestView(
+		    sample_request.data(),
+		    sample_request.data() + sample_request.size(),
+		    request_view);
+		ASSERT_TRUE(result.state ==
+			    http::ParserState::VersionNotSupported);
+	}
+	{ // POST with a Content-Length body and a pipelined request after it
+		std::string sample_request = "POST /submit HTTP/1.1\r\n"
+					     "Content-Length: 5\r\n\r\n"
+					     "helloGET / HTTP/1.1\r\n\r\n";
+		std::unique_ptr<io::IOBuffer<char>> io_buffer =
+		    io::IOBuffer<char>::create(1024);
+		io_buffer->appendRawBytes(sample_request.c_str(),
+					  sample_request.size());
+		http::HTTPRequestView<> request_view;
+		http::HTTPParseResult<http::ParserState> result =
+		    http::ParseHTTP1_1RequestView(io_buffer, request_view);
+		ASSERT_TRUE(result.state == http::ParserState::ParsingDone);
+		ASSERT_EQ(request_view.getBody(), "hello");
+		ASSERT_EQ(request_view.getTargetResource(), "/submit");
+		io_buffer->modifyStartOffset(result.consumed);
+		result = http::ParseHTTP1_1RequestView(io_buffer, request_view);
+		ASSERT_TRUE(result.state == http::ParserState::ParsingDone);
+		ASSERT_EQ(request_view.getTargetResource(), "/");
+		ASSERT_EQ(request_view.headerCount(), 0);
+		ASSERT_EQ(result.consumed, io_buffer->getDataSize());
+	}
+	{ // Incomplete requests report the state where the input ran out
+		std::string sample_request = "POST /submit HTTP/1.1\r\n"
+					     "Content-Length: 5\r\n\r\n"
+					     "hel";
+		http::HTTPRequestView<> request_view;
+		const char *begin = sample_request.data();
+		ASSERT_TRUE(
+		    http::ParseHTTP1_1RequestView(begin, begin + 2, request_view)
+			.state == http::ParserState::RequestMethod);
+		ASSERT_TRUE(
+		    http::ParseHTTP1_1RequestView(begin, begin + 30, request_view)
+			.state == http::ParserState::HeaderName);
+		ASSERT_TRUE(http::ParseHTTP1_1RequestView(
+				begin, begin + sample_request.size(),
+				request_view)
+				.state == http::ParserState::MessageBody);
+	}
+	{ // Malformed requests and header overflow
+		http::HTTPRequestView<2> request_view;
+		std::string bad_request = "GET /index.php HTTP/1.1\r\n"
+					  "Bad Header: value\r\n\r\n";
+		ASSERT_TRUE(http::ParseHTTP1_1RequestView(
+				bad_request.data(),
+				bad_request.data() + bad_request.size(),
+				request_view)
+				.state == http::ParserState::ProtocolError);
+		std::string many_headers = "GET / HTTP/1.1\r\n"
+					   "A: 1\r\nB: 2\r\nC: 3\r\n\r\n";
+		ASSERT_TRUE(http::ParseHTTP1_1RequestView(
+				many_headers.data(),
+				many_headers.data() + many_headers.size(),
+				request_view)
+				.state == http::ParserState::ProtocolError);
+		std::string smuggled = "POST / HTTP/1.1\r\n"
+				       "Content-Length: 5\r\n"
+				       "Transfer-Encoding: chunked\r\n\r\n";
+		ASSERT_TRUE(http::ParseHTTP1_1RequestView(
+				smuggled.data(),
+				smuggled.data() + smuggled.size(),
+				request_view)
+				.state == http::ParserState::ProtocolError);
+	}
+}
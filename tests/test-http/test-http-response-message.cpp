@@ -1,9 +1,13 @@
 #include "HTTPConstants.hpp"
 #include "http/HTTPMessage.hpp"
+#include "io/IOBuffer.hpp"
 #include <cstdlib>
 #include <cstring>
 #include <gtest/gtest.h>
 #include <memory>
+#include <stdexcept>
+#include <string>
+#include <sys/uio.h>
 
 TEST(HTTPResponseMessageTest, TestOne) {
 	using namespace blueth;
@@ -12,10 +16,10 @@ TEST(HTTPResponseMessageTest, TestOne) {
 		    http::HTTPResponseMessage::create();
 		std::string expected =
 		    "HTTP/1.1 301 Moved Permanently\r\n"
-		    "Cache-Control: public, max-age=2592000\r\n"
+		    "Location: https://fb.com/endpoint.php\r\n"
 		    "Content-Type: text/html; charset=UTF-8\r\n"
-		    "Powered-By: Proxygen/FB-CXX\r\n"
-		    "Location: https://fb.com/endpoint.php\r\n\r\n"
+		    "Cache-Control: public, max-age=2592000\r\n"
+		    "Powered-By: Proxygen/FB-CXX\r\n\r\n"
 		    "<html>it's a 301 response</html>";
 		message->setHTTPVersion(http::HTTPVersion::HTTP1_1);
 		message->pushBackResponseCode('3');
@@ -58,3 +62,71 @@ TEST(HTTPResponseMessageTest, TestOne) {
 		ASSERT_EQ(message->buildRawMessage(), expected);
 	}
 }
+
+TEST(HTTPResponseMessageTest, SerializeInPlace) {
+	using namespace blueth;
+	std::unique_ptr<http::HTTPResponseMessage> message =
+	    http::HTTPResponseMessage::create();
+	message->setResponseCode(http::HTTPResponseCodes::TemporaryRedirect);
+	message->addHeader("Location", "/login");
+	message->addHeader("Content-Length", "5");
+	message->pushBackRawBody("moved");
+	std::string expected_head = "HTTP/1.1 307 Temporary Redirect\r\n"
+				    "Location: /login\r\n"
+				    "Content-Length: 5\r\n\r\n";
+	ASSERT_EQ(message->rawHeadSize(), expected_head.size());
+	ASSERT_EQ(message->buildRawMessage(), expected_head + "moved");
+	{ // Appended after the bytes already in the buffer
+		std::unique_ptr<io::IOBuffer<char>> io_buffer =
+		    io::IOBuffer<char>::create(8);
+		io_buffer->appendRawBytes("prev", 4);
+		message->serializeTo(*io_buffer);
+		ASSERT_EQ((std::string{io_buffer->getStartOffsetPointer(),
+				       io_buffer->getDataSize()}),
+			  "prev" + expected_head + "moved");
+	}
+	{ // The body segment points at the message body
+		std::unique_ptr<io::IOBuffer<char>> head_buffer =
+		    io::IOBuffer<char>::create(256);
+		::iovec iov[2];
+		ASSERT_EQ(message->fillIovec(*head_buffer, iov), 2);
+		ASSERT_EQ((std::string{static_cast<char *>(iov[0].iov_base),
+				       iov[0].iov_len}),
+			  expected_head);
+		ASSERT_EQ(iov[1].iov_base,
+			  message->constGetRawBody().getStartOffsetPointer());
+		ASSERT_EQ(iov[1].iov_len, 5);
+		message->flushBody();
+		ASSERT_EQ(message->fillIovec(*head_buffer, iov), 1);
+	}
+	{ // A code without a reason phrase gets the one of its class
+		message->flushBody();
+		message->setResponseCode(
+		    static_cast<http::HTTPResponseCodes>(418));
+		ASSERT_EQ(message->buildRawMessage().substr(0, 27),
+			  "HTTP/1.1 418 Client Error\r\n");
+		message->setResponseCode(
+		    static_cast<http::HTTPResponseCodes>(308));
+		message->setHTTPVersion(http::HTTPVersion::HTTP1_0);
+		ASSERT_EQ(message->buildRawMessage().substr(0, 26),
+			  "HTTP/1.0 308 Redirection\r\n");
+		message->setHTTPVersion(http::HTTPVersion::HTTP1_1);
+	}
+	{ // A code out of 100-599 isn't serialized
+		message->setResponseCode(
+		    static_cast<http::HTTPResponseCodes>(99));
+		ASSERT_EQ(message->rawHeadSize(), 0);
+		ASSERT_EQ(message->buildRawMessage(), "");
+		std::unique_ptr<io::IOBuffer<char>> io_buffer =
+		    io::IOBuffer<char>::create(64);
+		ASSERT_THROW(message->serializeTo(*io_buffer),
+			     std::invalid_argument);
+		ASSERT_EQ(io_buffer->getDataSize(), 0);
+		ASSERT_EQ(http::status_line_from_response_code(
+			      http::HTTPResponseCodes::NotFound),
+			  "HTTP/1.1 404 Not Found\r\n");
+		ASSERT_EQ(http::string_from_response_code(
+			      http::HTTPResponseCodes::NotFound),
+			  "Not Found");
+	}
+}
@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+#include <http/HTTPCommonResponseMessageTemplate.hpp>
+#include <io/IOBuffer.hpp>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+using namespace blueth;
+
+TEST(HttpResponseTemplate, DateClock) {
+	char date[http::HTTPDateClock::date_size];
+	http::format_imf_fixdate(784111777, date);
+	ASSERT_EQ(std::string(date, sizeof(date)),
+		  "Sun, 06 Nov 1994 08:49:37 GMT");
+	http::HTTPDateClock date_clock;
+	ASSERT_TRUE(date_clock.tick(1626775200));
+	ASSERT_EQ(date_clock.getDate(), "Tue, 20 Jul 2021 10:00:00 GMT");
+	// Rendered only once per second
+	ASSERT_FALSE(date_clock.tick(1626775200));
+	ASSERT_TRUE(date_clock.tick(1626775201));
+	ASSERT_EQ(date_clock.getDate(), "Tue, 20 Jul 2021 10:00:01 GMT");
+}
+
+TEST(HttpResponseTemplate, PatchedDate) {
+	http::HTTPDateClock date_clock;
+	date_clock.tick(1626775200);
+	http::HTTPResponseTemplate not_found = http::make_response_template(
+	    http::TemplateType::NotFound, "<html>Not Found</html>");
+	std::string expected = "HTTP/1.1 404 Not Found\r\n"
+			       "Content-Type: text/html\r\n"
+			       "Content-Length: 22\r\n"
+			       "Date: Tue, 20 Jul 2021 10:00:00 GMT\r\n\r\n"
+			       "<html>Not Found</html>";
+	ASSERT_EQ(not_found.getBytes(date_clock), expected);
+	const char *template_bytes = not_found.getBytes().data();
+	date_clock.tick(1626775261);
+	std::unique_ptr<io::IOBuffer<char>> io_buffer =
+	    io::IOBuffer<char>::create(16);
+	not_found.appendTo(*io_buffer, date_clock);
+	expected.replace(expected.find("10:00:00"), 8, "10:01:01");
+	ASSERT_EQ((std::string{io_buffer->getStartOffsetPointer(),
+			       io_buffer->getDataSize()}),
+		  expected);
+	// Patched in place
+	ASSERT_EQ(not_found.getBytes().data(), template_bytes);
+	{
+		http::HTTPResponseTemplate unauthorized =
+		    http::make_response_template(http::TemplateType::Unauthorized,
+						 "Basic realm=\"blueth\"");
+		ASSERT_EQ(unauthorized.getBytes(date_clock),
+			  "HTTP/1.1 401 Unauthorized\r\n"
+			  "Content-Type: text/html\r\n"
+			  "Content-Length: 0\r\n"
+			  "WWW-Authenticate: Basic realm=\"blueth\"\r\n"
+			  "Date: Tue, 20 Jul 2021 10:01:01 GMT\r\n\r\n");
+		http::HTTPResponseMessage invalid_message;
+		invalid_message.setResponseCode(
+		    static_cast<http::HTTPResponseCodes>(99));
+		ASSERT_THROW(http::HTTPResponseTemplate{invalid_message},
+			     std::invalid_argument);
+	}
+}
@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+#include <http/HTTPRouter.hpp>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+using namespace blueth;
+
+namespace {
+
+using TestRouter = http::HTTPRouter<std::string>;
+
+// Name of the matched route, "" if there is none
+std::string match(const TestRouter &router, std::string_view path,
+		  http::HTTPRouteParams &params,
+		  http::HTTPRequestType request_type = http::HTTPRequestType::Get) {
+	const std::string *route = router.findRoute(request_type, path, params);
+	return route ? *route : "";
+}
+
+} // namespace
+
+TEST(HttpRouter, StaticRoutes) {
+	TestRouter router;
+	for (std::string_view pattern :
+	     {"/", "/users", "/usage", "/user", "/users/new", "/us"})
+		router.addRoute(http::HTTPRequestType::Get, pattern,
+				std::string{pattern});
+	router.addRoute(http::HTTPRequestType::Post, "/users", "post users");
+	ASSERT_EQ(router.routeCount(), 7);
+
+	http::HTTPRouteParams params;
+	for (std::string_view path :
+	     {"/", "/users", "/usage", "/user", "/users/new", "/us"}) {
+		ASSERT_EQ(match(router, path, params), path);
+		ASSERT_TRUE(params.empty());
+	}
+	ASSERT_EQ(match(router, "/users", params, http::HTTPRequestType::Post),
+		  "post users");
+	ASSERT_EQ(match(router, "/u", params), "");
+	ASSERT_EQ(match(router, "/users/", params), "");
+	ASSERT_EQ(match(router, "/userss", params), "");
+	ASSERT_EQ(match(router, "/usage", params, http::HTTPRequestType::Delete),
+		  "");
+
+	// The handler of an identical pattern is replaced
+	router.addRoute(http::HTTPRequestType::Get, "/users", "users v2");
+	ASSERT_EQ(match(router, "/users", params), "users v2");
+	ASSERT_EQ(router.routeCount(), 7);
+}
+
+TEST(HttpRouter, Captures) {
+	TestRouter router;
+	router.addRoute(http::HTTPRequestType::Get, "/users/:id", "user");
+	router.addRoute(http::HTTPRequestType::Get, "/users/new", "new user");
+	router.addRoute(http::HTTPRequestType::Get, "/users/:id/posts/:post_id",
+			"post");
+	router.addRoute(http::HTTPRequestType::Get, "/users/:id/files/*path",
+			"file");
+	router.addRoute(http::HTTPRequestType::Get, "/static/*", "static");
+
+	http::HTTPRouteParams params;
+	std::string path = "/users/42";
+	ASSERT_EQ(match(router, path, params), "user");
+	ASSERT_EQ(params.size(), 1);
+	ASSERT_EQ(params.getValue("id"), "42");
+	// A view into the looked up path
+	ASSERT_EQ(params[0].value.data(), path.data() + 7);
+
+	// The static edge wins over the parameter
+	ASSERT_EQ(match(router, "/users/new", params), "new user");
+	ASSERT_TRUE(params.empty());
+	ASSERT_EQ(match(router, "/users/newer", params), "user");
+	ASSERT_EQ(params.getValue("id"), "newer");
+
+	// Backtracking from the static "new" to the parameter
+	ASSERT_EQ(match(router, "/users/new/posts/7", params), "post");
+	ASSERT_EQ(params.size(), 2);
+	ASSERT_EQ(params.getValue("id"), "new");
+	ASSERT_EQ(params.getValue("post_id"), "7");
+
+	ASSERT_EQ(match(router, "/users/9/files/docs/a%20b.txt", params), "file");
+	ASSERT_EQ(params.getValue("id"), "9");
+	ASSERT_EQ(params.getValue("path"), "docs/a%20b.txt");
+	ASSERT_EQ(match(router, "/static/", params), "static");
+	ASSERT_EQ(params.getValue(""), "");
+	ASSERT_EQ(match(router, "/static/css/site.css", params), "static");
+	ASSERT_EQ(params.getValue(""), "css/site.css");
+
+	// A parameter doesn't capture an empty segment
+	ASSERT_EQ(match(router, "/users/", params), "");
+	ASSERT_EQ(match(router, "/users//posts/7", params), "");
+	ASSERT_EQ(match(router, "/users/9/posts/7/", params), "");
+	ASSERT_FALSE(params.getValue("id").has_value());
+}
+
+TEST(HttpRouter, MalformedPatterns) {
+	TestRouter router;
+	router.addRoute(http::HTTPRequestType::Get, "/users/:id", "user");
+	ASSERT_THROW(router.addRoute(http::HTTPRequestType::Get, "users", ""),
+		     std::invalid_argument);
+	ASSERT_THROW(router.addRoute(http::HTTPRequestType::Get, "/files/*a/b", ""),
+		     std::invalid_argument);
+	ASSERT_THROW(router.addRoute(http::HTTPRequestType::Get, "/users/:", ""),
+		     std::invalid_argument);
+	ASSERT_THROW(router.addRoute(http::HTTPRequestType::Get,
+				     "/users/:name/posts", ""),
+		     std::invalid_argument);
+	ASSERT_THROW(router.addRoute(http::HTTPRequestType::Unsupported, "/", ""),
+		     std::invalid_argument);
+	ASSERT_THROW(router.addRoute(http::HTTPRequestType::Get,
+				     "/:a/:b/:c/:d/:e/:f/:g/:h/:i", ""),
+		     std::invalid_argument);
+}
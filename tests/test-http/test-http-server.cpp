@@ -0,0 +1,384 @@
+#include "HTTPMessage.hpp"
+#include <HTTPConstants.hpp>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <http/HTTPParserStateMachineResponse.hpp>
+#include <http/HTTPServer.hpp>
+#include <io/IOBuffer.hpp>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include <zlib.h>
+
+using namespace blueth;
+
+namespace {
+
+const char *server_address = "127.0.0.1";
+
+// A page large and repetitive enough to be compressed
+std::string page_body() {
+	std::string body = "<html><body>";
+	for (int row{}; row < 100; row++)
+		body += "<p>Row " + std::to_string(row) + " of the table</p>";
+	return body + "</body></html>";
+}
+
+/**
+ * Server on a thread of its own, stopped at the end of the test
+ */
+class TestServer {
+      public:
+	TestServer(std::uint16_t server_port,
+		   http::HTTPServerOptions server_options = {})
+	    : server_{http::HTTPServer::create(server_address, server_port,
+					       server_options)} {
+		server_->addHandler(
+		    http::HTTPRequestType::Get, "/hello",
+		    [](const http::HTTPRequestMessage &,
+		       http::HTTPResponseMessage &response) {
+			    response.addHeader("Content-Type", "text/plain");
+			    response.pushBackRawBody("hello");
+		    });
+		server_->addHandler(
+		    http::HTTPRequestType::Get, "/page",
+		    [](const http::HTTPRequestMessage &,
+		       http::HTTPResponseMessage &response) {
+			    response.addHeader("Content-Type",
+					       "text/html; charset=utf-8");
+			    response.pushBackRawBody(page_body());
+		    });
+		server_->addHandler(
+		    http::HTTPRequestType::Get, "/users/:id",
+		    [](const http::HTTPRequestMessage &,
+		       const http::HTTPRouteParams &route_params,
+		       http::HTTPResponseMessage &response) {
+			    response.pushBackRawBody(
+				std::string{*route_params.getValue("id")});
+		    });
+		server_->addHandler(http::HTTPRequestType::Get, "/echo",
+				    [](const http::HTTPRequestMessage &request,
+				       http::HTTPResponseMessage &response) {
+					    response.pushBackRawBody(std::string{
+						request.getTargetResource()});
+				    });
+		server_thread_ = std::thread{[this]() { server_->start(); }};
+	}
+	~TestServer() {
+		server_->stop();
+		server_thread_.join();
+	}
+
+      private:
+	std::unique_ptr<http::HTTPServer> server_;
+	std::thread server_thread_;
+};
+
+int connect_client(std::uint16_t server_port) {
+	int client_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+	timeval receive_timeout{5, 0};
+	::setsockopt(client_fd, SOL_SOCKET, SO_RCVTIMEO, &receive_timeout,
+		     sizeof(receive_timeout));
+	sockaddr_in server_sockaddr{};
+	server_sockaddr.sin_family = AF_INET;
+	server_sockaddr.sin_port = htons(server_port);
+	::inet_pton(AF_INET, server_address, &server_sockaddr.sin_addr);
+	EXPECT_EQ(::connect(client_fd,
+			    reinterpret_cast<sockaddr *>(&server_sockaddr),
+			    sizeof(server_sockaddr)),
+		  0);
+	return client_fd;
+}
+
+void send_request(int client_fd, const std::string &raw_request) {
+	ASSERT_EQ(::send(client_fd, raw_request.data(), raw_request.size(), 0),
+		  static_cast<ssize_t>(raw_request.size()));
+}
+
+/**
+ * Read response_count responses, fewer if the server closes the connection
+ */
+std::vector<std::unique_ptr<http::HTTPResponseMessage>>
+read_responses(int client_fd, std::size_t response_count) {
+	std::vector<std::unique_ptr<http::HTTPResponseMessage>> returner;
+	std::unique_ptr<io::IOBuffer<char>> io_buffer =
+	    io::IOBuffer<char>::create(4096);
+	http::ResponseParserState current_state =
+	    http::ResponseParserState::ResponseProtocolH;
+	std::unique_ptr<http::HTTPResponseMessage> http_message =
+	    http::HTTPResponseMessage::create();
+	while (returner.size() < response_count) {
+		io_buffer->clear();
+		ssize_t recv_ret = ::recv(client_fd, io_buffer->getBuffer(),
+					  io_buffer->getCapacity(), 0);
+		if (recv_ret <= 0) break;
+		io_buffer->modifyEndOffset(recv_ret);
+		while (io_buffer->getDataSize()) {
+			std::size_t consumed_bytes{};
+			http_message = http::ParseHTTP1_1ResponseMessage(
+			    io_buffer, current_state, std::move(http_message),
+			    consumed_bytes);
+			io_buffer->modifyStartOffset(consumed_bytes);
+			if (current_state != http::ResponseParserState::ParsingDone)
+				break;
+			returner.push_back(std::move(http_message));
+			http_message = http::HTTPResponseMessage::create();
+			current_state = http::ResponseParserState::ResponseProtocolH;
+		}
+	}
+	return returner;
+}
+
+// The server closed the connection(a reset when it drops our unread bytes)
+bool read_end_of_stream(int client_fd) {
+	char byte;
+	ssize_t recv_ret = ::recv(client_fd, &byte, 1, 0);
+	return recv_ret == 0 || (recv_ret < 0 && errno == ECONNRESET);
+}
+
+std::string body_string(const http::HTTPResponseMessage &http_message) {
+	return std::string{http_message.constGetRawBody().getStartOffsetPointer(),
+			   http_message.constGetRawBody().getDataSize()};
+}
+
+std::string gunzip(const std::string &compressed) {
+	::z_stream stream{};
+	inflateInit2(&stream, 16 + 15);
+	std::string decompressed(64 * 1024, '\0');
+	stream.next_in =
+	    reinterpret_cast<Bytef *>(const_cast<char *>(compressed.data()));
+	stream.avail_in = static_cast<uInt>(compressed.size());
+	stream.next_out = reinterpret_cast<Bytef *>(decompressed.data());
+	stream.avail_out = static_cast<uInt>(decompressed.size());
+	int inflate_ret = ::inflate(&stream, Z_FINISH);
+	decompressed.resize(inflate_ret == Z_STREAM_END ? stream.total_out : 0);
+	::inflateEnd(&stream);
+	return decompressed;
+}
+
+} // namespace
+
+TEST(HttpServer, KeepAlive) {
+	TestServer test_server{9191};
+	int client_fd = connect_client(9191);
+	for (int request{}; request < 2; request++) {
+		send_request(client_fd,
+			     "GET /hello HTTP/1.1\r\nHost: localhost\r\n\r\n");
+		std::vector<std::unique_ptr<http::HTTPResponseMessage>> responses =
+		    read_responses(client_fd, 1);
+		ASSERT_EQ(responses.size(), 1);
+		ASSERT_EQ(responses[0]->getResponseCode(), http::HTTPResponseCodes::Ok);
+		ASSERT_EQ(body_string(*responses[0]), "hello");
+		ASSERT_EQ(responses[0]->getHeaderValue("Content-Length").value(), "5");
+		ASSERT_FALSE(responses[0]->getHeaderValue("Connection").has_value());
+		ASSERT_TRUE(responses[0]->getHeaderValue("Date").has_value());
+	}
+	{ // Path parameter
+		send_request(client_fd,
+			     "GET /users/42?fields=name HTTP/1.1\r\nHost: localhost\r\n\r\n");
+		std::vector<std::unique_ptr<http::HTTPResponseMessage>> responses =
+		    read_responses(client_fd, 1);
+		ASSERT_EQ(responses.size(), 1);
+		ASSERT_EQ(body_string(*responses[0]), "42");
+	}
+	{ // HEAD falls back to the GET handler, without the body
+		send_request(client_fd,
+			     "HEAD /hello HTTP/1.1\r\nHost: localhost\r\n\r\n");
+		std::string raw_response;
+		char recv_buffer[1024];
+		while (raw_response.find("\r\n\r\n") == std::string::npos) {
+			ssize_t recv_ret =
+			    ::recv(client_fd, recv_buffer, sizeof(recv_buffer), 0);
+			ASSERT_GT(recv_ret, 0);
+			raw_response.append(recv_buffer, recv_ret);
+		}
+		ASSERT_TRUE(raw_response.starts_with("HTTP/1.1 200 OK\r\n"));
+		ASSERT_NE(raw_response.find("Content-Length: 5\r\n"),
+			  std::string::npos);
+		ASSERT_TRUE(raw_response.ends_with("\r\n\r\n"));
+	}
+	{ // Unknown path
+		send_request(client_fd,
+			     "GET /missing HTTP/1.1\r\nHost: localhost\r\n\r\n");
+		std::vector<std::unique_ptr<http::HTTPResponseMessage>> responses =
+		    read_responses(client_fd, 1);
+		ASSERT_EQ(responses.size(), 1);
+		ASSERT_EQ(responses[0]->getResponseCode(),
+			  http::HTTPResponseCodes::NotFound);
+		ASSERT_EQ(responses[0]->getHeaderValue("Content-Length").value(), "0");
+		// The pre-rendered 404 and the handler responses are dated
+		ASSERT_EQ(responses[0]->getHeaderValue("Date").value().size(), 29);
+	}
+	::close(client_fd);
+}
+
+TEST(HttpServer, Pipelining) {
+	TestServer test_server{9192};
+	int client_fd = connect_client(9192);
+	send_request(client_fd, "GET /echo?request=1 HTTP/1.1\r\nHost: localhost\r\n\r\n"
+				"GET /echo?request=2 HTTP/1.1\r\nHost: localhost\r\n\r\n"
+				"GET /echo?request=3 HTTP/1.1\r\nHost: localhost\r\n\r\n");
+	std::vector<std::unique_ptr<http::HTTPResponseMessage>> responses =
+	    read_responses(client_fd, 3);
+	ASSERT_EQ(responses.size(), 3);
+	ASSERT_EQ(body_string(*responses[0]), "/echo?request=1");
+	ASSERT_EQ(body_string(*responses[1]), "/echo?request=2");
+	ASSERT_EQ(body_string(*responses[2]), "/echo?request=3");
+	::close(client_fd);
+}
+
+TEST(HttpServer, ConnectionClose) {
+	TestServer test_server{9193};
+	{ // Closed on the client's request, the pipelined request is not served
+		int client_fd = connect_client(9193);
+		send_request(client_fd, "GET /hello HTTP/1.1\r\nHost: localhost\r\n"
+					"Connection: close\r\n\r\n"
+					"GET /hello HTTP/1.1\r\nHost: localhost\r\n\r\n");
+		std::vector<std::unique_ptr<http::HTTPResponseMessage>> responses =
+		    read_responses(client_fd, 2);
+		ASSERT_EQ(responses.size(), 1);
+		ASSERT_EQ(body_string(*responses[0]), "hello");
+		ASSERT_EQ(responses[0]->getHeaderValue("Connection").value(), "close");
+		ASSERT_TRUE(read_end_of_stream(client_fd));
+		::close(client_fd);
+	}
+	{ // An HTTP/1.0 connection is closed after the response by default
+		int client_fd = connect_client(9193);
+		send_request(client_fd, "GET /hello HTTP/1.0\r\n\r\n");
+		std::vector<std::unique_ptr<http::HTTPResponseMessage>> responses =
+		    read_responses(client_fd, 1);
+		ASSERT_EQ(responses.size(), 1);
+		ASSERT_EQ(body_string(*responses[0]), "hello");
+		ASSERT_EQ(responses[0]->getHeaderValue("Connection").value(), "close");
+		ASSERT_TRUE(read_end_of_stream(client_fd));
+		::close(client_fd);
+	}
+	{ // Unless it asks for keep-alive
+		int client_fd = connect_client(9193);
+		for (int request{}; request < 2; request++) {
+			send_request(client_fd, "GET /hello HTTP/1.0\r\n"
+						"Connection: Keep-Alive\r\n\r\n");
+			std::vector<std::unique_ptr<http::HTTPResponseMessage>>
+			    responses = read_responses(client_fd, 1);
+			ASSERT_EQ(responses.size(), 1);
+			ASSERT_EQ(body_string(*responses[0]), "hello");
+			ASSERT_EQ(responses[0]->getHeaderValue("Connection").value(),
+				  "keep-alive");
+		}
+		::close(client_fd);
+	}
+	{ // Malformed request
+		int client_fd = connect_client(9193);
+		send_request(client_fd, "GET /hello HTTP/1.1\r\nHost localhost\r\n\r\n");
+		std::vector<std::unique_ptr<http::HTTPResponseMessage>> responses =
+		    read_responses(client_fd, 1);
+		ASSERT_EQ(responses.size(), 1);
+		ASSERT_EQ(responses[0]->getResponseCode(),
+			  http::HTTPResponseCodes::BadRequest);
+		ASSERT_EQ(responses[0]->getHeaderValue("Connection").value(), "close");
+		ASSERT_TRUE(read_end_of_stream(client_fd));
+		::close(client_fd);
+	}
+	{ // An unknown HTTP-version or method
+		using http::HTTPResponseCodes;
+		for (auto [request, response_code] :
+		     {std::pair{"GET /hello HTTP/2.0\r\n\r\n",
+				HTTPResponseCodes::HttpVersionNotSupported},
+		      std::pair{"BREW /hello HTTP/1.1\r\n\r\n",
+				HTTPResponseCodes::NotImplemented}}) {
+			int client_fd = connect_client(9193);
+			send_request(client_fd, request);
+			std::vector<std::unique_ptr<http::HTTPResponseMessage>>
+			    responses = read_responses(client_fd, 1);
+			ASSERT_EQ(responses.size(), 1);
+			ASSERT_EQ(responses[0]->getResponseCode(),
+				  response_code);
+			ASSERT_TRUE(read_end_of_stream(client_fd));
+			::close(client_fd);
+		}
+	}
+}
+
+TEST(HttpServer, Timeouts) {
+	http::HTTPServerOptions server_options;
+	server_options.idle_timeout = std::chrono::milliseconds{300};
+	server_options.header_read_timeout = std::chrono::milliseconds{200};
+	server_options.timer_interval = std::chrono::milliseconds{50};
+	TestServer test_server{9194, server_options};
+	{ // Idle connection
+		int client_fd = connect_client(9194);
+		std::chrono::steady_clock::time_point start =
+		    std::chrono::steady_clock::now();
+		ASSERT_TRUE(read_end_of_stream(client_fd));
+		ASSERT_GE(std::chrono::steady_clock::now() - start,
+			  std::chrono::milliseconds{300});
+		::close(client_fd);
+	}
+	{ // A request head trickling in, a byte at a time
+		int client_fd = connect_client(9194);
+		std::string raw_request = "GET /hello HTTP/1.1\r\nHost: localhost\r\n";
+		bool closed{false};
+		for (char byte : raw_request) {
+			if (::send(client_fd, &byte, 1, MSG_NOSIGNAL) != 1) {
+				closed = true;
+				break;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds{20});
+		}
+		ASSERT_TRUE(closed || read_end_of_stream(client_fd));
+		::close(client_fd);
+	}
+}
+
+TEST(HttpServer, Compression) {
+	http::HTTPServerOptions server_options;
+	server_options.compression = http::HTTPCompressionPolicy{};
+	TestServer test_server{9195, server_options};
+	int client_fd = connect_client(9195);
+	// A body is cached on its second miss, the third response is a hit
+	for (int request{}; request < 3; request++) {
+		send_request(client_fd, "GET /page HTTP/1.1\r\nHost: localhost\r\n"
+					"Accept-Encoding: deflate;q=0.5, gzip\r\n\r\n");
+		std::vector<std::unique_ptr<http::HTTPResponseMessage>> responses =
+		    read_responses(client_fd, 1);
+		ASSERT_EQ(responses.size(), 1);
+		ASSERT_EQ(responses[0]->getHeaderValue("Content-Encoding").value(),
+			  "gzip");
+		ASSERT_EQ(responses[0]->getHeaderValue("Vary").value(),
+			  "Accept-Encoding");
+		std::string compressed = body_string(*responses[0]);
+		ASSERT_LT(compressed.size(), page_body().size());
+		ASSERT_EQ(responses[0]->getHeaderValue("Content-Length").value(),
+			  std::to_string(compressed.size()));
+		ASSERT_EQ(gunzip(compressed), page_body());
+	}
+	{ // Not accepted
+		send_request(client_fd, "GET /page HTTP/1.1\r\nHost: localhost\r\n"
+					"Accept-Encoding: gzip;q=0, br\r\n\r\n");
+		std::vector<std::unique_ptr<http::HTTPResponseMessage>> responses =
+		    read_responses(client_fd, 1);
+		ASSERT_EQ(responses.size(), 1);
+		ASSERT_FALSE(
+		    responses[0]->getHeaderValue("Content-Encoding").has_value());
+		ASSERT_EQ(responses[0]->getHeaderValue("Vary").value(),
+			  "Accept-Encoding");
+		ASSERT_EQ(body_string(*responses[0]), page_body());
+	}
+	{ // Below the minimum size
+		send_request(client_fd, "GET /hello HTTP/1.1\r\nHost: localhost\r\n"
+					"Accept-Encoding: gzip\r\n\r\n");
+		std::vector<std::unique_ptr<http::HTTPResponseMessage>> responses =
+		    read_responses(client_fd, 1);
+		ASSERT_EQ(responses.size(), 1);
+		ASSERT_FALSE(
+		    responses[0]->getHeaderValue("Content-Encoding").has_value());
+		ASSERT_EQ(body_string(*responses[0]), "hello");
+	}
+	::close(client_fd);
+}
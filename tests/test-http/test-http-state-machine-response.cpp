@@ -42,10 +42,10 @@ TEST(HttpStateMachineResponse, TestOne) {
 			    http::HTTPResponseCodes::MovedPermanently);
 		ASSERT_TRUE(parsed_response->getHTTPVersion() ==
 			    http::HTTPVersion::HTTP1_1);
-		ASSERT_EQ(parsed_response->constGetRawBody()->getDataSize(),
+		ASSERT_EQ(parsed_response->constGetRawBody().getDataSize(),
 			  msg_body.size());
 		ASSERT_TRUE(std::memcmp(parsed_response->constGetRawBody()
-					    ->getStartOffsetPointer(),
+					    .getStartOffsetPointer(),
 					msg_body.c_str(),
 					msg_body.size()) == 0);
 		ASSERT_EQ(
@@ -73,7 +73,7 @@ TEST(HttpStateMachineResponse, TestOne) {
 						      std::move(http_message));
 		ASSERT_TRUE(current_state ==
 			    http::ResponseParserState::ProtocolError);
-		ASSERT_TRUE(parsed_response->constGetRawBody()->getDataSize() ==
+		ASSERT_TRUE(parsed_response->constGetRawBody().getDataSize() ==
 			    0);
 	}
 	{ // Invalid 200 OK message
@@ -95,7 +95,7 @@ TEST(HttpStateMachineResponse, TestOne) {
 						      std::move(http_message));
 		ASSERT_TRUE(current_state ==
 			    http::ResponseParserState::ProtocolError);
-		ASSERT_TRUE(parsed_response->constGetRawBody()->getDataSize() ==
+		ASSERT_TRUE(parsed_response->constGetRawBody().getDataSize() ==
 			    0);
 	}
 	{ // Valid 200 OK message
@@ -121,12 +121,243 @@ TEST(HttpStateMachineResponse, TestOne) {
 		ASSERT_FALSE(current_state ==
 			     http::ResponseParserState::ProtocolError);
 		ASSERT_FALSE(
-		    parsed_response->constGetRawBody()->getDataSize() == 0);
+		    parsed_response->constGetRawBody().getDataSize() == 0);
 		ASSERT_TRUE(current_state ==
 			    http::ResponseParserState::ParsingDone);
-		ASSERT_TRUE(parsed_response->constGetRawBody()->getDataSize() ==
+		ASSERT_TRUE(parsed_response->constGetRawBody().getDataSize() ==
 			    msg_body.size());
 		ASSERT_TRUE(parsed_response->getResponseCode() ==
 			    http::HTTPResponseCodes::Ok);
 	}
 }
+
+TEST(HttpStateMachineResponse, StreamingBody) {
+	std::unique_ptr<io::IOBuffer<char>> io_buffer =
+	    io::IOBuffer<char>::create(2048);
+	{ // Content-Length body across reads, streamed into the sink
+		std::string sample_response = "HTTP/1.1 200 OK\r\n"
+					      "Content-Length: 11\r\n\r\n"
+					      "hello world"
+					      "HTTP/1.1 204 No Content\r\n\r\n";
+		http::ResponseParserState current_state =
+		    http::ResponseParserState::ResponseProtocolH;
+		std::unique_ptr<http::HTTPResponseMessage> http_message =
+		    http::HTTPResponseMessage::create();
+		std::string streamed_body;
+		auto body_sink = [&streamed_body](const char *data,
+						  std::size_t size) {
+			streamed_body.append(data, size);
+		};
+		std::size_t consumed_bytes{};
+		for (std::size_t offset{}; offset < sample_response.size();
+		     offset += 7) {
+			io_buffer->appendRawBytes(
+			    sample_response.c_str() + offset,
+			    std::min<std::size_t>(
+				7, sample_response.size() - offset));
+			http_message = http::ParseHTTP1_1ResponseMessage(
+			    io_buffer, current_state, std::move(http_message),
+			    consumed_bytes, http::HTTPParserLimits{}, body_sink);
+			io_buffer->modifyStartOffset(consumed_bytes);
+			if (current_state ==
+			    http::ResponseParserState::ParsingDone)
+				break;
+		}
+		ASSERT_TRUE(current_state ==
+			    http::ResponseParserState::ParsingDone);
+		ASSERT_EQ(streamed_body, "hello world");
+		// The body is not stored in the message
+		ASSERT_EQ(http_message->constGetRawBody().getDataSize(), 0);
+		// The start of the next response is left in the buffer
+		ASSERT_EQ(std::string(io_buffer->getStartOffsetPointer(),
+				      io_buffer->getDataSize()),
+			  "HTTP/1");
+		io_buffer->clear();
+	}
+	{ // Responses without a body, whatever the framing headers say
+		std::string sample_response = "HTTP/1.1 304 Not Modified\r\n"
+					      "Content-Length: 100\r\n\r\n";
+		io_buffer->appendRawBytes(sample_response.c_str(),
+					  sample_response.size());
+		http::ResponseParserState current_state =
+		    http::ResponseParserState::ResponseProtocolH;
+		std::size_t consumed_bytes{};
+		http::ParseHTTP1_1ResponseMessage(
+		    io_buffer, current_state, http::HTTPResponseMessage::create(),
+		    consumed_bytes);
+		ASSERT_TRUE(current_state ==
+			    http::ResponseParserState::ParsingDone);
+		ASSERT_EQ(consumed_bytes, sample_response.size());
+		io_buffer->clear();
+
+		sample_response = "HTTP/1.1 200 Connection established\r\n\r\n"
+				  "tunneled bytes";
+		io_buffer->appendRawBytes(sample_response.c_str(),
+					  sample_response.size());
+		current_state = http::ResponseParserState::ResponseProtocolH;
+		std::unique_ptr<http::HTTPResponseMessage> http_message =
+		    http::HTTPResponseMessage::create();
+		http_message->setRequestType(http::HTTPRequestType::Connect);
+		http_message = http::ParseHTTP1_1ResponseMessage(
+		    io_buffer, current_state, std::move(http_message),
+		    consumed_bytes);
+		ASSERT_TRUE(current_state ==
+			    http::ResponseParserState::ParsingDone);
+		ASSERT_EQ(consumed_bytes, sample_response.find("tunneled"));
+		ASSERT_EQ(http_message->constGetRawBody().getDataSize(), 0);
+		io_buffer->clear();
+	}
+	{ // Body delimited by the end of the connection
+		std::string sample_response = "HTTP/1.1 200 OK\r\n"
+					      "Content-Type: text/plain\r\n\r\n"
+					      "until the close";
+		io_buffer->appendRawBytes(sample_response.c_str(),
+					  sample_response.size());
+		http::ResponseParserState current_state =
+		    http::ResponseParserState::ResponseProtocolH;
+		std::size_t consumed_bytes{};
+		std::unique_ptr<http::HTTPResponseMessage> http_message =
+		    http::ParseHTTP1_1ResponseMessage(
+			io_buffer, current_state,
+			http::HTTPResponseMessage::create(), consumed_bytes);
+		ASSERT_TRUE(
+		    current_state ==
+		    http::ResponseParserState::ResponseMessageBodyUntilClose);
+		ASSERT_EQ(consumed_bytes, sample_response.size());
+		http::ParseHTTP1_1ResponseEndOfStream(current_state);
+		ASSERT_TRUE(current_state ==
+			    http::ResponseParserState::ParsingDone);
+		ASSERT_EQ(std::string(http_message->constGetRawBody().cbegin(),
+				      http_message->constGetRawBody().cend()),
+			  "until the close");
+		ASSERT_TRUE(http_message->getHTTPVersion() ==
+			    http::HTTPVersion::HTTP1_1);
+		io_buffer->clear();
+
+		// A proxied HTTP/1.0 response without Content-Length
+		sample_response = "HTTP/1.0 200 OK\r\n"
+				  "Server: upstream\r\n\r\n"
+				  "read until close";
+		io_buffer->appendRawBytes(sample_response.c_str(),
+					  sample_response.size());
+		current_state = http::ResponseParserState::ResponseProtocolH;
+		http_message = http::ParseHTTP1_1ResponseMessage(
+		    io_buffer, current_state,
+		    http::HTTPResponseMessage::create(), consumed_bytes);
+		ASSERT_TRUE(http_message->getHTTPVersion() ==
+			    http::HTTPVersion::HTTP1_0);
+		ASSERT_TRUE(
+		    current_state ==
+		    http::ResponseParserState::ResponseMessageBodyUntilClose);
+		http::ParseHTTP1_1ResponseEndOfStream(current_state);
+		ASSERT_TRUE(current_state ==
+			    http::ResponseParserState::ParsingDone);
+		ASSERT_EQ(std::string(http_message->constGetRawBody().cbegin(),
+				      http_message->constGetRawBody().cend()),
+			  "read until close");
+		io_buffer->clear();
+
+		// A Content-Length body cut short by the close is an error
+		sample_response = "HTTP/1.1 200 OK\r\n"
+				  "Content-Length: 10\r\n\r\n"
+				  "short";
+		io_buffer->appendRawBytes(sample_response.c_str(),
+					  sample_response.size());
+		current_state = http::ResponseParserState::ResponseProtocolH;
+		http::ParseHTTP1_1ResponseMessage(
+		    io_buffer, current_state, http::HTTPResponseMessage::create(),
+		    consumed_bytes);
+		ASSERT_TRUE(current_state ==
+			    http::ResponseParserState::ResponseMessageBody);
+		http::ParseHTTP1_1ResponseEndOfStream(current_state);
+		ASSERT_TRUE(current_state ==
+			    http::ResponseParserState::ProtocolError);
+		io_buffer->clear();
+	}
+	{ // Limits and malformed Content-Length
+		http::HTTPParserLimits parser_limits;
+		parser_limits.max_body_size = 4;
+		std::string sample_response = "HTTP/1.1 200 OK\r\n"
+					      "Content-Length: 5\r\n\r\n"
+					      "hello";
+		io_buffer->appendRawBytes(sample_response.c_str(),
+					  sample_response.size());
+		http::ResponseParserState current_state =
+		    http::ResponseParserState::ResponseProtocolH;
+		std::size_t consumed_bytes{};
+		http::ParseHTTP1_1ResponseMessage(
+		    io_buffer, current_state, http::HTTPResponseMessage::create(),
+		    consumed_bytes, parser_limits);
+		ASSERT_TRUE(current_state ==
+			    http::ResponseParserState::BodyTooLarge);
+		io_buffer->clear();
+
+		sample_response = "HTTP/1.1 200 OK\r\n\r\nhello";
+		io_buffer->appendRawBytes(sample_response.c_str(),
+					  sample_response.size());
+		current_state = http::ResponseParserState::ResponseProtocolH;
+		http::ParseHTTP1_1ResponseMessage(
+		    io_buffer, current_state, http::HTTPResponseMessage::create(),
+		    consumed_bytes, parser_limits);
+		ASSERT_TRUE(current_state ==
+			    http::ResponseParserState::BodyTooLarge);
+		io_buffer->clear();
+
+		parser_limits.max_header_section_size = 16;
+		sample_response = "HTTP/1.1 200 OK\r\nServer: blueth\r\n\r\n";
+		io_buffer->appendRawBytes(sample_response.c_str(),
+					  sample_response.size());
+		current_state = http::ResponseParserState::ResponseProtocolH;
+		http::ParseHTTP1_1ResponseMessage(
+		    io_buffer, current_state, http::HTTPResponseMessage::create(),
+		    consumed_bytes, parser_limits);
+		ASSERT_TRUE(current_state ==
+			    http::ResponseParserState::HeaderSectionTooLarge);
+		io_buffer->clear();
+
+		sample_response = "HTTP/1.1 200 OK\r\n"
+				  "Content-Length: 5x\r\n\r\n";
+		io_buffer->appendRawBytes(sample_response.c_str(),
+					  sample_response.size());
+		current_state = http::ResponseParserState::ResponseProtocolH;
+		http::ParseHTTP1_1ResponseMessage(
+		    io_buffer, current_state, http::HTTPResponseMessage::create(),
+		    consumed_bytes);
+		ASSERT_TRUE(current_state ==
+			    http::ResponseParserState::ProtocolError);
+		io_buffer->clear();
+	}
+	{ // Conflicting framing headers
+		auto parse_response = [&io_buffer](
+					  const std::string &response) {
+			io_buffer->clear();
+			io_buffer->appendRawBytes(response.c_str(),
+						  response.size());
+			http::ResponseParserState current_state =
+			    http::ResponseParserState::ResponseProtocolH;
+			std::size_t consumed_bytes{};
+			http::ParseHTTP1_1ResponseMessage(
+			    io_buffer, current_state,
+			    http::HTTPResponseMessage::create(),
+			    consumed_bytes);
+			return current_state;
+		};
+		ASSERT_TRUE(parse_response("HTTP/1.1 200 OK\r\n"
+					   "Content-Length: 5\r\n"
+					   "Content-Length: 6\r\n\r\nhello") ==
+			    http::ResponseParserState::ProtocolError);
+		ASSERT_TRUE(parse_response("HTTP/1.1 200 OK\r\n"
+					   "Transfer-Encoding: chunked\r\n"
+					   "Content-Length: 5\r\n\r\n") ==
+			    http::ResponseParserState::ProtocolError);
+		ASSERT_TRUE(parse_response("HTTP/1.1 200 OK\r\n"
+					   "Transfer-Encoding: chunked\r\n"
+					   "Transfer-Encoding: gzip\r\n\r\n") ==
+			    http::ResponseParserState::ProtocolError);
+		// A final coding other than chunked is read until the close
+		ASSERT_TRUE(
+		    parse_response("HTTP/1.1 200 OK\r\n"
+				   "Transfer-Encoding: gzip\r\n\r\nhello") ==
+		    http::ResponseParserState::ResponseMessageBodyUntilClose);
+	}
+}
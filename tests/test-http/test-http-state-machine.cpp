@@ -38,6 +38,51 @@ TEST(HttpStateMachine, TestOne) {
 		ASSERT_TRUE(parsed_request->getHeaderValue("Host") ==
 			    "Proxygen.fb.com");
 	}
+	{ // The minor version is recorded
+		for (auto [request_line, http_version] :
+		     {std::pair{"GET / HTTP/1.0\r\n\r\n", http::HTTPVersion::HTTP1_0},
+		      std::pair{"GET / HTTP/1.1\r\n\r\n",
+				http::HTTPVersion::HTTP1_1}}) {
+			std::string sample_request = request_line;
+			std::unique_ptr<io::IOBuffer<char>> io_buffer =
+			    io::IOBuffer<char>::create(2048);
+			io_buffer->appendRawBytes(sample_request.c_str(),
+						  sample_request.size());
+			http::ParserState current_state =
+			    http::ParserState::RequestLineBegin;
+			std::unique_ptr<http::HTTPRequestMessage> parsed_request =
+			    http::ParseHTTP1_1RequestMessage(
+				io_buffer, current_state,
+				http::HTTPRequestMessage::create());
+			ASSERT_TRUE(current_state == http::ParserState::ParsingDone);
+			ASSERT_TRUE(parsed_request->getHTTPVersion() == http_version);
+		}
+	}
+	{ // Only HTTP/1.0 and HTTP/1.1 are accepted
+		for (auto [request_line, parser_state] :
+		     {std::pair{"GET / HTTP/0.9\r\n\r\n",
+				http::ParserState::VersionNotSupported},
+		      std::pair{"GET / HTTP/1.7\r\n\r\n",
+				http::ParserState::VersionNotSupported},
+		      std::pair{"GET / HTTP/2.0\r\n\r\n",
+				http::ParserState::VersionNotSupported},
+		      std::pair{"GET / HTTP/1.10\r\n\r\n",
+				http::ParserState::ProtocolError},
+		      std::pair{"GET / HTTP/1.\r\n\r\n",
+				http::ParserState::ProtocolError}}) {
+			std::string sample_request = request_line;
+			std::unique_ptr<io::IOBuffer<char>> io_buffer =
+			    io::IOBuffer<char>::create(2048);
+			io_buffer->appendRawBytes(sample_request.c_str(),
+						  sample_request.size());
+			http::ParserState current_state =
+			    http::ParserState::RequestLineBegin;
+			http::ParseHTTP1_1RequestMessage(
+			    io_buffer, current_state,
+			    http::HTTPRequestMessage::create());
+			ASSERT_TRUE(current_state == parser_state);
+		}
+	}
 	{ // Invalid HTTP GET Message
 		std::unique_ptr<http::HTTPRequestMessage> http_message =
 		    http::HTTPRequestMessage::create();
@@ -184,3 +229,289 @@ TEST(HttpStateMachine, TestOne) {
 				"Host") == "Proxygen.fb.com");
 	}
 }
+
+TEST(HttpStateMachine, SIMDMatchesScalar) {
+	std::string sample_request =
+	    "GET /search?q=blueth&lang=en-US HTTP/1.1\r\n"
+	    "Host: www.example.com\r\n"
+	    "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:109.0) "
+	    "Gecko/20100101 Firefox/115.0\r\n"
+	    "Accept: text/html,application/xhtml+xml;q=0.9,*/*;q=0.8\r\n"
+	    "Accept-Language:   en-US,en;q=0.5  \r\n"
+	    "Cookie: session_id=4f2a9c81d7e3; theme=dark; tz=UTC\r\n"
+	    "X-Very-Long-Custom-Header-Name-For-The-Vector-Path: yes\r\n\r\n";
+	// Feed the request split at every possible offset, the SIMD and the
+	// scalar parser must agree with each other
+	for (std::size_t split{}; split <= sample_request.size(); split++) {
+		std::unique_ptr<io::IOBuffer<char>> io_buffer =
+		    io::IOBuffer<char>::create(1024);
+		http::ParserState simd_state = http::ParserState::RequestLineBegin;
+		http::ParserState scalar_state =
+		    http::ParserState::RequestLineBegin;
+		std::unique_ptr<http::HTTPRequestMessage> simd_request =
+		    http::HTTPRequestMessage::create();
+		std::unique_ptr<http::HTTPRequestMessage> scalar_request =
+		    http::HTTPRequestMessage::create();
+		io_buffer->appendRawBytes(sample_request.c_str(), split);
+		simd_request = http::ParseHTTP1_1RequestMessage(
+		    io_buffer, simd_state, std::move(simd_request));
+		scalar_request = http::ParseHTTP1_1RequestMessage<false>(
+		    io_buffer, scalar_state, std::move(scalar_request));
+		ASSERT_TRUE(simd_state == scalar_state);
+		io_buffer->clear();
+		io_buffer->appendRawBytes(sample_request.c_str() + split,
+					  sample_request.size() - split);
+		simd_request = http::ParseHTTP1_1RequestMessage(
+		    io_buffer, simd_state, std::move(simd_request));
+		scalar_request = http::ParseHTTP1_1RequestMessage<false>(
+		    io_buffer, scalar_state, std::move(scalar_request));
+		ASSERT_TRUE(simd_state == http::ParserState::ParsingDone);
+		ASSERT_TRUE(scalar_state == http::ParserState::ParsingDone);
+		for (const auto &request : {std::move(simd_request),
+					    std::move(scalar_request)}) {
+			ASSERT_TRUE(request->getTargetResource() ==
+				    "/search?q=blueth&lang=en-US");
+			ASSERT_TRUE(request->constGetHTTPHeaders()
+					->headerCount() == 6);
+			ASSERT_TRUE(request->getHeaderValue("User-Agent") ==
+				    "Mozilla/5.0 (X11; Linux x86_64; rv:109.0) "
+				    "Gecko/20100101 Firefox/115.0");
+			ASSERT_TRUE(request->getHeaderValue(
+					"Accept-Language") == "en-US,en;q=0.5");
+		}
+	}
+	{ // Control characters and separators are rejected by both parsers
+		for (std::string invalid_request :
+		     {"GET /a HTTP/1.1\r\nHost: a\x01b\r\n\r\n",
+		      "GET /a HTTP/1.1\r\nHo(st: ab\r\n\r\n",
+		      "GET /a\x7F HTTP/1.1\r\n\r\n"}) {
+			std::unique_ptr<io::IOBuffer<char>> io_buffer =
+			    io::IOBuffer<char>::create(1024);
+			io_buffer->appendRawBytes(invalid_request.c_str(),
+						  invalid_request.size());
+			http::ParserState simd_state =
+			    http::ParserState::RequestLineBegin;
+			http::ParserState scalar_state =
+			    http::ParserState::RequestLineBegin;
+			http::ParseHTTP1_1RequestMessage(
+			    io_buffer, simd_state,
+			    http::HTTPRequestMessage::create());
+			http::ParseHTTP1_1RequestMessage<false>(
+			    io_buffer, scalar_state,
+			    http::HTTPRequestMessage::create());
+			ASSERT_TRUE(simd_state ==
+				    http::ParserState::ProtocolError);
+			ASSERT_TRUE(scalar_state ==
+				    http::ParserState::ProtocolError);
+		}
+	}
+}
+
+TEST(HttpStateMachine, Pipelining) {
+	std::string first_request = "POST /upload HTTP/1.1\r\n"
+				    "Content-Length: 11\r\n\r\n"
+				    "hello world";
+	std::string second_request = "GET /index.php HTTP/1.1\r\n"
+				     "Host: Proxygen.fb.com\r\n\r\n";
+	std::string third_request = "PUT /data HTTP/1.1\r\n"
+				    "content-length: 4\r\n\r\n"
+				    "abcd";
+	std::string batch = first_request + second_request + third_request;
+	{ // Consumed bytes stop at the end of the first message
+		std::unique_ptr<io::IOBuffer<char>> io_buffer =
+		    io::IOBuffer<char>::create(2048);
+		io_buffer->appendRawBytes(batch.c_str(), batch.size());
+		http::ParserState current_state =
+		    http::ParserState::RequestLineBegin;
+		std::size_t consumed_bytes{};
+		std::unique_ptr<http::HTTPRequestMessage> parsed_request =
+		    http::ParseHTTP1_1RequestMessage(
+			io_buffer, current_state,
+			http::HTTPRequestMessage::create(), consumed_bytes);
+		ASSERT_TRUE(current_state == http::ParserState::ParsingDone);
+		ASSERT_EQ(consumed_bytes, first_request.size());
+		ASSERT_TRUE(parsed_request->getRequestType() ==
+			    http::HTTPRequestType::Post);
+		ASSERT_EQ(std::string(parsed_request->constGetRawBody().cbegin(),
+				      parsed_request->constGetRawBody().cend()),
+			  "hello world");
+	}
+	// The whole batch split at every offset into two reads, the driver must
+	// always extract the same three requests
+	for (std::size_t split{}; split <= batch.size(); split++) {
+		std::unique_ptr<io::IOBuffer<char>> io_buffer =
+		    io::IOBuffer<char>::create(2048);
+		http::ParserState current_state =
+		    http::ParserState::RequestLineBegin;
+		std::unique_ptr<http::HTTPRequestMessage> http_message =
+		    http::HTTPRequestMessage::create();
+		std::vector<std::unique_ptr<http::HTTPRequestMessage>> requests;
+		auto on_request =
+		    [&](std::unique_ptr<http::HTTPRequestMessage> request) {
+			    requests.push_back(std::move(request));
+		    };
+		io_buffer->appendRawBytes(batch.c_str(), split);
+		http::ParseHTTP1_1PipelinedRequests(io_buffer, current_state,
+						    http_message, on_request);
+		io_buffer->appendRawBytes(batch.c_str() + split,
+					  batch.size() - split);
+		http::ParseHTTP1_1PipelinedRequests(io_buffer, current_state,
+						    http_message, on_request);
+		ASSERT_EQ(requests.size(), 3);
+		ASSERT_EQ(io_buffer->getDataSize(), 0);
+		ASSERT_EQ(requests[0]->constGetRawBody().getDataSize(), 11);
+		ASSERT_EQ(requests[1]->getTargetResource(), "/index.php");
+		ASSERT_TRUE(requests[1]->getHeaderValue("Host") ==
+			    "Proxygen.fb.com");
+		ASSERT_TRUE(requests[2]->getRequestType() ==
+			    http::HTTPRequestType::Put);
+		ASSERT_EQ(std::string(requests[2]->constGetRawBody().cbegin(),
+				      requests[2]->constGetRawBody().cend()),
+			  "abcd");
+	}
+	{ // Malformed Content-Length
+		std::string bad_request = "POST / HTTP/1.1\r\n"
+					  "Content-Length: 1x\r\n\r\n";
+		std::unique_ptr<io::IOBuffer<char>> io_buffer =
+		    io::IOBuffer<char>::create(2048);
+		io_buffer->appendRawBytes(bad_request.c_str(),
+					  bad_request.size());
+		http::ParserState current_state =
+		    http::ParserState::RequestLineBegin;
+		http::ParseHTTP1_1RequestMessage(
+		    io_buffer, current_state, http::HTTPRequestMessage::create());
+		ASSERT_TRUE(current_state == http::ParserState::ProtocolError);
+	}
+}
+
+TEST(HttpStateMachine, BodySinkAndLimits) {
+	std::string upload_request = "PUT /upload HTTP/1.1\r\n"
+				     "Content-Length: 26\r\n\r\n"
+				     "abcdefghijklmnopqrstuvwxyz";
+	{ // The body is streamed to the sink across the reads, not stored
+		std::unique_ptr<io::IOBuffer<char>> io_buffer =
+		    io::IOBuffer<char>::create(2048);
+		http::ParserState current_state =
+		    http::ParserState::RequestLineBegin;
+		std::unique_ptr<http::HTTPRequestMessage> http_message =
+		    http::HTTPRequestMessage::create();
+		std::string sunk_body;
+		std::size_t sink_calls{};
+		auto body_sink = [&](const char *data, std::size_t size) {
+			sunk_body.append(data, size);
+			sink_calls++;
+		};
+		for (std::size_t offset{}; offset < upload_request.size();
+		     offset += 10) {
+			std::size_t read_size =
+			    std::min<std::size_t>(10, upload_request.size() - offset);
+			io_buffer->appendRawBytes(upload_request.c_str() + offset,
+						  read_size);
+			std::size_t consumed_bytes{};
+			http_message = http::ParseHTTP1_1RequestMessage(
+			    io_buffer, current_state, std::move(http_message),
+			    consumed_bytes, http::HTTPParserLimits{}, body_sink);
+			io_buffer->modifyStartOffset(consumed_bytes);
+		}
+		ASSERT_TRUE(current_state == http::ParserState::ParsingDone);
+		ASSERT_EQ(sunk_body, "abcdefghijklmnopqrstuvwxyz");
+		ASSERT_GT(sink_calls, 1);
+		ASSERT_EQ(http_message->constGetRawBody().getDataSize(), 0);
+	}
+	auto parse_with_limits = [](const std::string &request,
+				    const http::HTTPParserLimits &limits) {
+		std::unique_ptr<io::IOBuffer<char>> io_buffer =
+		    io::IOBuffer<char>::create(2048);
+		io_buffer->appendRawBytes(request.c_str(), request.size());
+		http::ParserState current_state =
+		    http::ParserState::RequestLineBegin;
+		std::size_t consumed_bytes{};
+		http::ParseHTTP1_1RequestMessage(
+		    io_buffer, current_state, http::HTTPRequestMessage::create(),
+		    consumed_bytes, limits);
+		return current_state;
+	};
+	http::HTTPParserLimits limits;
+	limits.max_target_resource_size = 8;
+	ASSERT_TRUE(parse_with_limits("GET /0123456789 HTTP/1.1\r\n\r\n",
+				      limits) ==
+		    http::ParserState::RequestURITooLarge);
+	ASSERT_TRUE(parse_with_limits("GET /0123456 HTTP/1.1\r\n\r\n",
+				      limits) == http::ParserState::ParsingDone);
+	ASSERT_TRUE(parse_with_limits("GET /01234567", limits) ==
+		    http::ParserState::RequestURITooLarge);
+	limits = http::HTTPParserLimits{};
+	limits.max_header_section_size = 32;
+	ASSERT_TRUE(parse_with_limits("GET / HTTP/1.1\r\nCookie: 0123456789",
+				      limits) ==
+		    http::ParserState::HeaderSectionTooLarge);
+	limits = http::HTTPParserLimits{};
+	limits.max_body_size = 16;
+	// Rejected from the Content-Length, before the body is read
+	ASSERT_TRUE(parse_with_limits(upload_request.substr(0, 45), limits) ==
+		    http::ParserState::BodyTooLarge);
+	ASSERT_TRUE(parse_with_limits("POST / HTTP/1.1\r\n"
+				      "Transfer-Encoding: chunked\r\n\r\n"
+				      "8\r\n01234567\r\n9\r\n",
+				      limits) == http::ParserState::BodyTooLarge);
+	// A body buffer that fails to grow ends the parse, not the process
+	auto parse_out_of_memory = [](const std::string &request) {
+		std::unique_ptr<io::IOBuffer<char>> io_buffer =
+		    io::IOBuffer<char>::create(2048);
+		io_buffer->appendRawBytes(request.c_str(), request.size());
+		http::ParserState current_state =
+		    http::ParserState::RequestLineBegin;
+		std::size_t consumed_bytes{};
+		http::ParseHTTP1_1RequestMessage(
+		    io_buffer, current_state, http::HTTPRequestMessage::create(),
+		    consumed_bytes, http::HTTPParserLimits{},
+		    [](const char *, std::size_t) { throw std::bad_alloc{}; });
+		return current_state;
+	};
+	ASSERT_TRUE(parse_out_of_memory(upload_request) ==
+		    http::ParserState::BodyTooLarge);
+	ASSERT_TRUE(parse_out_of_memory("POST / HTTP/1.1\r\n"
+					"Transfer-Encoding: chunked\r\n\r\n"
+					"8\r\n01234567\r\n0\r\n\r\n") ==
+		    http::ParserState::BodyTooLarge);
+}
+
+TEST(HttpStateMachine, ConflictingFraming) {
+	auto parse_request = [](const std::string &request) {
+		std::unique_ptr<io::IOBuffer<char>> io_buffer =
+		    io::IOBuffer<char>::create(2048);
+		io_buffer->appendRawBytes(request.c_str(), request.size());
+		http::ParserState current_state =
+		    http::ParserState::RequestLineBegin;
+		http::ParseHTTP1_1RequestMessage(
+		    io_buffer, current_state, http::HTTPRequestMessage::create());
+		return current_state;
+	};
+	ASSERT_TRUE(parse_request("POST / HTTP/1.1\r\n"
+				  "Content-Length: 5\r\n"
+				  "Content-Length: 5\r\n\r\nhello") ==
+		    http::ParserState::ParsingDone);
+	ASSERT_TRUE(parse_request("POST / HTTP/1.1\r\n"
+				  "Content-Length: 5\r\n"
+				  "Content-Length: 0\r\n\r\nhello") ==
+		    http::ParserState::ProtocolError);
+	ASSERT_TRUE(parse_request("POST / HTTP/1.1\r\n"
+				  "Transfer-Encoding: chunked\r\n"
+				  "Transfer-Encoding: identity\r\n\r\n") ==
+		    http::ParserState::ProtocolError);
+	ASSERT_TRUE(parse_request("POST / HTTP/1.1\r\n"
+				  "Transfer-Encoding: chunked, gzip\r\n\r\n") ==
+		    http::ParserState::ProtocolError);
+	ASSERT_TRUE(parse_request("POST / HTTP/1.1\r\n"
+				  "Content-Length: 5\r\n"
+				  "Transfer-Encoding: chunked\r\n\r\n") ==
+		    http::ParserState::ProtocolError);
+	ASSERT_TRUE(parse_request("POST / HTTP/1.1\r\n"
+				  "Transfer-Encoding: chunked\r\n"
+				  "Content-Length: 5\r\n\r\n") ==
+		    http::ParserState::ProtocolError);
+	ASSERT_TRUE(parse_request("POST / HTTP/1.1\r\n"
+				  "Transfer-Encoding: gzip, chunked\r\n\r\n"
+				  "0\r\n\r\n") ==
+		    http::ParserState::ParsingDone);
+}
@@ -0,0 +1,78 @@
+#include <HTTPConstants.hpp>
+#include <gtest/gtest.h>
+#include <http/HTTPHeaders.hpp>
+#include <http/HTTPParserStateMachine.hpp>
+#include <http/HTTPTokenTable.hpp>
+#include <io/IOBuffer.hpp>
+#include <string>
+
+using namespace blueth;
+TEST(HTTPTokenTable, PerfectHash) {
+	// Every well-known name maps back to its own ID, in any case
+	for (std::size_t index = 1; index < http::header_id_count; index++) {
+		std::string header_name{http::well_known_header_names[index]};
+		ASSERT_TRUE(http::header_id_from_name(header_name) ==
+			    static_cast<http::HTTPHeaderID>(index));
+		for (char &header_char : header_name)
+			header_char = std::toupper(header_char);
+		ASSERT_TRUE(http::header_id_from_name(header_name) ==
+			    static_cast<http::HTTPHeaderID>(index));
+	}
+	static_assert(http::header_id_from_name("content-length") ==
+		      http::HTTPHeaderID::ContentLength);
+	ASSERT_TRUE(http::header_id_from_name("X-Custom-Header") ==
+		    http::HTTPHeaderID::Unknown);
+	ASSERT_TRUE(http::header_id_from_name("Content-Lengthy") ==
+		    http::HTTPHeaderID::Unknown);
+	ASSERT_TRUE(http::header_id_from_name("") ==
+		    http::HTTPHeaderID::Unknown);
+
+	static_assert(http::request_type_from_method("PATCH") ==
+		      http::HTTPRequestType::Patch);
+	ASSERT_TRUE(http::request_type_from_method("DELETE") ==
+		    http::HTTPRequestType::Delete);
+	ASSERT_TRUE(http::request_type_from_method("OPTIONS") ==
+		    http::HTTPRequestType::Options);
+	ASSERT_TRUE(http::request_type_from_method("TRACE") ==
+		    http::HTTPRequestType::Trace);
+	ASSERT_TRUE(http::request_type_from_method("get") ==
+		    http::HTTPRequestType::Unsupported);
+	ASSERT_TRUE(http::request_type_from_method("BREW") ==
+		    http::HTTPRequestType::Unsupported);
+	ASSERT_EQ(http::method_from_request_type(http::HTTPRequestType::Options),
+		  "OPTIONS");
+}
+
+TEST(HTTPTokenTable, HeadersByID) {
+	http::HTTPHeaders http_headers;
+	http_headers.addHeader({"content-type", "text/html"});
+	http_headers.addHeader(http::HTTPHeaderID::Host, "www.example.com");
+	http_headers.addHeader({"X-Custom-Header", "value"});
+	ASSERT_EQ(http_headers.getHeaderValue(http::HTTPHeaderID::ContentType),
+		  "text/html");
+	ASSERT_EQ(http_headers.getHeaderValue("Content-Type"), "text/html");
+	ASSERT_EQ(http_headers.getHeaderValue("host"), "www.example.com");
+	ASSERT_EQ(http_headers.getHeaderValue("X-Custom-Header"), "value");
+	ASSERT_TRUE(http_headers.headerContains(http::HTTPHeaderID::Host));
+	ASSERT_FALSE(http_headers.headerContains(http::HTTPHeaderID::Cookie));
+	ASSERT_TRUE(http_headers.removeHeader("content-type"));
+	ASSERT_FALSE(http_headers.getHeaderValue("Content-Type").has_value());
+
+	std::string sample_request = "DELETE /items/42 HTTP/1.1\r\n"
+				     "HOST: www.example.com\r\n\r\n";
+	std::unique_ptr<io::IOBuffer<char>> io_buffer =
+	    io::IOBuffer<char>::create(1024);
+	io_buffer->appendRawBytes(sample_request.c_str(),
+				  sample_request.size());
+	http::ParserState current_state = http::ParserState::RequestLineBegin;
+	std::unique_ptr<http::HTTPRequestMessage> parsed_request =
+	    http::ParseHTTP1_1RequestMessage(io_buffer, current_state,
+					     http::HTTPRequestMessage::create());
+	ASSERT_TRUE(current_state == http::ParserState::ParsingDone);
+	ASSERT_TRUE(parsed_request->getRequestType() ==
+		    http::HTTPRequestType::Delete);
+	ASSERT_EQ(parsed_request->getHeaderValue(http::HTTPHeaderID::Host),
+		  "www.example.com");
+	ASSERT_EQ(parsed_request->buildRawMessage().substr(0, 17),
+		  "DELETE /items/42 ");
+}
@@ -0,0 +1,121 @@
+#include <HTTPConstants.hpp>
+#include <gtest/gtest.h>
+#include <http/HTTPMessage.hpp>
+#include <http/HTTPURI.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace blueth;
+
+TEST(HttpURI, URIView) {
+	{ // origin-form
+		http::HTTPURIView uri_view =
+		    http::parse_uri_view("/api/items/42?sort=desc&page=2#top");
+		ASSERT_EQ(uri_view.scheme, "");
+		ASSERT_EQ(uri_view.authority, "");
+		ASSERT_EQ(uri_view.path, "/api/items/42");
+		ASSERT_EQ(uri_view.query, "sort=desc&page=2");
+		ASSERT_EQ(uri_view.fragment, "top");
+	}
+	{ // absolute-form
+		http::HTTPURIView uri_view =
+		    http::parse_uri_view("http://example.com:8080/index.html?a=b");
+		ASSERT_EQ(uri_view.scheme, "http");
+		ASSERT_EQ(uri_view.authority, "example.com:8080");
+		ASSERT_EQ(uri_view.path, "/index.html");
+		ASSERT_EQ(uri_view.query, "a=b");
+		uri_view = http::parse_uri_view("http://example.com");
+		ASSERT_EQ(uri_view.authority, "example.com");
+		ASSERT_EQ(uri_view.path, "");
+	}
+	{ // authority-form and asterisk-form
+		http::HTTPURIView uri_view = http::parse_uri_view("example.com:443");
+		ASSERT_EQ(uri_view.authority, "example.com:443");
+		ASSERT_EQ(uri_view.path, "");
+		ASSERT_EQ(http::parse_uri_view("*").path, "*");
+	}
+	{ // Query without a value, the views point into the target
+		std::string target = "/search?";
+		http::HTTPURIView uri_view = http::parse_uri_view(target);
+		ASSERT_EQ(uri_view.path, "/search");
+		ASSERT_EQ(uri_view.query, "");
+		ASSERT_EQ(uri_view.path.data(), target.data());
+	}
+	{ // Through the request message
+		std::unique_ptr<http::HTTPRequestMessage> http_message =
+		    http::HTTPRequestMessage::create();
+		http_message->setHTTPTargetResource("/login?next=%2Fhome");
+		ASSERT_EQ(http_message->getURIView().path, "/login");
+		ASSERT_EQ(http_message->getURIView().query, "next=%2Fhome");
+	}
+}
+
+TEST(HttpURI, PathSegmentsAndQuery) {
+	{
+		std::vector<std::string_view> segments;
+		for (std::string_view segment : http::HTTPPathSegments{"/a//b/"})
+			segments.push_back(segment);
+		ASSERT_EQ(segments, (std::vector<std::string_view>{"a", "", "b", ""}));
+		ASSERT_TRUE(http::HTTPPathSegments{"/"}.empty());
+		ASSERT_TRUE(http::HTTPPathSegments{""}.empty());
+	}
+	{
+		http::HTTPQueryParams query_params{"sort=desc&&flag&page=2&sort=asc"};
+		std::vector<std::string> params;
+		for (const http::HTTPNameValueView &param : query_params)
+			params.push_back(std::string{param.name} + ":" +
+					 std::string{param.value});
+		ASSERT_EQ(params, (std::vector<std::string>{"sort:desc", "flag:",
+							    "page:2", "sort:asc"}));
+		ASSERT_EQ(query_params.getValue("sort").value(), "desc");
+		ASSERT_EQ(query_params.getValue("flag").value(), "");
+		ASSERT_FALSE(query_params.getValue("missing").has_value());
+		ASSERT_TRUE(http::HTTPQueryParams{""}.empty());
+	}
+}
+
+TEST(HttpURI, Cookies) {
+	http::HTTPCookies cookies{
+	    " session=abc123;theme=dark;  quoted=\"a b\" ; ; nameless; tz=Europe%2FBerlin"};
+	std::vector<std::string> pairs;
+	for (const http::HTTPNameValueView &cookie : cookies)
+		pairs.push_back(std::string{cookie.name} + ":" +
+				std::string{cookie.value});
+	ASSERT_EQ(pairs, (std::vector<std::string>{"session:abc123", "theme:dark",
+						   "quoted:a b", ":nameless",
+						   "tz:Europe%2FBerlin"}));
+	ASSERT_EQ(cookies.getValue("theme").value(), "dark");
+	ASSERT_FALSE(cookies.getValue("nameless").has_value());
+}
+
+TEST(HttpURI, PercentDecode) {
+	std::string storage;
+	{ // Nothing to decode, the component itself is returned
+		std::string_view encoded = "/static/js/app.3f9c1a.js";
+		std::optional<std::string_view> decoded =
+		    http::percent_decode_view(encoded, storage);
+		ASSERT_EQ(decoded.value().data(), encoded.data());
+		// '+' is only a space in a query
+		encoded = "a+b";
+		ASSERT_EQ(http::percent_decode_view(encoded, storage).value().data(),
+			  encoded.data());
+		ASSERT_EQ(http::percent_decode_view(encoded, storage, true).value(),
+			  "a b");
+	}
+	{ // Escapes at the start, the end and past the vector width
+		std::string encoded = "%2Fhome%2f" + std::string(40, 'x') + "%20y%41";
+		ASSERT_EQ(http::percent_decode_view(encoded, storage).value(),
+			  "/home/" + std::string(40, 'x') + " yA");
+		std::string output = "prefix:";
+		ASSERT_TRUE(http::percent_decode("caf%C3%A9", output));
+		ASSERT_EQ(output, "prefix:caf\xC3\xA9");
+	}
+	{ // Malformed escapes
+		ASSERT_FALSE(http::percent_decode_view("100%", storage).has_value());
+		ASSERT_FALSE(http::percent_decode_view("%4", storage).has_value());
+		ASSERT_FALSE(http::percent_decode_view("%zz", storage).has_value());
+		ASSERT_FALSE(http::needs_percent_decoding(std::string(100, 'a')));
+		ASSERT_TRUE(http::needs_percent_decoding(std::string(100, 'a') + "%"));
+	}
+}
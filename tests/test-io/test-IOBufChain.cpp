@@ -0,0 +1,106 @@
+#include "IOBufChain.hpp"
+#include "IOBuffer.hpp"
+#include <cstring>
+#include <gtest/gtest.h>
+#include <string>
+#include <sys/uio.h>
+
+using namespace blueth;
+
+static std::unique_ptr<io::IOBuffer<char>> make_buffer(const char *data) {
+	std::unique_ptr<io::IOBuffer<char>> io_buffer =
+	    io::IOBuffer<char>::create(std::strlen(data));
+	io_buffer->appendRawBytes(data, std::strlen(data));
+	return io_buffer;
+}
+
+static std::string chain_to_string(const io::IOBufChain<char> &chain) {
+	std::string returner;
+	for (auto it = chain.cbegin(); it != chain.cend(); ++it)
+		returner.append(it->data(), it->size());
+	return returner;
+}
+
+TEST(IOBufChainTest, AppendPrepend) {
+	io::IOBufChain<char> chain;
+	ASSERT_TRUE(chain.empty());
+	chain.append(make_buffer("World"));
+	chain.prepend(make_buffer("Hello "));
+	chain.append(make_buffer("!"));
+	ASSERT_EQ(chain.segmentCount(), 3);
+	ASSERT_EQ(chain.getDataSize(), 12);
+	ASSERT_EQ(chain_to_string(chain), "Hello World!");
+
+	io::IOBufChain<char> other;
+	other.append(make_buffer(" Foo"));
+	other.append(make_buffer(" Bar"));
+	chain.append(std::move(other));
+	ASSERT_TRUE(other.empty());
+	ASSERT_EQ(chain.segmentCount(), 5);
+	ASSERT_EQ(chain_to_string(chain), "Hello World! Foo Bar");
+
+	// Empty buffers are not added as segments
+	chain.append(io::IOBuffer<char>::create(10));
+	ASSERT_EQ(chain.segmentCount(), 5);
+}
+
+TEST(IOBufChainTest, SplitAndTrim) {
+	io::IOBufChain<char> chain;
+	std::shared_ptr<io::IOBuffer<char>> shared_buffer =
+	    make_buffer("Hello World");
+	chain.append(shared_buffer);
+	chain.append(make_buffer(" Foo Bar"));
+
+	io::IOBufChain<char> head = chain.splitAt(5);
+	ASSERT_EQ(chain_to_string(head), "Hello");
+	ASSERT_EQ(chain_to_string(chain), " World Foo Bar");
+	// The boundary segment points to the same memory
+	ASSERT_EQ(head.cbegin()->data(), shared_buffer->getBuffer());
+	ASSERT_EQ(chain.cbegin()->data(), shared_buffer->getBuffer() + 5);
+	ASSERT_EQ(shared_buffer.use_count(), 3);
+
+	io::IOBufChain<char> second = chain.splitAt(6);
+	ASSERT_EQ(chain_to_string(second), " World");
+	ASSERT_EQ(chain.segmentCount(), 1);
+	ASSERT_THROW(chain.splitAt(100), std::out_of_range);
+
+	chain.trimStart(1);
+	chain.trimEnd(4);
+	ASSERT_EQ(chain_to_string(chain), "Foo");
+	chain.trimStart(100);
+	ASSERT_TRUE(chain.empty());
+	ASSERT_EQ(chain.segmentCount(), 0);
+}
+
+TEST(IOBufChainTest, AppendRawBytesAndCoalesce) {
+	io::IOBufChain<char> chain;
+	chain.appendRawBytes("Hello", 5);
+	chain.appendRawBytes(" World", 6);
+	// Written into the spare capacity of the tail segment
+	ASSERT_EQ(chain.segmentCount(), 1);
+
+	io::IOBufChain<char> cloned = chain.clone();
+	chain.appendRawBytes("!", 1);
+	// The tail is now shared with 'cloned', a new segment is allocated
+	ASSERT_EQ(chain.segmentCount(), 2);
+	ASSERT_EQ(chain_to_string(cloned), "Hello World");
+
+	chain.prepend(make_buffer(">> "));
+	const char *contiguous = chain.coalesce();
+	ASSERT_EQ(chain.segmentCount(), 1);
+	ASSERT_EQ(std::string(contiguous, chain.getDataSize()),
+		  ">> Hello World!");
+}
+
+TEST(IOBufChainTest, Iovec) {
+	io::IOBufChain<char> chain;
+	chain.append(make_buffer("GET / HTTP/1.1\r\n"));
+	chain.append(make_buffer("Host: blueth\r\n\r\n"));
+	std::vector<::iovec> iov = chain.getIovec();
+	ASSERT_EQ(iov.size(), 2);
+	ASSERT_EQ(iov[0].iov_len, 16);
+	ASSERT_EQ(std::memcmp(iov[1].iov_base, "Host: blueth\r\n\r\n", 16), 0);
+	::iovec small_iov[1]{};
+	ASSERT_EQ(chain.fillIovec(small_iov, 1), 1);
+	ASSERT_EQ(std::memcmp(small_iov[0].iov_base, "GET /", 5), 0);
+}
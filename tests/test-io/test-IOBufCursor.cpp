@@ -0,0 +1,93 @@
+#include "IOBufCursor.hpp"
+#include "InlineIOBuffer.hpp"
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+
+using namespace blueth;
+
+namespace {
+constexpr std::uint32_t constexprDecode() {
+	constexpr char frame[] = {0x00, 0x00, 0x01, 0x02, (char)0xAC, 0x02};
+	io::Cursor<char> cursor(frame, sizeof(frame));
+	std::uint32_t length = cursor.read<std::uint32_t>();
+	return length + cursor.readVarint();
+}
+static_assert(io::loadInteger<std::uint16_t>("\x12\x34") == 0x1234);
+static_assert(io::loadInteger<std::uint16_t, std::endian::little>(
+		  "\x12\x34") == 0x3412);
+static_assert(constexprDecode() == 0x0102 + 300);
+} // namespace
+
+TEST(IOBufCursorTest, ReadIntegers) {
+	std::unique_ptr<io::IOBuffer<std::uint8_t>> io_buffer =
+	    io::IOBuffer<std::uint8_t>::create(64);
+	const std::uint8_t frame[] = {0xCA, 0xFE, 0xDE, 0xAD, 0xBE, 0xEF,
+				      0x01, 0x00, 0x00, 0x00, 0xFF, 'x',
+				      'y',  'z'};
+	io_buffer->appendRawBytes(frame, sizeof(frame));
+	io::Cursor<std::uint8_t> cursor(*io_buffer);
+	ASSERT_EQ(cursor.peek<std::uint16_t>(), 0xCAFE);
+	ASSERT_EQ(cursor.read<std::uint16_t>(), 0xCAFE);
+	ASSERT_EQ(cursor.read<std::uint32_t>(), 0xDEADBEEF);
+	ASSERT_EQ((cursor.read<std::uint32_t, std::endian::little>()), 1);
+	ASSERT_EQ(cursor.read<std::int8_t>(), -1);
+	std::span<const std::uint8_t> tail = cursor.readSpan(3);
+	ASSERT_EQ(tail.data(), io_buffer->getStartOffsetPointer() + 11);
+	ASSERT_EQ(tail[2], 'z');
+	ASSERT_TRUE(cursor.isAtEnd());
+	ASSERT_THROW(cursor.read<std::uint8_t>(), std::out_of_range);
+	cursor.retreat(3);
+	ASSERT_EQ(cursor.getConsumed(), 11);
+	ASSERT_THROW(cursor.skip(4), std::out_of_range);
+	ASSERT_THROW(cursor.readSpan(4), std::out_of_range);
+	ASSERT_EQ(cursor.getRemaining(), 3);
+}
+
+TEST(IOBufCursorTest, AppenderRoundTrip) {
+	io::InlineIOBuffer<char, 8> io_buffer;
+	io::Appender<io::InlineIOBuffer<char, 8>> appender(io_buffer, 16);
+	appender.write<std::uint16_t>(0xABCD);
+	appender.write<std::uint64_t, std::endian::little>(0x1122334455667788);
+	appender.writeVarint(0);
+	appender.writeVarint(300);
+	appender.writeVarint(UINT64_MAX);
+	appender.writeSignedVarint(-64);
+	appender.push("tail", 4);
+	ASSERT_FALSE(io_buffer.isInline());
+
+	io::Cursor<char> cursor(io_buffer);
+	ASSERT_EQ(cursor.read<std::uint16_t>(), 0xABCD);
+	ASSERT_EQ((cursor.read<std::uint64_t, std::endian::little>()),
+		  0x1122334455667788);
+	ASSERT_EQ(cursor.readVarint(), 0);
+	ASSERT_EQ(cursor.readVarint(), 300);
+	ASSERT_EQ(cursor.readVarint(), UINT64_MAX);
+	ASSERT_EQ(cursor.readSignedVarint(), -64);
+	std::span<const char> tail = cursor.readSpan(4);
+	ASSERT_EQ(std::string(tail.begin(), tail.end()), "tail");
+	ASSERT_TRUE(cursor.isAtEnd());
+}
+
+TEST(IOBufCursorTest, MalformedVarint) {
+	const char truncated[] = {(char)0x80, (char)0x80};
+	io::Cursor<char> cursor(truncated, sizeof(truncated));
+	ASSERT_THROW(cursor.readVarint(), std::out_of_range);
+	std::string too_long(11, (char)0xFF);
+	io::Cursor<char> long_cursor(too_long.data(), too_long.size());
+	ASSERT_THROW(long_cursor.readVarint(), std::runtime_error);
+}
+
+TEST(IOBufCursorTest, DirectWrite) {
+	std::unique_ptr<io::IOBuffer<char>> io_buffer =
+	    io::IOBuffer<char>::create(4);
+	io::Appender<io::IOBuffer<char>> appender(*io_buffer);
+	appender.ensure(100);
+	ASSERT_GE(appender.getWritableSize(), 100);
+	std::memset(appender.getWritableData(), 'a', 100);
+	appender.append(100);
+	ASSERT_EQ(io_buffer->getDataSize(), 100);
+	io::Cursor<char> cursor(*io_buffer);
+	cursor.skip(99);
+	ASSERT_EQ(cursor.read<char>(), 'a');
+}
@@ -0,0 +1,99 @@
+#include "IOBufChain.hpp"
+#include "IOBufSlice.hpp"
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+using namespace blueth;
+using CharSlice = io::IOBufSlice<char>;
+
+TEST(IOBufSliceTest, AdoptWithoutCopy) {
+	std::string payload(1000, 'p');
+	const char *payload_memory = payload.data();
+	CharSlice from_string = CharSlice::adoptString(std::move(payload));
+	ASSERT_EQ(from_string.data(), payload_memory);
+	ASSERT_EQ(from_string.size(), 1000);
+
+	std::unique_ptr<io::IOBuffer<char>> io_buffer =
+	    io::IOBuffer<char>::create(64);
+	io_buffer->appendRawBytes("xxHello", 7);
+	io_buffer->modifyStartOffset(2);
+	const char *buffer_memory = io_buffer->getStartOffsetPointer();
+	CharSlice from_buffer = CharSlice::takeOwnership(std::move(io_buffer));
+	ASSERT_EQ(from_buffer.data(), buffer_memory);
+	ASSERT_EQ(from_buffer.toStringView(), "Hello");
+
+	bool deleted = false;
+	char *raw_memory = static_cast<char *>(::malloc(16));
+	std::memcpy(raw_memory, "external", 8);
+	{
+		CharSlice external = CharSlice::wrapMemory(
+		    raw_memory, 8, [&deleted](const char *ptr) {
+			    deleted = true;
+			    ::free((void *)ptr);
+		    });
+		CharSlice copy = external;
+		ASSERT_EQ(external.useCount(), 2);
+		ASSERT_EQ(copy.toStringView(), "external");
+	}
+	ASSERT_TRUE(deleted);
+
+	CharSlice copied = CharSlice::copyBuffer("copied", 6);
+	ASSERT_EQ(copied.toStringView(), "copied");
+}
+
+TEST(IOBufSliceTest, Slicing) {
+	CharSlice slice = CharSlice::adoptString("Hello, World");
+	CharSlice world = slice.slice(7, 5);
+	ASSERT_EQ(world.toStringView(), "World");
+	ASSERT_EQ(world.data(), slice.data() + 7);
+	ASSERT_EQ(slice.slice(5).toStringView(), ", World");
+	ASSERT_EQ(slice.useCount(), 2);
+	ASSERT_TRUE(slice.slice(12).empty());
+	ASSERT_THROW(slice.slice(13), std::out_of_range);
+	ASSERT_THROW(slice.slice(7, 6), std::out_of_range);
+}
+
+TEST(IOBufSliceTest, MapFile) {
+	char file_path[] = "/tmp/blueth-slice-XXXXXX";
+	int fd = ::mkstemp(file_path);
+	ASSERT_GE(fd, 0);
+	ASSERT_EQ(::write(fd, "mapped file", 11), 11);
+	::close(fd);
+	CharSlice mapped = CharSlice::mapFile(file_path);
+	::unlink(file_path);
+	ASSERT_EQ(mapped.toStringView(), "mapped file");
+	ASSERT_THROW(CharSlice::mapFile("/nonexistent/blueth"),
+		     std::runtime_error);
+}
+
+TEST(IOBufSliceTest, FanOutToChains) {
+	CharSlice payload = CharSlice::adoptString(std::string(4096, 'b'));
+	std::vector<io::IOBufChain<char>> peer_chains(100);
+	for (io::IOBufChain<char> &chain : peer_chains) {
+		chain.appendRawBytes("HDR:", 4);
+		chain.append(payload);
+	}
+	ASSERT_EQ(payload.useCount(), 101);
+	io::IOBufChain<char> chain = std::move(peer_chains.front());
+	ASSERT_EQ(chain.getDataSize(), 4100);
+	std::vector<::iovec> iov = chain.getIovec();
+	ASSERT_EQ(iov.size(), 2);
+	ASSERT_EQ(iov[1].iov_base, payload.data());
+	// Slice segments are never written into
+	chain.appendRawBytes("tail", 4);
+	ASSERT_EQ(chain.segmentCount(), 3);
+	io::IOBufChain<char> head = chain.splitAt(10);
+	ASSERT_EQ(std::string(head.coalesce(), 10), "HDR:bbbbbb");
+	chain.trimEnd(4);
+	ASSERT_EQ(chain.getDataSize(), 4090);
+	ASSERT_EQ(chain.cbegin()->data(), payload.data() + 6);
+	chain.prepend(payload.slice(0, 2));
+	ASSERT_EQ(chain.getDataSize(), 4092);
+	peer_chains.clear();
+	head.clear();
+	chain.clear();
+	ASSERT_EQ(payload.useCount(), 1);
+}
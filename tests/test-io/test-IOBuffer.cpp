@@ -1,7 +1,9 @@
 #include "IOBuffer.hpp"
+#include "InlineIOBuffer.hpp"
 #include <cstdint>
 #include <cstring>
 #include <gtest/gtest.h>
+#include <string>
 #include <utility>
 
 using namespace blueth;
@@ -87,3 +89,136 @@ TEST(IOBufferTestHTTPMessage, IOBuffer){
 	ASSERT_EQ(*io_buffer->begin(), 'w');
 	ASSERT_TRUE((*(io_buffer->end()-1) == '\r' && *(io_buffer->cend()-1) == '\r' && *io_buffer->cbegin() == 'w'));
 }
+
+TEST(IOBufferTestGrowthPolicy, IOBuffer){
+	io::IOBufGrowthPolicy geometric = io::IOBufGrowthPolicy::geometric();
+	ASSERT_EQ(geometric.nextCapacity(100, 101), 200);
+	ASSERT_EQ(geometric.nextCapacity(100, 500), 500);
+	ASSERT_EQ(geometric.nextCapacity(0, 10), 10);
+	io::IOBufGrowthPolicy exact = io::IOBufGrowthPolicy::exact();
+	ASSERT_EQ(exact.nextCapacity(100, 101), 101);
+	io::IOBufGrowthPolicy capped = io::IOBufGrowthPolicy::capped(64);
+	ASSERT_EQ(capped.nextCapacity(32, 33), 64);
+	ASSERT_EQ(capped.nextCapacity(1000, 1001), 1064);
+
+	std::unique_ptr<io::IOBuffer<char>> io_buffer = 
+		io::IOBuffer<char>::create(10);
+	io_buffer->appendRawBytes("0123456789", 10);
+	io_buffer->appendRawBytes("a", 1);
+	ASSERT_EQ(io_buffer->getCapacity(), 20);
+	io_buffer->setGrowthPolicy(io::IOBufGrowthPolicy::exact());
+	io_buffer->appendRawBytes("0123456789", 10);
+	ASSERT_EQ(io_buffer->getCapacity(), 21);
+	ASSERT_EQ(std::memcmp(io_buffer->getStartOffsetPointer(), "0123456789a0123456789", 21), 0);
+
+	// Appending a IOBuffer reserves enough space for the source data
+	std::unique_ptr<io::IOBuffer<char>> io_buffer_two = 
+		io::IOBuffer<char>::create(4);
+	io_buffer_two->appendRawBytes(*io_buffer);
+	ASSERT_EQ(io_buffer_two->getDataSize(), 21);
+}
+
+TEST(IOBufferTestCompaction, IOBuffer){
+	std::unique_ptr<io::IOBuffer<char>> io_buffer = 
+		io::IOBuffer<char>::create(16);
+	io_buffer->setCompactionThreshold(8);
+	io_buffer->appendRawBytes("0123456789abcdef", 16);
+	io_buffer->modifyStartOffset(10); // Consumed 10 bytes
+	io_buffer->appendRawBytes("XYZ", 3);
+	// Headroom is reclaimed instead of growing the buffer
+	ASSERT_EQ(io_buffer->getCapacity(), 16);
+	ASSERT_EQ(io_buffer->getStartOffset(), 0);
+	ASSERT_EQ(io_buffer->getDataSize(), 9);
+	ASSERT_EQ(std::memcmp(io_buffer->getStartOffsetPointer(), "abcdefXYZ", 9), 0);
+
+	io_buffer->modifyStartOffset(2);
+	io_buffer->compact();
+	ASSERT_EQ(io_buffer->getStartOffset(), 0);
+	ASSERT_EQ(std::memcmp(io_buffer->getStartOffsetPointer(), "cdefXYZ", 7), 0);
+	io_buffer->shrinkToFit();
+	ASSERT_EQ(io_buffer->getCapacity(), 7);
+	ASSERT_EQ(io_buffer->getAvailableSpace(), 0);
+	ASSERT_EQ(std::memcmp(io_buffer->getStartOffsetPointer(), "cdefXYZ", 7), 0);
+	io_buffer->clear();
+	io_buffer->shrinkToFit();
+	ASSERT_EQ(io_buffer->getCapacity(), 0);
+	io_buffer->appendRawBytes("Hey", 3);
+	ASSERT_EQ(io_buffer->getDataSize(), 3);
+
+	io::IOBuffer<char> moved{std::move(*io_buffer)};
+	ASSERT_EQ(moved.getCapacity(), 3);
+	ASSERT_EQ(moved.getCompactionThreshold(), 8);
+}
+
+TEST(IOBufferTestSelfAppend, IOBuffer){
+	std::unique_ptr<io::IOBuffer<char>> io_buffer = 
+		io::IOBuffer<char>::create(8);
+	io_buffer->appendRawBytes("abcdefgh", 8);
+	// The buffer is full, the source moves when it grows
+	io_buffer->appendRawBytes(*io_buffer);
+	ASSERT_EQ(io_buffer->getDataSize(), 16);
+	ASSERT_EQ(std::memcmp(io_buffer->getStartOffsetPointer(), "abcdefghabcdefgh", 16), 0);
+
+	// The source moves when the headroom is reclaimed
+	io_buffer->setCompactionThreshold(4);
+	io_buffer->modifyStartOffset(12);
+	io_buffer->appendRawBytes(io_buffer->getStartOffsetPointer() + 1, 3);
+	io_buffer->appendRawBytes(*io_buffer);
+	ASSERT_EQ(std::string(io_buffer->getStartOffsetPointer(), io_buffer->getDataSize()), "efghfghefghfgh");
+}
+
+TEST(IOBufferTestAllocators, IOBuffer){
+	std::unique_ptr<io::IOBuffer<char, io::IOBufCacheLineAllocator>> cache_line_buffer =
+		io::IOBuffer<char, io::IOBufCacheLineAllocator>::create(100);
+	ASSERT_EQ(reinterpret_cast<std::uintptr_t>(cache_line_buffer->getBuffer()) % 64, 0);
+	cache_line_buffer->appendRawBytes("Hello", 5);
+	cache_line_buffer->reserve(1000);
+	ASSERT_EQ(reinterpret_cast<std::uintptr_t>(cache_line_buffer->getBuffer()) % 64, 0);
+	ASSERT_EQ(std::memcmp(cache_line_buffer->getStartOffsetPointer(), "Hello", 5), 0);
+
+	io::IOBuffer<std::uint8_t, io::IOBufPageAlignedAllocator> page_buffer{10};
+	ASSERT_EQ(reinterpret_cast<std::uintptr_t>(page_buffer.getBuffer()) % 4096, 0);
+
+	// Starts in malloc memory and moves to a huge page mapping
+	io::IOBuffer<char, io::IOBufHugePageAllocator> huge_buffer{1024};
+	std::string chunk(64 * 1024, 'x');
+	chunk[0] = 'a';
+	for (int i{}; i < 48; i++) huge_buffer.appendRawBytes(chunk.c_str(), chunk.size());
+	ASSERT_GE(huge_buffer.getCapacity(), io::IOBufHugePageAllocator::min_mapping_size);
+	ASSERT_EQ(huge_buffer.getDataSize(), 48 * chunk.size());
+	ASSERT_EQ(huge_buffer.getStartOffsetPointer()[47 * chunk.size()], 'a');
+	ASSERT_EQ(huge_buffer.getStartOffsetPointer()[47 * chunk.size() + 1], 'x');
+	huge_buffer.modifyStartOffset(47 * chunk.size());
+	huge_buffer.shrinkToFit();
+	ASSERT_EQ(huge_buffer.getCapacity(), chunk.size());
+	ASSERT_EQ(*huge_buffer.getStartOffsetPointer(), 'a');
+}
+
+TEST(IOBufferTestFileBacked, IOBuffer){
+	using FileBackedAllocator = io::IOBufFileBackedAllocator<64 * 1024>;
+	io::IOBuffer<char, FileBackedAllocator> file_buffer{1024};
+	std::string chunk(16 * 1024, 'x');
+	chunk[0] = 'a';
+	file_buffer.appendRawBytes(chunk.c_str(), chunk.size());
+	// Spills over to the file mapping and grows it in place with mremap
+	for (int i{}; i < 63; i++) file_buffer.appendRawBytes(chunk.c_str(), chunk.size());
+	ASSERT_GE(file_buffer.getCapacity(), FileBackedAllocator::spill_threshold);
+	ASSERT_EQ(file_buffer.getDataSize(), 64 * chunk.size());
+	for (int i{}; i < 64; i++) {
+		ASSERT_EQ(file_buffer.getStartOffsetPointer()[i * chunk.size()], 'a');
+		ASSERT_EQ(file_buffer.getStartOffsetPointer()[i * chunk.size() + 1], 'x');
+	}
+	file_buffer.modifyStartOffset(63 * chunk.size());
+	file_buffer.shrinkToFit();
+	ASSERT_EQ(file_buffer.getCapacity(), chunk.size());
+	ASSERT_EQ(*file_buffer.getStartOffsetPointer(), 'a');
+
+	io::InlineIOBuffer<char, 64, FileBackedAllocator> inline_buffer;
+	for (int i{}; i < 8; i++) inline_buffer.appendRawBytes(chunk.c_str(), chunk.size());
+	ASSERT_FALSE(inline_buffer.isInline());
+	ASSERT_EQ(inline_buffer.getStartOffsetPointer()[7 * chunk.size()], 'a');
+	inline_buffer.modifyStartOffset(8 * chunk.size() - 10);
+	inline_buffer.shrinkToFit();
+	ASSERT_TRUE(inline_buffer.isInline());
+	ASSERT_EQ(std::string(inline_buffer.cbegin(), inline_buffer.cend()), std::string(10, 'x'));
+}
@@ -0,0 +1,75 @@
+#include "IOBufferPool.hpp"
+#include <cstring>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+using namespace blueth;
+using CharPool = io::IOBufferPool<char>;
+
+TEST(IOBufferPoolTest, SizeClasses) {
+	ASSERT_EQ(CharPool::sizeClassIndex(1), 0);
+	ASSERT_EQ(CharPool::sizeClassIndex(256), 0);
+	ASSERT_EQ(CharPool::sizeClassIndex(257), 1);
+	ASSERT_EQ(CharPool::sizeClassIndex(2048), 3);
+	ASSERT_EQ(CharPool::sizeClassCapacity(3), 2048);
+	ASSERT_EQ(CharPool::sizeClassIndex(4 * 1024 * 1024),
+		  CharPool::num_size_classes - 1);
+	ASSERT_EQ(CharPool::sizeClassIndex(4 * 1024 * 1024 + 1),
+		  CharPool::num_size_classes);
+}
+
+TEST(IOBufferPoolTest, AcquireRelease) {
+	CharPool &pool = CharPool::getInstance();
+	pool.trim();
+	io::IOBufferPoolStats before = pool.getStats();
+	const char *first_memory = nullptr;
+	{
+		CharPool::Handle handle = pool.acquire(1000);
+		ASSERT_TRUE(handle);
+		ASSERT_EQ(handle->getCapacity(), 1024);
+		handle->appendRawBytes("Hello", 5);
+		first_memory = handle->getBuffer();
+		ASSERT_EQ(pool.getStats().outstanding, before.outstanding + 1);
+	}
+	{
+		// We get the same buffer back from the thread cache, cleared
+		CharPool::Handle handle = pool.acquire(600);
+		ASSERT_EQ(handle->getBuffer(), first_memory);
+		ASSERT_EQ(handle->getDataSize(), 0);
+		CharPool::Handle handle_two = pool.acquire(600);
+		ASSERT_NE(handle_two->getBuffer(), first_memory);
+		ASSERT_EQ(pool.getStats().high_water,
+			  std::max(before.high_water, before.outstanding + 2));
+		CharPool::Handle moved = std::move(handle_two);
+		ASSERT_FALSE(handle_two);
+	}
+	io::IOBufferPoolStats after = pool.getStats();
+	ASSERT_EQ(after.acquired - before.acquired, 3);
+	ASSERT_EQ(after.pool_hits - before.pool_hits, 1);
+	ASSERT_EQ(after.released - before.released, 3);
+	ASSERT_EQ(after.outstanding, before.outstanding);
+
+	// Detached buffers are never returned to the pool
+	std::unique_ptr<io::IOBuffer<char>> detached =
+	    pool.acquire(100).release();
+	ASSERT_EQ(detached->getCapacity(), 256);
+	ASSERT_EQ(pool.getStats().outstanding, before.outstanding);
+}
+
+TEST(IOBufferPoolTest, ThreadExitMovesToGlobal) {
+	CharPool &pool = CharPool::getInstance();
+	pool.trim();
+	std::thread worker([&pool]() {
+		std::vector<CharPool::Handle> handles;
+		for (int i{}; i < 4; i++) handles.push_back(pool.acquire(8192));
+	});
+	worker.join();
+	ASSERT_EQ(pool.getStats().cached_global, 4);
+	io::IOBufferPoolStats before = pool.getStats();
+	CharPool::Handle handle = pool.acquire(8000);
+	ASSERT_EQ(pool.getStats().pool_hits - before.pool_hits, 1);
+	ASSERT_EQ(pool.getStats().cached_global, 3);
+	pool.trim();
+	ASSERT_EQ(pool.getStats().cached_global, 0);
+}
@@ -0,0 +1,75 @@
+#include "InlineIOBuffer.hpp"
+#include <cstring>
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace blueth;
+using SmallBuffer = io::InlineIOBuffer<char, 16>;
+
+TEST(InlineIOBufferTest, StaysInline) {
+	SmallBuffer io_buffer;
+	ASSERT_TRUE(io_buffer.isInline());
+	ASSERT_EQ(io_buffer.getCapacity(), 16);
+	io_buffer.appendRawBytes("Hello, World", 12);
+	ASSERT_TRUE(io_buffer.isInline());
+	ASSERT_EQ(io_buffer.getDataSize(), 12);
+	io_buffer.modifyStartOffset(7);
+	ASSERT_EQ(std::string(io_buffer.cbegin(), io_buffer.cend()), "World");
+	// Compaction makes the room instead of spilling
+	io_buffer.appendRawBytes("!!!!!!!!", 8);
+	ASSERT_TRUE(io_buffer.isInline());
+	ASSERT_EQ(std::string(io_buffer.cbegin(), io_buffer.cend()),
+		  "World!!!!!!!!");
+}
+
+TEST(InlineIOBufferTest, SpillAndShrink) {
+	SmallBuffer io_buffer;
+	std::string data(100, 'x');
+	io_buffer.appendRawBytes("abc", 3);
+	io_buffer.appendRawBytes(data.c_str(), data.size());
+	ASSERT_FALSE(io_buffer.isInline());
+	ASSERT_GE(io_buffer.getCapacity(), 103);
+	ASSERT_EQ(std::memcmp(io_buffer.getStartOffsetPointer(), "abcxxx", 6),
+		  0);
+	io_buffer.modifyStartOffset(95);
+	io_buffer.shrinkToFit();
+	ASSERT_TRUE(io_buffer.isInline());
+	ASSERT_EQ(io_buffer.getCapacity(), 16);
+	ASSERT_EQ(std::string(io_buffer.cbegin(), io_buffer.cend()),
+		  "xxxxxxxx");
+
+	SmallBuffer large_buffer(64);
+	ASSERT_FALSE(large_buffer.isInline());
+	ASSERT_EQ(large_buffer.getCapacity(), 64);
+}
+
+TEST(InlineIOBufferTest, SelfAppend) {
+	SmallBuffer io_buffer;
+	io_buffer.appendRawBytes("0123456789", 10);
+	// Spilling to the heap moves the source
+	io_buffer.appendRawBytes(io_buffer.getStartOffsetPointer(),
+				 io_buffer.getDataSize());
+	ASSERT_FALSE(io_buffer.isInline());
+	ASSERT_EQ(std::string(io_buffer.cbegin(), io_buffer.cend()),
+		  "01234567890123456789");
+}
+
+TEST(InlineIOBufferTest, Move) {
+	SmallBuffer inline_buffer;
+	inline_buffer.appendRawBytes("inline", 6);
+	SmallBuffer moved_inline(std::move(inline_buffer));
+	ASSERT_TRUE(moved_inline.isInline());
+	ASSERT_EQ(std::string(moved_inline.cbegin(), moved_inline.cend()),
+		  "inline");
+	ASSERT_EQ(inline_buffer.getDataSize(), 0);
+
+	SmallBuffer heap_buffer;
+	std::string data(64, 'y');
+	heap_buffer.appendRawBytes(data.c_str(), data.size());
+	const char *heap_memory = heap_buffer.getBuffer();
+	moved_inline = std::move(heap_buffer);
+	ASSERT_EQ(moved_inline.getBuffer(), heap_memory);
+	ASSERT_EQ(moved_inline.getDataSize(), 64);
+	ASSERT_TRUE(heap_buffer.isInline());
+	ASSERT_EQ(heap_buffer.getCapacity(), 16);
+}
@@ -0,0 +1,82 @@
+#include "MirroredRingBuffer.hpp"
+#include <cstring>
+#include <gtest/gtest.h>
+#include <http/HTTPParserStateMachine.hpp>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace blueth;
+
+TEST(MirroredRingBufferTest, Mirroring) {
+	std::unique_ptr<io::MirroredRingBuffer<char>> ring_buffer =
+	    io::MirroredRingBuffer<char>::create(100);
+	std::size_t capacity = ring_buffer->getCapacity();
+	ASSERT_EQ(capacity % ::sysconf(_SC_PAGESIZE), 0);
+	ASSERT_EQ(ring_buffer->getAvailableSpace(), capacity);
+	// Bytes written into the first mapping are visible in the second one
+	ring_buffer->getBuffer()[10] = 'X';
+	ASSERT_EQ(ring_buffer->getBuffer()[capacity + 10], 'X');
+
+	std::string filler(capacity - 4, 'a');
+	ring_buffer->appendRawBytes(filler.c_str(), filler.size());
+	ring_buffer->modifyStartOffset(filler.size());
+	ASSERT_EQ(ring_buffer->getDataSize(), 0);
+	// The data crosses the end of the first mapping, but the span is
+	// still contiguous for the reader
+	ring_buffer->appendRawBytes("Hello World", 11);
+	ASSERT_EQ(std::memcmp(ring_buffer->getStartOffsetPointer(),
+			      "Hello World", 11),
+		  0);
+	ASSERT_EQ(std::memcmp(ring_buffer->getBuffer(), "o World", 7), 0);
+	ring_buffer->modifyStartOffset(6);
+	// start_offset moved into the second mapping and is normalized
+	ASSERT_EQ(ring_buffer->getStartOffset(), 2);
+	ASSERT_EQ(std::string(ring_buffer->cbegin(), ring_buffer->cend()),
+		  "World");
+	ASSERT_EQ(ring_buffer->getAvailableSpace(), capacity - 5);
+	std::string too_large(capacity, 'b');
+	ASSERT_THROW(
+	    ring_buffer->appendRawBytes(too_large.c_str(), too_large.size()),
+	    std::runtime_error);
+}
+
+TEST(MirroredRingBufferTest, ParsersAcrossTheWrap) {
+	std::unique_ptr<io::MirroredRingBuffer<char>> ring_buffer =
+	    io::MirroredRingBuffer<char>::create(4096);
+	std::string filler(ring_buffer->getCapacity() - 20, 'a');
+	ring_buffer->appendRawBytes(filler.c_str(), filler.size());
+	ring_buffer->modifyStartOffset(filler.size());
+
+	std::string sample_request = "GET /index.php HTTP/1.1\r\n"
+				     "Accept: */*\r\n"
+				     "Host: Proxygen.fb.com\r\n\r\n";
+	ring_buffer->appendRawBytes(sample_request.c_str(),
+				    sample_request.size());
+	http::ParserState current_state = http::ParserState::RequestLineBegin;
+	std::unique_ptr<http::HTTPRequestMessage> parsed_request =
+	    http::ParseHTTP1_1RequestMessage(ring_buffer, current_state,
+					     http::HTTPRequestMessage::create());
+	ASSERT_TRUE(current_state == http::ParserState::ParsingDone);
+	ASSERT_EQ(parsed_request->getTargetResource(), "/index.php");
+	ASSERT_TRUE(parsed_request->getHeaderValue("Host") ==
+		    "Proxygen.fb.com");
+
+	ring_buffer->clear();
+	ring_buffer->appendRawBytes(filler.c_str(), filler.size());
+	ring_buffer->modifyStartOffset(filler.size());
+	std::string lines = "first line foo\r\nsecond line bar\r\n";
+	ring_buffer->appendRawBytes(lines.c_str(), lines.size());
+	// The lines are contiguous even though they wrap around the ring
+	std::string_view ring_view{ring_buffer->getStartOffsetPointer(),
+				   ring_buffer->getDataSize()};
+	std::vector<std::string_view> results;
+	for (std::size_t line_end; (line_end = ring_view.find("\r\n")) !=
+				   std::string_view::npos;) {
+		results.push_back(ring_view.substr(0, line_end));
+		ring_view.remove_prefix(line_end + 2);
+	}
+	ASSERT_EQ(results.size(), 2);
+	ASSERT_EQ(results[0], "first line foo");
+	ASSERT_EQ(results[1], "second line bar");
+}